@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+
+// clang-format off
+#define NANODBC_DISABLE_NANODBC_NAMESPACE_FOR_INTERNAL_TESTS
+#include "nanodbc/nanodbc.cpp" // access private conversion routines
+// clang-format on
+
+#include <cstddef>
+#include <string>
+
+namespace
+{
+
+// Text that is three quarters ASCII, with a two, a three and a four byte sequence in every
+// sixteen bytes, so that neither the ASCII nor the multibyte paths are measured alone.
+std::string utf8_text(std::size_t bytes)
+{
+    static char const pattern[] = "nanodbc \xC3\xA9\xE3\x83\x84\xF0\x9F\x98\x80";
+    std::string text;
+    while (text.size() + sizeof(pattern) - 1 <= bytes)
+        text += pattern;
+    text.append(bytes - text.size(), 'x');
+    return text;
+}
+
+void convert_utf8_to_wide(benchmark::State& state)
+{
+    auto const utf8 = utf8_text(static_cast<std::size_t>(state.range(0)));
+    nanodbc::wide_string wide;
+    for (auto _ : state)
+    {
+        convert(utf8, wide);
+        benchmark::DoNotOptimize(wide.data());
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * utf8.size()));
+}
+BENCHMARK(convert_utf8_to_wide)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+void convert_wide_to_utf8(benchmark::State& state)
+{
+    nanodbc::wide_string wide;
+    convert(utf8_text(static_cast<std::size_t>(state.range(0))), wide);
+    std::string utf8;
+    for (auto _ : state)
+    {
+        convert(wide, utf8);
+        benchmark::DoNotOptimize(utf8.data());
+    }
+    state.SetBytesProcessed(
+        static_cast<std::int64_t>(
+            state.iterations() * wide.size() * sizeof(nanodbc::wide_string::value_type)));
+}
+BENCHMARK(convert_wide_to_utf8)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+} // namespace
@@ -0,0 +1,258 @@
+#include <benchmark/benchmark.h>
+#include <nanodbc/nanodbc.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+// These run against the database named by NANODBC_BENCHMARK_CONNSTR, or by default a SQLite
+// file in the working directory through the SQLite ODBC driver, which is registered under a
+// different name on Windows. A benchmark that cannot reach the database reports the error
+// and is skipped, so the conversion benchmarks still run without one.
+
+namespace
+{
+
+constexpr int table_rows = 10000;
+
+// Connection strings and queries are ASCII, which widens one byte to one unit.
+nanodbc::string text(std::string const& s)
+{
+    return nanodbc::string(s.begin(), s.end());
+}
+
+nanodbc::string connection_string()
+{
+    if (char const* env = std::getenv("NANODBC_BENCHMARK_CONNSTR"))
+        return text(env);
+#ifdef _WIN32
+    return NANODBC_TEXT("Driver=SQLite3 ODBC Driver;Database=nanodbc_benchmark.db;");
+#else
+    return NANODBC_TEXT("Driver=SQLite3;Database=nanodbc_benchmark.db;");
+#endif
+}
+
+// One connection serves every benchmark, and the tables they read are created on first use.
+nanodbc::connection& database()
+{
+    static nanodbc::connection connection(connection_string());
+    return connection;
+}
+
+void create_table(nanodbc::string const& name, nanodbc::string const& columns)
+{
+    try
+    {
+        nanodbc::execute(database(), NANODBC_TEXT("drop table ") + name + NANODBC_TEXT(";"));
+    }
+    catch (nanodbc::database_error const&)
+    {
+        // It did not exist.
+    }
+    nanodbc::execute(
+        database(), NANODBC_TEXT("create table ") + name + NANODBC_TEXT(" ") + columns +
+                        NANODBC_TEXT(";"));
+}
+
+// bench_rows (i int, b bigint, d double precision, s varchar(64)) with table_rows rows.
+void fill_rows()
+{
+    static bool filled = false;
+    if (filled)
+        return;
+
+    create_table(
+        NANODBC_TEXT("bench_rows"),
+        NANODBC_TEXT("(i int, b bigint, d double precision, s varchar(64))"));
+
+    std::vector<int> i(table_rows);
+    std::vector<long long> b(table_rows);
+    std::vector<double> d(table_rows);
+    std::vector<std::string> s(table_rows);
+    for (int row = 0; row < table_rows; ++row)
+    {
+        i[row] = row;
+        b[row] = static_cast<long long>(row) << 32;
+        d[row] = row / 7.0;
+        s[row] = "row " + std::to_string(row) + " of the benchmark table";
+    }
+
+    nanodbc::transaction transaction(database());
+    nanodbc::statement statement(database());
+    nanodbc::prepare(
+        statement, NANODBC_TEXT("insert into bench_rows (i, b, d, s) values (?, ?, ?, ?);"));
+    statement.bind(0, i.data(), i.size());
+    statement.bind(1, b.data(), b.size());
+    statement.bind(2, d.data(), d.size());
+    statement.bind_strings(3, s);
+    nanodbc::execute(statement, table_rows);
+    transaction.commit();
+    filled = true;
+}
+
+// Runs body, reporting a database error as the benchmark's error.
+template <class Body>
+void with_database(benchmark::State& state, Body body)
+{
+    try
+    {
+        body();
+    }
+    catch (std::exception const& e)
+    {
+        state.SkipWithError(e.what());
+    }
+}
+
+// Typed fetch of every row through bound columns, by rowset size.
+void fetch_numbers(benchmark::State& state)
+{
+    with_database(state, [&] {
+        fill_rows();
+        auto const rowset_size = static_cast<long>(state.range(0));
+        std::int64_t rows = 0;
+        for (auto _ : state)
+        {
+            auto result = nanodbc::execute(
+                database(), NANODBC_TEXT("select i, b, d from bench_rows;"), rowset_size);
+            while (result.next())
+            {
+                benchmark::DoNotOptimize(result.get<int>(0));
+                benchmark::DoNotOptimize(result.get<long long>(1));
+                benchmark::DoNotOptimize(result.get<double>(2));
+                ++rows;
+            }
+        }
+        state.SetItemsProcessed(rows);
+        state.SetBytesProcessed(rows * (sizeof(int) + sizeof(long long) + sizeof(double)));
+    });
+}
+BENCHMARK(fetch_numbers)->Arg(1)->Arg(10)->Arg(100)->Arg(1000);
+
+// Character column read as a narrow string and as a wide one, by rowset size.
+template <class String>
+void fetch_strings(benchmark::State& state)
+{
+    with_database(state, [&] {
+        fill_rows();
+        auto const rowset_size = static_cast<long>(state.range(0));
+        std::int64_t rows = 0;
+        std::int64_t bytes = 0;
+        for (auto _ : state)
+        {
+            auto result = nanodbc::execute(
+                database(), NANODBC_TEXT("select s from bench_rows;"), rowset_size);
+            while (result.next())
+            {
+                auto const s = result.get<String>(0);
+                bytes += static_cast<std::int64_t>(s.size() * sizeof(typename String::value_type));
+                ++rows;
+            }
+        }
+        state.SetItemsProcessed(rows);
+        state.SetBytesProcessed(bytes);
+    });
+}
+BENCHMARK_TEMPLATE(fetch_strings, std::string)->Arg(1)->Arg(100)->Arg(1000);
+BENCHMARK_TEMPLATE(fetch_strings, nanodbc::wide_string)->Arg(1)->Arg(100)->Arg(1000);
+
+// Long value read through SQLGetData in pieces, by value size.
+void fetch_lob(benchmark::State& state)
+{
+    with_database(state, [&] {
+        auto const size = static_cast<std::size_t>(state.range(0));
+        constexpr int lob_rows = 16;
+        create_table(NANODBC_TEXT("bench_lob"), NANODBC_TEXT("(v text)"));
+        {
+            std::vector<std::string> values(lob_rows, std::string(size, 'L'));
+            nanodbc::statement statement(database());
+            nanodbc::prepare(statement, NANODBC_TEXT("insert into bench_lob (v) values (?);"));
+            statement.bind_strings(0, values);
+            nanodbc::execute(statement, lob_rows);
+        }
+
+        std::int64_t bytes = 0;
+        for (auto _ : state)
+        {
+            auto result = nanodbc::execute(database(), NANODBC_TEXT("select v from bench_lob;"));
+            while (result.next())
+                bytes += static_cast<std::int64_t>(result.get<std::string>(0).size());
+        }
+        state.SetItemsProcessed(state.iterations() * lob_rows);
+        state.SetBytesProcessed(bytes);
+    });
+}
+BENCHMARK(fetch_lob)->Arg(4 * 1024)->Arg(64 * 1024)->Arg(1024 * 1024);
+
+// Parameter array insert, by rows per execution. The table is emptied outside the timing.
+void insert_batch(benchmark::State& state)
+{
+    with_database(state, [&] {
+        auto const batch = static_cast<std::size_t>(state.range(0));
+        create_table(NANODBC_TEXT("bench_insert"), NANODBC_TEXT("(i int, d double precision)"));
+        std::vector<int> i(batch);
+        std::vector<double> d(batch);
+        for (std::size_t row = 0; row < batch; ++row)
+        {
+            i[row] = static_cast<int>(row);
+            d[row] = row / 3.0;
+        }
+
+        nanodbc::statement statement(database());
+        nanodbc::prepare(statement, NANODBC_TEXT("insert into bench_insert (i, d) values (?, ?);"));
+        statement.bind(0, i.data(), batch);
+        statement.bind(1, d.data(), batch);
+        for (auto _ : state)
+        {
+            nanodbc::transaction transaction(database());
+            nanodbc::execute(statement, static_cast<long>(batch));
+            transaction.commit();
+
+            state.PauseTiming();
+            nanodbc::execute(database(), NANODBC_TEXT("delete from bench_insert;"));
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(batch));
+        state.SetBytesProcessed(
+            state.iterations() * static_cast<std::int64_t>(batch * (sizeof(int) + sizeof(double))));
+    });
+}
+BENCHMARK(insert_batch)->Arg(1)->Arg(100)->Arg(1000);
+
+// Round trip of a one row query, prepared anew each time.
+void prepare_execute(benchmark::State& state)
+{
+    with_database(state, [&] {
+        nanodbc::statement statement(database());
+        for (auto _ : state)
+        {
+            nanodbc::prepare(statement, NANODBC_TEXT("select 1;"));
+            auto result = nanodbc::execute(statement);
+            result.next();
+            benchmark::DoNotOptimize(result.get<int>(0));
+        }
+        state.SetItemsProcessed(state.iterations());
+    });
+}
+BENCHMARK(prepare_execute);
+
+// The same round trip with the statement prepared once.
+void execute_prepared(benchmark::State& state)
+{
+    with_database(state, [&] {
+        nanodbc::statement statement(database());
+        nanodbc::prepare(statement, NANODBC_TEXT("select 1;"));
+        for (auto _ : state)
+        {
+            auto result = nanodbc::execute(statement);
+            result.next();
+            benchmark::DoNotOptimize(result.get<int>(0));
+        }
+        state.SetItemsProcessed(state.iterations());
+    });
+}
+BENCHMARK(execute_prepared);
+
+} // namespace
@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <nanodbc/nanodbc.h>
+
+#include <cstdint>
+#include <exception>
+#include <string>
+
+// These run against the mock driver from the tests, which serves rows from memory, so what
+// they measure is nanodbc's own cost per row and per call rather than a database's.
+
+namespace
+{
+
+nanodbc::connection& mock()
+{
+    static nanodbc::connection connection(NANODBC_TEXT("Driver=" NANODBC_MOCK_DRIVER ";"));
+    return connection;
+}
+
+nanodbc::string query(std::int64_t rows, char const* columns)
+{
+    auto const s = "rows=" + std::to_string(rows) + " columns=" + columns;
+    return nanodbc::string(s.begin(), s.end());
+}
+
+// Every column of every row of a result with the given columns, by rowset size.
+void mock_fetch(benchmark::State& state, char const* columns, short count)
+{
+    try
+    {
+        constexpr std::int64_t rows = 100000;
+        auto const statement_text = query(rows, columns);
+        auto const rowset_size = static_cast<long>(state.range(0));
+        for (auto _ : state)
+        {
+            auto result = nanodbc::execute(mock(), statement_text, rowset_size);
+            while (result.next())
+            {
+                for (short column = 0; column < count; ++column)
+                    benchmark::DoNotOptimize(result.get<nanodbc::string>(column));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * rows);
+    }
+    catch (std::exception const& e)
+    {
+        state.SkipWithError(e.what());
+    }
+}
+BENCHMARK_CAPTURE(mock_fetch, numbers, "int,bigint,double", 3)->Arg(1)->Arg(100)->Arg(1000);
+BENCHMARK_CAPTURE(mock_fetch, strings, "varchar(32),wvarchar(32)", 2)->Arg(1)->Arg(100)->Arg(1000);
+
+// Typed reads of bound numeric columns, which involve no conversion to text.
+void mock_fetch_typed(benchmark::State& state)
+{
+    try
+    {
+        constexpr std::int64_t rows = 100000;
+        auto const statement_text = query(rows, "int,bigint,double");
+        auto const rowset_size = static_cast<long>(state.range(0));
+        for (auto _ : state)
+        {
+            auto result = nanodbc::execute(mock(), statement_text, rowset_size);
+            while (result.next())
+            {
+                benchmark::DoNotOptimize(result.get<int>(0));
+                benchmark::DoNotOptimize(result.get<long long>(1));
+                benchmark::DoNotOptimize(result.get<double>(2));
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * rows);
+    }
+    catch (std::exception const& e)
+    {
+        state.SkipWithError(e.what());
+    }
+}
+BENCHMARK(mock_fetch_typed)->Arg(1)->Arg(100)->Arg(1000);
+
+} // namespace
@@ -16,6 +16,10 @@
 #include <nanodbc/nanodbc.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
 #include <clocale>
 #include <cstdio>
 #include <cstdlib>
@@ -24,12 +28,25 @@
 #include <iomanip>
 #include <limits>
 #include <map>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
 
 #ifndef __clang__
 #include <cstdint>
 #endif
 
+// std::from_chars, where the standard library has it for floating point as well as integers
+#if defined(NANODBC_HAS_STD_STRING_VIEW) && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define NANODBC_HAS_STD_FROM_CHARS
+#endif
+#endif
+#endif
+
 #ifdef NANODBC_HAS_STD_OPTIONAL
 template <class T>
 inline static void opt_reset(std::optional<T>& opt)
@@ -61,6 +78,30 @@ struct is_optional<std::optional<T>> : std::true_type
 // std::wcslen
 #include <cwchar>
 
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER) && defined(_WIN32)
+#error "NANODBC_ENABLE_DIRECT_DRIVER needs dlopen, which is not available on Windows"
+#endif
+// dlopen, for linking a driver directly and for finding the bulk copy functions of a loaded one
+#if !defined(_WIN32) &&                                                                            \
+    (defined(NANODBC_ENABLE_DIRECT_DRIVER) || !defined(NANODBC_DISABLE_MSSQL_BCP))
+#include <dlfcn.h>
+#endif
+// Walking the loaded libraries, for finding the one the driver manager loaded a driver from
+#if !defined(_WIN32) && !defined(NANODBC_DISABLE_MSSQL_BCP)
+#if defined(__APPLE__)
+#include <mach-o/dyld.h>
+#else
+#include <link.h>
+#endif
+#endif
+// mmap, for reading a spool file in place
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #ifdef __APPLE__
 // silence spurious OS X deprecation warnings
 #ifndef MAC_OS_X_VERSION_MIN_REQUIRED
@@ -179,6 +220,26 @@ struct is_optional<std::optional<T>> : std::true_type
 #define SQL_SS_LENGTH_UNLIMITED (0)
 #endif
 
+// Driver specific constants of the bulk copy API, from msodbcsql.h
+#ifndef SQL_COPT_SS_BASE
+#define SQL_COPT_SS_BASE 1200
+#endif
+#ifndef SQL_COPT_SS_BCP
+#define SQL_COPT_SS_BCP (SQL_COPT_SS_BASE + 19)
+#endif
+#ifndef SQL_BCP_ON
+#define SQL_BCP_ON 1UL
+#endif
+#ifndef DB_IN
+#define DB_IN 1
+#endif
+#ifndef SQL_VARLEN_DATA
+#define SQL_VARLEN_DATA (-10)
+#endif
+#ifndef BCPABORT
+#define BCPABORT 6
+#endif
+
 // Max length of DBVARBINARY and DBVARCHAR, etc. +1 for zero byte
 // MSDN: Large value data types are those that exceed the maximum row size of 8 KB
 #define SQLSERVER_DBMAXCHAR (8000 + 1)
@@ -243,9 +304,39 @@ using nanodbc::wide_string;
 #define NANODBC_STRINGIZE_I(text) #text
 #define NANODBC_STRINGIZE(text) NANODBC_STRINGIZE_I(text)
 
+// The function a call goes to: the driver manager's, or once link_driver() has loaded a driver,
+// the driver's own. The driver is linked before any handle is allocated and stays linked, so a
+// non-null pointer read once is read again unchanged. See link_driver().
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+#define NANODBC_DRIVER_FUNCTION(FUNC)                                                              \
+    (linked_functions.load(std::memory_order_acquire)                                              \
+         ? linked_functions.load(std::memory_order_relaxed)->FUNC                                  \
+         : &FUNC)
+#else
+#define NANODBC_DRIVER_FUNCTION(FUNC) FUNC
+#endif
+
 // By making all calls to ODBC functions through this macro, we can easily get
 // runtime debugging information of which ODBC functions are being called,
 // in what order, and with what parameters by defining NANODBC_ODBC_API_DEBUG.
+//
+// Each call is also counted and timed while call tracing is enabled at runtime; while it is
+// not, the hook costs a relaxed load of one flag. See the Instrumentation section.
+#define NANODBC_TRACED_CALL_RC(FUNC, RC, ...)                                                      \
+    do                                                                                             \
+    {                                                                                              \
+        if (call_tracing_on.load(std::memory_order_relaxed))                                       \
+        {                                                                                          \
+            static traced_call_site const nanodbc_call_site(NANODBC_STRINGIZE(FUNC));              \
+            auto const nanodbc_call_start = std::chrono::steady_clock::now();                      \
+            RC = NANODBC_DRIVER_FUNCTION(FUNC)(__VA_ARGS__);                                       \
+            trace_call(nanodbc_call_site, nanodbc_call_start, RC);                                 \
+        }                                                                                          \
+        else                                                                                       \
+        {                                                                                          \
+            RC = NANODBC_DRIVER_FUNCTION(FUNC)(__VA_ARGS__);                                       \
+        }                                                                                          \
+    } while (false) /**/
 #ifdef NANODBC_ODBC_API_DEBUG
 #include <iostream>
 #define NANODBC_CALL_RC(FUNC, RC, ...)                                                             \
@@ -254,19 +345,258 @@ using nanodbc::wide_string;
         std::cerr << __FILE__                                                                      \
             ":" NANODBC_STRINGIZE(__LINE__) " " NANODBC_STRINGIZE(FUNC) "(" #__VA_ARGS__ ")"       \
                   << std::endl;                                                                    \
-        RC = FUNC(__VA_ARGS__);                                                                    \
+        NANODBC_TRACED_CALL_RC(FUNC, RC, __VA_ARGS__);                                             \
     } while (false) /**/
+#else
+#define NANODBC_CALL_RC(FUNC, RC, ...) NANODBC_TRACED_CALL_RC(FUNC, RC, __VA_ARGS__)
+#endif
 #define NANODBC_CALL(FUNC, ...)                                                                    \
     do                                                                                             \
     {                                                                                              \
-        std::cerr << __FILE__                                                                      \
-            ":" NANODBC_STRINGIZE(__LINE__) " " NANODBC_STRINGIZE(FUNC) "(" #__VA_ARGS__ ")"       \
-                  << std::endl;                                                                    \
-        FUNC(__VA_ARGS__);                                                                         \
+        RETCODE nanodbc_call_rc;                                                                   \
+        NANODBC_CALL_RC(FUNC, nanodbc_call_rc, __VA_ARGS__);                                       \
+        (void)nanodbc_call_rc;                                                                     \
     } while (false) /**/
+
+namespace
+{
+// Call tracing keeps its counters per thread. Each thread that makes a traced call allocates a
+// block of counters, lists it in the registry and from then on increments it alone, with
+// relaxed atomics and no lock. Reading the statistics adds the blocks up under the registry's
+// mutex; a thread that exits folds its block into the totals of exited threads first.
+//
+// Every call site names its function once, the first time it is traced, and is given the
+// function's slot in the blocks. Functions past the limit share the last slot.
+constexpr std::size_t traced_function_limit = 128;
+constexpr std::size_t traced_bucket_count = nanodbc::call_stats::buckets;
+
+std::atomic<bool> call_tracing_on{false};
+
+struct traced_counters
+{
+    std::atomic<unsigned long long> calls;
+    std::atomic<unsigned long long> errors;
+    std::atomic<unsigned long long> nanoseconds;
+    std::atomic<unsigned long long> histogram[traced_bucket_count];
+};
+
+struct traced_thread_counters
+{
+    traced_counters functions[traced_function_limit];
+};
+
+struct call_tracing_registry
+{
+    std::mutex mutex;
+    std::vector<char const*> functions;
+    std::vector<traced_thread_counters*> threads;
+    traced_thread_counters exited;
+
+    std::mutex span_mutex;
+    std::atomic<bool> has_span_handler{false};
+    std::shared_ptr<std::function<void(nanodbc::call_span const&)>> span_handler;
+};
+
+// Never destroyed, as threads may still exit and fold their counters in after static
+// destructors have run.
+call_tracing_registry& tracing_registry()
+{
+    static auto* const registry = new call_tracing_registry();
+    return *registry;
+}
+
+void add_traced_counters(traced_counters& to, traced_counters const& from) noexcept
+{
+    auto const add = [](std::atomic<unsigned long long>& a,
+                        std::atomic<unsigned long long> const& b) {
+        a.fetch_add(b.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    };
+    add(to.calls, from.calls);
+    add(to.errors, from.errors);
+    add(to.nanoseconds, from.nanoseconds);
+    for (std::size_t i = 0; i < traced_bucket_count; ++i)
+        add(to.histogram[i], from.histogram[i]);
+}
+
+std::size_t register_traced_function(char const* function)
+{
+    auto& registry = tracing_registry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    auto& functions = registry.functions;
+    for (std::size_t i = 0; i < functions.size(); ++i)
+    {
+        if (std::strcmp(functions[i], function) == 0)
+            return i;
+    }
+    if (functions.size() + 1 < traced_function_limit)
+    {
+        functions.push_back(function);
+        return functions.size() - 1;
+    }
+    if (functions.size() < traced_function_limit)
+        functions.push_back("(other)");
+    return traced_function_limit - 1;
+}
+
+struct traced_call_site
+{
+    explicit traced_call_site(char const* function)
+        : function(function)
+        , index(register_traced_function(function))
+    {
+    }
+
+    char const* const function;
+    std::size_t const index;
+};
+
+// Owns the calling thread's block and folds it into the totals when the thread exits.
+struct traced_thread
+{
+    traced_thread_counters* counters = nullptr;
+
+    ~traced_thread()
+    {
+        if (!counters)
+            return;
+        auto& registry = tracing_registry();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        for (std::size_t i = 0; i < traced_function_limit; ++i)
+            add_traced_counters(registry.exited.functions[i], counters->functions[i]);
+        auto& threads = registry.threads;
+        threads.erase(std::find(threads.begin(), threads.end(), counters));
+        delete counters;
+    }
+};
+
+traced_thread_counters& this_thread_counters()
+{
+    thread_local traced_thread thread;
+    if (!thread.counters)
+    {
+        std::unique_ptr<traced_thread_counters> counters(new traced_thread_counters());
+        auto& registry = tracing_registry();
+        std::lock_guard<std::mutex> guard(registry.mutex);
+        registry.threads.push_back(counters.get());
+        thread.counters = counters.release();
+    }
+    return *thread.counters;
+}
+
+void trace_call(
+    traced_call_site const& site,
+    std::chrono::steady_clock::time_point start,
+    RETCODE rc) noexcept
+{
+    auto const duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    unsigned long long const elapsed = duration.count() > 0 ? duration.count() : 0;
+    std::size_t bucket = 0;
+    for (auto rest = elapsed >> 1; rest != 0 && bucket + 1 < traced_bucket_count; rest >>= 1)
+        ++bucket;
+
+    try
+    {
+        auto& counters = this_thread_counters().functions[site.index];
+        counters.calls.fetch_add(1, std::memory_order_relaxed);
+        if (rc == SQL_ERROR || rc == SQL_INVALID_HANDLE)
+            counters.errors.fetch_add(1, std::memory_order_relaxed);
+        counters.nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        counters.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+        auto& registry = tracing_registry();
+        if (registry.has_span_handler.load(std::memory_order_acquire))
+        {
+            std::shared_ptr<std::function<void(nanodbc::call_span const&)>> handler;
+            {
+                std::lock_guard<std::mutex> guard(registry.span_mutex);
+                handler = registry.span_handler;
+            }
+            if (handler)
+                (*handler)(nanodbc::call_span{site.function, start, duration, rc});
+        }
+    }
+    catch (...)
+    {
+        // The call itself has completed and its caller is owed its return code; a block that
+        // could not be allocated or a handler that threw costs the call its statistics only.
+    }
+}
+} // namespace
+
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+namespace
+{
+// Every ODBC function nanodbc calls, by the name it is called by. The functions that have a W
+// variant are called by that name in Unicode builds, and some by both names.
+// clang-format off
+#define NANODBC_DRIVER_FUNCTIONS(X)                                                                \
+    X(SQLAllocHandle) X(SQLBindCol) X(SQLBindParameter) X(SQLCancel) X(SQLColAttribute)            \
+    X(SQLColumns) X(SQLConnect) X(SQLDataSources) X(SQLDescribeCol) X(SQLDescribeParam)            \
+    X(SQLDisconnect) X(SQLDriverConnect) X(SQLDrivers) X(SQLEndTran) X(SQLExecDirect)              \
+    X(SQLExecute) X(SQLFetch) X(SQLFetchScroll) X(SQLFreeHandle) X(SQLFreeStmt)                    \
+    X(SQLGetConnectAttr) X(SQLGetData) X(SQLGetDescField) X(SQLGetDiagField) X(SQLGetDiagRec)      \
+    X(SQLGetInfo) X(SQLGetStmtAttr) X(SQLMoreResults) X(SQLNumParams) X(SQLNumResultCols)          \
+    X(SQLPrepare) X(SQLPrimaryKeys) X(SQLProcedureColumns) X(SQLProcedures) X(SQLRowCount)         \
+    X(SQLSetConnectAttr) X(SQLSetEnvAttr) X(SQLSetPos) X(SQLSetStmtAttr) X(SQLStatistics)          \
+    X(SQLTablePrivileges) X(SQLTables)
+#if defined(NANODBC_ENABLE_UNICODE)
+#define NANODBC_DRIVER_WIDE_FUNCTIONS(X)                                                           \
+    X(SQLColAttributeW) X(SQLColumnsW) X(SQLConnectW) X(SQLDataSourcesW) X(SQLDescribeColW)        \
+    X(SQLDriverConnectW) X(SQLDriversW) X(SQLExecDirectW) X(SQLGetConnectAttrW)                    \
+    X(SQLGetDescFieldW) X(SQLGetDiagFieldW) X(SQLGetDiagRecW) X(SQLGetInfoW) X(SQLGetStmtAttrW)    \
+    X(SQLPrepareW) X(SQLPrimaryKeysW) X(SQLProcedureColumnsW) X(SQLProceduresW)                    \
+    X(SQLSetStmtAttrW) X(SQLStatisticsW) X(SQLTablePrivilegesW) X(SQLTablesW)
+#else
+#define NANODBC_DRIVER_WIDE_FUNCTIONS(X)
+#endif
+#if !defined(NANODBC_DISABLE_ASYNC) &&                                                             \
+    (defined(SQL_ATTR_ASYNC_DBC_EVENT) || defined(SQL_API_SQLCOMPLETEASYNC))
+#define NANODBC_DRIVER_ASYNC_FUNCTIONS(X) X(SQLCompleteAsync)
 #else
-#define NANODBC_CALL_RC(FUNC, RC, ...) RC = FUNC(__VA_ARGS__)
-#define NANODBC_CALL(FUNC, ...) FUNC(__VA_ARGS__)
+#define NANODBC_DRIVER_ASYNC_FUNCTIONS(X)
+#endif
+// clang-format on
+
+// The entry points of a directly linked driver, named after the functions they stand in for so
+// that NANODBC_DRIVER_FUNCTION can select one by the name a call site uses.
+struct driver_functions
+{
+#define NANODBC_DRIVER_MEMBER(f) decltype(&::f) f = nullptr;
+    NANODBC_DRIVER_FUNCTIONS(NANODBC_DRIVER_MEMBER)
+    NANODBC_DRIVER_WIDE_FUNCTIONS(NANODBC_DRIVER_MEMBER)
+    NANODBC_DRIVER_ASYNC_FUNCTIONS(NANODBC_DRIVER_MEMBER)
+#undef NANODBC_DRIVER_MEMBER
+
+    std::string path;
+};
+
+// Set once, never reset: the handles nanodbc holds belong to the driver they were allocated by.
+std::atomic<driver_functions const*> linked_functions{nullptr};
+
+// The environment handles allocated, which must all belong to the driver manager for a driver to
+// be linked.
+std::atomic<long> live_environments{0};
+
+// Stands in for a function the driver does not export, failing the way a driver manager does.
+template <class... Params>
+SQLRETURN SQL_API unsupported_driver_function(Params...)
+{
+    return SQL_ERROR;
+}
+
+template <class... Params>
+bool resolve_driver_function(void* library, char const* name, SQLRETURN(SQL_API*& f)(Params...))
+{
+    if (void* symbol = dlsym(library, name))
+    {
+        f = reinterpret_cast<SQLRETURN(SQL_API*)(Params...)>(symbol);
+        return true;
+    }
+    f = &unsupported_driver_function<Params...>;
+    return false;
+}
+} // namespace
 #endif
 
 // clang-format off
@@ -966,60 +1296,323 @@ public:
     bool bound_;
 };
 
+// Two decimal digits for each value below 100, so integers are written a pair at a time.
+char const digit_pairs[201] = "00010203040506070809"
+                              "10111213141516171819"
+                              "20212223242526272829"
+                              "30313233343536373839"
+                              "40414243444546474849"
+                              "50515253545556575859"
+                              "60616263646566676869"
+                              "70717273747576777879"
+                              "80818283848586878889"
+                              "90919293949596979899";
+
+// Writes the decimal digits of value backwards, ending at end, and returns where they begin.
+inline char* format_digits(unsigned long long value, char* end) noexcept
+{
+    while (value >= 100)
+    {
+        auto const pair = static_cast<std::size_t>(value % 100) * 2;
+        value /= 100;
+        *--end = digit_pairs[pair + 1];
+        *--end = digit_pairs[pair];
+    }
+    if (value >= 10)
+    {
+        auto const pair = static_cast<std::size_t>(value) * 2;
+        *--end = digit_pairs[pair + 1];
+        *--end = digit_pairs[pair];
+    }
+    else
+    {
+        *--end = static_cast<char>('0' + value);
+    }
+    return end;
+}
+
+// The longest integer, with its sign.
+constexpr std::size_t max_integer_size = 21;
+
+template <class T>
+char* format_integer(char* out, T value) noexcept
+{
+    char digits[max_integer_size];
+    char* const end = digits + sizeof(digits);
+    // Negating the most negative value is undefined, so the digits come from an unsigned copy.
+    auto magnitude = static_cast<unsigned long long>(value);
+    if (value < 0)
+    {
+        *out++ = '-';
+        magnitude = 0ULL - magnitude;
+    }
+    char* const begin = format_digits(magnitude, end);
+    std::memcpy(out, begin, static_cast<std::size_t>(end - begin));
+    return out + (end - begin);
+}
+
 // Renders value as decimal digits, zero padded to at least width, keeping a minus sign in
-// front of the padding. Wider values keep all their digits rather than being truncated.
-inline std::string zero_padded(long value, std::size_t width)
+// front of the padding. Wider values keep all their digits rather than being truncated, as
+// fields of a driver-filled struct are not assumed to be in range.
+inline char* format_padded(char* out, long value, std::size_t width) noexcept
 {
-    // Negating the most negative value is undefined, so the digits come from an unsigned
-    // copy. Fields of a driver-filled struct are not assumed to be in range.
+    char digits[max_integer_size];
+    char* const end = digits + sizeof(digits);
     auto const magnitude =
         value < 0 ? 0UL - static_cast<unsigned long>(value) : static_cast<unsigned long>(value);
-    std::string const sign = value < 0 ? "-" : "";
-    auto digits = std::to_string(magnitude);
-    if (sign.size() + digits.size() < width)
-        digits.insert(0, width - sign.size() - digits.size(), '0');
-    return sign + digits;
+    char* const begin = format_digits(magnitude, end);
+    auto size = static_cast<std::size_t>(end - begin);
+    if (value < 0)
+    {
+        *out++ = '-';
+        ++size;
+    }
+    for (; size < width; ++size)
+        *out++ = '0';
+    std::memcpy(out, begin, static_cast<std::size_t>(end - begin));
+    return out + (end - begin);
 }
 
-// Renders a timestampoffset as a backend renders datetimeoffset, for example
-// "2006-12-30 13:45:12.3450000 -08:00". The struct counts fractional seconds in billionths;
-// scale says how many of those digits the column carries.
-inline std::string
-timestampoffset_as_string(nanodbc::timestampoffset const& value, SQLSMALLINT scale)
+// Room for the longest text the temporal formatters below write, a timestampoffset whose
+// fields are all out of range.
+constexpr std::size_t max_temporal_size = 80;
+
+inline char* format_date(char* out, long year, long month, long day) noexcept
 {
-    auto const& stamp = value.stamp;
+    out = format_padded(out, year, 4);
+    *out++ = '-';
+    out = format_padded(out, month, 2);
+    *out++ = '-';
+    return format_padded(out, day, 2);
+}
 
-    auto result = zero_padded(stamp.year, 4);
-    result += '-';
-    result += zero_padded(stamp.month, 2);
-    result += '-';
-    result += zero_padded(stamp.day, 2);
-    result += ' ';
-    result += zero_padded(stamp.hour, 2);
-    result += ':';
-    result += zero_padded(stamp.min, 2);
-    result += ':';
-    result += zero_padded(stamp.sec, 2);
+inline char* format_time(char* out, long hour, long minute, long second) noexcept
+{
+    out = format_padded(out, hour, 2);
+    *out++ = ':';
+    out = format_padded(out, minute, 2);
+    *out++ = ':';
+    return format_padded(out, second, 2);
+}
 
+// The struct counts fractional seconds in billionths; scale says how many of those digits the
+// column carries.
+inline char*
+format_timestamp(char* out, nanodbc::timestamp const& stamp, SQLSMALLINT scale) noexcept
+{
+    out = format_date(out, stamp.year, stamp.month, stamp.day);
+    *out++ = ' ';
+    out = format_time(out, stamp.hour, stamp.min, stamp.sec);
     if (scale > 0 && scale <= 9)
     {
         // Narrow the billionths down to the digits the column carries.
         long divisor = 1;
         for (SQLSMALLINT i = scale; i < 9; ++i)
             divisor *= 10;
-        result += '.';
-        result += zero_padded(stamp.fract / divisor, static_cast<std::size_t>(scale));
+        *out++ = '.';
+        out = format_padded(out, stamp.fract / divisor, static_cast<std::size_t>(scale));
     }
+    return out;
+}
 
+// As a backend renders datetimeoffset, for example "2006-12-30 13:45:12.3450000 -08:00".
+inline char* format_timestampoffset(
+    char* out,
+    nanodbc::timestampoffset const& value,
+    SQLSMALLINT scale) noexcept
+{
+    out = format_timestamp(out, value.stamp, scale);
     // Both offset fields carry the sign, so either one being negative means the whole
     // offset is behind UTC.
     bool const behind_utc = value.offset_hour < 0 || value.offset_minute < 0;
-    result += behind_utc ? " -" : " +";
-    result += zero_padded(std::abs(static_cast<int>(value.offset_hour)), 2);
-    result += ':';
-    result += zero_padded(std::abs(static_cast<int>(value.offset_minute)), 2);
+    *out++ = ' ';
+    *out++ = behind_utc ? '-' : '+';
+    out = format_padded(out, std::abs(static_cast<int>(value.offset_hour)), 2);
+    *out++ = ':';
+    return format_padded(out, std::abs(static_cast<int>(value.offset_minute)), 2);
+}
 
-    return result;
+inline std::string
+timestampoffset_as_string(nanodbc::timestampoffset const& value, SQLSMALLINT scale)
+{
+    char text[max_temporal_size];
+    return std::string(text, format_timestampoffset(text, value, scale));
+}
+
+inline std::string date_as_string(nanodbc::date const& d)
+{
+    char text[max_temporal_size];
+    return std::string(text, format_date(text, d.year, d.month, d.day));
+}
+
+inline std::string time_as_string(nanodbc::time const& t)
+{
+    char text[max_temporal_size];
+    return std::string(text, format_time(text, t.hour, t.min, t.sec));
+}
+
+// As get<string>() of a timestamp column has always rendered it on POSIX systems, where strftime's
+// "%Y-%m-%d %H:%M:%S %z" gave a time that carries no offset as UTC. Windows' strftime gave the
+// local offset instead, which the value does not carry, so there too it is now "+0000".
+inline std::string timestamp_as_string(nanodbc::timestamp const& stamp)
+{
+    char text[max_temporal_size];
+    char* end = format_timestamp(text, stamp, 0);
+    static char const utc[] = " +0000";
+    std::memcpy(end, utc, sizeof(utc) - 1);
+    end += sizeof(utc) - 1;
+    return std::string(text, end);
+}
+
+// A date, a time, or both, with an offset if the text had one.
+struct parsed_temporal
+{
+    nanodbc::timestampoffset value{};
+    bool has_date = false;
+    bool has_time = false;
+};
+
+// Reads a field of exactly count digits.
+inline bool parse_digits(char const*& p, char const* end, int count, long& value) noexcept
+{
+    if (end - p < count)
+        return false;
+    value = 0;
+    for (int i = 0; i < count; ++i, ++p)
+    {
+        if (*p < '0' || *p > '9')
+            return false;
+        value = value * 10 + (*p - '0');
+    }
+    return true;
+}
+
+inline bool parse_char(char const*& p, char const* end, char c) noexcept
+{
+    if (p == end || *p != c)
+        return false;
+    ++p;
+    return true;
+}
+
+// Whether the day is in the month, February having 29 days in a Gregorian leap year.
+inline bool valid_date(long year, long month, long day) noexcept
+{
+    static int const days_in_month[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month < 1 || month > 12 || day < 1)
+        return false;
+    bool const leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return day <= days_in_month[month - 1] + (month == 2 && leap ? 1 : 0);
+}
+
+// Parses a date, a time, or a date and time, as ISO 8601 and SQL Server render them: for
+// example "2006-12-30", "13:45:12", "2006-12-30 13:45:12.345" and
+// "2006-12-30T13:45:12.3450000 -08:00". Date and time may be separated by a space or a "T", an
+// offset may follow the time with or without a space, "Z" standing for UTC, and fractional
+// digits past the ninth are dropped. Blanks around the text, as CHAR columns pad with, are
+// ignored. Anything else, including fields out of range, has neither date nor time.
+inline parsed_temporal parse_temporal(char const* p, char const* end) noexcept
+{
+    while (p != end && *p == ' ')
+        ++p;
+    while (p != end && end[-1] == ' ')
+        --end;
+
+    parsed_temporal parsed;
+    auto& stamp = parsed.value.stamp;
+    long year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    bool const time_only = end - p >= 3 && p[2] == ':';
+    if (!time_only)
+    {
+        if (!parse_digits(p, end, 4, year) || !parse_char(p, end, '-') ||
+            !parse_digits(p, end, 2, month) || !parse_char(p, end, '-') ||
+            !parse_digits(p, end, 2, day) || !valid_date(year, month, day))
+            return {};
+        stamp.year = static_cast<std::int16_t>(year);
+        stamp.month = static_cast<std::int16_t>(month);
+        stamp.day = static_cast<std::int16_t>(day);
+        if (p == end)
+        {
+            parsed.has_date = true;
+            return parsed;
+        }
+        if (!parse_char(p, end, ' ') && !parse_char(p, end, 'T'))
+            return {};
+    }
+
+    if (!parse_digits(p, end, 2, hour) || !parse_char(p, end, ':') ||
+        !parse_digits(p, end, 2, minute) || !parse_char(p, end, ':') ||
+        !parse_digits(p, end, 2, second) || hour > 23 || minute > 59 || second > 60)
+        return {};
+    stamp.hour = static_cast<std::int16_t>(hour);
+    stamp.min = static_cast<std::int16_t>(minute);
+    stamp.sec = static_cast<std::int16_t>(second);
+    if (parse_char(p, end, '.'))
+    {
+        std::int32_t fract = 0;
+        int digits = 0;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p, ++digits)
+        {
+            if (digits < 9)
+                fract = fract * 10 + (*p - '0');
+        }
+        if (digits == 0)
+            return {};
+        for (; digits < 9; ++digits)
+            fract *= 10;
+        stamp.fract = fract;
+    }
+
+    if (!time_only)
+    {
+        parse_char(p, end, ' ');
+        if (!parse_char(p, end, 'Z') && p != end)
+        {
+            bool const behind_utc = *p == '-';
+            long offset_hour = 0, offset_minute = 0;
+            if ((!parse_char(p, end, '+') && !parse_char(p, end, '-')) ||
+                !parse_digits(p, end, 2, offset_hour))
+                return {};
+            parse_char(p, end, ':');
+            if (!parse_digits(p, end, 2, offset_minute) || offset_hour > 14 || offset_minute > 59)
+                return {};
+            parsed.value.offset_hour =
+                static_cast<std::int16_t>(behind_utc ? -offset_hour : offset_hour);
+            parsed.value.offset_minute =
+                static_cast<std::int16_t>(behind_utc ? -offset_minute : offset_minute);
+        }
+    }
+    if (p != end)
+        return {};
+    parsed.has_date = !time_only;
+    parsed.has_time = true;
+    return parsed;
+}
+
+// Parses wide text by narrowing it first, which loses nothing of the ASCII a date or time is
+// written in.
+template <class Unit>
+parsed_temporal parse_temporal(Unit const* units, std::size_t count) noexcept
+{
+    typedef typename std::make_unsigned<Unit>::type unsigned_unit;
+    while (count != 0 && units[count - 1] == static_cast<Unit>(' '))
+        --count;
+    char text[max_temporal_size];
+    if (count > sizeof(text))
+        return {};
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto const code = static_cast<unsigned_unit>(units[i]);
+        if (code >= 0x80)
+            return {};
+        text[i] = static_cast<char>(code);
+    }
+    return parse_temporal(text, text + count);
+}
+
+inline parsed_temporal parse_temporal(char const* text, std::size_t size) noexcept
+{
+    return parse_temporal(text, text + size);
 }
 
 // Encapsulates properties of statement parameter.
@@ -1067,6 +1660,24 @@ struct bound_buffer
     SQLSMALLINT ctype_ = sql_ctype<T>::value;
 };
 
+// Maps a row's SQL_ATTR_PARAM_STATUS_PTR entry to the status reported to callers.
+inline nanodbc::statement::param_status to_param_status(SQLUSMALLINT status) noexcept
+{
+    switch (status)
+    {
+    case SQL_PARAM_SUCCESS:
+        return nanodbc::statement::PARAM_SUCCESS;
+    case SQL_PARAM_SUCCESS_WITH_INFO:
+        return nanodbc::statement::PARAM_SUCCESS_WITH_INFO;
+    case SQL_PARAM_ERROR:
+        return nanodbc::statement::PARAM_ERROR;
+    case SQL_PARAM_UNUSED:
+        return nanodbc::statement::PARAM_UNUSED;
+    default:
+        return nanodbc::statement::PARAM_DIAG_UNAVAILABLE;
+    }
+}
+
 inline void deallocate_handle(SQLHANDLE& handle, short handle_type)
 {
     if (!handle)
@@ -1077,6 +1688,10 @@ inline void deallocate_handle(SQLHANDLE& handle, short handle_type)
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(handle, handle_type);
     handle = nullptr;
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+    if (handle_type == SQL_HANDLE_ENV)
+        live_environments.fetch_sub(1, std::memory_order_relaxed);
+#endif
 }
 
 inline void allocate_env_handle(SQLHENV& env)
@@ -1088,6 +1703,9 @@ inline void allocate_env_handle(SQLHENV& env)
     NANODBC_CALL_RC(SQLAllocHandle, rc, SQL_HANDLE_ENV, SQL_NULL_HANDLE, &env);
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(env, SQL_HANDLE_ENV);
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+    live_environments.fetch_add(1, std::memory_order_relaxed);
+#endif
 
     try
     {
@@ -1549,6 +2167,14 @@ public:
                 NANODBC_THROW_DATABASE_ERROR(dbc_, SQL_HANDLE_DBC);
         }
         connected_ = false;
+
+        // The next connection may be to another driver.
+        {
+            std::lock_guard<std::mutex> guard(profile_mutex_);
+            if (!profile_set_)
+                profile_.reset();
+        }
+        invalidate_metadata();
     }
 
     std::size_t transactions() const noexcept { return transactions_; }
@@ -1560,7 +2186,16 @@ public:
     template <class T>
     T get_info(short info_type) const
     {
-        return get_info_impl<T>(info_type);
+        // The current database can change with a statement, so it is always asked for.
+        if (info_type == SQL_DATABASE_NAME)
+            return get_info_impl<T>(info_type);
+        T value;
+        if (!cached_info(info_type, value))
+        {
+            value = get_info_impl<T>(info_type);
+            cache_info(info_type, value);
+        }
+        return value;
     }
     string dbms_name() const;
 
@@ -1603,47 +2238,261 @@ public:
 
     void rollback(bool onoff) noexcept { rollback_ = onoff; }
 
-private:
-    template <class T, typename std::enable_if<!is_string<T>::value, int>::type = 0>
-    T get_info_impl(short info_type) const;
+    void cache_parameter_descriptions(bool enable)
+    {
+        std::lock_guard<std::mutex> guard(parameter_cache_mutex_);
+        caches_parameters_.store(enable, std::memory_order_relaxed);
+        if (!enable)
+            parameter_cache_.clear();
+    }
 
-    template <class T, typename std::enable_if<is_string<T>::value, int>::type = 0>
-    T get_info_impl(short info_type) const;
+    bool caches_parameter_descriptions() const noexcept
+    {
+        return caches_parameters_.load(std::memory_order_relaxed);
+    }
 
-    HENV env_;
-    HDBC dbc_;
-    bool connected_;
-    std::size_t transactions_;
-    bool rollback_; // if true, this connection is marked for eventual transaction rollback
-};
+    void clear_parameter_descriptions()
+    {
+        std::lock_guard<std::mutex> guard(parameter_cache_mutex_);
+        parameter_cache_.clear();
+    }
 
-template <class T, typename std::enable_if<!is_string<T>::value, int>::type>
-T connection::connection_impl::get_info_impl(short info_type) const
-{
-    T value = 0;
-    RETCODE rc = SQL_SUCCESS;
-    NANODBC_CALL_RC(NANODBC_FUNC(SQLGetInfo), rc, dbc_, info_type, &value, 0, nullptr);
-    if (!success(rc))
-        NANODBC_THROW_DATABASE_ERROR(dbc_, SQL_HANDLE_DBC);
-    return value;
-}
+    // Copies the description cached for a parameter of query, returning false if there is none.
+    bool cached_parameter_description(
+        string const& query,
+        short param_index,
+        bound_parameter& description) const
+    {
+        std::lock_guard<std::mutex> guard(parameter_cache_mutex_);
+        auto const cached = parameter_cache_.find(query);
+        if (cached == parameter_cache_.end())
+            return false;
+        auto const param = cached->second.find(param_index);
+        if (param == cached->second.end())
+            return false;
+        description = param->second;
+        return true;
+    }
 
-template <class T, typename std::enable_if<is_string<T>::value, int>::type>
-T connection::connection_impl::get_info_impl(short info_type) const
-{
-    NANODBC_SQLCHAR value[1024] = {0};
-    SQLSMALLINT length(0);
-    RETCODE rc = SQL_SUCCESS;
-    NANODBC_CALL_RC(
-        NANODBC_FUNC(SQLGetInfo),
-        rc,
-        dbc_,
-        info_type,
-        value,
-        sizeof(value) / sizeof(NANODBC_SQLCHAR),
-        &length);
-    if (!success(rc))
-        NANODBC_THROW_DATABASE_ERROR(dbc_, SQL_HANDLE_DBC);
+    void cache_parameter_description(
+        string const& query,
+        short param_index,
+        bound_parameter const& description)
+    {
+        std::lock_guard<std::mutex> guard(parameter_cache_mutex_);
+        if (caches_parameters_.load(std::memory_order_relaxed))
+            parameter_cache_[query][param_index] = description;
+    }
+
+    driver_profile profile() const
+    {
+        std::lock_guard<std::mutex> guard(profile_mutex_);
+        if (!profile_)
+            profile_ = std::make_unique<driver_profile>(probe_profile());
+        return *profile_;
+    }
+
+    void set_profile(driver_profile const& profile)
+    {
+        std::lock_guard<std::mutex> guard(profile_mutex_);
+        profile_ = std::make_unique<driver_profile>(profile);
+        profile_set_ = true;
+    }
+
+    void reset_profile()
+    {
+        std::lock_guard<std::mutex> guard(profile_mutex_);
+        profile_.reset();
+        profile_set_ = false;
+    }
+
+    void cache_metadata(std::chrono::seconds ttl)
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        metadata_ttl_ = std::max(ttl, std::chrono::seconds::zero());
+        if (metadata_ttl_ == std::chrono::seconds::zero())
+            metadata_cache_.clear();
+    }
+
+    std::chrono::seconds metadata_ttl() const
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        return metadata_ttl_;
+    }
+
+    void invalidate_metadata()
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        metadata_cache_.clear();
+        info_numbers_.clear();
+        info_strings_.clear();
+    }
+
+    void invalidate_metadata(string const& table, string const& schema, string const& catalog)
+    {
+        // An empty name or one with a wildcard was a pattern that may have matched the table.
+        auto const may_match = [](string const& cached, string const& name) {
+            return name.empty() || cached.empty() || cached == name ||
+                   cached.find_first_of(NANODBC_TEXT("%_")) != string::npos;
+        };
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        for (auto entry = metadata_cache_.begin(); entry != metadata_cache_.end();)
+        {
+            metadata_key const& key = entry->first;
+            if (may_match(std::get<1>(key), catalog) && may_match(std::get<2>(key), schema) &&
+                may_match(std::get<3>(key), table))
+                entry = metadata_cache_.erase(entry);
+            else
+                ++entry;
+        }
+    }
+
+    std::shared_ptr<void const> cached_metadata(
+        short lookup,
+        string const& catalog,
+        string const& schema,
+        string const& table,
+        string const& column)
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        auto const entry =
+            metadata_cache_.find(metadata_key(lookup, catalog, schema, table, column));
+        if (entry == metadata_cache_.end())
+            return nullptr;
+        if (std::chrono::steady_clock::now() >= entry->second.expires)
+        {
+            metadata_cache_.erase(entry);
+            return nullptr;
+        }
+        return entry->second.rows;
+    }
+
+    void cache_metadata(
+        short lookup,
+        string const& catalog,
+        string const& schema,
+        string const& table,
+        string const& column,
+        std::shared_ptr<void const> rows)
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        if (metadata_ttl_ == std::chrono::seconds::zero())
+            return;
+        metadata_entry& entry =
+            metadata_cache_[metadata_key(lookup, catalog, schema, table, column)];
+        entry.rows = std::move(rows);
+        entry.expires = std::chrono::steady_clock::now() + metadata_ttl_;
+    }
+
+private:
+    // A number SQLGetInfo returned, by info type, size and signedness of the type read into.
+    using info_key = std::tuple<short, std::size_t, bool>;
+
+    driver_profile probe_profile() const;
+
+    bool cached_info(short info_type, string& value) const
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        auto const found = info_strings_.find(info_type);
+        if (found == info_strings_.end())
+            return false;
+        value = found->second;
+        return true;
+    }
+
+    // Numbers are kept by size as well, since the driver writes as many bytes as it was asked,
+    // and by signedness, since the same bytes read as a signed type may be negative.
+    template <class T>
+    static info_key make_info_key(short info_type) noexcept
+    {
+        return info_key(info_type, sizeof(T), std::is_signed<T>::value);
+    }
+
+    template <class T>
+    bool cached_info(short info_type, T& value) const
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        auto const found = info_numbers_.find(make_info_key<T>(info_type));
+        if (found == info_numbers_.end())
+            return false;
+        value = static_cast<T>(found->second);
+        return true;
+    }
+
+    void cache_info(short info_type, string const& value) const
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        info_strings_[info_type] = value;
+    }
+
+    template <class T>
+    void cache_info(short info_type, T value) const
+    {
+        std::lock_guard<std::mutex> guard(metadata_mutex_);
+        info_numbers_[make_info_key<T>(info_type)] =
+            static_cast<unsigned long long>(value);
+    }
+
+    template <class T, typename std::enable_if<!is_string<T>::value, int>::type = 0>
+    T get_info_impl(short info_type) const;
+
+    template <class T, typename std::enable_if<is_string<T>::value, int>::type = 0>
+    T get_info_impl(short info_type) const;
+
+    HENV env_;
+    HDBC dbc_;
+    bool connected_;
+    std::size_t transactions_;
+    bool rollback_; // if true, this connection is marked for eventual transaction rollback
+    // Parameter descriptions reported by the driver, by the text of the query they belong to.
+    std::atomic<bool> caches_parameters_{false};
+    mutable std::mutex parameter_cache_mutex_;
+    std::map<string, std::map<short, bound_parameter>> parameter_cache_;
+    // The driver profile, probed on first use unless set.
+    mutable std::mutex profile_mutex_;
+    mutable std::unique_ptr<driver_profile> profile_;
+    bool profile_set_{false};
+    // SQLGetInfo values and catalog lookups, by lookup, catalog, schema, table and column.
+    using metadata_key = std::tuple<short, string, string, string, string>;
+    struct metadata_entry
+    {
+        std::shared_ptr<void const> rows;
+        std::chrono::steady_clock::time_point expires;
+    };
+    mutable std::mutex metadata_mutex_;
+    mutable std::map<info_key, unsigned long long> info_numbers_;
+    mutable std::map<short, string> info_strings_;
+    std::chrono::seconds metadata_ttl_{0};
+    std::map<metadata_key, metadata_entry> metadata_cache_;
+};
+
+template <class T, typename std::enable_if<!is_string<T>::value, int>::type>
+T connection::connection_impl::get_info_impl(short info_type) const
+{
+    T value = 0;
+    RETCODE rc = SQL_SUCCESS;
+    NANODBC_CALL_RC(NANODBC_FUNC(SQLGetInfo), rc, dbc_, info_type, &value, 0, nullptr);
+    if (!success(rc))
+        NANODBC_THROW_DATABASE_ERROR(dbc_, SQL_HANDLE_DBC);
+    return value;
+}
+
+template <class T, typename std::enable_if<is_string<T>::value, int>::type>
+T connection::connection_impl::get_info_impl(short info_type) const
+{
+    NANODBC_SQLCHAR value[1024] = {0};
+    SQLSMALLINT length(0);
+    RETCODE rc = SQL_SUCCESS;
+    NANODBC_CALL_RC(
+        NANODBC_FUNC(SQLGetInfo),
+        rc,
+        dbc_,
+        info_type,
+        value,
+        sizeof(value) / sizeof(NANODBC_SQLCHAR),
+        &length);
+    if (!success(rc))
+        NANODBC_THROW_DATABASE_ERROR(dbc_, SQL_HANDLE_DBC);
     return {&value[0], &value[size(value)]};
 }
 
@@ -1672,6 +2521,117 @@ string connection::connection_impl::database_name() const
     return get_info<string>(SQL_DATABASE_NAME);
 }
 
+namespace
+{
+
+// Limits of a DBMS on the shape of a multi-row INSERT. ODBC reports neither the number of
+// parameter markers a statement may have nor the number of rows a VALUES list may hold, so
+// they are known by name; anything else gets the defaults of driver_profile.
+struct insert_limits
+{
+    char const* dbms;
+    std::size_t parameters;
+    std::size_t rows;
+};
+
+insert_limits const known_insert_limits[] = {
+    {"Microsoft SQL Server", 2000, 1000}, // 2100 markers, less a margin for sp_prepexec
+    {"PostgreSQL", 65535, 1000},
+    {"MySQL", 65535, 1000},
+    {"MariaDB", 65535, 1000},
+    {"Oracle", 65535, 1}, // no VALUES lists before 23ai
+    {"SQLite", 999, 1000},
+};
+
+} // namespace
+
+driver_profile connection::connection_impl::probe_profile() const
+{
+    driver_profile profile;
+    profile.driver_name = driver_name();
+    profile.driver_version = driver_version();
+    profile.dbms_name = dbms_name();
+    profile.dbms_version = dbms_version();
+
+    // Not every driver reports every value, and those missing are zero.
+    auto const info = [this](short info_type) -> std::uint32_t {
+        try
+        {
+            return get_info<SQLUINTEGER>(info_type);
+        }
+        catch (database_error const&)
+        {
+            return 0;
+        }
+    };
+    profile.param_array_row_counts = info(SQL_PARAM_ARRAY_ROW_COUNTS);
+    profile.batch_support = info(SQL_BATCH_SUPPORT);
+    profile.scroll_options = info(SQL_SCROLL_OPTIONS);
+    try
+    {
+        profile.getdata_extensions = get_info<SQLUINTEGER>(SQL_GETDATA_EXTENSIONS);
+        profile.getdata_extensions_reported = true;
+    }
+    catch (database_error const&)
+    {
+    }
+
+    // These drivers accept parameter arrays but execute the statement once per row; their
+    // library names are sqlite3odbc, myodbc and maodbc, with prefixes and suffixes by platform.
+    std::string driver;
+    convert(profile.driver_name, driver);
+    std::transform(driver.begin(), driver.end(), driver.begin(), [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+    bool const by_row = driver.find("sqlite") != std::string::npos ||
+                        driver.find("myodbc") != std::string::npos ||
+                        driver.find("maodbc") != std::string::npos;
+    profile.native_parameter_arrays = profile.param_array_row_counts != 0 && !by_row;
+
+    std::string dbms;
+    convert(profile.dbms_name, dbms);
+    for (auto const& limits : known_insert_limits)
+    {
+        if (dbms.compare(0, std::strlen(limits.dbms), limits.dbms) == 0)
+        {
+            profile.max_parameters = limits.parameters;
+            profile.max_insert_rows = limits.rows;
+            break;
+        }
+    }
+
+    profile.rows_per_fetch = 1000;
+    return profile;
+}
+
+std::string to_string(driver_profile const& profile)
+{
+    auto const text = [](string const& value) {
+        std::string converted;
+        convert(value, converted);
+        return converted;
+    };
+    auto const hex = [](std::uint32_t value) {
+        char buffer[16];
+        std::snprintf(buffer, sizeof(buffer), "0x%08x", static_cast<unsigned int>(value));
+        return std::string(buffer);
+    };
+    return "driver_name: " + text(profile.driver_name) + "\n" +
+           "driver_version: " + text(profile.driver_version) + "\n" +
+           "dbms_name: " + text(profile.dbms_name) + "\n" +
+           "dbms_version: " + text(profile.dbms_version) + "\n" +
+           "param_array_row_counts: " + std::to_string(profile.param_array_row_counts) + "\n" +
+           "batch_support: " + hex(profile.batch_support) + "\n" +
+           "scroll_options: " + hex(profile.scroll_options) + "\n" +
+           "getdata_extensions: " +
+           (profile.getdata_extensions_reported ? hex(profile.getdata_extensions) : "unknown") +
+           "\n" +
+           "native_parameter_arrays: " + (profile.native_parameter_arrays ? "true" : "false") +
+           "\n" + "rows_per_fetch: " + std::to_string(profile.rows_per_fetch) + "\n" +
+           "max_parameters: " + std::to_string(profile.max_parameters) + "\n" +
+           "max_insert_rows: " + std::to_string(profile.max_insert_rows) + "\n";
+}
+
 template string connection::get_info(short info_type) const;
 
 // SQLUSMALLINT, SQLUINTEGER and SQLULEN name different underlying types per platform, and
@@ -1826,7 +2786,6 @@ public:
         : stmt_(nullptr)
         , open_(false)
         , conn_()
-        , bind_len_or_null_()
 #if defined(NANODBC_DO_ASYNC_IMPL)
         , async_(false)
         , async_enabled_(false)
@@ -1843,10 +2802,6 @@ public:
         : stmt_(nullptr)
         , open_(false)
         , conn_()
-        , bind_len_or_null_()
-        , wide_string_data_()
-        , string_data_()
-        , binary_data_()
 #if defined(NANODBC_DO_ASYNC_IMPL)
         , async_(false)
         , async_enabled_(false)
@@ -1864,10 +2819,6 @@ public:
         : stmt_(nullptr)
         , open_(false)
         , conn_()
-        , bind_len_or_null_()
-        , wide_string_data_()
-        , string_data_()
-        , binary_data_()
 #if defined(NANODBC_DO_ASYNC_IMPL)
         , async_(false)
         , async_enabled_(false)
@@ -1885,10 +2836,6 @@ public:
         : stmt_(nullptr)
         , open_(false)
         , conn_()
-        , bind_len_or_null_()
-        , wide_string_data_()
-        , string_data_()
-        , binary_data_()
 #if defined(NANODBC_DO_ASYNC_IMPL)
         , async_(false)
         , async_enabled_(false)
@@ -1954,6 +2901,8 @@ public:
 
     bool open() const noexcept { return open_; }
 
+    bool prepared() const noexcept { return prepared_; }
+
     bool connected() const noexcept { return conn_.connected(); }
 
     const class connection& connection() const noexcept { return conn_; }
@@ -1980,7 +2929,10 @@ public:
         }
 
         open_ = false;
+        prepared_ = false;
         stmt_ = nullptr;
+        param_status_.clear();
+        param_status_bound_ = 0;
     }
 
 #ifndef NANODBC_DISABLE_MSSQL_TVP
@@ -1998,7 +2950,7 @@ public:
             throw programming_error("invalid tvp param type");
 
         tvp_data_.emplace(std::make_pair(param_index, tvp));
-        *bind_len_or_null = &bind_len_or_null_[param_index];
+        *bind_len_or_null = &params_[param_index].indicators;
         open_tvp_ = true;
     }
 
@@ -2037,6 +2989,7 @@ public:
 #endif
 
         RETCODE rc = SQL_SUCCESS;
+        prepared_ = false;
         NANODBC_CALL_RC(
             NANODBC_FUNC(SQLPrepare),
             rc,
@@ -2045,6 +2998,12 @@ public:
             (SQLINTEGER)query.size());
         if (!success(rc) && rc != SQL_STILL_EXECUTING)
             NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
+        prepared_ = true;
+
+        params_sized_ = false;
+        caches_parameters_ = conn_.impl_->caches_parameter_descriptions();
+        if (caches_parameters_)
+            prepared_query_ = query;
 
         this->timeout(timeout);
 
@@ -2223,6 +3182,7 @@ public:
         void* event_handle = nullptr)
     {
         open(conn);
+        prepared_ = false;
 
 #if defined(NANODBC_DO_ASYNC_IMPL)
         if (event_handle == nullptr)
@@ -2232,6 +3192,8 @@ public:
 #endif
 
         RETCODE rc = SQL_SUCCESS;
+        long const batch_operations =
+            array_sizes.parameter_array_length > 0 ? array_sizes.parameter_array_length : 1;
         if (array_sizes.parameter_array_length > 0)
         {
             NANODBC_CALL_RC(
@@ -2244,11 +3206,15 @@ public:
             if (!success(rc))
                 NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
         }
+        prepare_param_status(batch_operations);
 
         this->timeout(timeout);
+        refresh_bound_references();
 
         NANODBC_CALL_RC(
             NANODBC_FUNC(SQLExecDirect), rc, stmt_, (NANODBC_SQLCHAR*)query.c_str(), SQL_NTS);
+        if (batch_operations > 1 && (rc == SQL_ERROR || rc == SQL_SUCCESS_WITH_INFO))
+            collect_param_diagnostics();
         if (!success(rc) && rc != SQL_NO_DATA && rc != SQL_STILL_EXECUTING)
             NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
 
@@ -2306,10 +3272,14 @@ public:
             0);
         if (!success(rc) && rc != SQL_NO_DATA)
             NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
+        prepare_param_status(batch_operations);
 
         this->timeout(timeout);
+        refresh_bound_references();
 
         NANODBC_CALL_RC(SQLExecute, rc, stmt_);
+        if (batch_operations > 1 && (rc == SQL_ERROR || rc == SQL_SUCCESS_WITH_INFO))
+            collect_param_diagnostics();
         if (!success(rc) && rc != SQL_NO_DATA && rc != SQL_STILL_EXECUTING)
             NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
 
@@ -2378,8 +3348,27 @@ public:
 
     void reset_parameters() noexcept
     {
-        param_descr_data_.clear();
+        for (auto& state : params_)
+            state.described = false;
+        unbind_parameters();
+    }
+
+    // Unbinds every parameter, and goes back to binding them column-wise after bind_rows().
+    void unbind_parameters() noexcept
+    {
+        for (auto& state : params_)
+            state.refresh = nullptr;
         NANODBC_CALL(SQLFreeStmt, stmt_, SQL_RESET_PARAMS);
+        if (rows_bound_)
+        {
+            NANODBC_CALL(
+                SQLSetStmtAttr,
+                stmt_,
+                SQL_ATTR_PARAM_BIND_TYPE,
+                (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN,
+                SQL_IS_UINTEGER);
+            rows_bound_ = false;
+        }
     }
 
     short parameters() const
@@ -2399,13 +3388,10 @@ public:
 
     unsigned long parameter_size(short param_index)
     {
-        if (param_descr_data_.count(param_index))
-        {
-            return static_cast<unsigned long>(param_descr_data_.at(param_index).size_);
-        }
-
-        describe_parameters(param_index);
-        const SQLULEN& param_size = param_descr_data_.at(param_index).size_;
+        auto const& state = parameter_state(param_index);
+        if (!state.described)
+            describe_parameters(param_index);
+        const SQLULEN& param_size = state.description.size_;
         NANODBC_ASSERT(
             param_size < static_cast<SQLULEN>(std::numeric_limits<unsigned long>::max()));
         return static_cast<unsigned long>(param_size);
@@ -2413,26 +3399,117 @@ public:
 
     short parameter_scale(short param_index)
     {
-        if (param_descr_data_.count(param_index))
-        {
-            return static_cast<short>(param_descr_data_.at(param_index).scale_);
-        }
-
-        describe_parameters(param_index);
-        const SQLSMALLINT& param_scale = param_descr_data_.at(param_index).scale_;
+        auto const& state = parameter_state(param_index);
+        if (!state.described)
+            describe_parameters(param_index);
+        const SQLSMALLINT& param_scale = state.description.scale_;
         return static_cast<short>(param_scale);
     }
 
     short parameter_type(short param_index)
     {
-        if (param_descr_data_.count(param_index))
+        auto const& state = parameter_state(param_index);
+        if (!state.described)
+            describe_parameters(param_index);
+        const SQLSMALLINT& param_type = state.description.type_;
+        return static_cast<short>(param_type);
+    }
+
+    std::vector<param_status> parameter_status() const
+    {
+        std::vector<param_status> status;
+        status.reserve(param_status_rows_);
+        for (std::size_t i = 0; i < param_status_rows_; ++i)
+            status.push_back(to_param_status(param_status_[i]));
+        return status;
+    }
+
+    unsigned long parameters_processed() const noexcept
+    {
+        return static_cast<unsigned long>(params_processed_);
+    }
+
+    std::vector<param_diagnostic> const& parameter_diagnostics() const noexcept
+    {
+        return param_diagnostics_;
+    }
+
+    // Binds the row status array and processed count once per statement handle, again only
+    // when a larger parameter array outgrows them.
+    void prepare_param_status(long batch_operations)
+    {
+        auto const rows = static_cast<std::size_t>(batch_operations > 0 ? batch_operations : 1);
+        if (rows > param_status_bound_)
         {
-            return static_cast<short>(param_descr_data_.at(param_index).type_);
+            param_status_.resize(rows);
+            RETCODE rc = SQL_SUCCESS;
+            NANODBC_CALL_RC(
+                SQLSetStmtAttr, rc, stmt_, SQL_ATTR_PARAM_STATUS_PTR, param_status_.data(), 0);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
+            NANODBC_CALL_RC(
+                SQLSetStmtAttr, rc, stmt_, SQL_ATTR_PARAMS_PROCESSED_PTR, &params_processed_, 0);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
+            param_status_bound_ = rows;
         }
+        std::fill_n(param_status_.begin(), rows, static_cast<SQLUSMALLINT>(SQL_PARAM_UNUSED));
+        param_status_rows_ = rows;
+        params_processed_ = 0;
+        param_diagnostics_.clear();
+    }
 
-        describe_parameters(param_index);
-        const SQLSMALLINT& param_type = param_descr_data_.at(param_index).type_;
-        return static_cast<short>(param_type);
+    // Reads every diagnostic record of the last execution along with the parameter row it
+    // concerns. Done before any other call on the statement, which would discard them.
+    void collect_param_diagnostics()
+    {
+        std::vector<NANODBC_SQLCHAR> sql_message(SQL_MAX_MESSAGE_LENGTH);
+        for (SQLSMALLINT record = 1;; ++record)
+        {
+            NANODBC_SQLCHAR sql_state[6] = {0};
+            SQLINTEGER native_error = 0;
+            SQLSMALLINT total_bytes = 0;
+            RETCODE rc = SQL_SUCCESS;
+            NANODBC_CALL_RC(
+                NANODBC_FUNC(SQLGetDiagRec),
+                rc,
+                SQL_HANDLE_STMT,
+                stmt_,
+                record,
+                sql_state,
+                &native_error,
+                sql_message.data(),
+                static_cast<SQLSMALLINT>(sql_message.size()),
+                &total_bytes);
+            if (!success(rc))
+                break;
+
+            SQLLEN row_number = SQL_NO_ROW_NUMBER;
+            NANODBC_CALL_RC(
+                NANODBC_FUNC(SQLGetDiagField),
+                rc,
+                SQL_HANDLE_STMT,
+                stmt_,
+                record,
+                SQL_DIAG_ROW_NUMBER,
+                &row_number,
+                SQL_IS_INTEGER,
+                nullptr);
+            if (!success(rc))
+                row_number = SQL_NO_ROW_NUMBER;
+
+            auto const message_length = (std::min)(
+                static_cast<std::size_t>(total_bytes > 0 ? total_bytes : 0),
+                sql_message.size() - 1);
+            param_diagnostic diagnostic;
+            diagnostic.row = row_number > 0 ? static_cast<long>(row_number - 1) : -1;
+            for (std::size_t i = 0; i < 5; ++i)
+                diagnostic.state.push_back(static_cast<char>(sql_state[i]));
+            diagnostic.native = native_error;
+            string const message(sql_message.data(), sql_message.data() + message_length);
+            convert(message, diagnostic.message);
+            param_diagnostics_.push_back(std::move(diagnostic));
+        }
     }
 
     static SQLSMALLINT param_type_from_direction(param_direction direction)
@@ -2457,7 +3534,7 @@ public:
         }
     }
 
-    // initializes bind_len_or_null_ and gets information for bind
+    // initializes the parameter's indicators and gets information for bind
     void prepare_bind(
         short param_index,
         std::size_t batch_size,
@@ -2470,24 +3547,24 @@ public:
         disable_async();
 #endif
 
-        if (!param_descr_data_.count(param_index))
-        {
+        // The other parameters are bound to rows, and would be read with their stride.
+        if (rows_bound_)
+            unbind_parameters();
+
+        auto& state = parameter_state(param_index);
+        if (!state.described)
             describe_parameters(param_index);
-        }
+        state.refresh = nullptr;
         param.index_ = param_index;
-        param.type_ = param_descr_data_[param_index].type_;
-        param.size_ = param_descr_data_[param_index].size_;
-        param.scale_ = param_descr_data_[param_index].scale_;
+        param.type_ = state.description.type_;
+        param.size_ = state.description.size_;
+        param.scale_ = state.description.scale_;
         param.iotype_ = param_type_from_direction(direction);
 
-        if (!bind_len_or_null_.count(param_index))
-            bind_len_or_null_[param_index] = std::vector<null_type>();
-        std::vector<null_type>().swap(bind_len_or_null_[param_index]);
-
-        // ODBC weirdness: this must be at least 8 elements in size
+        // ODBC weirdness: this must be at least 8 elements in size. The indicators keep their
+        // capacity from bind to bind, so binding no more rows than before allocates nothing.
         const std::size_t indicator_size = batch_size > 8 ? batch_size : 8;
-        bind_len_or_null_[param_index].reserve(indicator_size);
-        bind_len_or_null_[param_index].assign(indicator_size, SQL_NULL_DATA);
+        state.indicators.assign(indicator_size, SQL_NULL_DATA);
 
         NANODBC_ASSERT(param.index_ == param_index);
         NANODBC_ASSERT(param.iotype_ > 0);
@@ -2537,7 +3614,7 @@ public:
             param.scale_,     // decimal digits
             (SQLPOINTER)buffer.values_, // parameter value
             buffer_length,              // buffer length
-            bind_len_or_null_[param.index_].data());
+            params_[param.index_].indicators.data());
 
         if (!success(rc))
             NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
@@ -2574,7 +3651,7 @@ public:
             param.scale_,     // decimal digits
             (SQLPOINTER)buffer.values_, // parameter value
             buffer_size,                // buffer length
-            bind_len_or_null_[param.index_].data());
+            params_[param.index_].indicators.data());
 
         if (!success(rc))
             NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
@@ -2606,13 +3683,11 @@ public:
         {
             max_length = std::max(values[i].size(), max_length);
         }
-        binary_data_[param_index] = std::vector<uint8_t>(batch_size * max_length, 0);
+        auto& binary_data = params_[param_index].binary_data;
+        binary_data.assign(batch_size * max_length, 0);
         for (std::size_t i = 0; i < batch_size; ++i)
         {
-            std::copy(
-                values[i].begin(),
-                values[i].end(),
-                binary_data_[param_index].data() + (i * max_length));
+            std::copy(values[i].begin(), values[i].end(), binary_data.data() + (i * max_length));
         }
 
         if (null_sentry)
@@ -2620,7 +3695,7 @@ public:
             for (std::size_t i = 0; i < batch_size; ++i)
                 if (!std::equal(values[i].begin(), values[i].end(), null_sentry))
                 {
-                    bind_len_or_null_[param_index][i] = values[i].size();
+                    params_[param_index].indicators[i] = values[i].size();
                 }
         }
         else if (nulls)
@@ -2628,18 +3703,17 @@ public:
             for (std::size_t i = 0; i < batch_size; ++i)
             {
                 if (!nulls[i])
-                    bind_len_or_null_[param_index][i] = values[i].size(); // null terminated
+                    params_[param_index].indicators[i] = values[i].size(); // null terminated
             }
         }
         else
         {
             for (std::size_t i = 0; i < batch_size; ++i)
             {
-                bind_len_or_null_[param_index][i] = values[i].size();
+                params_[param_index].indicators[i] = values[i].size();
             }
         }
-        bound_buffer<uint8_t> buffer(
-            binary_data_[param_index].data(), batch_size, max_length, SQL_C_BINARY);
+        bound_buffer<uint8_t> buffer(binary_data.data(), batch_size, max_length, SQL_C_BINARY);
         bind_parameter(param, buffer);
     }
 
@@ -2661,32 +3735,289 @@ public:
         bool const* nulls = nullptr,
         typename T::value_type const* null_sentry = nullptr);
 
-    // handles multiple null values
-    void bind_null(short param_index, std::size_t batch_size)
+    // Binds a variable once. The driver reads a fixed size value through the binding at each
+    // execution, so nothing needs doing until the parameter is bound again.
+    template <class T>
+    void bind_ref(param_direction direction, short param_index, T& value)
+    {
+        bind(direction, param_index, &value, 1);
+    }
+
+    // A string's length changes without a bind, and its characters move when it reallocates,
+    // so just_execute() refreshes the binding before each execution.
+    template <class T>
+    void bind_ref(param_direction direction, short param_index, std::basic_string<T>& value)
     {
+        if (direction != PARAM_IN)
+            throw programming_error("strings can only be bound by reference as input parameters");
+
         bound_parameter param;
-        prepare_bind(param_index, batch_size, PARAM_IN, param);
+        prepare_bind(param_index, 1, direction, param);
+        auto& state = params_[param_index];
+        state.ref = &value;
+        bind_string_ref<T>(param_index);
+        state.refresh = &statement_impl::refresh_string_ref<T>;
+    }
+
+    template <class T>
+    void refresh_string_ref(short param_index)
+    {
+        auto& state = params_[param_index];
+        auto const& value = *static_cast<std::basic_string<T> const*>(state.ref);
+        if (value.data() != state.ref_data || value.capacity() != state.ref_capacity)
+            bind_string_ref<T>(param_index);
+        else
+            state.indicators[0] = static_cast<null_type>(value.size() * sizeof(T));
+    }
+
+    // Binds the string's own characters, with room for as many as it can hold before it
+    // reallocates.
+    template <class T>
+    void bind_string_ref(short param_index)
+    {
+#ifndef NANODBC_DISABLE_MSSQL_TVP
+        if (open_tvp_)
+            throw programming_error("cannot bind parameter, close tvp first");
+#endif
+
+        auto& state = params_[param_index];
+        auto const& value = *static_cast<std::basic_string<T> const*>(state.ref);
+        state.indicators[0] = static_cast<null_type>(value.size() * sizeof(T));
 
         RETCODE rc = SQL_SUCCESS;
         NANODBC_CALL_RC(
             SQLBindParameter,
             rc,
             stmt_,
-            param.index_ + 1, // parameter number
-            param.iotype_,    // input or output typ,
-            SQL_C_CHAR,
-            param.type_, // parameter type
-            param.size_, // column size ignored for many types, but needed for string,
+            param_index + 1,
+            SQL_PARAM_INPUT,
+            sql_ctype<T>::value,
+            state.description.type_,
+            state.description.size_,
+            state.description.scale_,
+            (SQLPOINTER)value.data(),
+            (value.capacity() + 1) * sizeof(T),
+            state.indicators.data());
+        if (!success(rc))
+            NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
+
+        state.ref_data = value.data();
+        state.ref_capacity = value.capacity();
+    }
+
+    // handles multiple null values
+    void bind_null(short param_index, std::size_t batch_size)
+    {
+        bound_parameter param;
+        prepare_bind(param_index, batch_size, PARAM_IN, param);
+
+        RETCODE rc = SQL_SUCCESS;
+        NANODBC_CALL_RC(
+            SQLBindParameter,
+            rc,
+            stmt_,
+            param.index_ + 1, // parameter number
+            param.iotype_,    // input or output typ,
+            SQL_C_CHAR,
+            param.type_, // parameter type
+            param.size_, // column size ignored for many types, but needed for string,
             0,           // decimal digits
             nullptr,     // null value
             0,           // buffe length
-            bind_len_or_null_[param.index_].data());
+            params_[param.index_].indicators.data());
+        if (!success(rc))
+            NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
+    }
+
+    // Binds parameter i to member i of each of count structs, row-wise. If every member holds
+    // its value as the C type it is bound as, the structs are bound where they are, without
+    // indicators. Otherwise the values are copied into rows_buffer_, one record per struct, each
+    // record starting with the indicators of its values.
+    void bind_rows(
+        void const* rows,
+        std::size_t count,
+        std::size_t row_size,
+        std::vector<statement::row_parameter> const& parameters)
+    {
+#ifndef NANODBC_DISABLE_MSSQL_TVP
+        if (open_tvp_)
+            throw programming_error("cannot bind parameter, close tvp first");
+#endif
+        NANODBC_ASSERT(count > 0);
+
+        // Parameters bound column-wise before would be read with the rows' stride.
+        unbind_parameters();
+
+        auto const* const first = static_cast<char const*>(rows);
+        bool in_place = true;
+        for (auto const& parameter : parameters)
+            in_place = in_place && parameter.in_place;
+
+        std::size_t const n = parameters.size();
+        std::vector<std::size_t> value_offsets(n);
+        std::vector<std::size_t> value_sizes(n);
+        std::size_t stride = row_size;
+        if (!in_place)
+        {
+            auto const aligned = [](std::size_t size) {
+                std::size_t const alignment = alignof(std::max_align_t);
+                return (size + alignment - 1) / alignment * alignment;
+            };
+
+            // Each value has room for the longest of its parameter's values.
+            stride = n * sizeof(null_type);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                auto const& parameter = parameters[i];
+                std::size_t size = parameter.unit_size;
+                for (std::size_t row = 0; row < count; ++row)
+                {
+                    char const* const member = first + row * row_size + parameter.offset;
+                    size = (std::max)(size, parameter.size(member));
+                }
+                value_offsets[i] = aligned(stride);
+                value_sizes[i] = size;
+                stride = value_offsets[i] + size;
+            }
+            stride = aligned(stride);
+
+            rows_buffer_.resize(count * stride);
+            for (std::size_t row = 0; row < count; ++row)
+            {
+                char* const record = rows_buffer_.data() + row * stride;
+                auto* const indicators = reinterpret_cast<null_type*>(record);
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    auto const& parameter = parameters[i];
+                    std::size_t length = 0;
+                    bool const value = parameter.copy(
+                        first + row * row_size + parameter.offset,
+                        record + value_offsets[i],
+                        length);
+                    indicators[i] = value ? static_cast<null_type>(length) : SQL_NULL_DATA;
+                }
+            }
+        }
+
+        RETCODE rc = SQL_SUCCESS;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto const& parameter = parameters[i];
+            bound_parameter param;
+            prepare_bind(static_cast<short>(i), 1, PARAM_IN, param);
+
+            // A value longer than the parameter is bound as unlimited, as bind() binds it.
+            SQLULEN param_size = param.size_;
+            if (!in_place && (parameter.kind == mapped_kind::text ||
+                              parameter.kind == mapped_kind::character ||
+                              parameter.kind == mapped_kind::binary))
+            {
+                std::size_t longest = value_sizes[i] / parameter.unit_size;
+                if (parameter.kind != mapped_kind::binary)
+                    --longest; // the terminator
+                if (longest > param_size)
+                    param_size = SQL_SS_LENGTH_UNLIMITED;
+            }
+
+            NANODBC_CALL_RC(
+                SQLBindParameter,
+                rc,
+                stmt_,
+                param.index_ + 1,
+                param.iotype_,
+                row_parameter_ctype(parameter),
+                param.type_,
+                param_size,
+                param.scale_,
+                in_place ? (SQLPOINTER)(first + parameter.offset)
+                         : (SQLPOINTER)(rows_buffer_.data() + value_offsets[i]),
+                in_place ? parameter.unit_size : value_sizes[i],
+                in_place ? nullptr : reinterpret_cast<null_type*>(rows_buffer_.data()) + i);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
+        }
+
+        NANODBC_CALL_RC(
+            SQLSetStmtAttr,
+            rc,
+            stmt_,
+            SQL_ATTR_PARAM_BIND_TYPE,
+            (SQLPOINTER)(std::uintptr_t)stride,
+            SQL_IS_UINTEGER);
+        rows_bound_ = true;
         if (!success(rc))
+        {
+            unbind_parameters();
             NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
+        }
+    }
+
+    // The C type a member of the given kind and size is bound as.
+    static SQLSMALLINT row_parameter_ctype(statement::row_parameter const& parameter)
+    {
+        auto const size = parameter.unit_size;
+        switch (parameter.kind)
+        {
+        case mapped_kind::boolean:
+            return SQL_C_BIT;
+        case mapped_kind::character:
+        case mapped_kind::text:
+            if (size == sizeof(SQLCHAR))
+                return SQL_C_CHAR;
+            if (size == sizeof(SQLWCHAR))
+                return SQL_C_WCHAR;
+            break;
+        case mapped_kind::signed_integer:
+            if (size == 1)
+                return SQL_C_STINYINT;
+            if (size == 2)
+                return SQL_C_SSHORT;
+            if (size == 4)
+                return SQL_C_SLONG;
+            if (size == 8)
+                return SQL_C_SBIGINT;
+            break;
+        case mapped_kind::unsigned_integer:
+            if (size == 1)
+                return SQL_C_UTINYINT;
+            if (size == 2)
+                return SQL_C_USHORT;
+            if (size == 4)
+                return SQL_C_ULONG;
+            if (size == 8)
+                return SQL_C_UBIGINT;
+            break;
+        case mapped_kind::floating:
+            if (size == sizeof(SQLREAL))
+                return SQL_C_FLOAT;
+            if (size == sizeof(SQLDOUBLE))
+                return SQL_C_DOUBLE;
+            break;
+        case mapped_kind::binary:
+            return SQL_C_BINARY;
+        case mapped_kind::date:
+            return SQL_C_DATE;
+        case mapped_kind::time:
+            return SQL_C_TIME;
+        case mapped_kind::timestamp:
+            return SQL_C_TIMESTAMP;
+        case mapped_kind::unsupported:
+            break;
+        }
+        throw programming_error("bind_rows has no C type for a member of this size");
     }
 
     void describe_parameters(const short param_index)
     {
+        auto& state = parameter_state(param_index);
+        if (caches_parameters_ &&
+            conn_.impl_->cached_parameter_description(
+                prepared_query_, param_index, state.description))
+        {
+            state.described = true;
+            return;
+        }
+
         RETCODE rc = SQL_SUCCESS;
         SQLSMALLINT nullable = 0; // unused
 #if defined(NANODBC_DO_ASYNC_IMPL)
@@ -2697,15 +4028,21 @@ public:
             rc,
             stmt_,
             static_cast<SQLUSMALLINT>(param_index + 1),
-            &param_descr_data_[param_index].type_,
-            &param_descr_data_[param_index].size_,
-            &param_descr_data_[param_index].scale_,
+            &state.description.type_,
+            &state.description.size_,
+            &state.description.scale_,
             &nullable);
         if (!success(rc))
         {
-            param_descr_data_.erase(param_index);
+            state.described = false;
             NANODBC_THROW_DATABASE_ERROR(stmt_, SQL_HANDLE_STMT);
         }
+        state.described = true;
+        if (caches_parameters_)
+        {
+            conn_.impl_->cache_parameter_description(
+                prepared_query_, param_index, state.description);
+        }
     }
 
     void describe_parameters(
@@ -2720,12 +4057,47 @@ public:
 
         for (std::size_t i = 0; i < idx.size(); ++i)
         {
-            param_descr_data_[idx[i]].type_ = static_cast<SQLSMALLINT>(type[i]);
-            param_descr_data_[idx[i]].size_ = static_cast<SQLULEN>(size[i]);
-            param_descr_data_[idx[i]].scale_ = static_cast<SQLSMALLINT>(scale[i]);
-            param_descr_data_[idx[i]].index_ = static_cast<SQLUSMALLINT>(i);
-            param_descr_data_[idx[i]].iotype_ = PARAM_IN; // not used
+            auto& state = parameter_state(idx[i]);
+            state.description.type_ = static_cast<SQLSMALLINT>(type[i]);
+            state.description.size_ = static_cast<SQLULEN>(size[i]);
+            state.description.scale_ = static_cast<SQLSMALLINT>(scale[i]);
+            state.description.index_ = static_cast<SQLUSMALLINT>(i);
+            state.description.iotype_ = PARAM_IN; // not used
+            state.described = true;
+        }
+    }
+
+    void describe_parameters(std::vector<param_description> const& descriptions)
+    {
+        for (std::size_t i = 0; i < descriptions.size(); ++i)
+        {
+            auto& state = parameter_state(static_cast<short>(i));
+            state.description.type_ = static_cast<SQLSMALLINT>(descriptions[i].type);
+            state.description.size_ = static_cast<SQLULEN>(descriptions[i].size);
+            state.description.scale_ = static_cast<SQLSMALLINT>(descriptions[i].scale);
+            state.description.index_ = static_cast<SQLUSMALLINT>(i);
+            state.description.iotype_ = PARAM_IN; // not used
+            state.described = true;
+        }
+    }
+
+    std::vector<param_description> parameter_descriptions()
+    {
+        short const count = parameters();
+        std::vector<param_description> descriptions;
+        descriptions.reserve(static_cast<std::size_t>(count));
+        for (short i = 0; i < count; ++i)
+        {
+            if (!parameter_state(i).described)
+                describe_parameters(i);
+            auto const& param = params_[static_cast<std::size_t>(i)].description;
+            param_description description;
+            description.type = param.type_;
+            description.size = static_cast<unsigned long>(param.size_);
+            description.scale = param.scale_;
+            descriptions.push_back(description);
         }
+        return descriptions;
     }
 
     // comparator for null sentry values
@@ -2747,14 +4119,79 @@ public:
     std::vector<T>& get_bound_string_data(short param_index);
 
 private:
+    struct param_state
+    {
+        bound_parameter description;
+        bool described = false;
+        std::vector<null_type> indicators;
+        std::vector<wide_string::value_type> wide_string_data;
+        std::vector<std::string::value_type> string_data;
+        std::vector<uint8_t> binary_data;
+        // Set while a string is bound with bind_ref(): the string, where its characters were
+        // when it was bound, and the function that brings the binding up to date with it.
+        void const* ref = nullptr;
+        void const* ref_data = nullptr;
+        std::size_t ref_capacity = 0;
+        void (statement_impl::*refresh)(short) = nullptr;
+    };
+
+    // Brings the bindings of strings bound with bind_ref() up to date with the strings, before
+    // either kind of execution sends them.
+    void refresh_bound_references()
+    {
+        for (short i = 0; i < static_cast<short>(params_.size()); ++i)
+        {
+            if (params_[i].refresh)
+                (this->*params_[i].refresh)(i);
+        }
+    }
+
+    param_state& parameter_state(short param_index)
+    {
+        NANODBC_ASSERT(param_index >= 0);
+        if (!params_sized_ && open())
+        {
+            // Size for every marker at once, rather than growing as they are bound.
+            SQLSMALLINT count = 0;
+            RETCODE rc = SQL_SUCCESS;
+#if defined(NANODBC_DO_ASYNC_IMPL)
+            disable_async();
+#endif
+            NANODBC_CALL_RC(SQLNumParams, rc, stmt_, &count);
+            if (success(rc) && count > 0 && static_cast<std::size_t>(count) > params_.size())
+                params_.resize(static_cast<std::size_t>(count));
+            params_sized_ = true;
+        }
+        auto const index = static_cast<std::size_t>(param_index);
+        if (index >= params_.size())
+            params_.resize(index + 1);
+        return params_[index];
+    }
+
     HSTMT stmt_;
     bool open_;
+    bool prepared_{false}; // a query is prepared and no other was executed directly since
     class connection conn_;
-    std::map<short, std::vector<null_type>> bind_len_or_null_;
-    std::map<short, std::vector<wide_string::value_type>> wide_string_data_;
-    std::map<short, std::vector<std::string::value_type>> string_data_;
-    std::map<short, std::vector<uint8_t>> binary_data_;
-    std::map<short, bound_parameter> param_descr_data_;
+    // Per parameter marker, by index: its description, the indicators bound with it and the
+    // buffers holding copies of its string and binary values. Sized from SQLNumParams after each
+    // prepare and kept across binds, so rebinding a statement reuses the buffers. A deque, so
+    // that growing it for an index past the markers leaves the states already handed out, such
+    // as the indicators of an open table-valued parameter, where they are.
+    std::deque<param_state> params_;
+    bool params_sized_{false};
+    // Whether bind_rows() bound the parameters row-wise, and the records it copied values into.
+    bool rows_bound_{false};
+    std::vector<char> rows_buffer_;
+    // The query last prepared, while its parameter descriptions are cached by the connection.
+    string prepared_query_;
+    bool caches_parameters_{false};
+    // Row status and processed count of parameter array executions, and the array size
+    // bound to the current handle.
+    std::vector<SQLUSMALLINT> param_status_;
+    std::size_t param_status_bound_{0};
+    std::size_t param_status_rows_{0};
+    SQLULEN params_processed_{0};
+    std::vector<param_diagnostic> param_diagnostics_;
 
 #if defined(NANODBC_DO_ASYNC_IMPL)
     bool async_;                 // true if statement is currently in SQL_STILL_EXECUTING mode
@@ -2790,18 +4227,18 @@ void statement::statement_impl::bind(
     {
         for (std::size_t i = 0; i < batch_size; ++i)
             if (!equals(values[i], *null_sentry))
-                bind_len_or_null_[param_index][i] = present;
+                params_[param_index].indicators[i] = present;
     }
     else if (nulls)
     {
         for (std::size_t i = 0; i < batch_size; ++i)
             if (!nulls[i])
-                bind_len_or_null_[param_index][i] = present;
+                params_[param_index].indicators[i] = present;
     }
     else
     {
         for (std::size_t i = 0; i < batch_size; ++i)
-            bind_len_or_null_[param_index][i] = present;
+            params_[param_index].indicators[i] = present;
     }
 
     bound_buffer<T> buffer(values, batch_size);
@@ -2831,7 +4268,7 @@ void statement::statement_impl::bind_strings(
     // add space for null terminator
     ++max_length;
 
-    string_data = string_vector(batch_size * max_length, 0);
+    string_data.assign(batch_size * max_length, 0);
     for (std::size_t i = 0; i < batch_size; ++i)
     {
         std::copy(values[i].begin(), values[i].end(), string_data.data() + (i * max_length));
@@ -2861,7 +4298,7 @@ void statement::statement_impl::bind_strings(
                 values + i * value_size, values + (i + 1) * value_size);
             const std::basic_string<T> s_rhs(null_sentry);
             if (!equals(s_lhs, s_rhs))
-                bind_len_or_null_[param_index][i] = SQL_NTS;
+                params_[param_index].indicators[i] = SQL_NTS;
         }
     }
     else if (nulls)
@@ -2869,14 +4306,14 @@ void statement::statement_impl::bind_strings(
         for (std::size_t i = 0; i < batch_size; ++i)
         {
             if (!nulls[i])
-                bind_len_or_null_[param_index][i] = SQL_NTS; // null terminated
+                params_[param_index].indicators[i] = SQL_NTS; // null terminated
         }
     }
     else
     {
         for (std::size_t i = 0; i < batch_size; ++i)
         {
-            bind_len_or_null_[param_index][i] = SQL_NTS;
+            params_[param_index].indicators[i] = SQL_NTS;
         }
     }
 
@@ -2924,14 +4361,14 @@ template <>
 std::vector<wide_string::value_type>&
 statement::statement_impl::get_bound_string_data(short param_index)
 {
-    return wide_string_data_[param_index];
+    return parameter_state(param_index).wide_string_data;
 }
 
 template <>
 std::vector<std::string::value_type>&
 statement::statement_impl::get_bound_string_data(short param_index)
 {
-    return string_data_[param_index];
+    return parameter_state(param_index).string_data;
 }
 
 } // namespace nanodbc
@@ -3738,17 +5175,42 @@ public:
             NANODBC_THROW_DATABASE_ERROR(stmt_.native_statement_handle(), SQL_HANDLE_STMT);
 
         auto_bind_columns();
+
+        // A long column is read by positioning on its row, which a driver allows in a rowset
+        // of several rows only with SQL_GD_BLOCK. Without it, such a result goes a row at a
+        // time, as the result class documents and rowset_size() reports.
+        if (has_unbound_ && rowset_size_ > 1 && lacks_get_data_in_blocks())
+        {
+            NANODBC_CALL_RC(
+                SQLSetStmtAttr,
+                rc,
+                stmt_.native_statement_handle(),
+                SQL_ATTR_ROW_ARRAY_SIZE,
+                (SQLPOINTER)(std::intptr_t)1,
+                0);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt_.native_statement_handle(), SQL_HANDLE_STMT);
+            rowset_size_ = 1;
+        }
     }
 
-    ~result_impl() noexcept { cleanup_bound_columns(); }
+    ~result_impl() noexcept
+    {
+        stop_prefetch();
+        cleanup_bound_columns();
+    }
 
     void* native_statement_handle() const noexcept { return stmt_.native_statement_handle(); }
 
     long rowset_size() const noexcept { return rowset_size_; }
 
-    long affected_rows() const { return stmt_.affected_rows(); }
+    long affected_rows() const
+    {
+        auto const handle_lock = lock_handle();
+        return stmt_.affected_rows();
+    }
 
-    bool has_affected_rows() const { return stmt_.affected_rows() != -1; }
+    bool has_affected_rows() const { return affected_rows() != -1; }
 
     long rows() const noexcept
     {
@@ -3756,7 +5218,12 @@ public:
         return static_cast<long>(row_count_);
     }
 
-    short columns() const { return stmt_.columns(); }
+    short columns() const
+    {
+        if (prefetch_)
+            return prefetch_->columns;
+        return stmt_.columns();
+    }
 
     bool first()
     {
@@ -3781,9 +5248,70 @@ public:
             return rowset_position_ < rows();
         }
         rowset_position_ = 0;
+        if (prefetch_)
+            return take_prefetched_rowset();
         return fetch(0, SQL_FETCH_NEXT, event_handle);
     }
 
+    // Starts fetching rowsets on a background thread, into a second set of buffers which
+    // next() swaps in once the current rowset is done. Only possible if every column is
+    // bound: reading an unbound one needs the cursor still on its row.
+    bool enable_prefetch()
+    {
+        if (prefetch_)
+            return true;
+        if (has_unbound_ || at_end_ || bound_columns_size_ < 1)
+            return false;
+
+        auto state = std::make_unique<prefetch_state>();
+        state->pdata.resize(static_cast<std::size_t>(bound_columns_size_));
+        state->cbdata.resize(static_cast<std::size_t>(bound_columns_size_));
+        for (short i = 0; i < bound_columns_size_; ++i)
+        {
+            bound_column const& col = bound_columns_[i];
+            state->pdata[i] =
+                std::make_unique<char[]>(static_cast<std::size_t>(rowset_size_ * col.clen_));
+            state->cbdata[i] =
+                std::make_unique<null_type[]>(static_cast<std::size_t>(rowset_size_));
+        }
+
+        // The metadata read while the thread runs is read now, rather than from the handle.
+        state->columns = stmt_.columns();
+
+#if defined(NANODBC_DO_ASYNC_IMPL)
+        // The thread fetches synchronously. Whatever was set is set again when it stops.
+        HSTMT const handle = stmt_.native_statement_handle();
+        SQLULEN async_enable = SQL_ASYNC_ENABLE_OFF;
+        NANODBC_CALL(
+            SQLGetStmtAttr, handle, SQL_ATTR_ASYNC_ENABLE, &async_enable, SQL_IS_UINTEGER, nullptr);
+        NANODBC_CALL(
+            SQLGetStmtAttr,
+            handle,
+            SQL_ATTR_ASYNC_STMT_EVENT,
+            &state->async_event,
+            SQL_IS_POINTER,
+            nullptr);
+        state->async_enabled = async_enable == SQL_ASYNC_ENABLE_ON;
+        stmt_.disable_async();
+#endif
+
+        RETCODE rc = SQL_SUCCESS;
+        NANODBC_CALL_RC(
+            SQLSetStmtAttr,
+            rc,
+            stmt_.native_statement_handle(),
+            SQL_ATTR_ROWS_FETCHED_PTR,
+            &state->row_count,
+            0);
+        if (!success(rc))
+            NANODBC_THROW_DATABASE_ERROR(stmt_.native_statement_handle(), SQL_HANDLE_STMT);
+
+        prefetch_ = std::move(state);
+        prefetch_->requested = true;
+        prefetch_->worker = std::thread([this] { prefetch_rowsets(); });
+        return true;
+    }
+
 #if defined(NANODBC_DO_ASYNC_IMPL)
     bool async_next(void* event_handle)
     {
@@ -3839,6 +5367,7 @@ public:
 
     unsigned long position() const
     {
+        auto const handle_lock = lock_handle();
         SQLULEN pos = 0; // necessary to initialize to 0
         RETCODE rc = SQL_SUCCESS;
         NANODBC_CALL_RC(
@@ -3866,6 +5395,7 @@ public:
     {
         if (at_end_)
             return true;
+        auto const handle_lock = lock_handle();
         SQLULEN pos = 0; // necessary to initialize to 0
         RETCODE rc = SQL_SUCCESS;
         NANODBC_CALL_RC(
@@ -3899,6 +5429,7 @@ public:
         // The others cannot, and report what the fetch knew.
         if (!col.bound_ && col.ctype_ == SQL_C_BINARY)
         {
+            auto const handle_lock = lock_handle();
             SQLCHAR unused = 0;
             constexpr SQLLEN buffer_length = 0;
             SQLLEN indicator = 0;
@@ -3999,6 +5530,7 @@ public:
     string column_datatype_name(short column) const
     {
         throw_if_column_is_out_of_range(column);
+        auto const handle_lock = lock_handle();
 
         NANODBC_SQLCHAR type_name[256] = {0};
         SQLSMALLINT len = 0; // total number of bytes
@@ -4043,6 +5575,7 @@ public:
     bool column_unsigned(short column) const
     {
         throw_if_column_is_out_of_range(column);
+        auto const handle_lock = lock_handle();
 
         SQLLEN type_unsigned = SQL_FALSE;
         RETCODE rc = SQL_SUCCESS;
@@ -4071,6 +5604,7 @@ public:
 
     bool next_result()
     {
+        auto handle_lock = lock_handle();
         RETCODE rc = SQL_SUCCESS;
 
 #if defined(NANODBC_DO_ASYNC_IMPL)
@@ -4082,6 +5616,7 @@ public:
             return false;
         if (!success(rc))
             NANODBC_THROW_DATABASE_ERROR(stmt_.native_statement_handle(), SQL_HANDLE_STMT);
+        handle_lock.unlock();
         auto_bind_columns();
         return true;
     }
@@ -4260,6 +5795,82 @@ public:
         return result;
     }
 
+#ifdef NANODBC_HAS_STD_VARIANT
+    // Reads every column of the current row into row, from left to right.
+    void get_row(std::vector<value>& row) const;
+#endif
+
+    // Where the current row's value of a column lies in the rowset buffer, with its length in
+    // bytes, for reading it in place. Null for a column that is not bound, or whose value did not
+    // fit the buffer, which get_unless_null() reads instead. The caller checks is_null() first.
+    char const* bound_cell(short column, std::size_t& length) const
+    {
+        throw_if_column_is_out_of_range(column);
+        bound_column const& col = bound_columns_[column];
+        if (!col.bound_ || col.blob_ || !col.pdata_)
+            return nullptr;
+        switch (col.ctype_)
+        {
+        case SQL_C_CHAR:
+        case SQL_C_WCHAR:
+        case SQL_C_BINARY:
+        {
+            // Only these have lengths of their own, which the indicator holds.
+            SQLLEN const indicator = col.cbdata_[static_cast<std::size_t>(rowset_position_)];
+            if (indicator == SQL_NO_TOTAL || indicator < 0 || bound_column_was_truncated(column))
+                return nullptr;
+            length = static_cast<std::size_t>(indicator);
+            break;
+        }
+        default:
+            length = static_cast<std::size_t>(col.clen_);
+            break;
+        }
+        return col.pdata_.get() + rowset_position_ * col.clen_;
+    }
+
+    // Returns the current row's value of a bound column of the given C type, as the fetch
+    // wrote it, or null if the value is null or there is no such column or current row.
+    char const* fixed_cell(short column, SQLSMALLINT ctype) const noexcept
+    {
+        if (column < 0 || column >= bound_columns_size_ || rowset_position_ >= rows())
+            return nullptr;
+        bound_column const& col = bound_columns_[column];
+        auto const row = static_cast<std::size_t>(rowset_position_);
+        if (!col.bound_ || !col.pdata_ || col.ctype_ != ctype || col.cbdata_[row] == SQL_NULL_DATA)
+            return nullptr;
+        return col.pdata_.get() + row * col.clen_;
+    }
+
+    // Parses the current row's value of a character column as a date, a time or both. A bound
+    // value is parsed in place; any other is read as text first.
+    parsed_temporal get_temporal_from_text(short column) const
+    {
+        std::size_t length = 0;
+        if (char const* const data = bound_cell(column, length))
+        {
+            if (bound_columns_[column].ctype_ == SQL_C_WCHAR)
+                return parse_temporal(
+                    reinterpret_cast<SQLWCHAR const*>(data), length / sizeof(SQLWCHAR));
+            return parse_temporal(data, length);
+        }
+        std::string text;
+        get_ref_impl(column, text);
+        return parse_temporal(text.data(), text.size());
+    }
+
+    // Reads a column of the current row as get_ref() does, but returns false rather than
+    // throwing for a null, which for an unbound column is only known after the read.
+    template <class T>
+    bool get_unless_null(short column, T& result) const
+    {
+        throw_if_column_is_out_of_range(column);
+        if (is_null(column))
+            return false;
+        get_ref_impl<T>(column, result);
+        return !is_null(column);
+    }
+
 private:
     template <typename T>
     std::unique_ptr<T, std::function<void(T*)>> ensure_pdata(short column) const;
@@ -4286,19 +5897,36 @@ private:
     // no include SQL Server's, so a re-read has to be asked for rather than assumed.
     bool supports_get_data_on_bound_column() const
     {
-        if (get_data_extensions_ < 0)
+        auto const extensions = get_data_extensions();
+        return extensions >= 0 && (extensions & SQL_GD_BOUND) != 0;
+    }
+
+    // Whether the driver is known not to read columns with SQLGetData in a rowset of more than
+    // one row. A driver whose answer is unknown is given the benefit of the doubt.
+    bool lacks_get_data_in_blocks() const
+    {
+        auto const extensions = get_data_extensions();
+        return extensions >= 0 && (extensions & SQL_GD_BLOCK) == 0;
+    }
+
+    // The driver's SQL_GETDATA_EXTENSIONS, or -1 where its profile does not say.
+    int get_data_extensions() const
+    {
+        if (!get_data_extensions_probed_)
         {
+            get_data_extensions_probed_ = true;
             try
             {
-                get_data_extensions_ = static_cast<int>(
-                    stmt_.connection().get_info<SQLUINTEGER>(SQL_GETDATA_EXTENSIONS));
+                auto const profile = stmt_.connection().profile();
+                if (profile.getdata_extensions_reported)
+                    get_data_extensions_ = static_cast<int>(profile.getdata_extensions);
             }
             catch (...)
             {
-                get_data_extensions_ = 0;
+                // Left unknown.
             }
         }
-        return (get_data_extensions_ & SQL_GD_BOUND) != 0;
+        return get_data_extensions_;
     }
 
     // A driver may report a column size smaller than the values it goes on to return, in
@@ -4306,6 +5934,10 @@ private:
     // there was. The indicator counts the bytes available, not the bytes written.
     bool bound_column_was_truncated(short column) const
     {
+        // With a rowset being prefetched the cursor has already moved on, so there is no
+        // reading the value again.
+        if (prefetch_)
+            return false;
         bound_column const& col = bound_columns_[column];
         if (!col.bound_ || col.blob_ || col.clen_ == 0)
             return false;
@@ -4345,6 +5977,7 @@ private:
     // If event_handle is specified, fetch returns true iff the statement is still executing
     bool fetch(long rows, SQLUSMALLINT orientation, void* event_handle = nullptr)
     {
+        auto const handle_lock = lock_handle();
         before_move();
 
 #if defined(NANODBC_DO_ASYNC_IMPL)
@@ -4575,6 +6208,7 @@ private:
     {
         NANODBC_ASSERT(column.pdata_);
         NANODBC_ASSERT(column.cbdata_);
+        auto const handle_lock = lock_handle();
 
         RETCODE rc = SQL_SUCCESS;
         NANODBC_CALL_RC(
@@ -4594,6 +6228,7 @@ private:
     void unbind_column(bound_column& column)
     {
         NANODBC_ASSERT(column.cbdata_);
+        auto const handle_lock = lock_handle();
         has_unbound_ = true;
 
         RETCODE rc = SQL_SUCCESS;
@@ -4612,39 +6247,205 @@ private:
         column.bound_ = false;
     }
 
-    void set_current_position()
+    // Runs on the prefetch thread: each request binds the spare buffers and fetches the next
+    // rowset into them. The buffers next() reads from are left alone.
+    void prefetch_rowsets() noexcept
     {
-        if (rowset_position_ < rowset_size_ && rowset_position_ < rows())
+        std::unique_lock<std::mutex> lock(prefetch_->mutex);
+        for (;;)
         {
-            RETCODE rc = SQL_SUCCESS;
+            prefetch_->wake.wait(lock, [this] { return prefetch_->stop || prefetch_->requested; });
+            if (prefetch_->stop)
+                return;
+            prefetch_->requested = false;
+            lock.unlock();
+
+            bool no_data = false;
+            std::exception_ptr error;
+            try
+            {
+                std::lock_guard<std::mutex> handle_lock(prefetch_->handle);
+                no_data = !fetch_into_spare_buffers();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            prefetch_->no_data = no_data;
+            prefetch_->error = error;
+            prefetch_->done = true;
+            prefetch_->wake.notify_all();
+        }
+    }
+
+    bool fetch_into_spare_buffers()
+    {
+        RETCODE rc = SQL_SUCCESS;
+        for (short i = 0; i < bound_columns_size_; ++i)
+        {
+            bound_column const& col = bound_columns_[i];
+            null_type* const cbdata = prefetch_->cbdata[i].get();
+            for (long row = 0; row < rowset_size_; ++row)
+                cbdata[row] = 0;
+
             NANODBC_CALL_RC(
-                SQLSetPos,
+                SQLBindCol,
                 rc,
                 stmt_.native_statement_handle(),
-                static_cast<SQLSETPOSIROW>(rowset_position_) + 1,
-                SQL_POSITION,
-                SQL_LOCK_NO_CHANGE);
+                static_cast<SQLUSMALLINT>(col.column_ + 1), // ColumnNumber
+                col.ctype_,                                 // TargetType
+                prefetch_->pdata[i].get(),                  // TargetValuePtr
+                col.clen_,                                  // BufferLength
+                cbdata);                                    // StrLen_or_Ind
             if (!success(rc))
                 NANODBC_THROW_DATABASE_ERROR(stmt_.native_statement_handle(), SQL_HANDLE_STMT);
         }
-    }
 
-private:
-    statement stmt_;
-    const long rowset_size_;
-    SQLULEN row_count_;
-    std::unique_ptr<bound_column[]> bound_columns_;
-    short bound_columns_size_;
-    long rowset_position_;
-    std::map<string, bound_column*> bound_columns_by_name_;
-    bool at_end_;
-#if defined(NANODBC_DO_ASYNC_IMPL)
-    bool async_; // true if statement is currently in SQL_STILL_EXECUTING mode
-#endif
-    bool has_unbound_;
-    // SQL_GETDATA_EXTENSIONS, read once on first use. -1 until then.
-    mutable int get_data_extensions_ = -1;
-};
+        NANODBC_CALL_RC(SQLFetchScroll, rc, stmt_.native_statement_handle(), SQL_FETCH_NEXT, 0);
+        if (rc == SQL_NO_DATA)
+            return false;
+        if (!success(rc))
+            NANODBC_THROW_DATABASE_ERROR(stmt_.native_statement_handle(), SQL_HANDLE_STMT);
+        return true;
+    }
+
+    // Waits for the rowset being prefetched, makes it the current one and asks for the next.
+    bool take_prefetched_rowset()
+    {
+        if (at_end_)
+            return false;
+
+        std::unique_lock<std::mutex> lock(prefetch_->mutex);
+        prefetch_->wake.wait(lock, [this] { return prefetch_->done; });
+        prefetch_->done = false;
+
+        if (prefetch_->error || prefetch_->no_data)
+        {
+            at_end_ = true;
+            row_count_ = 0;
+            if (prefetch_->error)
+                std::rethrow_exception(prefetch_->error);
+            return false;
+        }
+
+        for (short i = 0; i < bound_columns_size_; ++i)
+        {
+            bound_column& col = bound_columns_[i];
+            std::swap(col.pdata_, prefetch_->pdata[i]);
+            std::swap(col.cbdata_, prefetch_->cbdata[i]);
+        }
+        row_count_ = prefetch_->row_count;
+
+        prefetch_->requested = true;
+        prefetch_->wake.notify_all();
+        return row_count_ > 0;
+    }
+
+    // Joins the thread and puts back what enable_prefetch() changed on the handle. The columns
+    // are left unbound, as they were last bound to buffers the prefetch state owns.
+    void stop_prefetch() noexcept
+    {
+        if (!prefetch_)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(prefetch_->mutex);
+            prefetch_->stop = true;
+            prefetch_->wake.notify_all();
+        }
+        if (prefetch_->worker.joinable())
+            prefetch_->worker.join();
+
+        HSTMT const handle = stmt_.native_statement_handle();
+        NANODBC_CALL(SQLFreeStmt, handle, SQL_UNBIND);
+        NANODBC_CALL(SQLSetStmtAttr, handle, SQL_ATTR_ROWS_FETCHED_PTR, &row_count_, 0);
+        for (short i = 0; i < bound_columns_size_; ++i)
+            bound_columns_[i].bound_ = false;
+#if defined(NANODBC_DO_ASYNC_IMPL)
+        if (prefetch_->async_enabled)
+        {
+            try
+            {
+                stmt_.enable_async(prefetch_->async_event);
+            }
+            catch (...)
+            {
+                // Left disabled, as the statement then knows it to be.
+            }
+        }
+#endif
+        prefetch_.reset();
+    }
+
+    // While rowsets are prefetched, calls on the statement handle take turns with the thread's
+    // fetch. Otherwise the lock holds nothing.
+    std::unique_lock<std::mutex> lock_handle() const
+    {
+        if (prefetch_)
+            return std::unique_lock<std::mutex>(prefetch_->handle);
+        return std::unique_lock<std::mutex>();
+    }
+
+    void set_current_position()
+    {
+        if (rowset_position_ < rowset_size_ && rowset_position_ < rows())
+        {
+            auto const handle_lock = lock_handle();
+            RETCODE rc = SQL_SUCCESS;
+            NANODBC_CALL_RC(
+                SQLSetPos,
+                rc,
+                stmt_.native_statement_handle(),
+                static_cast<SQLSETPOSIROW>(rowset_position_) + 1,
+                SQL_POSITION,
+                SQL_LOCK_NO_CHANGE);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt_.native_statement_handle(), SQL_HANDLE_STMT);
+        }
+    }
+
+private:
+    statement stmt_;
+    long rowset_size_;
+    SQLULEN row_count_;
+    std::unique_ptr<bound_column[]> bound_columns_;
+    short bound_columns_size_;
+    long rowset_position_;
+    std::map<string, bound_column*> bound_columns_by_name_;
+    bool at_end_;
+#if defined(NANODBC_DO_ASYNC_IMPL)
+    bool async_; // true if statement is currently in SQL_STILL_EXECUTING mode
+#endif
+    bool has_unbound_;
+    // SQL_GETDATA_EXTENSIONS of the driver profile, read once on first use. -1 until then.
+    mutable int get_data_extensions_ = -1;
+    mutable bool get_data_extensions_probed_ = false;
+
+    // Spare buffers and the handshake with the thread fetching into them.
+    struct prefetch_state
+    {
+        std::thread worker;
+        std::mutex mutex;
+        std::condition_variable wake;
+        // Held around each call on the statement handle, by the thread and the reader alike.
+        std::mutex handle;
+        short columns = 0;
+#if defined(NANODBC_DO_ASYNC_IMPL)
+        bool async_enabled = false;
+        SQLPOINTER async_event = nullptr;
+#endif
+        bool requested = false;
+        bool done = false;
+        bool stop = false;
+        bool no_data = false;
+        std::exception_ptr error;
+        SQLULEN row_count = 0;
+        std::vector<std::unique_ptr<char[]>> pdata;
+        std::vector<std::unique_ptr<null_type[]>> cbdata;
+    };
+    std::unique_ptr<prefetch_state> prefetch_;
+};
 
 template <>
 inline void result::result_impl::get_ref_impl<date>(short column, date& result) const
@@ -4661,6 +6462,16 @@ inline void result::result_impl::get_ref_impl<date>(short column, date& result)
         result = date{stamp.year, stamp.month, stamp.day};
         return;
     }
+    case SQL_C_CHAR:
+    case SQL_C_WCHAR:
+    {
+        auto const parsed = get_temporal_from_text(column);
+        if (!parsed.has_date)
+            break;
+        auto const& stamp = parsed.value.stamp;
+        result = date{stamp.year, stamp.month, stamp.day};
+        return;
+    }
     case SQL_C_BINARY:
     {
         if (col.sqltype_ == SQL_SS_TIMESTAMPOFFSET)
@@ -4691,6 +6502,16 @@ inline void result::result_impl::get_ref_impl<time>(short column, time& result)
         result = time{stamp.hour, stamp.min, stamp.sec};
         return;
     }
+    case SQL_C_CHAR:
+    case SQL_C_WCHAR:
+    {
+        auto const parsed = get_temporal_from_text(column);
+        if (!parsed.has_time)
+            break;
+        auto const& stamp = parsed.value.stamp;
+        result = time{stamp.hour, stamp.min, stamp.sec};
+        return;
+    }
     case SQL_C_BINARY:
     {
         if (col.sqltype_ == SQL_SS_TIMESTAMPOFFSET)
@@ -4723,6 +6544,15 @@ inline void result::result_impl::get_ref_impl<timestamp>(short column, timestamp
         result = *ensure_pdata<timestamp>(column);
         return;
     }
+    case SQL_C_CHAR:
+    case SQL_C_WCHAR:
+    {
+        auto const parsed = get_temporal_from_text(column);
+        if (!parsed.has_date)
+            break;
+        result = parsed.value.stamp;
+        return;
+    }
     case SQL_C_BINARY:
     {
         if (col.sqltype_ == SQL_SS_TIMESTAMPOFFSET)
@@ -4758,6 +6588,15 @@ result::result_impl::get_ref_impl<timestampoffset>(short column, timestampoffset
         result = timestampoffset{stamp, 0, 0};
         return;
     }
+    case SQL_C_CHAR:
+    case SQL_C_WCHAR:
+    {
+        auto const parsed = get_temporal_from_text(column);
+        if (!parsed.has_date)
+            break;
+        result = parsed.value;
+        return;
+    }
     case SQL_C_BINARY:
     {
         if (col.sqltype_ == SQL_SS_TIMESTAMPOFFSET)
@@ -4798,6 +6637,7 @@ inline void result::result_impl::get_ref_impl(short column, T& result) const
         if (!is_bound(column) ||
             (bound_column_was_truncated(column) && supports_get_data_on_bound_column()))
         {
+            auto const handle_lock = lock_handle();
             // Input is always std::string, while output may be std::string or wide_string
             std::string out;
             // Data still available, which shrinks with each SQLGetData; not the amount
@@ -4856,6 +6696,7 @@ inline void result::result_impl::get_ref_impl(short column, T& result) const
         if (!is_bound(column) ||
             (bound_column_was_truncated(column) && supports_get_data_on_bound_column()))
         {
+            auto const handle_lock = lock_handle();
             // Input is always wide_string, output might be std::string or wide_string.
             // Use a string builder to build the output string.
             wide_string out;
@@ -4976,44 +6817,14 @@ inline void result::result_impl::get_ref_impl(short column, T& result) const
         // strftime. The caller tests for the null again after this returns.
         if (is_null(column))
             return;
-        std::tm st{};
-        st.tm_year = d.year - 1900;
-        st.tm_mon = d.month - 1;
-        st.tm_mday = d.day;
-        std::string old_lc_time_container;
-        const char* old_lc_time = nullptr;
-        if (char const* olc_lc_time_ptr = std::setlocale(LC_TIME, nullptr))
-        {
-            old_lc_time_container = olc_lc_time_ptr;
-            old_lc_time = old_lc_time_container.c_str();
-        }
-        std::setlocale(LC_TIME, "");
-        char date_str[512];
-        std::strftime(date_str, sizeof(date_str), "%Y-%m-%d", &st);
-        std::setlocale(LC_TIME, old_lc_time);
-        convert(date_str, result);
+        convert(date_as_string(d), result);
         return;
     }
 
     case SQL_C_TIME:
     {
         const time t = *ensure_pdata<time>(column);
-        std::tm st{};
-        st.tm_hour = t.hour;
-        st.tm_min = t.min;
-        st.tm_sec = t.sec;
-        std::string old_lc_time_container;
-        const char* old_lc_time = nullptr;
-        if (char const* olc_lc_time_ptr = std::setlocale(LC_TIME, nullptr))
-        {
-            old_lc_time_container = olc_lc_time_ptr;
-            old_lc_time = old_lc_time_container.c_str();
-        }
-        std::setlocale(LC_TIME, "");
-        char date_str[512];
-        std::strftime(date_str, sizeof(date_str), "%H:%M:%S", &st);
-        std::setlocale(LC_TIME, old_lc_time);
-        convert(date_str, result);
+        convert(time_as_string(t), result);
         return;
     }
 
@@ -5026,25 +6837,7 @@ inline void result::result_impl::get_ref_impl(short column, T& result) const
         // strftime. The caller tests for the null again after this returns.
         if (is_null(column))
             return;
-        std::tm st{};
-        st.tm_year = stamp.year - 1900;
-        st.tm_mon = stamp.month - 1;
-        st.tm_mday = stamp.day;
-        st.tm_hour = stamp.hour;
-        st.tm_min = stamp.min;
-        st.tm_sec = stamp.sec;
-        std::string old_lc_time_container;
-        const char* old_lc_time = nullptr;
-        if (char const* olc_lc_time_ptr = std::setlocale(LC_TIME, nullptr))
-        {
-            old_lc_time_container = olc_lc_time_ptr;
-            old_lc_time = old_lc_time_container.c_str();
-        }
-        std::setlocale(LC_TIME, "");
-        char date_str[512];
-        std::strftime(date_str, sizeof(date_str), "%Y-%m-%d %H:%M:%S %z", &st);
-        std::setlocale(LC_TIME, old_lc_time);
-        convert(date_str, result);
+        convert(timestamp_as_string(stamp), result);
         return;
     }
     default:
@@ -5067,6 +6860,7 @@ inline void result::result_impl::get_ref_impl<std::vector<std::uint8_t>>(
     {
         if (!is_bound(column))
         {
+            auto const handle_lock = lock_handle();
             // Input and output is always array of bytes.
             std::vector<std::uint8_t> out;
             std::uint8_t buffer[1024] = {0};
@@ -5324,33 +7118,208 @@ inline void result::result_impl::get_ref_impl<_variant_t>(short column, _variant
 }
 #endif
 
+#ifdef NANODBC_HAS_STD_VARIANT
+namespace
+{
+// The alternative of the cell, made current if it is not already, so that a string left over
+// from the previous row keeps its storage.
+template <class T>
+T& value_as(value& cell)
+{
+    if (!std::holds_alternative<T>(cell))
+        cell.emplace<T>();
+    return std::get<T>(cell);
+}
+} // namespace
+
+template <>
+inline void result::result_impl::get_ref_impl<value>(short column, value& result) const
+{
+    bound_column const& col = bound_columns_[column];
+    switch (col.ctype_)
+    {
+    case SQL_C_BIT:
+    case SQL_C_TINYINT:
+    case SQL_C_STINYINT:
+    case SQL_C_UTINYINT:
+    case SQL_C_SHORT:
+    case SQL_C_SSHORT:
+    case SQL_C_USHORT:
+    case SQL_C_LONG:
+    case SQL_C_SLONG:
+    case SQL_C_ULONG:
+    case SQL_C_SBIGINT:
+    case SQL_C_UBIGINT:
+        get_ref_impl(column, value_as<long long>(result));
+        return;
+    case SQL_C_FLOAT:
+    case SQL_C_DOUBLE:
+        get_ref_impl(column, value_as<double>(result));
+        return;
+    case SQL_C_DATE:
+        get_ref_impl(column, value_as<date>(result));
+        return;
+    case SQL_C_TIME:
+        get_ref_impl(column, value_as<time>(result));
+        return;
+    case SQL_C_TIMESTAMP:
+        get_ref_impl(column, value_as<timestamp>(result));
+        return;
+    case SQL_C_BINARY:
+        // Bound as binary, but rendered as text like get<string>() does.
+        if (col.sqltype_ == SQL_SS_TIMESTAMPOFFSET)
+            break;
+        get_ref_impl(column, value_as<std::vector<std::uint8_t>>(result));
+        return;
+    default:
+        break;
+    }
+    get_ref_impl(column, value_as<string>(result));
+}
+
+inline void result::result_impl::get_row(std::vector<value>& row) const
+{
+    short const count = columns();
+    row.resize(static_cast<std::size_t>(count));
+    for (short column = 0; column < count; ++column)
+    {
+        value& cell = row[static_cast<std::size_t>(column)];
+        if (is_null(column))
+        {
+            cell = std::monostate{};
+            continue;
+        }
+        get_ref_impl(column, cell);
+
+        // An unbound column's null is only known once SQLGetData has run.
+        if (is_null(column))
+            cell = std::monostate{};
+    }
+}
+#endif
+
 namespace detail
 {
-auto from_string(std::string const& s, float)
+// The numbers below are read as std::stoll, std::stod and the like read them: whitespace in
+// front is skipped, a sign may lead, and anything after the number is ignored, so that "12.50"
+// read as an integer is 12. Unlike those they read a range of characters rather than a
+// std::string, and the decimal mark is always '.', whatever the locale.
+
+inline bool is_number_space(char c) noexcept
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Skips whitespace and a sign, returning whether the sign was a minus.
+inline bool skip_to_digits(char const*& first, char const* last) noexcept
+{
+    while (first != last && is_number_space(*first))
+        ++first;
+    bool const negative = first != last && *first == '-';
+    if (first != last && (*first == '-' || *first == '+'))
+        ++first;
+    return negative;
+}
+
+inline unsigned long long parse_magnitude(char const* first, char const* last)
+{
+    if (first == last || *first < '0' || *first > '9')
+        throw std::invalid_argument("from_string: no number");
+    constexpr auto max = std::numeric_limits<unsigned long long>::max();
+    unsigned long long value = 0;
+    for (; first != last && *first >= '0' && *first <= '9'; ++first)
+    {
+        auto const digit = static_cast<unsigned>(*first - '0');
+        if (value > (max - digit) / 10)
+            throw std::out_of_range("from_string: out of range");
+        value = value * 10 + digit;
+    }
+    return value;
+}
+
+inline long long from_chars(char const* first, char const* last, long long)
 {
-    return std::stof(s);
+    bool const negative = skip_to_digits(first, last);
+    auto const magnitude = parse_magnitude(first, last);
+    constexpr auto max = static_cast<unsigned long long>(std::numeric_limits<long long>::max());
+    if (magnitude > max + (negative ? 1 : 0))
+        throw std::out_of_range("from_string: out of range");
+    if (!negative || magnitude == 0)
+        return static_cast<long long>(magnitude);
+    return -static_cast<long long>(magnitude - 1) - 1;
 }
 
-auto from_string(std::string const& s, double)
+// Unlike std::stoull, a negative number is out of range rather than wrapped around.
+inline unsigned long long from_chars(char const* first, char const* last, unsigned long long)
 {
-    return std::stod(s);
+    bool const negative = skip_to_digits(first, last);
+    auto const magnitude = parse_magnitude(first, last);
+    if (negative && magnitude != 0)
+        throw std::out_of_range("from_string: out of range");
+    return magnitude;
+}
+
+template <class T>
+T from_chars_real(char const* first, char const* last)
+{
+    while (first != last && is_number_space(*first))
+        ++first;
+#if defined(NANODBC_HAS_STD_FROM_CHARS)
+    // std::from_chars takes no plus sign.
+    if (last - first > 1 && *first == '+' && first[1] != '-' && first[1] != '+')
+        ++first;
+    T value{};
+    auto const parsed = std::from_chars(first, last, value);
+    if (parsed.ec == std::errc::invalid_argument)
+        throw std::invalid_argument("from_string: no number");
+    if (parsed.ec == std::errc::result_out_of_range)
+        throw std::out_of_range("from_string: out of range");
+    return value;
+#else
+    // strtod reads the decimal mark of the C locale, so the number is copied, and its '.'
+    // swapped for that mark where it is another.
+    char const mark = *std::localeconv()->decimal_point;
+    char buffer[128];
+    std::string long_text;
+    auto const size = static_cast<std::size_t>(last - first);
+    char* text = buffer;
+    if (size >= sizeof(buffer))
+    {
+        long_text.resize(size + 1);
+        text = &long_text[0];
+    }
+    for (std::size_t i = 0; i < size; ++i)
+        text[i] = first[i] == '.' ? mark : first[i];
+    text[size] = '\0';
+
+    char* end = nullptr;
+    errno = 0;
+    auto const value = std::is_same<T, float>::value ? std::strtof(text, &end)
+                                                      : std::strtod(text, &end);
+    if (end == text)
+        throw std::invalid_argument("from_string: no number");
+    if (errno == ERANGE)
+        throw std::out_of_range("from_string: out of range");
+    return static_cast<T>(value);
+#endif
 }
 
-auto from_string(std::string const& s, long long)
+inline float from_chars(char const* first, char const* last, float)
 {
-    return std::stoll(s);
+    return from_chars_real<float>(first, last);
 }
 
-auto from_string(std::string const& s, unsigned long long)
+inline double from_chars(char const* first, char const* last, double)
 {
-    return std::stoull(s);
+    return from_chars_real<double>(first, last);
 }
 
 template <typename R, typename std::enable_if<std::is_integral<R>::value, int>::type = 0>
-auto from_string(std::string const& s, R)
+R from_chars(char const* first, char const* last, R)
 {
-    auto const integer = from_string(
-        s,
+    auto const integer = from_chars(
+        first,
+        last,
         typename std::conditional<std::is_signed<R>::value, long long, unsigned long long>::type{});
     if (integer > std::numeric_limits<R>::max() || integer < std::numeric_limits<R>::min())
         throw std::range_error("from_string argument out of range");
@@ -5358,18 +7327,25 @@ auto from_string(std::string const& s, R)
 }
 
 #if defined(_MSC_VER)
-auto from_string(std::string const& s, _variant_t) noexcept
+inline _variant_t from_chars(char const* first, char const* last, _variant_t)
 {
-    return s.c_str();
+    return std::string(first, last).c_str();
 }
 #endif
 
 } // namespace detail
 
+// Reads a number from the characters of [first, last), with no copy of them made.
+template <typename R>
+auto from_string(char const* first, char const* last) -> R
+{
+    return detail::from_chars(first, last, R{});
+}
+
 template <typename R>
 auto from_string(std::string const& s) -> R
 {
-    return detail::from_string(s, R{});
+    return from_string<R>(s.data(), s.data() + s.size());
 }
 
 template <class T, typename std::enable_if<is_character<T>::value, int>::type>
@@ -5396,6 +7372,29 @@ void result::result_impl::get_ref_from_string_column(short column, T& result) co
     bound_column const& col = bound_columns_[column];
     if (col.ctype_ != SQL_C_CHAR && col.ctype_ != SQL_C_WCHAR)
         throw type_incompatible_error();
+
+    // A bound value, such as that of a DECIMAL column, is read where it lies. A wide one is
+    // narrowed first, which loses nothing of a number.
+    std::size_t length = 0;
+    if (char const* const data = bound_cell(column, length))
+    {
+        if (col.ctype_ == SQL_C_CHAR)
+        {
+            result = from_string<T>(data, data + length);
+            return;
+        }
+        auto const units = reinterpret_cast<SQLWCHAR const*>(data);
+        char narrow[128];
+        auto const count = length / sizeof(SQLWCHAR);
+        if (count <= sizeof(narrow))
+        {
+            for (std::size_t i = 0; i < count; ++i)
+                narrow[i] = units[i] < 0x80 ? static_cast<char>(units[i]) : '?';
+            result = from_string<T>(narrow, narrow + count);
+            return;
+        }
+    }
+
     std::string str;
     get_ref_impl(col.column_, str);
     result = from_string<T>(str);
@@ -5516,6 +7515,11 @@ std::list<datasource> list_datasources()
     SQLSMALLINT driver_len_ret{0};
     SQLUSMALLINT direction{SQL_FETCH_FIRST};
 
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+    if (linked_functions.load(std::memory_order_acquire))
+        throw programming_error("list_datasources needs the driver manager, not a linked driver");
+#endif
+
     connection env; // ensures handles RAII
     env.allocate();
     NANODBC_ASSERT(env.native_env_handle());
@@ -5568,6 +7572,11 @@ std::list<driver> list_drivers()
     SQLSMALLINT attrs_len_ret{0};
     SQLUSMALLINT direction{SQL_FETCH_FIRST};
 
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+    if (linked_functions.load(std::memory_order_acquire))
+        throw programming_error("list_drivers needs the driver manager, not a linked driver");
+#endif
+
     connection env; // ensures handles RAII
     env.allocate();
     NANODBC_ASSERT(env.native_env_handle());
@@ -5627,6 +7636,53 @@ std::list<driver> list_drivers()
     return drivers;
 }
 
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+void link_driver(std::string const& path)
+{
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> guard(mutex);
+
+    if (auto const linked = linked_functions.load(std::memory_order_acquire))
+    {
+        if (linked->path == path)
+            return;
+        throw programming_error("another driver is linked already: " + linked->path);
+    }
+    if (live_environments.load(std::memory_order_relaxed) != 0)
+        throw programming_error("cannot link a driver while connections are open");
+
+    void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library)
+        throw programming_error("cannot load driver: " + std::string(dlerror()));
+
+    std::unique_ptr<driver_functions> functions(new driver_functions());
+    functions->path = path;
+#define NANODBC_RESOLVE_FUNCTION(f) resolve_driver_function(library, #f, functions->f);
+    NANODBC_DRIVER_FUNCTIONS(NANODBC_RESOLVE_FUNCTION)
+    NANODBC_DRIVER_WIDE_FUNCTIONS(NANODBC_RESOLVE_FUNCTION)
+    NANODBC_DRIVER_ASYNC_FUNCTIONS(NANODBC_RESOLVE_FUNCTION)
+#undef NANODBC_RESOLVE_FUNCTION
+
+    // Without these nanodbc can neither allocate a handle nor report why a call failed.
+    if (!dlsym(library, "SQLAllocHandle") || !dlsym(library, "SQLFreeHandle") ||
+        !dlsym(library, NANODBC_STRINGIZE(NANODBC_FUNC(SQLGetDiagRec))))
+    {
+        dlclose(library);
+        throw programming_error("not an ODBC driver: " + path);
+    }
+
+    // The library stays loaded for as long as the process runs, like the driver manager would
+    // keep a driver loaded while its handles are in use.
+    linked_functions.store(functions.release(), std::memory_order_release);
+}
+
+std::string linked_driver()
+{
+    auto const linked = linked_functions.load(std::memory_order_acquire);
+    return linked ? linked->path : std::string();
+}
+#endif
+
 result execute(connection& conn, string const& query, long batch_operations, long timeout)
 {
     class statement statement;
@@ -5862,78 +7918,152 @@ string connection::catalog_name() const
     return impl_->catalog_name();
 }
 
-std::size_t connection::ref_transaction() noexcept
+void connection::cache_parameter_descriptions(bool enable)
 {
-    return impl_->ref_transaction();
+    impl_->cache_parameter_descriptions(enable);
 }
 
-std::size_t connection::unref_transaction() noexcept
+bool connection::caches_parameter_descriptions() const noexcept
 {
-    return impl_->unref_transaction();
+    return impl_->caches_parameter_descriptions();
 }
 
-bool connection::rollback() const noexcept
+void connection::clear_parameter_descriptions()
 {
-    return impl_->rollback();
+    impl_->clear_parameter_descriptions();
 }
 
-void connection::rollback(bool onoff) noexcept
+driver_profile connection::profile() const
 {
-    impl_->rollback(onoff);
+    return impl_->profile();
 }
 
-} // namespace nanodbc
-
-// clang-format off
-// 88888888888                                                  888    d8b                             8888888888                 888
-//     888                                                      888    Y8P                             888                        888
-//     888                                                      888                                    888                        888
-//     888  888d888 8888b.  88888b.  .d8888b   8888b.   .d8888b 888888 888  .d88b.  88888b.            8888888 888  888  888  .d88888 .d8888b
-//     888  888P"      "88b 888 "88b 88K          "88b d88P"    888    888 d88""88b 888 "88b           888     888  888  888 d88" 888 88K
-//     888  888    .d888888 888  888 "Y8888b. .d888888 888      888    888 888  888 888  888           888     888  888  888 888  888 "Y8888b.
-//     888  888    888  888 888  888      X88 888  888 Y88b.    Y88b.  888 Y88..88P 888  888           888     Y88b 888 d88P Y88b 888      X88
-//     888  888    "Y888888 888  888  88888P' "Y888888  "Y8888P  "Y888 888  "Y88P"  888  888           888      "Y8888888P"   "Y88888  88888P'
-// MARK: Transaction Fwd -
-// clang-format on
-
-namespace nanodbc
-{
-
-transaction::transaction(const class connection& conn)
-    : impl_(std::make_shared<transaction_impl>(conn))
+void connection::set_profile(driver_profile const& profile)
 {
+    impl_->set_profile(profile);
 }
 
-transaction::transaction(const transaction& rhs) noexcept
-    : impl_(rhs.impl_)
+void connection::reset_profile()
 {
+    impl_->reset_profile();
 }
 
-transaction::transaction(transaction&& rhs) noexcept
-    : impl_(std::move(rhs.impl_))
+void connection::cache_metadata(std::chrono::seconds ttl)
 {
+    impl_->cache_metadata(ttl);
 }
 
-transaction& transaction::operator=(transaction rhs) noexcept
+std::chrono::seconds connection::metadata_ttl() const
 {
-    swap(rhs);
-    return *this;
+    return impl_->metadata_ttl();
 }
 
-void transaction::swap(transaction& rhs) noexcept
+void connection::invalidate_metadata()
 {
-    using std::swap;
-    swap(impl_, rhs.impl_);
+    impl_->invalidate_metadata();
 }
 
-transaction::~transaction() noexcept {}
-
-void transaction::commit()
+void connection::invalidate_metadata(
+    string const& table,
+    string const& schema,
+    string const& catalog)
 {
-    impl_->commit();
+    impl_->invalidate_metadata(table, schema, catalog);
 }
 
-void transaction::rollback() noexcept
+std::shared_ptr<void const> connection::cached_metadata(
+    short lookup,
+    string const& catalog,
+    string const& schema,
+    string const& table,
+    string const& column) const
+{
+    return impl_->cached_metadata(lookup, catalog, schema, table, column);
+}
+
+void connection::cache_metadata(
+    short lookup,
+    string const& catalog,
+    string const& schema,
+    string const& table,
+    string const& column,
+    std::shared_ptr<void const> rows)
+{
+    impl_->cache_metadata(lookup, catalog, schema, table, column, std::move(rows));
+}
+
+std::size_t connection::ref_transaction() noexcept
+{
+    return impl_->ref_transaction();
+}
+
+std::size_t connection::unref_transaction() noexcept
+{
+    return impl_->unref_transaction();
+}
+
+bool connection::rollback() const noexcept
+{
+    return impl_->rollback();
+}
+
+void connection::rollback(bool onoff) noexcept
+{
+    impl_->rollback(onoff);
+}
+
+} // namespace nanodbc
+
+// clang-format off
+// 88888888888                                                  888    d8b                             8888888888                 888
+//     888                                                      888    Y8P                             888                        888
+//     888                                                      888                                    888                        888
+//     888  888d888 8888b.  88888b.  .d8888b   8888b.   .d8888b 888888 888  .d88b.  88888b.            8888888 888  888  888  .d88888 .d8888b
+//     888  888P"      "88b 888 "88b 88K          "88b d88P"    888    888 d88""88b 888 "88b           888     888  888  888 d88" 888 88K
+//     888  888    .d888888 888  888 "Y8888b. .d888888 888      888    888 888  888 888  888           888     888  888  888 888  888 "Y8888b.
+//     888  888    888  888 888  888      X88 888  888 Y88b.    Y88b.  888 Y88..88P 888  888           888     Y88b 888 d88P Y88b 888      X88
+//     888  888    "Y888888 888  888  88888P' "Y888888  "Y8888P  "Y888 888  "Y88P"  888  888           888      "Y8888888P"   "Y88888  88888P'
+// MARK: Transaction Fwd -
+// clang-format on
+
+namespace nanodbc
+{
+
+transaction::transaction(const class connection& conn)
+    : impl_(std::make_shared<transaction_impl>(conn))
+{
+}
+
+transaction::transaction(const transaction& rhs) noexcept
+    : impl_(rhs.impl_)
+{
+}
+
+transaction::transaction(transaction&& rhs) noexcept
+    : impl_(std::move(rhs.impl_))
+{
+}
+
+transaction& transaction::operator=(transaction rhs) noexcept
+{
+    swap(rhs);
+    return *this;
+}
+
+void transaction::swap(transaction& rhs) noexcept
+{
+    using std::swap;
+    swap(impl_, rhs.impl_);
+}
+
+transaction::~transaction() noexcept {}
+
+void transaction::commit()
+{
+    impl_->commit();
+}
+
+void transaction::rollback() noexcept
 {
     impl_->rollback();
 }
@@ -6029,6 +8159,11 @@ bool statement::open() const noexcept
     return impl_->open();
 }
 
+bool statement::prepared() const noexcept
+{
+    return impl_->prepared();
+}
+
 bool statement::connected() const noexcept
 {
     return impl_->connected();
@@ -6182,6 +8317,21 @@ void statement::reset_parameters() noexcept
     impl_->reset_parameters();
 }
 
+std::vector<statement::param_status> statement::parameter_status() const
+{
+    return impl_->parameter_status();
+}
+
+unsigned long statement::parameters_processed() const noexcept
+{
+    return impl_->parameters_processed();
+}
+
+std::vector<statement::param_diagnostic> statement::parameter_diagnostics() const
+{
+    return impl_->parameter_diagnostics();
+}
+
 unsigned long statement::parameter_size(short param_index) const
 {
     return impl_->parameter_size(param_index);
@@ -6255,6 +8405,27 @@ template void statement::bind(short, const bool*, std::size_t, param_direction);
 NANODBC_INSTANTIATE_BIND_STRINGS(std::string);
 NANODBC_INSTANTIATE_BIND_STRINGS(wide_string);
 
+// bind_ref() takes the types bind() does, but for the character types, whose single values
+// are strings bound by their own type instead.
+template void statement::bind_ref(short, bool&, param_direction);
+template void statement::bind_ref(short, signed char&, param_direction);
+template void statement::bind_ref(short, unsigned char&, param_direction);
+template void statement::bind_ref(short, short&, param_direction);
+template void statement::bind_ref(short, unsigned short&, param_direction);
+template void statement::bind_ref(short, int&, param_direction);
+template void statement::bind_ref(short, unsigned int&, param_direction);
+template void statement::bind_ref(short, long int&, param_direction);
+template void statement::bind_ref(short, unsigned long int&, param_direction);
+template void statement::bind_ref(short, long long&, param_direction);
+template void statement::bind_ref(short, unsigned long long&, param_direction);
+template void statement::bind_ref(short, float&, param_direction);
+template void statement::bind_ref(short, double&, param_direction);
+template void statement::bind_ref(short, date&, param_direction);
+template void statement::bind_ref(short, time&, param_direction);
+template void statement::bind_ref(short, timestamp&, param_direction);
+template void statement::bind_ref(short, std::string&, param_direction);
+template void statement::bind_ref(short, wide_string&, param_direction);
+
 #ifdef NANODBC_HAS_STD_STRING_VIEW
 NANODBC_INSTANTIATE_BIND_VECTOR_STRINGS(std::string_view);
 NANODBC_INSTANTIATE_BIND_VECTOR_STRINGS(wide_string_view);
@@ -6392,11 +8563,26 @@ void statement::bind_strings(
     impl_->bind_strings(direction, param_index, values, nulls);
 }
 
+template <class T>
+void statement::bind_ref(short param_index, T& value, param_direction direction)
+{
+    impl_->bind_ref(direction, param_index, value);
+}
+
 void statement::bind_null(short param_index, std::size_t batch_size)
 {
     impl_->bind_null(param_index, batch_size);
 }
 
+void statement::bind_rows(
+    void const* rows,
+    std::size_t count,
+    std::size_t row_size,
+    std::vector<row_parameter> const& parameters)
+{
+    impl_->bind_rows(rows, count, row_size, parameters);
+}
+
 void statement::describe_parameters(
     const std::vector<short>& idx,
     const std::vector<short>& type,
@@ -6406,6 +8592,16 @@ void statement::describe_parameters(
     impl_->describe_parameters(idx, type, size, scale);
 }
 
+void statement::describe_parameters(std::vector<param_description> const& descriptions)
+{
+    impl_->describe_parameters(descriptions);
+}
+
+std::vector<statement::param_description> statement::parameter_descriptions()
+{
+    return impl_->parameter_descriptions();
+}
+
 } // namespace nanodbc
 
 // clang-format off
@@ -7013,47 +9209,224 @@ short table_valued_parameter::parameter_type(short param_index) const
 //                                                   "Y88P"
 // MARK: Catalog -
 // clang-format on
+
+namespace
+{
+
+// Catalog results are fetched in blocks too. Their columns include wide ones, such as REMARKS
+// and COLUMN_DEF, so blocks stay smaller than those of a query.
+long catalog_rowset_size(nanodbc::connection const& conn)
+{
+    return std::min(conn.profile().rows_per_fetch, 256L);
+}
+
+// Gives each distinct name one position in the strings of a catalog_snapshot.
+class name_interner
+{
+public:
+    explicit name_interner(std::vector<nanodbc::string>& strings)
+        : strings_(strings)
+    {
+        intern(nanodbc::string());
+    }
+
+    std::uint32_t intern(nanodbc::string const& name)
+    {
+        auto const found = ids_.find(name);
+        if (found != ids_.end())
+            return found->second;
+        auto const id = static_cast<std::uint32_t>(strings_.size());
+        strings_.push_back(name);
+        ids_.emplace(name, id);
+        return id;
+    }
+
+    // Finds the position of a name already interned, without interning it if it is not.
+    bool find(nanodbc::string const& name, std::uint32_t& id) const
+    {
+        auto const found = ids_.find(name);
+        if (found == ids_.end())
+            return false;
+        id = found->second;
+        return true;
+    }
+
+private:
+    std::vector<nanodbc::string>& strings_;
+    std::unordered_map<nanodbc::string, std::uint32_t> ids_;
+};
+
+// Lookups kept by the metadata cache of a connection.
+short const cached_columns_lookup = 1;
+short const cached_primary_keys_lookup = 2;
+short const cached_tables_lookup = 3; // kept with the table type in place of the column
+
+} // namespace
+
 namespace nanodbc
 {
 
+// Every row of a catalog result, read in full so that the connection can keep it. Character
+// columns are kept as text and the others as numbers, as the accessors read them.
+class catalog::cached_rows
+{
+public:
+    explicit cached_rows(result& rows)
+        : columns_(rows.columns())
+    {
+        std::vector<bool> text(static_cast<std::size_t>(columns_));
+        for (short i = 0; i < columns_; ++i)
+        {
+            switch (rows.column_datatype(i))
+            {
+            case SQL_CHAR:
+            case SQL_VARCHAR:
+            case SQL_LONGVARCHAR:
+            case SQL_WCHAR:
+            case SQL_WVARCHAR:
+            case SQL_WLONGVARCHAR:
+                text[static_cast<std::size_t>(i)] = true;
+                break;
+            default:
+                break;
+            }
+        }
+        while (rows.next())
+        {
+            for (short i = 0; i < columns_; ++i)
+            {
+                cell value;
+                if (text[static_cast<std::size_t>(i)])
+                    value.text = rows.get<string>(i, string());
+                else
+                    value.number = rows.get<long long>(i, 0);
+                value.is_text = text[static_cast<std::size_t>(i)];
+                value.is_null = rows.is_null(i);
+                cells_.push_back(std::move(value));
+            }
+            ++rows_;
+        }
+    }
+
+    std::size_t rows() const noexcept { return rows_; }
+
+    template <class T>
+    T get(std::size_t row, short column) const
+    {
+        cell const& value = at(row, column);
+        if (value.is_null)
+            throw null_access_error();
+        return as(value, T());
+    }
+
+    template <class T>
+    T get(std::size_t row, short column, T const& fallback) const
+    {
+        cell const& value = at(row, column);
+        return value.is_null ? fallback : as(value, T());
+    }
+
+private:
+    struct cell
+    {
+        string text;
+        long long number = 0;
+        bool is_text = false;
+        bool is_null = true;
+    };
+
+    cell const& at(std::size_t row, short column) const
+    {
+        if (column < 0 || column >= columns_)
+            throw index_range_error();
+        return cells_[row * static_cast<std::size_t>(columns_) + static_cast<std::size_t>(column)];
+    }
+
+    static string as(cell const& value, string)
+    {
+        if (value.is_text)
+            return value.text;
+        string text;
+        convert(std::to_string(value.number), text);
+        return text;
+    }
+
+    template <class T>
+    static T as(cell const& value, T)
+    {
+        if (!value.is_text)
+            return static_cast<T>(value.number);
+        std::string text;
+        convert(value.text, text);
+        return from_string<T>(text);
+    }
+
+    short const columns_;
+    std::size_t rows_{0};
+    std::vector<cell> cells_;
+};
+
 catalog::tables::tables(result& find_result) noexcept
     : result_(find_result)
 {
 }
 
+catalog::tables::tables(std::shared_ptr<cached_rows const> rows) noexcept
+    : cached_(std::move(rows))
+{
+}
+
+template <class T>
+T catalog::tables::get(short column) const
+{
+    return cached_ ? cached_->get<T>(cached_row_ - 1, column) : result_.get<T>(column);
+}
+
+template <class T>
+T catalog::tables::get(short column, T const& fallback) const
+{
+    return cached_ ? cached_->get<T>(cached_row_ - 1, column, fallback)
+                   : result_.get<T>(column, fallback);
+}
+
 bool catalog::tables::next()
 {
-    return result_.next();
+    if (!cached_)
+        return result_.next();
+    if (cached_row_ == cached_->rows())
+        return false;
+    ++cached_row_;
+    return true;
 }
 
 string catalog::tables::table_catalog() const
 {
     // TABLE_CAT might be NULL
-    return result_.get<string>(0, string());
+    return get<string>(0, string());
 }
 
 string catalog::tables::table_schema() const
 {
     // TABLE_SCHEM might be NULL
-    return result_.get<string>(1, string());
+    return get<string>(1, string());
 }
 
 string catalog::tables::table_name() const
 {
     // TABLE_NAME column is never NULL
-    return result_.get<string>(2);
+    return get<string>(2);
 }
 
 string catalog::tables::table_type() const
 {
     // TABLE_TYPE column is never NULL
-    return result_.get<string>(3);
+    return get<string>(3);
 }
 
 string catalog::tables::table_remarks() const
 {
     // REMARKS might be NULL
-    return result_.get<string>(4, string());
+    return get<string>(4, string());
 }
 
 catalog::procedures::procedures(result& find_result) noexcept
@@ -7154,45 +9527,68 @@ catalog::primary_keys::primary_keys(result& find_result) noexcept
 {
 }
 
+catalog::primary_keys::primary_keys(std::shared_ptr<cached_rows const> rows) noexcept
+    : cached_(std::move(rows))
+{
+}
+
+template <class T>
+T catalog::primary_keys::get(short column) const
+{
+    return cached_ ? cached_->get<T>(cached_row_ - 1, column) : result_.get<T>(column);
+}
+
+template <class T>
+T catalog::primary_keys::get(short column, T const& fallback) const
+{
+    return cached_ ? cached_->get<T>(cached_row_ - 1, column, fallback)
+                   : result_.get<T>(column, fallback);
+}
+
 bool catalog::primary_keys::next()
 {
-    return result_.next();
+    if (!cached_)
+        return result_.next();
+    if (cached_row_ == cached_->rows())
+        return false;
+    ++cached_row_;
+    return true;
 }
 
 string catalog::primary_keys::table_catalog() const
 {
     // TABLE_CAT might be NULL
-    return result_.get<string>(0, string());
+    return get<string>(0, string());
 }
 
 string catalog::primary_keys::table_schema() const
 {
     // TABLE_SCHEM might be NULL
-    return result_.get<string>(1, string());
+    return get<string>(1, string());
 }
 
 string catalog::primary_keys::table_name() const
 {
     // TABLE_NAME is never NULL
-    return result_.get<string>(2);
+    return get<string>(2);
 }
 
 string catalog::primary_keys::column_name() const
 {
     // COLUMN_NAME is never NULL
-    return result_.get<string>(3);
+    return get<string>(3);
 }
 
 short catalog::primary_keys::column_number() const
 {
     // KEY_SEQ is never NULL
-    return result_.get<short>(4);
+    return get<short>(4);
 }
 
 string catalog::primary_keys::primary_key_name() const
 {
     // PK_NAME might be NULL
-    return result_.get<string>(5);
+    return get<string>(5);
 }
 
 catalog::procedure_columns::procedure_columns(result& find_result) noexcept
@@ -7324,117 +9720,140 @@ catalog::columns::columns(result& find_result) noexcept
 {
 }
 
+catalog::columns::columns(std::shared_ptr<cached_rows const> rows) noexcept
+    : cached_(std::move(rows))
+{
+}
+
+template <class T>
+T catalog::columns::get(short column) const
+{
+    return cached_ ? cached_->get<T>(cached_row_ - 1, column) : result_.get<T>(column);
+}
+
+template <class T>
+T catalog::columns::get(short column, T const& fallback) const
+{
+    return cached_ ? cached_->get<T>(cached_row_ - 1, column, fallback)
+                   : result_.get<T>(column, fallback);
+}
+
 bool catalog::columns::next()
 {
-    return result_.next();
+    if (!cached_)
+        return result_.next();
+    if (cached_row_ == cached_->rows())
+        return false;
+    ++cached_row_;
+    return true;
 }
 
 string catalog::columns::table_catalog() const
 {
     // TABLE_CAT might be NULL
-    return result_.get<string>(0, string());
+    return get<string>(0, string());
 }
 
 string catalog::columns::table_schema() const
 {
     // TABLE_SCHEM might be NULL
-    return result_.get<string>(1, string());
+    return get<string>(1, string());
 }
 
 string catalog::columns::table_name() const
 {
     // TABLE_NAME is never NULL
-    return result_.get<string>(2);
+    return get<string>(2);
 }
 
 string catalog::columns::column_name() const
 {
     // COLUMN_NAME is never NULL
-    return result_.get<string>(3);
+    return get<string>(3);
 }
 
 short catalog::columns::data_type() const
 {
     // DATA_TYPE is never NULL
-    return result_.get<short>(4);
+    return get<short>(4);
 }
 
 string catalog::columns::type_name() const
 {
     // TYPE_NAME is never NULL
-    return result_.get<string>(5);
+    return get<string>(5);
 }
 
 long catalog::columns::column_size() const
 {
     // COLUMN_SIZE
-    return result_.get<long>(6);
+    return get<long>(6);
 }
 
 long catalog::columns::buffer_length() const
 {
     // BUFFER_LENGTH
-    return result_.get<long>(7);
+    return get<long>(7);
 }
 
 short catalog::columns::decimal_digits() const
 {
     // DECIMAL_DIGITS might be NULL
-    return result_.get<short>(8, 0);
+    return get<short>(8, 0);
 }
 
 short catalog::columns::numeric_precision_radix() const
 {
     // NUM_PREC_RADIX might be NULL
-    return result_.get<short>(9, 0);
+    return get<short>(9, 0);
 }
 
 short catalog::columns::nullable() const
 {
     // NULLABLE is never NULL
-    return result_.get<short>(10);
+    return get<short>(10);
 }
 
 string catalog::columns::remarks() const
 {
     // REMARKS might be NULL
-    return result_.get<string>(11, string());
+    return get<string>(11, string());
 }
 
 string catalog::columns::column_default() const
 {
     // COLUMN_DEF might be NULL, if no default value is specified
-    return result_.get<string>(12, string());
+    return get<string>(12, string());
 }
 
 short catalog::columns::sql_data_type() const
 {
     // SQL_DATA_TYPE is never NULL
-    return result_.get<short>(13);
+    return get<short>(13);
 }
 
 short catalog::columns::sql_datetime_subtype() const
 {
     // SQL_DATETIME_SUB might be NULL
-    return result_.get<short>(14, 0);
+    return get<short>(14, 0);
 }
 
 long catalog::columns::char_octet_length() const
 {
     // CHAR_OCTET_LENGTH might be NULL
-    return result_.get<long>(15, 0);
+    return get<long>(15, 0);
 }
 
 long catalog::columns::ordinal_position() const
 {
     // ORDINAL_POSITION is never NULL
-    return result_.get<long>(16);
+    return get<long>(16);
 }
 
 string catalog::columns::is_nullable() const
 {
     // IS_NULLABLE might be NULL.
-    return result_.get<string>(17, string());
+    return get<string>(17, string());
 }
 
 catalog::catalog(connection& conn) noexcept
@@ -7451,6 +9870,9 @@ catalog::tables catalog::find_tables(
     // A null search pattern does not constrain the search, as % does. A zero-length one
     // matches only the empty string. https://msdn.microsoft.com/en-us/library/ms710171.aspx
 
+    if (auto rows = conn_.cached_metadata(cached_tables_lookup, catalog, schema, table, type))
+        return catalog::tables(std::static_pointer_cast<cached_rows const>(rows));
+
     statement stmt(conn_);
     RETCODE rc = SQL_SUCCESS;
     NANODBC_CALL_RC(
@@ -7468,7 +9890,13 @@ catalog::tables catalog::find_tables(
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
+    if (conn_.metadata_ttl() > std::chrono::seconds::zero())
+    {
+        auto rows = std::make_shared<cached_rows const>(find_result);
+        conn_.cache_metadata(cached_tables_lookup, catalog, schema, table, type, rows);
+        return catalog::tables(std::move(rows));
+    }
     catalog::tables tables(find_result);
     return tables;
 }
@@ -7494,7 +9922,7 @@ catalog::find_procedures(string const& procedure, string const& schema, string c
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
     catalog::procedures procedures(find_result);
     return procedures;
 }
@@ -7522,7 +9950,7 @@ catalog::procedure_columns catalog::find_procedure_columns(
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
     catalog::procedure_columns columns(find_result);
     return columns;
 }
@@ -7548,7 +9976,7 @@ catalog::find_table_privileges(string const& catalog, string const& table, strin
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
     catalog::table_privileges privileges(find_result);
     return privileges;
 }
@@ -7559,6 +9987,9 @@ catalog::columns catalog::find_columns(
     string const& schema,
     string const& catalog)
 {
+    if (auto rows = conn_.cached_metadata(cached_columns_lookup, catalog, schema, table, column))
+        return catalog::columns(std::static_pointer_cast<cached_rows const>(rows));
+
     statement stmt(conn_);
     RETCODE rc = SQL_SUCCESS;
     NANODBC_CALL_RC(
@@ -7576,7 +10007,13 @@ catalog::columns catalog::find_columns(
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
+    if (conn_.metadata_ttl() > std::chrono::seconds::zero())
+    {
+        auto rows = std::make_shared<cached_rows const>(find_result);
+        conn_.cache_metadata(cached_columns_lookup, catalog, schema, table, column, rows);
+        return catalog::columns(std::move(rows));
+    }
     catalog::columns columns(find_result);
     return columns;
 }
@@ -7584,6 +10021,10 @@ catalog::columns catalog::find_columns(
 catalog::primary_keys
 catalog::find_primary_keys(string const& table, string const& schema, string const& catalog)
 {
+    if (auto rows =
+            conn_.cached_metadata(cached_primary_keys_lookup, catalog, schema, table, string()))
+        return catalog::primary_keys(std::static_pointer_cast<cached_rows const>(rows));
+
     statement stmt(conn_);
     RETCODE rc = SQL_SUCCESS;
     NANODBC_CALL_RC(
@@ -7599,7 +10040,13 @@ catalog::find_primary_keys(string const& table, string const& schema, string con
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
+    if (conn_.metadata_ttl() > std::chrono::seconds::zero())
+    {
+        auto rows = std::make_shared<cached_rows const>(find_result);
+        conn_.cache_metadata(cached_primary_keys_lookup, catalog, schema, table, string(), rows);
+        return catalog::primary_keys(std::move(rows));
+    }
     catalog::primary_keys keys(find_result);
     return keys;
 }
@@ -7625,7 +10072,7 @@ std::list<string> catalog::list_catalogs()
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
     catalog::tables catalogs(find_result);
 
     std::list<string> names;
@@ -7655,7 +10102,7 @@ std::list<string> catalog::list_schemas()
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
     catalog::tables schemas(find_result);
 
     std::list<string> names;
@@ -7683,7 +10130,7 @@ std::list<string> catalog::list_table_types()
     if (!success(rc))
         NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
 
-    result find_result(stmt, 1);
+    result find_result(stmt, catalog_rowset_size(conn_));
     catalog::tables table_types(find_result);
 
     std::list<string> names;
@@ -7692,10 +10139,140 @@ std::list<string> catalog::list_table_types()
     return names;
 }
 
-} // namespace nanodbc
+catalog_snapshot catalog::snapshot(catalog_snapshot_options const& options)
+{
+    catalog_snapshot snapshot;
+    name_interner names(snapshot.strings);
 
-// clang-format off
-// 8888888b.                            888 888              8888888888                 888
+    // Tables by the catalog, schema and name ids that columns are matched against.
+    std::map<std::array<std::uint32_t, 3>, std::uint32_t> table_ids;
+    {
+        auto tables = find_tables(options.table, options.type, options.schema, options.catalog);
+        while (tables.next())
+        {
+            catalog_snapshot::table table{};
+            table.catalog = names.intern(tables.table_catalog());
+            table.schema = names.intern(tables.table_schema());
+            table.name = names.intern(tables.table_name());
+            table.type = names.intern(tables.table_type());
+            table_ids.emplace(
+                std::array<std::uint32_t, 3>{{table.catalog, table.schema, table.name}},
+                static_cast<std::uint32_t>(snapshot.tables.size()));
+            snapshot.tables.push_back(table);
+        }
+    }
+
+    // One search for the columns of every table, skipping those of tables of other types. The
+    // names of a column are only interned once its table is found to be kept, so those of the
+    // tables skipped take no room in the strings.
+    {
+        auto columns = find_columns(string(), options.table, options.schema, options.catalog);
+        while (columns.next())
+        {
+            std::array<std::uint32_t, 3> key;
+            if (!names.find(columns.table_catalog(), key[0]) ||
+                !names.find(columns.table_schema(), key[1]) ||
+                !names.find(columns.table_name(), key[2]))
+                continue;
+            auto const table = table_ids.find(key);
+            if (table == table_ids.end())
+                continue;
+            catalog_snapshot::column column{};
+            column.table = table->second;
+            column.name = names.intern(columns.column_name());
+            column.type_name = names.intern(columns.type_name());
+            column.default_value = names.intern(columns.column_default());
+            column.column_size = columns.column_size();
+            column.ordinal_position = columns.ordinal_position();
+            column.data_type = columns.data_type();
+            column.decimal_digits = columns.decimal_digits();
+            column.nullable = columns.nullable();
+            snapshot.columns.push_back(column);
+        }
+        // Columns come ordered by ordinal position within a table, and tables by type first.
+        std::stable_sort(
+            snapshot.columns.begin(),
+            snapshot.columns.end(),
+            [](catalog_snapshot::column const& a, catalog_snapshot::column const& b) {
+                return a.table < b.table;
+            });
+        for (std::size_t i = 0; i < snapshot.columns.size(); ++i)
+        {
+            auto& table = snapshot.tables[snapshot.columns[i].table];
+            if (table.column_count++ == 0)
+                table.first_column = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    // Neither lookup takes a pattern, so both go table by table.
+    for (std::size_t t = 0; t < snapshot.tables.size(); ++t)
+    {
+        auto& table = snapshot.tables[t];
+        auto const id = static_cast<std::uint32_t>(t);
+        string const& catalog = snapshot.strings[table.catalog];
+        string const& schema = snapshot.strings[table.schema];
+        string const& name = snapshot.strings[table.name];
+
+        if (options.primary_keys)
+        {
+            table.first_key_column = static_cast<std::uint32_t>(snapshot.key_columns.size());
+            auto keys = find_primary_keys(name, schema, catalog);
+            while (keys.next())
+            {
+                catalog_snapshot::key_column key{};
+                key.table = id;
+                key.column = names.intern(keys.column_name());
+                key.key_name = names.intern(keys.primary_key_name());
+                key.sequence = keys.column_number();
+                snapshot.key_columns.push_back(key);
+                ++table.key_column_count;
+            }
+        }
+
+        if (options.indexes)
+        {
+            table.first_index_column = static_cast<std::uint32_t>(snapshot.index_columns.size());
+            statement stmt(conn_);
+            RETCODE rc = SQL_SUCCESS;
+            NANODBC_CALL_RC(
+                NANODBC_FUNC(SQLStatistics),
+                rc,
+                stmt.native_statement_handle(),
+                (NANODBC_SQLCHAR*)(catalog.empty() ? nullptr : catalog.c_str()),
+                (catalog.empty() ? 0 : SQL_NTS),
+                (NANODBC_SQLCHAR*)(schema.empty() ? nullptr : schema.c_str()),
+                (schema.empty() ? 0 : SQL_NTS),
+                (NANODBC_SQLCHAR*)name.c_str(),
+                SQL_NTS,
+                SQL_INDEX_ALL,
+                SQL_QUICK);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt.native_statement_handle(), SQL_HANDLE_STMT);
+
+            result statistics(stmt, catalog_rowset_size(conn_));
+            while (statistics.next())
+            {
+                // TYPE is SQL_TABLE_STAT for the row of table statistics, which has no index.
+                if (statistics.get<short>(6) == SQL_TABLE_STAT)
+                    continue;
+                catalog_snapshot::index_column column{};
+                column.table = id;
+                column.name = names.intern(statistics.get<string>(5, string()));
+                column.column = names.intern(statistics.get<string>(8, string()));
+                column.position = statistics.get<short>(7, 0);
+                column.unique = statistics.get<short>(3, 1) == SQL_FALSE;
+                snapshot.index_columns.push_back(column);
+                ++table.index_column_count;
+            }
+        }
+    }
+    return snapshot;
+}
+
+} // namespace nanodbc
+
+// clang-format off
+// 8888888b.                            888 888              8888888888                 888
 // 888   Y88b                           888 888              888                        888
 // 888    888                           888 888              888                        888
 // 888   d88P .d88b.  .d8888b  888  888 888 888888           8888888 888  888  888  .d88888
@@ -7988,6 +10565,136 @@ result::operator bool() const noexcept
     return static_cast<bool>(impl_);
 }
 
+prefetching_result::prefetching_result(result&& rows)
+    : result_(std::move(rows))
+{
+    if (result_)
+        prefetching_ = result_.impl_->enable_prefetch();
+}
+
+bool prefetching_result::prefetching() const noexcept
+{
+    return prefetching_;
+}
+
+void* prefetching_result::native_statement_handle() const noexcept
+{
+    return result_.native_statement_handle();
+}
+
+long prefetching_result::rowset_size() const noexcept
+{
+    return result_.rowset_size();
+}
+
+long prefetching_result::rows() const noexcept
+{
+    return result_.rows();
+}
+
+short prefetching_result::columns() const
+{
+    return result_.columns();
+}
+
+bool prefetching_result::next()
+{
+    return result_.next();
+}
+
+bool prefetching_result::is_null(short column) const
+{
+    return result_.is_null(column);
+}
+
+bool prefetching_result::is_null(string const& column_name) const
+{
+    return result_.is_null(column_name);
+}
+
+short prefetching_result::column(string const& column_name) const
+{
+    return result_.column(column_name);
+}
+
+string prefetching_result::column_name(short column) const
+{
+    return result_.column_name(column);
+}
+
+prefetching_result::operator bool() const noexcept
+{
+    return static_cast<bool>(result_);
+}
+
+#ifdef NANODBC_HAS_STD_VARIANT
+cached_row_result::cached_row_result(result&& rows)
+    : result_(std::move(rows))
+{
+}
+
+void* cached_row_result::native_statement_handle() const noexcept
+{
+    return result_.native_statement_handle();
+}
+
+short cached_row_result::columns() const
+{
+    return result_.columns();
+}
+
+bool cached_row_result::next()
+{
+    has_row_ = result_.next();
+    if (has_row_)
+        result_.impl_->get_row(row_);
+    return has_row_;
+}
+
+value const& cached_row_result::get(short column) const
+{
+    if (!has_row_ || column < 0 || static_cast<std::size_t>(column) >= row_.size())
+        throw index_range_error();
+    return row_[static_cast<std::size_t>(column)];
+}
+
+value const& cached_row_result::get(string const& column_name) const
+{
+    return get(result_.column(column_name));
+}
+
+bool cached_row_result::is_null(short column) const
+{
+    return std::holds_alternative<std::monostate>(get(column));
+}
+
+bool cached_row_result::is_null(string const& column_name) const
+{
+    return std::holds_alternative<std::monostate>(get(column_name));
+}
+
+std::vector<value> const& cached_row_result::row() const noexcept
+{
+    static std::vector<value> const no_row;
+    return has_row_ ? row_ : no_row;
+}
+
+short cached_row_result::column(string const& column_name) const
+{
+    return result_.column(column_name);
+}
+
+string cached_row_result::column_name(short column) const
+{
+    return result_.column_name(column);
+}
+
+cached_row_result::operator bool() const noexcept
+{
+    return static_cast<bool>(result_);
+}
+#endif
+
 // The following are the only supported instantiations of result::get_ref().
 template void result::get_ref(short, std::string::value_type&) const;
 template void result::get_ref(short, wide_string::value_type&) const;
@@ -8306,11 +11013,4321 @@ template _variant_t result::get(string const&, _variant_t const&) const;
 #endif
 
 } // namespace nanodbc
+
+// clang-format off
+// 8888888b.                          888 888          888       .d8888b.
+// 888   Y88b                         888 888          888      d88P  Y88b
+// 888    888                         888 888          888      Y88b.
+// 888   d88P 8888b.  888d888 8888b.  888 888  .d88b.  888       "Y888b.    .d8888b  8888b.  88888b.
+// 8888888P"     "88b 888P"      "88b 888 888 d8P  Y8b 888          "Y88b. d88P"        "88b 888 "88b
+// 888       .d888888 888    .d888888 888 888 88888888 888            "888 888      .d888888 888  888
+// 888       888  888 888    888  888 888 888 Y8b.     888      Y88b  d88P Y88b.    888  888 888  888
+// 888       "Y888888 888    "Y888888 888 888  "Y8888  888       "Y8888P"   "Y8888P "Y888888 888  888
+// MARK: Parallel Scan -
+// clang-format on
+
+namespace
+{
+
+nanodbc::string const partition_placeholder = NANODBC_TEXT("{partition}");
+
+nanodbc::string partition_query(nanodbc::string const& query, nanodbc::string const& predicate)
+{
+    nanodbc::string sql;
+    nanodbc::string::size_type from = 0;
+    for (auto pos = query.find(partition_placeholder); pos != nanodbc::string::npos;
+         pos = query.find(partition_placeholder, from))
+    {
+        sql.append(query, from, pos - from);
+        sql += NANODBC_TEXT('(');
+        sql += predicate;
+        sql += NANODBC_TEXT(')');
+        from = pos + partition_placeholder.size();
+    }
+    sql.append(query, from, nanodbc::string::npos);
+    return sql;
+}
+
+// Partitions are dealt round-robin to per-worker queues. A worker takes work from the front
+// of its own queue and, once that is exhausted, steals from the back of the other queues.
+class scan_work_pool
+{
+public:
+    scan_work_pool(std::size_t workers, std::size_t partitions)
+        : queues_(workers)
+    {
+        for (std::size_t i = 0; i < partitions; ++i)
+            queues_[i % workers].indices.push_back(i);
+    }
+
+    bool take(std::size_t worker, std::size_t& index)
+    {
+        {
+            work_queue& own = queues_[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.indices.empty())
+            {
+                index = own.indices.front();
+                own.indices.pop_front();
+                return true;
+            }
+        }
+        for (std::size_t i = 1; i < queues_.size(); ++i)
+        {
+            work_queue& victim = queues_[(worker + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.indices.empty())
+            {
+                index = victim.indices.back();
+                victim.indices.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct work_queue
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> indices;
+    };
+
+    std::vector<work_queue> queues_;
+};
+
+} // namespace
+
+namespace nanodbc
+{
+
+std::vector<string> key_range_partitions(
+    connection& conn,
+    string const& table,
+    string const& key_column,
+    std::size_t count)
+{
+    if (count == 0)
+        count = 1;
+
+    result bounds = execute(
+        conn,
+        NANODBC_TEXT("SELECT MIN(") + key_column + NANODBC_TEXT("), MAX(") + key_column +
+            NANODBC_TEXT(") FROM ") + table);
+
+    std::vector<string> partitions;
+    if (bounds.next() && !bounds.is_null(0) && !bounds.is_null(1))
+    {
+        auto const lo = bounds.get<long long>(0);
+        auto const hi = bounds.get<long long>(1);
+        if (hi < lo)
+            throw programming_error("key range is empty");
+
+        // Offsets from the lower bound are computed unsigned, so the full range of a
+        // signed 64-bit key never overflows.
+        auto const span = static_cast<unsigned long long>(hi) - static_cast<unsigned long long>(lo);
+        unsigned long long parts = count;
+        if (span < parts - 1)
+            parts = span + 1;
+        auto const width = span / parts;
+        auto const rem = span % parts;
+
+        auto const boundary = [&](unsigned long long i) {
+            string value;
+            convert(
+                std::to_string(static_cast<long long>(
+                    static_cast<unsigned long long>(lo) + i * width + (std::min)(i, rem))),
+                value);
+            return value;
+        };
+
+        string lower = boundary(0);
+        for (unsigned long long i = 0; i < parts; ++i)
+        {
+            string predicate = key_column + NANODBC_TEXT(" >= ") + lower;
+            if (i + 1 < parts)
+            {
+                string upper = boundary(i + 1);
+                predicate += NANODBC_TEXT(" AND ") + key_column + NANODBC_TEXT(" < ") + upper;
+                lower = std::move(upper);
+            }
+            else
+            {
+                string upper;
+                convert(std::to_string(hi), upper);
+                predicate += NANODBC_TEXT(" AND ") + key_column + NANODBC_TEXT(" <= ") + upper;
+            }
+            partitions.push_back(std::move(predicate));
+        }
+    }
+    partitions.push_back(key_column + NANODBC_TEXT(" IS NULL"));
+    return partitions;
+}
+
+void parallel_scan(
+    std::function<connection()> const& connect,
+    string const& query,
+    std::vector<string> const& partitions,
+    std::function<void(scan_partition const&, result&)> const& consumer,
+    parallel_scan_options const& options)
+{
+    if (query.find(partition_placeholder) == string::npos)
+        throw programming_error("parallel_scan query has no {partition} placeholder");
+    if (!connect || !consumer)
+        throw programming_error("parallel_scan requires connection factory and consumer");
+    if (partitions.empty())
+        return;
+
+    std::size_t const workers =
+        (std::min)((std::max)(options.connections, std::size_t(1)), partitions.size());
+    scan_work_pool pool(workers, partitions.size());
+
+    std::atomic<bool> stop{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto const work = [&](std::size_t worker) {
+        try
+        {
+            connection conn = connect();
+            std::size_t index = 0;
+            while (!stop.load() && pool.take(worker, index))
+            {
+                result rows = execute(
+                    conn,
+                    partition_query(query, partitions[index]),
+                    options.rowset_size,
+                    options.timeout);
+                scan_partition const partition{index, partitions[index]};
+                consumer(partition, rows);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+            stop = true;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    try
+    {
+        for (std::size_t w = 0; w < workers; ++w)
+            threads.emplace_back(work, w);
+    }
+    catch (...)
+    {
+        stop = true;
+        for (auto& thread : threads)
+            thread.join();
+        throw;
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void parallel_scan(
+    string const& connection_string,
+    string const& query,
+    std::vector<string> const& partitions,
+    std::function<void(scan_partition const&, result&)> const& consumer,
+    parallel_scan_options const& options)
+{
+    parallel_scan(
+        [&connection_string] { return connection(connection_string); },
+        query,
+        partitions,
+        consumer,
+        options);
+}
+
+} // namespace nanodbc
+
+// clang-format off
+// 888888b.            888            888           888       888         d8b 888
+// 888  "88b           888            888           888   o   888         Y8P 888
+// 888  .88P           888            888           888  d8b  888             888
+// 8888888K.   8888b.  888888 .d8888b 88888b.       888 d888b 888 888d888 888 888888 .d88b.  888d888
+// 888  "Y88b     "88b 888   d88P"    888 "88b      888d88888b888 888P"   888 888   d8P  Y8b 888P"
+// 888    888 .d888888 888   888      888  888      88888P Y88888 888     888 888   88888888 888
+// 888   d88P 888  888 Y88b. Y88b.    888  888      8888P   Y8888 888     888 Y88b. Y8b.     888
+// 8888888P"  "Y888888  "Y888 "Y8888P 888  888      888P     Y888 888     888  "Y888 "Y8888  888
+// MARK: Batch Writer -
+// clang-format on
+
+namespace nanodbc
+{
+
+class batch_writer::batch_writer_impl
+{
+public:
+    batch_writer_impl(batch_writer_impl const&) = delete;
+    batch_writer_impl& operator=(batch_writer_impl const&) = delete;
+    batch_writer_impl(batch_writer_impl&&) = delete;
+    batch_writer_impl& operator=(batch_writer_impl&&) = delete;
+
+    batch_writer_impl(statement& stmt, std::size_t batch_size)
+        : stmt_(stmt)
+        , batch_size_(batch_size)
+        , status_(batch_size)
+    {
+        if (!stmt_.open() || !stmt_.prepared())
+            throw programming_error("batch_writer requires an open, prepared statement");
+        if (batch_size_ == 0)
+            throw programming_error("batch_writer batch size must be positive");
+#if defined(NANODBC_DO_ASYNC_IMPL)
+        // The background thread waits for each execution, which SQLExecute only does when
+        // asynchronous execution is off.
+        stmt_.disable_async();
+#endif
+    }
+
+    ~batch_writer_impl() noexcept
+    {
+        if (worker_.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                stop_ = true;
+                wake_.notify_all();
+            }
+            worker_.join();
+        }
+
+        // The statement outlives the writer, and must not keep pointers into its buffers.
+        if (arena_)
+            restore_statement();
+    }
+
+    void add_column(short param_index, SQLSMALLINT ctype, std::size_t value_size, bool text)
+    {
+        if (arena_)
+            throw programming_error("batch_writer columns must be added before any value is set");
+        if (param_index < 0)
+            throw index_range_error();
+        if (find_column(param_index))
+            throw programming_error("batch_writer column added twice");
+
+        column col;
+        col.index = param_index;
+        col.ctype = ctype;
+        col.value_size = value_size;
+        col.text = text;
+        col.type = stmt_.parameter_type(param_index);
+        col.size = stmt_.parameter_size(param_index);
+        col.scale = stmt_.parameter_scale(param_index);
+        columns_.push_back(col);
+    }
+
+    void on_batch(std::function<void(batch_result const&)> handler)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        handler_ = std::move(handler);
+    }
+
+    void set(short param_index, SQLSMALLINT ctype, void const* value, std::size_t value_size)
+    {
+        column const& col = column_for_value(param_index);
+        if (col.text || col.ctype != ctype || col.value_size != value_size)
+            throw type_incompatible_error();
+        std::memcpy(value_pointer(col), value, value_size);
+        *indicator_pointer(col) = static_cast<null_type>(value_size);
+    }
+
+    void set_string(short param_index, string::value_type const* value, std::size_t length)
+    {
+        using char_type = string::value_type;
+        column const& col = column_for_value(param_index);
+        if (!col.text)
+            throw type_incompatible_error();
+        if ((length + 1) * sizeof(char_type) > col.value_size)
+            throw programming_error("batch_writer string value exceeds its column length");
+        char_type* const data = static_cast<char_type*>(value_pointer(col));
+        std::copy(value, value + length, data);
+        data[length] = char_type();
+        *indicator_pointer(col) = SQL_NTS;
+    }
+
+    void add_row()
+    {
+        rethrow_pending_error();
+        prepare_buffers();
+        if (++row_ == batch_size_)
+            submit();
+    }
+
+    void flush()
+    {
+        rethrow_pending_error();
+        if (row_ > 0)
+            submit();
+    }
+
+    void finish()
+    {
+        flush();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return !busy_; });
+        }
+        rethrow_pending_error();
+    }
+
+    std::size_t rows() const noexcept { return row_; }
+
+private:
+    struct column
+    {
+        short index = 0;
+        SQLSMALLINT ctype = 0;
+        std::size_t value_size = 0;
+        bool text = false;
+        SQLSMALLINT type = 0;
+        SQLULEN size = 0;
+        SQLSMALLINT scale = 0;
+        std::size_t values_offset = 0;
+        std::size_t indicators_offset = 0;
+    };
+
+    column const* find_column(short param_index) const noexcept
+    {
+        for (auto const& col : columns_)
+            if (col.index == param_index)
+                return &col;
+        return nullptr;
+    }
+
+    column const& column_for_value(short param_index)
+    {
+        prepare_buffers();
+        column const* col = find_column(param_index);
+        if (!col)
+            throw index_range_error();
+        return *col;
+    }
+
+    void* value_pointer(column const& col) noexcept
+    {
+        return arena_.get() + fill_ * set_size_ + col.values_offset + row_ * col.value_size;
+    }
+
+    null_type* indicator_pointer(column const& col) noexcept
+    {
+        void* const indicators = arena_.get() + fill_ * set_size_ + col.indicators_offset;
+        return static_cast<null_type*>(indicators) + row_;
+    }
+
+    void clear_indicators(char* buffers, std::size_t set) noexcept
+    {
+        for (auto const& col : columns_)
+        {
+            void* const indicators = buffers + set * set_size_ + col.indicators_offset;
+            null_type* const first = static_cast<null_type*>(indicators);
+            for (std::size_t i = 0; i < batch_size_; ++i)
+                first[i] = SQL_NULL_DATA;
+        }
+    }
+
+    // Lays both buffer sets out in one block, the second at set_size_ bytes from the first,
+    // so that a single bind offset moves every value and indicator pointer between them.
+    void prepare_buffers()
+    {
+        if (arena_)
+            return;
+        if (columns_.empty())
+            throw programming_error("batch_writer has no columns");
+
+        auto const aligned = [](std::size_t size) {
+            std::size_t const alignment = alignof(std::max_align_t);
+            return (size + alignment - 1) / alignment * alignment;
+        };
+        set_size_ = 0;
+        for (auto& col : columns_)
+        {
+            col.values_offset = set_size_;
+            set_size_ += aligned(batch_size_ * col.value_size);
+            col.indicators_offset = set_size_;
+            set_size_ += aligned(batch_size_ * sizeof(null_type));
+        }
+        auto buffers = std::make_unique<char[]>(2 * set_size_);
+        clear_indicators(buffers.get(), 0);
+        clear_indicators(buffers.get(), 1);
+
+        HSTMT stmt = stmt_.native_statement_handle();
+        NANODBC_CALL(
+            SQLGetStmtAttr,
+            stmt,
+            SQL_ATTR_PARAM_STATUS_PTR,
+            &saved_status_,
+            SQL_IS_POINTER,
+            nullptr);
+        NANODBC_CALL(
+            SQLGetStmtAttr,
+            stmt,
+            SQL_ATTR_PARAMS_PROCESSED_PTR,
+            &saved_processed_,
+            SQL_IS_POINTER,
+            nullptr);
+
+        // The writer only counts as prepared, arena_ set, once the thread runs: until then a
+        // failure leaves the statement as it was and the next value tries again.
+        try
+        {
+            RETCODE rc = SQL_SUCCESS;
+            for (auto const& col : columns_)
+            {
+                void* const indicators = buffers.get() + col.indicators_offset;
+                NANODBC_CALL_RC(
+                    SQLBindParameter,
+                    rc,
+                    stmt,
+                    static_cast<SQLUSMALLINT>(col.index + 1), // parameter number
+                    SQL_PARAM_INPUT,                          // input or output type
+                    col.ctype,                                // value type
+                    col.type,                                 // parameter type
+                    col.size,                                 // column size
+                    col.scale,                                // decimal digits
+                    buffers.get() + col.values_offset,        // parameter value
+                    static_cast<SQLLEN>(col.value_size),      // buffer length
+                    static_cast<null_type*>(indicators));     // length or null indicator
+                if (!success(rc))
+                    NANODBC_THROW_DATABASE_ERROR(stmt, SQL_HANDLE_STMT);
+            }
+
+            NANODBC_CALL_RC(
+                SQLSetStmtAttr, rc, stmt, SQL_ATTR_PARAM_BIND_OFFSET_PTR, &bind_offset_, 0);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt, SQL_HANDLE_STMT);
+            NANODBC_CALL_RC(
+                SQLSetStmtAttr, rc, stmt, SQL_ATTR_PARAM_STATUS_PTR, status_.data(), 0);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt, SQL_HANDLE_STMT);
+            NANODBC_CALL_RC(
+                SQLSetStmtAttr, rc, stmt, SQL_ATTR_PARAMS_PROCESSED_PTR, &processed_, 0);
+            if (!success(rc))
+                NANODBC_THROW_DATABASE_ERROR(stmt, SQL_HANDLE_STMT);
+
+            worker_ = std::thread([this] { execute_batches(); });
+        }
+        catch (...)
+        {
+            restore_statement();
+            throw;
+        }
+        arena_ = std::move(buffers);
+    }
+
+    // Unbinds the buffers and gives the statement back the status pointers it had bound itself.
+    void restore_statement() noexcept
+    {
+        HSTMT stmt = stmt_.native_statement_handle();
+        NANODBC_CALL(SQLSetStmtAttr, stmt, SQL_ATTR_PARAM_BIND_OFFSET_PTR, nullptr, 0);
+        NANODBC_CALL(SQLSetStmtAttr, stmt, SQL_ATTR_PARAM_STATUS_PTR, saved_status_, 0);
+        NANODBC_CALL(SQLSetStmtAttr, stmt, SQL_ATTR_PARAMS_PROCESSED_PTR, saved_processed_, 0);
+        NANODBC_CALL(SQLSetStmtAttr, stmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+        stmt_.reset_parameters();
+    }
+
+    // Hands the filled set to the background thread, once it is done with the other one,
+    // and moves on to filling that.
+    void submit()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return !busy_; });
+        pending_set_ = fill_;
+        pending_rows_ = row_;
+        busy_ = true;
+        wake_.notify_all();
+        lock.unlock();
+
+        fill_ = 1 - fill_;
+        row_ = 0;
+        clear_indicators(arena_.get(), fill_);
+    }
+
+    void execute_batches() noexcept
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            wake_.wait(lock, [this] { return stop_ || busy_; });
+            if (!busy_)
+                return;
+            std::size_t const set = pending_set_;
+            batch_result outcome;
+            outcome.sequence = sequence_++;
+            outcome.rows = pending_rows_;
+            outcome.processed = 0;
+            lock.unlock();
+
+            try
+            {
+                execute_batch(set, outcome.rows);
+            }
+            catch (...)
+            {
+                outcome.error = std::current_exception();
+            }
+            outcome.processed = static_cast<std::size_t>(processed_);
+            outcome.row_status.reserve(outcome.rows);
+            for (std::size_t i = 0; i < outcome.rows; ++i)
+                outcome.row_status.push_back(to_param_status(status_[i]));
+
+            // The handler runs unlocked, and the filled set waits for it as for the execution.
+            lock.lock();
+            auto const handler = handler_;
+            lock.unlock();
+            std::exception_ptr error = handler ? nullptr : outcome.error;
+            if (handler)
+            {
+                try
+                {
+                    handler(outcome);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+            }
+
+            lock.lock();
+            if (error && !error_)
+                error_ = error;
+            busy_ = false;
+            wake_.notify_all();
+        }
+    }
+
+    void execute_batch(std::size_t set, std::size_t rows)
+    {
+        HSTMT stmt = stmt_.native_statement_handle();
+        bind_offset_ = static_cast<SQLULEN>(set * set_size_);
+        processed_ = 0;
+        std::fill(status_.begin(), status_.end(), static_cast<SQLUSMALLINT>(SQL_PARAM_UNUSED));
+
+        RETCODE rc = SQL_SUCCESS;
+        NANODBC_CALL_RC(SQLFreeStmt, rc, stmt, SQL_CLOSE);
+        if (!success(rc))
+            NANODBC_THROW_DATABASE_ERROR(stmt, SQL_HANDLE_STMT);
+        NANODBC_CALL_RC(
+            SQLSetStmtAttr,
+            rc,
+            stmt,
+            SQL_ATTR_PARAMSET_SIZE,
+            (SQLPOINTER)(std::intptr_t)rows,
+            0);
+        if (!success(rc))
+            NANODBC_THROW_DATABASE_ERROR(stmt, SQL_HANDLE_STMT);
+        NANODBC_CALL_RC(SQLExecute, rc, stmt);
+        if (!success(rc) && rc != SQL_NO_DATA)
+            NANODBC_THROW_DATABASE_ERROR(stmt, SQL_HANDLE_STMT);
+    }
+
+    void rethrow_pending_error()
+    {
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::swap(error, error_);
+        }
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    statement stmt_;
+    std::size_t const batch_size_;
+    std::vector<column> columns_;
+    std::unique_ptr<char[]> arena_;
+    std::size_t set_size_{0};
+    std::size_t fill_{0}; // set being filled by add_row()
+    std::size_t row_{0};  // row being filled
+
+    // Written by the driver during execution, only read by the background thread.
+    SQLULEN bind_offset_{0};
+    SQLULEN processed_{0};
+    std::vector<SQLUSMALLINT> status_;
+    SQLPOINTER saved_status_{nullptr};
+    SQLPOINTER saved_processed_{nullptr};
+
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool busy_{false}; // a batch is submitted and not yet executed
+    bool stop_{false};
+    std::size_t pending_set_{0};
+    std::size_t pending_rows_{0};
+    std::size_t sequence_{0};
+    std::function<void(batch_result const&)> handler_;
+    std::exception_ptr error_;
+};
+
+batch_writer::batch_writer(statement& stmt, std::size_t batch_size)
+    : impl_(std::make_shared<batch_writer_impl>(stmt, batch_size))
+{
+}
+
+batch_writer::~batch_writer() noexcept {}
+
+template <class T>
+void batch_writer::add_column(short param_index)
+{
+    impl_->add_column(param_index, sql_ctype<T>::value, sizeof(T), false);
+}
+
+void batch_writer::add_string_column(short param_index, std::size_t max_length)
+{
+    impl_->add_column(
+        param_index,
+        sql_ctype<string>::value,
+        (max_length + 1) * sizeof(string::value_type),
+        true);
+}
+
+void batch_writer::on_batch(std::function<void(batch_result const&)> handler)
+{
+    impl_->on_batch(std::move(handler));
+}
+
+template <class T>
+void batch_writer::set(short param_index, T const& value)
+{
+    impl_->set(param_index, sql_ctype<T>::value, &value, sizeof(T));
+}
+
+void batch_writer::set(short param_index, string const& value)
+{
+    impl_->set_string(param_index, value.c_str(), value.size());
+}
+
+void batch_writer::set(short param_index, string::value_type const* value)
+{
+    impl_->set_string(param_index, value, std::char_traits<string::value_type>::length(value));
+}
+
+void batch_writer::add_row()
+{
+    impl_->add_row();
+}
+
+void batch_writer::flush()
+{
+    impl_->flush();
+}
+
+void batch_writer::finish()
+{
+    impl_->finish();
+}
+
+std::size_t batch_writer::rows() const noexcept
+{
+    return impl_->rows();
+}
+
+// The following are the only supported instantiations of batch_writer columns.
+#define NANODBC_INSTANTIATE_BATCH_WRITER(type)                                                     \
+    template void batch_writer::add_column<type>(short);                                           \
+    template void batch_writer::set(short, type const&)
+
+NANODBC_INSTANTIATE_BATCH_WRITER(signed char);
+NANODBC_INSTANTIATE_BATCH_WRITER(unsigned char);
+NANODBC_INSTANTIATE_BATCH_WRITER(short);
+NANODBC_INSTANTIATE_BATCH_WRITER(unsigned short);
+NANODBC_INSTANTIATE_BATCH_WRITER(int);
+NANODBC_INSTANTIATE_BATCH_WRITER(unsigned int);
+NANODBC_INSTANTIATE_BATCH_WRITER(long int);
+NANODBC_INSTANTIATE_BATCH_WRITER(unsigned long int);
+NANODBC_INSTANTIATE_BATCH_WRITER(long long);
+NANODBC_INSTANTIATE_BATCH_WRITER(unsigned long long);
+NANODBC_INSTANTIATE_BATCH_WRITER(float);
+NANODBC_INSTANTIATE_BATCH_WRITER(double);
+NANODBC_INSTANTIATE_BATCH_WRITER(date);
+NANODBC_INSTANTIATE_BATCH_WRITER(time);
+NANODBC_INSTANTIATE_BATCH_WRITER(timestamp);
+
+#undef NANODBC_INSTANTIATE_BATCH_WRITER
+
+} // namespace nanodbc
+
+// clang-format off
+// 888888b.            888 888            .d8888b.
+// 888  "88b           888 888           d88P  Y88b
+// 888  .88P           888 888           888    888
+// 8888888K.  888  888 888 888  888      888         .d88b.  88888b.  888  888
+// 888  "Y88b 888  888 888 888 .88P      888        d88""88b 888 "88b 888  888
+// 888    888 888  888 888 888888K       888    888 888  888 888  888 888  888
+// 888   d88P Y88b 888 888 888 "88b      Y88b  d88P Y88..88P 888 d88P Y88b 888
+// 8888888P"   "Y88888 888 888  888       "Y8888P"   "Y88P"  88888P"   "Y88888
+//                                                           888           888
+//                                                           888      Y8b d88P
+//                                                           888       "Y88P"
+// MARK: Bulk Copy -
+// clang-format on
+
+namespace
+{
+
+// Bulk copy type tokens of msodbcsql.h, naming the C type of a bound program variable.
+constexpr int bcp_tinyint = 0x30;   // SQLINT1
+constexpr int bcp_smallint = 0x34;  // SQLINT2
+constexpr int bcp_int = 0x38;       // SQLINT4
+constexpr int bcp_bigint = 0x7f;    // SQLINT8
+constexpr int bcp_real = 0x3b;      // SQLFLT4
+constexpr int bcp_float = 0x3e;     // SQLFLT8
+constexpr int bcp_date = 0x28;      // SQLDATEN, bound as a SQL_DATE_STRUCT
+constexpr int bcp_datetime2 = 0x2a; // SQLDATETIME2N, bound as a SQL_TIMESTAMP_STRUCT
+#ifdef NANODBC_ENABLE_UNICODE
+constexpr int bcp_text = 0xef; // SQLNCHAR
+#else
+constexpr int bcp_text = 0x2f; // SQLCHARACTER
+#endif
+constexpr RETCODE bcp_succeed = 1;
+
+template <class T>
+struct bcp_type;
+
+template <>
+struct bcp_type<unsigned char> : std::integral_constant<int, bcp_tinyint>
+{
+};
+
+template <>
+struct bcp_type<short> : std::integral_constant<int, bcp_smallint>
+{
+};
+
+template <>
+struct bcp_type<int> : std::integral_constant<int, bcp_int>
+{
+};
+
+template <>
+struct bcp_type<long int>
+    : std::integral_constant<int, sizeof(long int) == 8 ? bcp_bigint : bcp_int>
+{
+};
+
+template <>
+struct bcp_type<long long> : std::integral_constant<int, bcp_bigint>
+{
+};
+
+template <>
+struct bcp_type<float> : std::integral_constant<int, bcp_real>
+{
+};
+
+template <>
+struct bcp_type<double> : std::integral_constant<int, bcp_float>
+{
+};
+
+template <>
+struct bcp_type<nanodbc::date> : std::integral_constant<int, bcp_date>
+{
+};
+
+template <>
+struct bcp_type<nanodbc::timestamp> : std::integral_constant<int, bcp_datetime2>
+{
+};
+
+// The bulk copy functions are exported by the SQL Server driver rather than by the driver
+// manager, so they are looked up in the driver library the connection has loaded.
+struct bcp_functions
+{
+    RETCODE(SQL_API* init)
+    (SQLHDBC, NANODBC_SQLCHAR const*, NANODBC_SQLCHAR const*, NANODBC_SQLCHAR const*, int) =
+        nullptr;
+    RETCODE(SQL_API* bind)
+    (SQLHDBC, unsigned char const*, int, SQLINTEGER, unsigned char const*, int, int, int) =
+        nullptr;
+    RETCODE(SQL_API* collen)(SQLHDBC, SQLINTEGER, int) = nullptr;
+    RETCODE(SQL_API* sendrow)(SQLHDBC) = nullptr;
+    SQLINTEGER(SQL_API* batch)(SQLHDBC) = nullptr;
+    SQLINTEGER(SQL_API* done)(SQLHDBC) = nullptr;
+    RETCODE(SQL_API* control)(SQLHDBC, int, void*) = nullptr;
+    void* library = nullptr;
+};
+
+void release_bcp_functions(bcp_functions& functions) noexcept
+{
+#if !defined(_WIN32) && !defined(NANODBC_DISABLE_MSSQL_BCP)
+    if (functions.library)
+        dlclose(functions.library);
+#endif
+    functions = bcp_functions();
+}
+
+#if !defined(NANODBC_DISABLE_MSSQL_BCP)
+template <class F>
+bool resolve_bcp_function(void* library, char const* name, F& function)
+{
+#if defined(_WIN32)
+    function = reinterpret_cast<F>(GetProcAddress(static_cast<HMODULE>(library), name));
+#else
+    function = reinterpret_cast<F>(dlsym(library, name));
+#endif
+    return function != nullptr;
+}
+
+// Returns the loaded library whose file name, without its directory, is the given one. The
+// driver reports the file name, while the driver manager loaded it from a path of its own, so
+// the path it was loaded from is found first and opened again, which loads nothing new.
+void* find_loaded_library(std::string const& name)
+{
+#if defined(_WIN32)
+    return GetModuleHandleA(name.c_str());
+#else
+    struct search
+    {
+        std::string const& name;
+        std::string path;
+
+        bool match(char const* loaded)
+        {
+            if (!loaded)
+                return false;
+            char const* const slash = std::strrchr(loaded, '/');
+            if (name != (slash ? slash + 1 : loaded))
+                return false;
+            path = loaded;
+            return true;
+        }
+    } found{name, {}};
+#if defined(__APPLE__)
+    for (std::uint32_t i = 0, n = _dyld_image_count(); i < n; ++i)
+    {
+        if (found.match(_dyld_get_image_name(i)))
+            break;
+    }
+#else
+    dl_iterate_phdr(
+        [](dl_phdr_info* info, std::size_t, void* data) {
+            return static_cast<search*>(data)->match(info->dlpi_name) ? 1 : 0;
+        },
+        &found);
+#endif
+    if (found.path.empty())
+        return nullptr;
+    return dlopen(found.path.c_str(), RTLD_LAZY | RTLD_NOLOAD);
+#endif
+}
+#endif
+
+// Returns true if BCP was enabled on the connection and the functions of its driver were found.
+// The driver is found among the libraries already loaded, by the file name it reports.
+bool load_bcp_functions(nanodbc::connection const& conn, bcp_functions& functions)
+{
+#if defined(NANODBC_DISABLE_MSSQL_BCP)
+    (void)conn;
+    (void)functions;
+    return false;
+#else
+    HDBC dbc = conn.native_dbc_handle();
+    SQLUINTEGER enabled = 0;
+    RETCODE rc = SQL_SUCCESS;
+    NANODBC_CALL_RC(
+        NANODBC_FUNC(SQLGetConnectAttr),
+        rc,
+        dbc,
+        SQL_COPT_SS_BCP,
+        &enabled,
+        SQL_IS_UINTEGER,
+        nullptr);
+    if (!success(rc) || enabled != SQL_BCP_ON)
+        return false;
+
+    std::string driver;
+    convert(conn.driver_name(), driver);
+    functions.library = find_loaded_library(driver);
+    if (!functions.library)
+        return false;
+
+#ifdef NANODBC_ENABLE_UNICODE
+    char const* const init = "bcp_initW";
+#else
+    char const* const init = "bcp_initA";
+#endif
+    if (!resolve_bcp_function(functions.library, init, functions.init) ||
+        !resolve_bcp_function(functions.library, "bcp_bind", functions.bind) ||
+        !resolve_bcp_function(functions.library, "bcp_collen", functions.collen) ||
+        !resolve_bcp_function(functions.library, "bcp_sendrow", functions.sendrow) ||
+        !resolve_bcp_function(functions.library, "bcp_batch", functions.batch) ||
+        !resolve_bcp_function(functions.library, "bcp_done", functions.done) ||
+        !resolve_bcp_function(functions.library, "bcp_control", functions.control))
+    {
+        release_bcp_functions(functions);
+        return false;
+    }
+    return true;
+#endif
+}
+
+} // namespace
+
+namespace nanodbc
+{
+
+class bulk_copy::bulk_copy_impl
+{
+public:
+    bulk_copy_impl(bulk_copy_impl const&) = delete;
+    bulk_copy_impl& operator=(bulk_copy_impl const&) = delete;
+    bulk_copy_impl(bulk_copy_impl&&) = delete;
+    bulk_copy_impl& operator=(bulk_copy_impl&&) = delete;
+
+    bulk_copy_impl(connection& conn, string const& table, std::size_t batch_size)
+        : conn_(conn)
+        , table_(table)
+        , batch_size_(batch_size)
+    {
+        if (!conn_.connected())
+            throw programming_error("bulk_copy requires an open connection");
+        if (batch_size_ == 0)
+            throw programming_error("bulk_copy batch size must be positive");
+        uses_bcp_ = load_bcp_functions(conn_, bcp_);
+    }
+
+    ~bulk_copy_impl() noexcept
+    {
+        // Only finish() commits: bcp_done would commit the rows sent since the last batch, so
+        // the copy is aborted instead, which discards them. On the insert path the writer
+        // discards what it holds.
+        if (copying_)
+            bcp_.control(conn_.native_dbc_handle(), BCPABORT, nullptr);
+        writer_.reset();
+        release_bcp_functions(bcp_);
+    }
+
+    bool uses_bcp() const noexcept { return uses_bcp_; }
+
+    template <class T>
+    void add_column(string const& name)
+    {
+        column col;
+        col.ctype = sql_ctype<T>::value;
+        col.value_size = sizeof(T);
+        col.bcp_type = bcp_type<T>::value;
+        col.add_to_writer = [](batch_writer& writer, short index) {
+            writer.add_column<T>(index);
+        };
+        col.add_to_copy = [](copy_in& copy, string const& name) { copy.add_column<T>(name); };
+        add_column(name, col);
+    }
+
+    void add_string_column(string const& name, std::size_t max_length)
+    {
+        column col;
+        col.ctype = sql_ctype<string>::value;
+        col.value_size = (max_length + 1) * sizeof(string::value_type);
+        col.text = true;
+        col.bcp_type = bcp_text;
+        add_column(name, col);
+    }
+
+    template <class T>
+    void set(short index, T const& value)
+    {
+        column& col = column_for_value(index);
+        if (col.text || col.ctype != sql_ctype<T>::value || col.value_size != sizeof(T))
+            throw type_incompatible_error();
+        if (copy_)
+            return copy_->set(index, value);
+        if (writer_)
+            return writer_->set(index, value);
+        std::memcpy(arena_.get() + col.offset, &value, sizeof(T));
+        col.length = static_cast<SQLINTEGER>(sizeof(T));
+    }
+
+    // The value is terminated at length, as the writer expects.
+    void set_string(short index, string::value_type const* value, std::size_t length)
+    {
+        using char_type = string::value_type;
+        column& col = column_for_value(index);
+        if (!col.text)
+            throw type_incompatible_error();
+        if ((length + 1) * sizeof(char_type) > col.value_size)
+            throw programming_error("bulk_copy string value exceeds its column length");
+        if (copy_)
+            return copy_->set(index, value);
+        if (writer_)
+            return writer_->set(index, value);
+        std::copy(value, value + length, reinterpret_cast<char_type*>(arena_.get() + col.offset));
+        col.length = static_cast<SQLINTEGER>(length * sizeof(char_type));
+    }
+
+    template <class T>
+    void bind(short index, T const* values, std::size_t batch_size, bool const* nulls)
+    {
+        column& col = declared_column(index);
+        if (col.text || col.ctype != sql_ctype<T>::value || col.value_size != sizeof(T))
+            throw type_incompatible_error();
+        col.values = values;
+        col.batch_size = batch_size;
+        col.nulls = nulls;
+        col.set_bound = [](bulk_copy_impl& impl, short index, void const* values, std::size_t row) {
+            impl.set(index, static_cast<T const*>(values)[row]);
+        };
+    }
+
+    void bind_strings(short index, std::vector<string> const& values, bool const* nulls)
+    {
+        column& col = declared_column(index);
+        if (!col.text)
+            throw type_incompatible_error();
+        col.values = &values;
+        col.batch_size = values.size();
+        col.nulls = nulls;
+        col.set_bound = [](bulk_copy_impl& impl, short index, void const* values, std::size_t row) {
+            auto const& value = (*static_cast<std::vector<string> const*>(values))[row];
+            impl.set_string(index, value.c_str(), value.size());
+        };
+    }
+
+    // The bound arrays go through the same path as values set one at a time.
+    void add_rows(std::size_t rows)
+    {
+        for (auto const& col : columns_)
+        {
+            if (col.set_bound && col.batch_size < rows)
+                throw programming_error("bulk_copy bound array is shorter than the rows added");
+        }
+        for (std::size_t row = 0; row < rows; ++row)
+        {
+            for (std::size_t i = 0; i < columns_.size(); ++i)
+            {
+                column const& col = columns_[i];
+                if (col.set_bound && !(col.nulls && col.nulls[row]))
+                    col.set_bound(*this, static_cast<short>(i), col.values, row);
+            }
+            add_row();
+        }
+    }
+
+    void add_row()
+    {
+        start();
+        if (copy_)
+            return copy_->add_row();
+        if (writer_)
+            return writer_->add_row();
+
+        // A length is only sent when it differs from the one the driver has, which for a
+        // column of fixed size that is never null means once.
+        HDBC dbc = conn_.native_dbc_handle();
+        for (auto& col : columns_)
+        {
+            if (col.length != col.sent_length)
+            {
+                if (bcp_.collen(dbc, col.length, col.ordinal) != bcp_succeed)
+                    NANODBC_THROW_DATABASE_ERROR(dbc, SQL_HANDLE_DBC);
+                col.sent_length = col.length;
+            }
+            col.length = SQL_NULL_DATA;
+        }
+        if (bcp_.sendrow(dbc) != bcp_succeed)
+            NANODBC_THROW_DATABASE_ERROR(dbc, SQL_HANDLE_DBC);
+        if (++rows_ == batch_size_)
+            commit_batch();
+    }
+
+    void flush()
+    {
+        if (copy_)
+            copy_->flush();
+        else if (writer_)
+            writer_->flush();
+        else if (copying_ && rows_ > 0)
+            commit_batch();
+    }
+
+    std::size_t finish()
+    {
+        if (copy_)
+        {
+            copied_ = copy_->finish();
+        }
+        else if (writer_)
+        {
+            writer_->finish();
+        }
+        else if (copying_)
+        {
+            copying_ = false;
+            SQLINTEGER const rows = bcp_.done(conn_.native_dbc_handle());
+            if (rows < 0)
+                NANODBC_THROW_DATABASE_ERROR(conn_.native_dbc_handle(), SQL_HANDLE_DBC);
+            copied_ += static_cast<std::size_t>(rows);
+            rows_ = 0;
+        }
+        return copied_;
+    }
+
+private:
+    struct column
+    {
+        string name;
+        SQLSMALLINT ctype = 0;
+        std::size_t value_size = 0;
+        bool text = false;
+        int bcp_type = 0;
+        void (*add_to_writer)(batch_writer&, short) = nullptr;
+        void (*add_to_copy)(copy_in&, string const&) = nullptr;
+        int ordinal = 0;           // one-based position of the column in the table
+        std::size_t offset = 0;    // of the column's value in the row buffer
+        SQLINTEGER length = SQL_NULL_DATA;      // of the value set in the current row
+        SQLINTEGER sent_length = SQL_NULL_DATA; // the driver was last given
+        // The array bound by bind(), which add_rows() reads through set_bound.
+        void const* values = nullptr;
+        std::size_t batch_size = 0;
+        bool const* nulls = nullptr;
+        void (*set_bound)(bulk_copy_impl&, short, void const*, std::size_t) = nullptr;
+    };
+
+    void add_column(string const& name, column& col)
+    {
+        if (started_)
+            throw programming_error("bulk_copy columns must be added before any value is set");
+        if (columns_.size() == static_cast<std::size_t>(std::numeric_limits<short>::max()))
+            throw programming_error("bulk_copy has too many columns");
+        col.name = name;
+        columns_.push_back(col);
+    }
+
+    column& column_for_value(short index)
+    {
+        start();
+        return declared_column(index);
+    }
+
+    column& declared_column(short index)
+    {
+        if (index < 0 || static_cast<std::size_t>(index) >= columns_.size())
+            throw index_range_error();
+        return columns_[static_cast<std::size_t>(index)];
+    }
+
+    void start()
+    {
+        if (started_)
+        {
+            if (uses_bcp_ && !copying_)
+                throw programming_error("bulk_copy has finished");
+            return;
+        }
+        if (columns_.empty())
+            throw programming_error("bulk_copy has no columns");
+        if (uses_bcp_)
+            start_bcp();
+        else
+            start_insert();
+        started_ = true;
+    }
+
+    void start_insert()
+    {
+        // A driver that executes an array row by row is better served by a multi-row INSERT.
+        if (!conn_.profile().native_parameter_arrays)
+        {
+            copy_options options;
+            options.rows_per_statement = batch_size_;
+            options.allow_bulk_copy = false;
+            copy_ = std::make_unique<copy_in>(conn_, table_, options);
+            for (auto const& col : columns_)
+            {
+                if (col.text)
+                    copy_->add_string_column(
+                        col.name, col.value_size / sizeof(string::value_type) - 1);
+                else
+                    col.add_to_copy(*copy_, col.name);
+            }
+            return;
+        }
+
+        string query = NANODBC_TEXT("INSERT INTO ") + table_ + NANODBC_TEXT(" (");
+        string markers;
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+        {
+            if (i > 0)
+            {
+                query += NANODBC_TEXT(", ");
+                markers += NANODBC_TEXT(", ");
+            }
+            query += columns_[i].name;
+            markers += NANODBC_TEXT('?');
+        }
+        query += NANODBC_TEXT(") VALUES (") + markers + NANODBC_TEXT(')');
+        statement_.prepare(conn_, query);
+
+        writer_ = std::make_unique<batch_writer>(statement_, batch_size_);
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+        {
+            auto const& col = columns_[i];
+            auto const index = static_cast<short>(i);
+            if (col.text)
+                writer_->add_string_column(index, col.value_size / sizeof(string::value_type) - 1);
+            else
+                col.add_to_writer(*writer_, index);
+        }
+        // Batches complete in order on the writer's thread, and finish() waits for the last.
+        writer_->on_batch([this](batch_result const& outcome) {
+            if (outcome.error)
+                std::rethrow_exception(outcome.error);
+            copied_ += outcome.rows;
+        });
+    }
+
+    void start_bcp()
+    {
+        // bcp_bind takes the position of a column in the table, rather than its name.
+        {
+            result columns = execute(
+                conn_, NANODBC_TEXT("SELECT * FROM ") + table_ + NANODBC_TEXT(" WHERE 1 = 0"));
+            for (auto& col : columns_)
+                col.ordinal = columns.column(col.name) + 1;
+        }
+
+        // One row of buffers, bound once.
+        std::size_t const alignment = alignof(std::max_align_t);
+        std::size_t size = 0;
+        for (auto& col : columns_)
+        {
+            col.offset = size;
+            size += (col.value_size + alignment - 1) / alignment * alignment;
+        }
+        arena_ = std::make_unique<char[]>(size);
+
+        HDBC dbc = conn_.native_dbc_handle();
+        if (bcp_.init(dbc, (NANODBC_SQLCHAR const*)table_.c_str(), nullptr, nullptr, DB_IN) !=
+            bcp_succeed)
+        {
+            NANODBC_THROW_DATABASE_ERROR(dbc, SQL_HANDLE_DBC);
+        }
+        copying_ = true;
+        for (auto& col : columns_)
+        {
+            // The driver takes a fixed size column's length from its binding until told another.
+            col.sent_length = col.text ? SQL_VARLEN_DATA : static_cast<SQLINTEGER>(col.value_size);
+            RETCODE const rc = bcp_.bind(
+                dbc,
+                reinterpret_cast<unsigned char const*>(arena_.get() + col.offset),
+                0, // no length prefix, lengths are set with bcp_collen
+                col.text ? SQL_VARLEN_DATA : static_cast<SQLINTEGER>(col.value_size),
+                nullptr, // no terminator
+                0,
+                col.bcp_type,
+                col.ordinal);
+            if (rc != bcp_succeed)
+                NANODBC_THROW_DATABASE_ERROR(dbc, SQL_HANDLE_DBC);
+        }
+    }
+
+    void commit_batch()
+    {
+        HDBC dbc = conn_.native_dbc_handle();
+        SQLINTEGER const rows = bcp_.batch(dbc);
+        if (rows < 0)
+            NANODBC_THROW_DATABASE_ERROR(dbc, SQL_HANDLE_DBC);
+        copied_ += static_cast<std::size_t>(rows);
+        rows_ = 0;
+    }
+
+    connection conn_;
+    string const table_;
+    std::size_t const batch_size_;
+    std::vector<column> columns_;
+    bool started_{false};
+    std::size_t copied_{0}; // rows committed
+
+    // The insert path, through parameter arrays or, where the driver executes those row by row,
+    // multi-row INSERT statements.
+    statement statement_;
+    std::unique_ptr<batch_writer> writer_;
+    std::unique_ptr<copy_in> copy_;
+
+    // The BCP path.
+    bool uses_bcp_{false};
+    bcp_functions bcp_;
+    bool copying_{false}; // between bcp_init and bcp_done
+    std::unique_ptr<char[]> arena_;
+    std::size_t rows_{0}; // sent since the last commit
+};
+
+bulk_copy::bulk_copy(connection& conn, string const& table, std::size_t batch_size)
+    : impl_(std::make_shared<bulk_copy_impl>(conn, table, batch_size))
+{
+}
+
+bulk_copy::~bulk_copy() noexcept {}
+
+bool bulk_copy::uses_bcp() const noexcept
+{
+    return impl_->uses_bcp();
+}
+
+template <class T>
+void bulk_copy::add_column(string const& name)
+{
+    impl_->add_column<T>(name);
+}
+
+void bulk_copy::add_string_column(string const& name, std::size_t max_length)
+{
+    impl_->add_string_column(name, max_length);
+}
+
+template <class T>
+void bulk_copy::set(short column, T const& value)
+{
+    impl_->set(column, value);
+}
+
+void bulk_copy::set(short column, string const& value)
+{
+    impl_->set_string(column, value.c_str(), value.size());
+}
+
+void bulk_copy::set(short column, string::value_type const* value)
+{
+    impl_->set_string(column, value, std::char_traits<string::value_type>::length(value));
+}
+
+template <class T>
+void bulk_copy::bind(short column, T const* values, std::size_t batch_size, bool const* nulls)
+{
+    impl_->bind(column, values, batch_size, nulls);
+}
+
+void bulk_copy::bind_strings(short column, std::vector<string> const& values, bool const* nulls)
+{
+    impl_->bind_strings(column, values, nulls);
+}
+
+void bulk_copy::add_row()
+{
+    impl_->add_row();
+}
+
+void bulk_copy::add_rows(std::size_t rows)
+{
+    impl_->add_rows(rows);
+}
+
+void bulk_copy::flush()
+{
+    impl_->flush();
+}
+
+std::size_t bulk_copy::finish()
+{
+    return impl_->finish();
+}
+
+// The following are the only supported instantiations of bulk_copy columns.
+#define NANODBC_INSTANTIATE_BULK_COPY(type)                                                        \
+    template void bulk_copy::add_column<type>(string const&);                                      \
+    template void bulk_copy::set(short, type const&);                                              \
+    template void bulk_copy::bind(short, type const*, std::size_t, bool const*)
+
+NANODBC_INSTANTIATE_BULK_COPY(unsigned char);
+NANODBC_INSTANTIATE_BULK_COPY(short);
+NANODBC_INSTANTIATE_BULK_COPY(int);
+NANODBC_INSTANTIATE_BULK_COPY(long int);
+NANODBC_INSTANTIATE_BULK_COPY(long long);
+NANODBC_INSTANTIATE_BULK_COPY(float);
+NANODBC_INSTANTIATE_BULK_COPY(double);
+NANODBC_INSTANTIATE_BULK_COPY(date);
+NANODBC_INSTANTIATE_BULK_COPY(timestamp);
+
+#undef NANODBC_INSTANTIATE_BULK_COPY
+
+} // namespace nanodbc
+
+// clang-format off
+//  .d8888b.
+// d88P  Y88b
+// 888    888
+// 888         .d88b.  88888b.  888  888
+// 888        d88""88b 888 "88b 888  888
+// 888    888 888  888 888  888 888  888
+// Y88b  d88P Y88..88P 888 d88P Y88b 888
+//  "Y8888P"   "Y88P"  88888P"   "Y88888
+//                     888           888
+//                     888      Y8b d88P
+//                     888       "Y88P"
+// MARK: Copy -
+// clang-format on
+
+namespace
+{
+
+// The most rows an INSERT of the given prefix and row text may have, within the limits of the
+// DBMS and the statement length the driver reports.
+std::size_t multirow_insert_rows(
+    nanodbc::connection const& conn,
+    std::size_t columns,
+    std::size_t prefix_length,
+    std::size_t row_length,
+    nanodbc::copy_options const& options)
+{
+    auto const profile = conn.profile();
+    std::size_t rows =
+        options.rows_per_statement > 0 ? options.rows_per_statement : profile.max_insert_rows;
+    std::size_t const parameters =
+        options.max_parameters > 0 ? options.max_parameters : profile.max_parameters;
+    rows = std::min(rows, parameters / std::max<std::size_t>(columns, 1));
+
+    unsigned int statement_length = 0;
+    try
+    {
+        statement_length = conn.get_info<unsigned int>(SQL_MAX_STATEMENT_LEN);
+    }
+    catch (nanodbc::database_error const&)
+    {
+        // No limit known.
+    }
+    if (statement_length > prefix_length)
+        rows = std::min(rows, (statement_length - prefix_length) / (row_length + 2));
+
+    return std::max<std::size_t>(rows, 1);
+}
+
+template <class Char>
+Char ascii_upper(Char c) noexcept
+{
+    return c >= Char('a') && c <= Char('z') ? static_cast<Char>(c - Char('a') + Char('A')) : c;
+}
+
+template <class Char>
+bool ascii_space(Char c) noexcept
+{
+    return c == Char(' ') || (c >= Char('\t') && c <= Char('\r'));
+}
+
+template <class Char>
+bool ascii_identifier(Char c) noexcept
+{
+    Char const upper = ascii_upper(c);
+    return (c >= Char('0') && c <= Char('9')) || (upper >= Char('A') && upper <= Char('Z')) ||
+           c == Char('_');
+}
+
+// Position just past the quoted text starting at the given quote, or the end of the query.
+std::size_t skip_quoted(nanodbc::string const& query, std::size_t quote)
+{
+    std::size_t const end = query.find(query[quote], quote + 1);
+    return end == nanodbc::string::npos ? query.size() : end + 1;
+}
+
+// Splits an INSERT of a single row into the text up to and including its VALUES keyword and the
+// parenthesized row after it, counting the parameter markers of the row. The row must end the
+// statement, but for a semicolon.
+bool split_insert_values(
+    nanodbc::string const& query,
+    nanodbc::string& prefix,
+    nanodbc::string& row,
+    std::size_t& parameters)
+{
+    using char_type = nanodbc::string::value_type;
+    static char const keyword[] = "VALUES";
+    std::size_t const keyword_length = sizeof(keyword) - 1;
+
+    // The last VALUES outside quotes and parentheses.
+    std::size_t values = nanodbc::string::npos;
+    int depth = 0;
+    for (std::size_t i = 0; i < query.size();)
+    {
+        char_type const c = query[i];
+        if (c == char_type('\'') || c == char_type('"'))
+        {
+            i = skip_quoted(query, i);
+            continue;
+        }
+        if (c == char_type('('))
+            ++depth;
+        else if (c == char_type(')'))
+            --depth;
+        else if (
+            depth == 0 && (i == 0 || !ascii_identifier(query[i - 1])) &&
+            i + keyword_length <= query.size())
+        {
+            std::size_t k = 0;
+            while (k < keyword_length && ascii_upper(query[i + k]) == char_type(keyword[k]))
+                ++k;
+            if (k == keyword_length && (i + k == query.size() || !ascii_identifier(query[i + k])))
+            {
+                values = i + k;
+                i += k;
+                continue;
+            }
+        }
+        ++i;
+    }
+    if (values == nanodbc::string::npos)
+        return false;
+
+    std::size_t open = values;
+    while (open < query.size() && ascii_space(query[open]))
+        ++open;
+    if (open == query.size() || query[open] != char_type('('))
+        return false;
+
+    // The matching parenthesis, counting the markers on the way.
+    parameters = 0;
+    depth = 0;
+    std::size_t close = open;
+    for (; close < query.size(); ++close)
+    {
+        char_type const c = query[close];
+        if (c == char_type('\'') || c == char_type('"'))
+        {
+            close = skip_quoted(query, close) - 1;
+            continue;
+        }
+        if (c == char_type('?'))
+            ++parameters;
+        else if (c == char_type('('))
+            ++depth;
+        else if (c == char_type(')') && --depth == 0)
+            break;
+    }
+    if (close == query.size() || parameters == 0)
+        return false;
+
+    for (std::size_t i = close + 1; i < query.size(); ++i)
+    {
+        if (query[i] != char_type(';') && !ascii_space(query[i]))
+            return false;
+    }
+
+    prefix = query.substr(0, values) + NANODBC_TEXT(' ');
+    row = query.substr(open, close + 1 - open);
+    return true;
+}
+
+} // namespace
+
+namespace nanodbc
+{
+
+// Rows buffered column by column and inserted by a statement of the form
+// prefix row, row, ..., row, prepared once with as many rows as a batch holds, when a batch
+// is first full, and bound once to the buffers. A partial batch is inserted by a statement of
+// its own size, kept for as long as partial batches keep that size.
+class multirow_inserter
+{
+public:
+    struct column
+    {
+        SQLSMALLINT ctype = 0;
+        std::size_t value_size = 0;
+        std::size_t values_offset = 0;
+        std::size_t indicators_offset = 0;
+        SQLSMALLINT type = 0;
+        SQLULEN size = 0;
+        SQLSMALLINT scale = 0;
+    };
+
+    multirow_inserter(
+        connection& conn,
+        string prefix,
+        string row,
+        std::vector<column> columns,
+        std::size_t rows)
+        : conn_(conn)
+        , prefix_(std::move(prefix))
+        , row_(std::move(row))
+        , columns_(std::move(columns))
+        , rows_(rows)
+    {
+        NANODBC_ASSERT(!columns_.empty() && rows_ > 0);
+        auto const aligned = [](std::size_t size) {
+            std::size_t const alignment = alignof(std::max_align_t);
+            return (size + alignment - 1) / alignment * alignment;
+        };
+        std::size_t size = 0;
+        for (auto& col : columns_)
+        {
+            col.values_offset = size;
+            size += aligned(rows_ * col.value_size);
+            col.indicators_offset = size;
+            size += aligned(rows_ * sizeof(null_type));
+        }
+        arena_ = std::make_unique<char[]>(size);
+        clear_indicators();
+    }
+
+    std::size_t rows_per_statement() const noexcept { return rows_; }
+
+    std::size_t inserted() const noexcept { return inserted_; }
+
+    void* value(std::size_t column) noexcept
+    {
+        auto const& col = columns_[column];
+        return arena_.get() + col.values_offset + filled_ * col.value_size;
+    }
+
+    null_type* indicator(std::size_t column) noexcept
+    {
+        auto const& col = columns_[column];
+        return reinterpret_cast<null_type*>(arena_.get() + col.indicators_offset) + filled_;
+    }
+
+    void add_row()
+    {
+        if (++filled_ < rows_)
+            return;
+        if (!full_prepared_)
+        {
+            prepare(full_, rows_);
+            full_prepared_ = true;
+        }
+        insert(full_, rows_);
+    }
+
+    // Discards the rows buffered.
+    void discard() noexcept { clear_indicators(); }
+
+    void flush()
+    {
+        if (filled_ == 0)
+            return;
+        if (filled_ != tail_rows_)
+        {
+            // The parameters of rows the smaller statement lacks would stay bound otherwise.
+            if (tail_.open())
+                tail_.reset_parameters();
+            tail_rows_ = 0;
+            prepare(tail_, filled_);
+            tail_rows_ = filled_;
+        }
+        insert(tail_, filled_);
+    }
+
+private:
+    string statement_text(std::size_t rows) const
+    {
+        string text;
+        text.reserve(prefix_.size() + rows * (row_.size() + 2));
+        text += prefix_;
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            if (i > 0)
+                text += NANODBC_TEXT(", ");
+            text += row_;
+        }
+        return text;
+    }
+
+    // Either statement is prepared when it is first needed. The parameters of the first row of
+    // the first one prepared describe those of every row.
+    void prepare(statement& stmt, std::size_t rows)
+    {
+        stmt.prepare(conn_, statement_text(rows));
+        if (!described_)
+        {
+            for (std::size_t i = 0; i < columns_.size(); ++i)
+            {
+                auto& col = columns_[i];
+                auto const index = static_cast<short>(i);
+                col.type = stmt.parameter_type(index);
+                col.size = stmt.parameter_size(index);
+                col.scale = stmt.parameter_scale(index);
+            }
+            described_ = true;
+        }
+        bind(stmt, rows);
+    }
+
+    // Parameter i of row r is bound to element r of column i's buffers.
+    void bind(statement& stmt, std::size_t rows)
+    {
+        HSTMT handle = stmt.native_statement_handle();
+        RETCODE rc = SQL_SUCCESS;
+        for (std::size_t r = 0; r < rows; ++r)
+        {
+            for (std::size_t i = 0; i < columns_.size(); ++i)
+            {
+                auto const& col = columns_[i];
+                char* const indicators = arena_.get() + col.indicators_offset;
+                NANODBC_CALL_RC(
+                    SQLBindParameter,
+                    rc,
+                    handle,
+                    static_cast<SQLUSMALLINT>(r * columns_.size() + i + 1), // parameter number
+                    SQL_PARAM_INPUT,                                        // input or output
+                    col.ctype,                                              // value type
+                    col.type,                                               // parameter type
+                    col.size,                                               // column size
+                    col.scale,                                              // decimal digits
+                    arena_.get() + col.values_offset + r * col.value_size, // parameter value
+                    static_cast<SQLLEN>(col.value_size),                    // buffer length
+                    reinterpret_cast<null_type*>(indicators) + r);          // length or null
+                if (!success(rc))
+                    NANODBC_THROW_DATABASE_ERROR(handle, SQL_HANDLE_STMT);
+            }
+        }
+    }
+
+    // The rows of a failed statement are discarded along with those of a successful one.
+    void insert(statement& stmt, std::size_t rows)
+    {
+        try
+        {
+            just_execute(stmt);
+        }
+        catch (...)
+        {
+            clear_indicators();
+            throw;
+        }
+        inserted_ += rows;
+        clear_indicators();
+    }
+
+    void clear_indicators() noexcept
+    {
+        for (auto const& col : columns_)
+        {
+            auto const first = reinterpret_cast<null_type*>(arena_.get() + col.indicators_offset);
+            std::fill(first, first + rows_, static_cast<null_type>(SQL_NULL_DATA));
+        }
+        filled_ = 0;
+    }
+
+    connection conn_;
+    string const prefix_;
+    string const row_;
+    std::vector<column> columns_;
+    std::size_t const rows_;
+    std::unique_ptr<char[]> arena_;
+    std::size_t filled_{0}; // rows buffered
+    std::size_t inserted_{0};
+    bool described_{false};
+    statement full_;
+    bool full_prepared_{false};
+    statement tail_;
+    std::size_t tail_rows_{0}; // rows of the statement tail_ has prepared, if any
+};
+
+class copy_in::copy_in_impl
+{
+public:
+    copy_in_impl(copy_in_impl const&) = delete;
+    copy_in_impl& operator=(copy_in_impl const&) = delete;
+    copy_in_impl(copy_in_impl&&) = delete;
+    copy_in_impl& operator=(copy_in_impl&&) = delete;
+
+    copy_in_impl(connection& conn, string const& table, copy_options const& options)
+        : conn_(conn)
+        , table_(table)
+        , options_(options)
+    {
+        if (!conn_.connected())
+            throw programming_error("copy_in requires an open connection");
+        if (options_.allow_bulk_copy)
+        {
+            std::size_t const batch_size =
+                options_.rows_per_statement > 0 ? options_.rows_per_statement : 1000;
+            bulk_ = std::make_unique<bulk_copy>(conn_, table_, batch_size);
+            if (!bulk_->uses_bcp())
+                bulk_.reset();
+        }
+    }
+
+    bool uses_bcp() const noexcept { return bulk_ != nullptr; }
+
+    std::size_t rows_per_statement() const noexcept
+    {
+        return inserter_ ? inserter_->rows_per_statement() : 0;
+    }
+
+    template <class T>
+    void add_column(string const& name)
+    {
+        if (bulk_)
+            return bulk_->add_column<T>(name);
+        add_column(name, sql_ctype<T>::value, sizeof(T), false);
+    }
+
+    void add_string_column(string const& name, std::size_t max_length)
+    {
+        if (bulk_)
+            return bulk_->add_string_column(name, max_length);
+        add_column(
+            name, sql_ctype<string>::value, (max_length + 1) * sizeof(string::value_type), true);
+    }
+
+    template <class T>
+    void set(short index, T const& value)
+    {
+        if (bulk_)
+            return bulk_->set(index, value);
+        column const& col = column_for_value(index);
+        if (col.text || col.ctype != sql_ctype<T>::value || col.value_size != sizeof(T))
+            throw type_incompatible_error();
+        auto const i = static_cast<std::size_t>(index);
+        std::memcpy(inserter_->value(i), &value, sizeof(T));
+        *inserter_->indicator(i) = static_cast<null_type>(sizeof(T));
+    }
+
+    void set_string(short index, string::value_type const* value, std::size_t length)
+    {
+        if (bulk_)
+            return bulk_->set(index, value);
+        using char_type = string::value_type;
+        column const& col = column_for_value(index);
+        if (!col.text)
+            throw type_incompatible_error();
+        if ((length + 1) * sizeof(char_type) > col.value_size)
+            throw programming_error("copy_in string value exceeds its column length");
+        auto const i = static_cast<std::size_t>(index);
+        char_type* const data = static_cast<char_type*>(inserter_->value(i));
+        std::copy(value, value + length, data);
+        data[length] = char_type();
+        *inserter_->indicator(i) = SQL_NTS;
+    }
+
+    void add_row()
+    {
+        if (bulk_)
+            return bulk_->add_row();
+        start();
+        inserter_->add_row();
+    }
+
+    void flush()
+    {
+        if (bulk_)
+            return bulk_->flush();
+        if (inserter_)
+            inserter_->flush();
+    }
+
+    std::size_t finish()
+    {
+        if (bulk_)
+            return bulk_->finish();
+        flush();
+        return inserter_ ? inserter_->inserted() : 0;
+    }
+
+private:
+    struct column
+    {
+        string name;
+        SQLSMALLINT ctype = 0;
+        std::size_t value_size = 0;
+        bool text = false;
+    };
+
+    void add_column(string const& name, SQLSMALLINT ctype, std::size_t value_size, bool text)
+    {
+        if (inserter_)
+            throw programming_error("copy_in columns must be added before any value is set");
+        if (columns_.size() == static_cast<std::size_t>(std::numeric_limits<short>::max()))
+            throw programming_error("copy_in has too many columns");
+        column col;
+        col.name = name;
+        col.ctype = ctype;
+        col.value_size = value_size;
+        col.text = text;
+        columns_.push_back(col);
+    }
+
+    column const& column_for_value(short index)
+    {
+        start();
+        if (index < 0 || static_cast<std::size_t>(index) >= columns_.size())
+            throw index_range_error();
+        return columns_[static_cast<std::size_t>(index)];
+    }
+
+    void start()
+    {
+        if (inserter_)
+            return;
+        if (columns_.empty())
+            throw programming_error("copy_in has no columns");
+
+        string prefix = NANODBC_TEXT("INSERT INTO ") + table_ + NANODBC_TEXT(" (");
+        string row = NANODBC_TEXT("(");
+        std::vector<multirow_inserter::column> columns;
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+        {
+            if (i > 0)
+            {
+                prefix += NANODBC_TEXT(", ");
+                row += NANODBC_TEXT(", ");
+            }
+            prefix += columns_[i].name;
+            row += NANODBC_TEXT('?');
+            multirow_inserter::column col;
+            col.ctype = columns_[i].ctype;
+            col.value_size = columns_[i].value_size;
+            columns.push_back(col);
+        }
+        prefix += NANODBC_TEXT(") VALUES ");
+        row += NANODBC_TEXT(')');
+
+        std::size_t const rows =
+            multirow_insert_rows(conn_, columns.size(), prefix.size(), row.size(), options_);
+        inserter_ = std::make_unique<multirow_inserter>(
+            conn_, std::move(prefix), std::move(row), std::move(columns), rows);
+    }
+
+    connection conn_;
+    string const table_;
+    copy_options const options_;
+    std::vector<column> columns_;
+    std::unique_ptr<bulk_copy> bulk_;
+    std::unique_ptr<multirow_inserter> inserter_;
+};
+
+copy_in::copy_in(connection& conn, string const& table, copy_options const& options)
+    : impl_(std::make_shared<copy_in_impl>(conn, table, options))
+{
+}
+
+copy_in::~copy_in() noexcept {}
+
+bool copy_in::uses_bcp() const noexcept
+{
+    return impl_->uses_bcp();
+}
+
+std::size_t copy_in::rows_per_statement() const noexcept
+{
+    return impl_->rows_per_statement();
+}
+
+template <class T>
+void copy_in::add_column(string const& name)
+{
+    impl_->add_column<T>(name);
+}
+
+void copy_in::add_string_column(string const& name, std::size_t max_length)
+{
+    impl_->add_string_column(name, max_length);
+}
+
+template <class T>
+void copy_in::set(short column, T const& value)
+{
+    impl_->set(column, value);
+}
+
+void copy_in::set(short column, string const& value)
+{
+    impl_->set_string(column, value.c_str(), value.size());
+}
+
+void copy_in::set(short column, string::value_type const* value)
+{
+    impl_->set_string(column, value, std::char_traits<string::value_type>::length(value));
+}
+
+void copy_in::add_row()
+{
+    impl_->add_row();
+}
+
+void copy_in::flush()
+{
+    impl_->flush();
+}
+
+std::size_t copy_in::finish()
+{
+    return impl_->finish();
+}
+
+// The following are the only supported instantiations of copy_in columns, those of bulk_copy.
+#define NANODBC_INSTANTIATE_COPY_IN(type)                                                          \
+    template void copy_in::add_column<type>(string const&);                                        \
+    template void copy_in::set(short, type const&)
+
+NANODBC_INSTANTIATE_COPY_IN(unsigned char);
+NANODBC_INSTANTIATE_COPY_IN(short);
+NANODBC_INSTANTIATE_COPY_IN(int);
+NANODBC_INSTANTIATE_COPY_IN(long int);
+NANODBC_INSTANTIATE_COPY_IN(long long);
+NANODBC_INSTANTIATE_COPY_IN(float);
+NANODBC_INSTANTIATE_COPY_IN(double);
+NANODBC_INSTANTIATE_COPY_IN(date);
+NANODBC_INSTANTIATE_COPY_IN(timestamp);
+
+#undef NANODBC_INSTANTIATE_COPY_IN
+
+std::size_t copy_out(
+    connection& conn,
+    string const& query,
+    std::function<void(prefetching_result&)> const& row_handler,
+    copy_options const& options)
+{
+    long const rows_per_fetch =
+        options.rows_per_fetch > 0 ? options.rows_per_fetch : conn.profile().rows_per_fetch;
+    prefetching_result rows(execute(conn, query, rows_per_fetch));
+    std::size_t count = 0;
+    while (rows.next())
+    {
+        row_handler(rows);
+        ++count;
+    }
+    return count;
+}
+
+class multirow_insert::multirow_insert_impl
+{
+public:
+    multirow_insert_impl(multirow_insert_impl const&) = delete;
+    multirow_insert_impl& operator=(multirow_insert_impl const&) = delete;
+    multirow_insert_impl(multirow_insert_impl&&) = delete;
+    multirow_insert_impl& operator=(multirow_insert_impl&&) = delete;
+
+    multirow_insert_impl(connection& conn, string const& query, copy_options const& options)
+        : conn_(conn)
+    {
+        if (!conn_.connected())
+            throw programming_error("multirow_insert requires an open connection");
+        std::size_t parameters = 0;
+        if (!split_insert_values(query, prefix_, row_, parameters))
+            throw programming_error(
+                "multirow_insert requires an INSERT ending in a VALUES list of one row with "
+                "parameters");
+        if (parameters > static_cast<std::size_t>(std::numeric_limits<short>::max()))
+            throw programming_error("multirow_insert query has too many parameters");
+        bindings_.resize(parameters);
+        rows_ = multirow_insert_rows(conn_, parameters, prefix_.size(), row_.size(), options);
+    }
+
+    short parameters() const noexcept { return static_cast<short>(bindings_.size()); }
+
+    std::size_t rows_per_statement() const noexcept { return rows_; }
+
+    template <class T>
+    void bind(short param_index, T const* values, std::size_t batch_size, bool const* nulls)
+    {
+        binding& b = binding_for(param_index);
+        b = binding();
+        b.ctype = sql_ctype<T>::value;
+        b.value_size = sizeof(T);
+        b.values = values;
+        b.nulls = nulls;
+        b.batch_size = batch_size;
+    }
+
+    void bind_strings(short param_index, std::vector<string> const& values, bool const* nulls)
+    {
+        binding& b = binding_for(param_index);
+        b = binding();
+        std::size_t length = 0;
+        for (auto const& value : values)
+            length = std::max(length, value.size());
+        b.ctype = sql_ctype<string>::value;
+        b.value_size = (length + 1) * sizeof(string::value_type);
+        b.strings = &values;
+        b.nulls = nulls;
+        b.batch_size = values.size();
+    }
+
+    std::size_t execute(std::size_t batch_operations)
+    {
+        for (auto const& b : bindings_)
+        {
+            if (b.ctype == 0)
+                throw programming_error("multirow_insert has a parameter that is not bound");
+            if (b.batch_size < batch_operations)
+                throw programming_error("multirow_insert batch exceeds a bound array");
+        }
+        last_inserted_ = 0;
+        if (batch_operations == 0)
+            return 0;
+        start();
+
+        std::size_t const inserted = inserter_->inserted();
+        try
+        {
+            for (std::size_t r = 0; r < batch_operations; ++r)
+            {
+                for (std::size_t i = 0; i < bindings_.size(); ++i)
+                {
+                    auto const& b = bindings_[i];
+                    if (b.nulls && b.nulls[r])
+                        continue; // the indicator is null until set
+                    if (b.strings)
+                    {
+                        string const& value = (*b.strings)[r];
+                        auto* const data = static_cast<string::value_type*>(inserter_->value(i));
+                        std::copy(value.begin(), value.end(), data);
+                        data[value.size()] = string::value_type();
+                        *inserter_->indicator(i) = SQL_NTS;
+                    }
+                    else
+                    {
+                        std::memcpy(
+                            inserter_->value(i),
+                            static_cast<char const*>(b.values) + r * b.value_size,
+                            b.value_size);
+                        *inserter_->indicator(i) = static_cast<null_type>(b.value_size);
+                    }
+                }
+                inserter_->add_row();
+            }
+            inserter_->flush();
+        }
+        catch (...)
+        {
+            last_inserted_ = inserter_->inserted() - inserted;
+            inserter_->discard();
+            throw;
+        }
+        last_inserted_ = inserter_->inserted() - inserted;
+        return last_inserted_;
+    }
+
+    std::size_t rows_inserted() const noexcept { return last_inserted_; }
+
+private:
+    struct binding
+    {
+        SQLSMALLINT ctype = 0;
+        std::size_t value_size = 0;
+        void const* values = nullptr;
+        std::vector<string> const* strings = nullptr;
+        bool const* nulls = nullptr;
+        std::size_t batch_size = 0;
+    };
+
+    binding& binding_for(short param_index)
+    {
+        if (param_index < 0 || static_cast<std::size_t>(param_index) >= bindings_.size())
+            throw index_range_error();
+        return bindings_[static_cast<std::size_t>(param_index)];
+    }
+
+    // Keeps the inserter, and so its statements, while its buffers fit the bound values.
+    void start()
+    {
+        bool fits = inserter_ != nullptr;
+        for (std::size_t i = 0; fits && i < bindings_.size(); ++i)
+        {
+            fits = bindings_[i].ctype == shape_[i].ctype &&
+                   bindings_[i].value_size <= shape_[i].value_size;
+        }
+        if (fits)
+            return;
+
+        inserter_.reset();
+        shape_.resize(bindings_.size());
+        for (std::size_t i = 0; i < bindings_.size(); ++i)
+        {
+            // A string parameter keeps the widest buffer it has needed.
+            if (bindings_[i].ctype != shape_[i].ctype)
+                shape_[i].value_size = 0;
+            shape_[i].ctype = bindings_[i].ctype;
+            shape_[i].value_size = std::max(shape_[i].value_size, bindings_[i].value_size);
+        }
+        inserter_ = std::make_unique<multirow_inserter>(conn_, prefix_, row_, shape_, rows_);
+    }
+
+    connection conn_;
+    string prefix_;
+    string row_;
+    std::size_t rows_{0};
+    std::vector<binding> bindings_;
+    std::vector<multirow_inserter::column> shape_;
+    std::unique_ptr<multirow_inserter> inserter_;
+    std::size_t last_inserted_{0}; // by the last execute()
+};
+
+multirow_insert::multirow_insert(
+    connection& conn,
+    string const& query,
+    copy_options const& options)
+    : impl_(std::make_shared<multirow_insert_impl>(conn, query, options))
+{
+}
+
+multirow_insert::~multirow_insert() noexcept {}
+
+short multirow_insert::parameters() const noexcept
+{
+    return impl_->parameters();
+}
+
+std::size_t multirow_insert::rows_per_statement() const noexcept
+{
+    return impl_->rows_per_statement();
+}
+
+template <class T>
+void multirow_insert::bind(
+    short param_index,
+    T const* values,
+    std::size_t batch_size,
+    bool const* nulls)
+{
+    impl_->bind(param_index, values, batch_size, nulls);
+}
+
+void multirow_insert::bind_strings(
+    short param_index,
+    std::vector<string> const& values,
+    bool const* nulls)
+{
+    impl_->bind_strings(param_index, values, nulls);
+}
+
+std::size_t multirow_insert::execute(std::size_t batch_operations)
+{
+    return impl_->execute(batch_operations);
+}
+
+std::size_t multirow_insert::rows_inserted() const noexcept
+{
+    return impl_->rows_inserted();
+}
+
+// The following are the only supported instantiations of multirow_insert::bind(), those of
+// copy_in.
+#define NANODBC_INSTANTIATE_MULTIROW_INSERT(type)                                                  \
+    template void multirow_insert::bind(short, type const*, std::size_t, bool const*)
+
+NANODBC_INSTANTIATE_MULTIROW_INSERT(unsigned char);
+NANODBC_INSTANTIATE_MULTIROW_INSERT(short);
+NANODBC_INSTANTIATE_MULTIROW_INSERT(int);
+NANODBC_INSTANTIATE_MULTIROW_INSERT(long int);
+NANODBC_INSTANTIATE_MULTIROW_INSERT(long long);
+NANODBC_INSTANTIATE_MULTIROW_INSERT(float);
+NANODBC_INSTANTIATE_MULTIROW_INSERT(double);
+NANODBC_INSTANTIATE_MULTIROW_INSERT(date);
+NANODBC_INSTANTIATE_MULTIROW_INSERT(timestamp);
+
+#undef NANODBC_INSTANTIATE_MULTIROW_INSERT
+
+} // namespace nanodbc
+
+// clang-format off
+// 888b     d888          888                    d8b          888 d8b
+// 8888b   d8888          888                    Y8P          888 Y8P
+// 88888b.d88888          888                                 888
+// 888Y88888P888  8888b.  888888 .d88b.  888d888 888  8888b.  888 888 88888888 .d88b.
+// 888 Y888P 888     "88b 888   d8P  Y8b 888P"   888     "88b 888 888    d88P d8P  Y8b
+// 888  Y8P  888 .d888888 888   88888888 888     888 .d888888 888 888   d88P  88888888
+// 888   "   888 888  888 Y88b. Y8b.     888     888 888  888 888 888  d88P   Y8b.
+// 888       888 "Y888888  "Y888 "Y8888  888     888 "Y888888 888 888 88888888 "Y8888
+// MARK: Materialize -
+// clang-format on
+
+namespace
+{
+
+// How a materialized column holds its values: fixed size ones in an array of their type, text
+// and binary ones end to end, with an offset per row.
+enum class cell_kind : std::uint8_t
+{
+    integer,          // std::int64_t
+    unsigned_integer, // std::uint64_t, for SQL_C_UBIGINT
+    real,             // double
+    date,             // nanodbc::date
+    time,             // nanodbc::time
+    timestamp,        // nanodbc::timestamp
+    text,             // nanodbc::string::value_type units
+    binary            // bytes
+};
+
+cell_kind column_cell_kind(int c_type, int sql_type) noexcept
+{
+    switch (c_type)
+    {
+    case SQL_C_UBIGINT:
+        return cell_kind::unsigned_integer;
+    case SQL_C_BIT:
+    case SQL_C_TINYINT:
+    case SQL_C_STINYINT:
+    case SQL_C_UTINYINT:
+    case SQL_C_SHORT:
+    case SQL_C_SSHORT:
+    case SQL_C_USHORT:
+    case SQL_C_LONG:
+    case SQL_C_SLONG:
+    case SQL_C_ULONG:
+    case SQL_C_SBIGINT:
+        return cell_kind::integer;
+    case SQL_C_FLOAT:
+    case SQL_C_DOUBLE:
+        return cell_kind::real;
+    case SQL_C_DATE:
+        return cell_kind::date;
+    case SQL_C_TIME:
+        return cell_kind::time;
+    case SQL_C_TIMESTAMP:
+        return cell_kind::timestamp;
+    case SQL_C_BINARY:
+        // Bound as binary, but read as text like get<string>() does.
+        return sql_type == SQL_SS_TIMESTAMPOFFSET ? cell_kind::text : cell_kind::binary;
+    default:
+        return cell_kind::text;
+    }
+}
+
+// The width of a value of a fixed size kind, or zero for text and binary.
+std::size_t cell_width(cell_kind kind) noexcept
+{
+    switch (kind)
+    {
+    case cell_kind::integer:
+    case cell_kind::unsigned_integer:
+        return sizeof(std::int64_t);
+    case cell_kind::real:
+        return sizeof(double);
+    case cell_kind::date:
+        return sizeof(nanodbc::date);
+    case cell_kind::time:
+        return sizeof(nanodbc::time);
+    case cell_kind::timestamp:
+        return sizeof(nanodbc::timestamp);
+    default:
+        return 0;
+    }
+}
+
+// The cells of a column, wherever they are held. Fixed size values lie end to end in data, and
+// the value of a text or binary row lies in data from offsets[row] up to offsets[row + 1],
+// which count bytes. nulls has a bit per row, the lowest bit of its first byte being row 0.
+struct column_cells
+{
+    cell_kind kind;
+    char const* data;
+    std::uint64_t const* offsets;
+    std::uint8_t const* nulls;
+};
+
+bool cell_is_null(column_cells const& cells, std::size_t row) noexcept
+{
+    return ((cells.nulls[row / 8] >> (row % 8)) & 1) != 0;
+}
+
+// Copied out rather than cast, as data need not be aligned for T.
+template <class T>
+T fixed_cell(column_cells const& cells, std::size_t row) noexcept
+{
+    T value;
+    std::memcpy(&value, cells.data + row * sizeof(T), sizeof(T));
+    return value;
+}
+
+std::pair<char const*, std::size_t> variable_cell(column_cells const& cells, std::size_t row)
+{
+    auto const begin = cells.offsets[row];
+    return {cells.data + begin, static_cast<std::size_t>(cells.offsets[row + 1] - begin)};
+}
+
+void text_cell(column_cells const& cells, std::size_t row, nanodbc::string& out)
+{
+    auto const bytes = variable_cell(cells, row);
+    out.resize(bytes.second / sizeof(nanodbc::string::value_type));
+    if (!out.empty())
+        std::memcpy(&out[0], bytes.first, bytes.second);
+}
+
+template <class T>
+void text_cell(column_cells const& cells, std::size_t row, T& out)
+{
+    nanodbc::string text;
+    text_cell(cells, row, text);
+    convert(text, out);
+}
+
+template <class T>
+void read_number_cell(column_cells const& cells, std::size_t row, T& out)
+{
+    switch (cells.kind)
+    {
+    case cell_kind::integer:
+        out = static_cast<T>(fixed_cell<std::int64_t>(cells, row));
+        return;
+    case cell_kind::unsigned_integer:
+        out = static_cast<T>(fixed_cell<std::uint64_t>(cells, row));
+        return;
+    case cell_kind::real:
+        out = static_cast<T>(fixed_cell<double>(cells, row));
+        return;
+    default:
+        break;
+    }
+    throw nanodbc::type_incompatible_error();
+}
+
+// A character of a text column is its first, as result reads it from the bound buffer.
+template <class T, typename std::enable_if<nanodbc::is_character<T>::value, int>::type = 0>
+void read_cell(column_cells const& cells, std::size_t row, T& out)
+{
+    if (cells.kind != cell_kind::text)
+        return read_number_cell(cells, row, out);
+    auto const bytes = variable_cell(cells, row);
+    nanodbc::string::value_type first{};
+    if (bytes.second >= sizeof(first))
+        std::memcpy(&first, bytes.first, sizeof(first));
+    out = static_cast<T>(first);
+}
+
+template <
+    class T,
+    typename std::enable_if<
+        std::is_arithmetic<T>::value && !nanodbc::is_character<T>::value,
+        int>::type = 0>
+void read_cell(column_cells const& cells, std::size_t row, T& out)
+{
+    if (cells.kind != cell_kind::text)
+        return read_number_cell(cells, row, out);
+    if (sizeof(nanodbc::string::value_type) == 1)
+    {
+        auto const bytes = variable_cell(cells, row);
+        out = nanodbc::from_string<T>(bytes.first, bytes.first + bytes.second);
+        return;
+    }
+    std::string text;
+    text_cell(cells, row, text);
+    out = nanodbc::from_string<T>(text);
+}
+
+template <class T, typename std::enable_if<nanodbc::is_string<T>::value, int>::type = 0>
+void read_cell(column_cells const& cells, std::size_t row, T& out)
+{
+    switch (cells.kind)
+    {
+    case cell_kind::integer:
+        convert(std::to_string(fixed_cell<std::int64_t>(cells, row)), out);
+        return;
+    case cell_kind::unsigned_integer:
+        convert(std::to_string(fixed_cell<std::uint64_t>(cells, row)), out);
+        return;
+    case cell_kind::real:
+        convert(std::to_string(fixed_cell<double>(cells, row)), out);
+        return;
+    case cell_kind::date:
+        convert(date_as_string(fixed_cell<nanodbc::date>(cells, row)), out);
+        return;
+    case cell_kind::time:
+        convert(time_as_string(fixed_cell<nanodbc::time>(cells, row)), out);
+        return;
+    case cell_kind::timestamp:
+        convert(timestamp_as_string(fixed_cell<nanodbc::timestamp>(cells, row)), out);
+        return;
+    case cell_kind::text:
+        text_cell(cells, row, out);
+        return;
+    case cell_kind::binary:
+    {
+        auto const bytes = variable_cell(cells, row);
+        convert(std::string(bytes.first, bytes.second), out);
+        return;
+    }
+    }
+}
+
+// A date or time held as text, as result parses one from a character column.
+parsed_temporal text_cell_temporal(column_cells const& cells, std::size_t row)
+{
+    auto const bytes = variable_cell(cells, row);
+    nanodbc::string::value_type units[256];
+    auto const count = bytes.second / sizeof(units[0]);
+    if (count > sizeof(units) / sizeof(units[0]))
+        return {};
+    std::memcpy(units, bytes.first, count * sizeof(units[0]));
+    return parse_temporal(units, count);
+}
+
+void read_cell(column_cells const& cells, std::size_t row, nanodbc::date& out)
+{
+    if (cells.kind == cell_kind::date)
+    {
+        out = fixed_cell<nanodbc::date>(cells, row);
+        return;
+    }
+    if (cells.kind == cell_kind::timestamp)
+    {
+        auto const stamp = fixed_cell<nanodbc::timestamp>(cells, row);
+        out = nanodbc::date{stamp.year, stamp.month, stamp.day};
+        return;
+    }
+    if (cells.kind == cell_kind::text)
+    {
+        auto const parsed = text_cell_temporal(cells, row);
+        if (parsed.has_date)
+        {
+            auto const& stamp = parsed.value.stamp;
+            out = nanodbc::date{stamp.year, stamp.month, stamp.day};
+            return;
+        }
+    }
+    throw nanodbc::type_incompatible_error();
+}
+
+void read_cell(column_cells const& cells, std::size_t row, nanodbc::time& out)
+{
+    if (cells.kind == cell_kind::time)
+    {
+        out = fixed_cell<nanodbc::time>(cells, row);
+        return;
+    }
+    if (cells.kind == cell_kind::timestamp)
+    {
+        auto const stamp = fixed_cell<nanodbc::timestamp>(cells, row);
+        out = nanodbc::time{stamp.hour, stamp.min, stamp.sec};
+        return;
+    }
+    if (cells.kind == cell_kind::text)
+    {
+        auto const parsed = text_cell_temporal(cells, row);
+        if (parsed.has_time)
+        {
+            auto const& stamp = parsed.value.stamp;
+            out = nanodbc::time{stamp.hour, stamp.min, stamp.sec};
+            return;
+        }
+    }
+    throw nanodbc::type_incompatible_error();
+}
+
+void read_cell(column_cells const& cells, std::size_t row, nanodbc::timestamp& out)
+{
+    if (cells.kind == cell_kind::timestamp)
+    {
+        out = fixed_cell<nanodbc::timestamp>(cells, row);
+        return;
+    }
+    if (cells.kind == cell_kind::date)
+    {
+        auto const d = fixed_cell<nanodbc::date>(cells, row);
+        out = nanodbc::timestamp{d.year, d.month, d.day, 0, 0, 0, 0};
+        return;
+    }
+    if (cells.kind == cell_kind::text)
+    {
+        auto const parsed = text_cell_temporal(cells, row);
+        if (parsed.has_date)
+        {
+            out = parsed.value.stamp;
+            return;
+        }
+    }
+    throw nanodbc::type_incompatible_error();
+}
+
+// A datetimeoffset column is held as the text get<string>() renders, and read back from it.
+void read_cell(column_cells const& cells, std::size_t row, nanodbc::timestampoffset& out)
+{
+    if (cells.kind == cell_kind::timestamp)
+    {
+        out = nanodbc::timestampoffset{fixed_cell<nanodbc::timestamp>(cells, row), 0, 0};
+        return;
+    }
+    if (cells.kind == cell_kind::text)
+    {
+        auto const parsed = text_cell_temporal(cells, row);
+        if (parsed.has_date)
+        {
+            out = parsed.value;
+            return;
+        }
+    }
+    throw nanodbc::type_incompatible_error();
+}
+
+void read_cell(column_cells const& cells, std::size_t row, std::vector<std::uint8_t>& out)
+{
+    if (cells.kind != cell_kind::binary)
+        throw nanodbc::type_incompatible_error();
+    auto const bytes = variable_cell(cells, row);
+    auto const first = reinterpret_cast<std::uint8_t const*>(bytes.first);
+    out.assign(first, first + bytes.second);
+}
+
+// Description of a materialized column.
+struct column_meta
+{
+    nanodbc::string name;
+    int sql_type;
+    int c_type;
+    long size;
+    int decimal_digits;
+    cell_kind kind;
+};
+
+std::vector<column_meta> describe_columns(nanodbc::result const& rows)
+{
+    std::vector<column_meta> columns;
+    short const count = rows.columns();
+    for (short i = 0; i < count; ++i)
+    {
+        int const sql_type = rows.column_datatype(i);
+        int const c_type = rows.column_c_datatype(i);
+        columns.push_back(
+            {rows.column_name(i),
+             sql_type,
+             c_type,
+             rows.column_size(i),
+             rows.column_decimal_digits(i),
+             column_cell_kind(c_type, sql_type)});
+    }
+    return columns;
+}
+
+// The cells of a run of rows as they are read, column by column, in buffers that grow.
+class chunk_builder
+{
+public:
+    struct column_buffers
+    {
+        cell_kind kind;
+        std::vector<char> data;
+        std::vector<std::uint64_t> offsets; // text and binary only
+        std::vector<std::uint8_t> nulls;
+    };
+
+    explicit chunk_builder(std::vector<column_meta> const& columns)
+    {
+        for (auto const& column : columns)
+            columns_.push_back({column.kind, {}, {}, {}});
+        clear();
+    }
+
+    // Empties the buffers for the next run of rows, keeping their capacity.
+    void clear()
+    {
+        for (auto& col : columns_)
+        {
+            col.data.clear();
+            col.nulls.clear();
+            col.offsets.clear();
+            if (cell_width(col.kind) == 0)
+                col.offsets.push_back(0);
+        }
+        rows_ = 0;
+    }
+
+    // Starts the next row, whose cells are then added in column order.
+    void add_row()
+    {
+        if (rows_ % 8 == 0)
+        {
+            for (auto& col : columns_)
+                col.nulls.push_back(0);
+        }
+        ++rows_;
+    }
+
+    cell_kind kind(short column) const noexcept { return columns_[column].kind; }
+
+    void add_null(short column)
+    {
+        column_buffers& col = columns_[column];
+        auto const row = rows_ - 1;
+        col.nulls.back() |= static_cast<std::uint8_t>(1u << (row % 8));
+        if (col.offsets.empty())
+            col.data.resize(col.data.size() + cell_width(col.kind));
+        else
+            col.offsets.push_back(col.data.size());
+    }
+
+    template <class T>
+    void add_fixed(short column, T const& value)
+    {
+        column_buffers& col = columns_[column];
+        NANODBC_ASSERT(cell_width(col.kind) == sizeof(T));
+        auto const at = col.data.size();
+        col.data.resize(at + sizeof(T));
+        std::memcpy(&col.data[at], &value, sizeof(T));
+    }
+
+    void add_variable(short column, void const* data, std::size_t size)
+    {
+        column_buffers& col = columns_[column];
+        NANODBC_ASSERT(!col.offsets.empty());
+        auto const bytes = static_cast<char const*>(data);
+        col.data.insert(col.data.end(), bytes, bytes + size);
+        col.offsets.push_back(col.data.size());
+    }
+
+    // Gives back what the buffers grew by beyond the values they hold.
+    void shrink_to_fit()
+    {
+        for (auto& col : columns_)
+        {
+            col.data.shrink_to_fit();
+            col.offsets.shrink_to_fit();
+            col.nulls.shrink_to_fit();
+        }
+    }
+
+    std::size_t rows() const noexcept { return rows_; }
+
+    column_buffers const& buffers(short column) const noexcept { return columns_[column]; }
+
+    column_cells cells(short column) const noexcept
+    {
+        auto const& col = columns_[column];
+        return {
+            col.kind,
+            col.data.data(),
+            col.offsets.empty() ? nullptr : col.offsets.data(),
+            col.nulls.data()};
+    }
+
+    std::size_t memory_size() const noexcept
+    {
+        std::size_t size = 0;
+        for (auto const& col : columns_)
+        {
+            size += col.data.size() + col.offsets.size() * sizeof(std::uint64_t) +
+                    col.nulls.size();
+        }
+        return size;
+    }
+
+private:
+    std::vector<column_buffers> columns_;
+    std::size_t rows_{0};
+};
+
+// Reads the next rows of a result into the chunk, up to max_rows of them, or all if zero.
+// Returns the number of rows read, fewer than max_rows only at the end of the result set.
+std::size_t read_rows(nanodbc::result& rows, chunk_builder& chunk, std::size_t max_rows)
+{
+    // Reused from one row to the next, so a bound text column is copied without allocating.
+    nanodbc::string text;
+    std::vector<std::uint8_t> bytes;
+    auto const add_fixed = [&](short column, auto value) {
+        rows.get_ref(column, decltype(value){}, value);
+        if (rows.is_null(column))
+            chunk.add_null(column);
+        else
+            chunk.add_fixed(column, value);
+    };
+
+    short const columns = rows.columns();
+    std::size_t count = 0;
+    while ((max_rows == 0 || count < max_rows) && rows.next())
+    {
+        ++count;
+        chunk.add_row();
+        for (short i = 0; i < columns; ++i)
+        {
+            // Read in column order, as unbound columns have to be. The null of a bound column
+            // is known before the read, and that of an unbound one after it.
+            if (rows.is_null(i))
+            {
+                chunk.add_null(i);
+                continue;
+            }
+            switch (chunk.kind(i))
+            {
+            case cell_kind::integer:
+                add_fixed(i, static_cast<long long>(0));
+                break;
+            case cell_kind::unsigned_integer:
+                add_fixed(i, static_cast<unsigned long long>(0));
+                break;
+            case cell_kind::real:
+                add_fixed(i, 0.0);
+                break;
+            case cell_kind::date:
+                add_fixed(i, nanodbc::date{});
+                break;
+            case cell_kind::time:
+                add_fixed(i, nanodbc::time{});
+                break;
+            case cell_kind::timestamp:
+                add_fixed(i, nanodbc::timestamp{});
+                break;
+            case cell_kind::text:
+                rows.get_ref(i, nanodbc::string(), text);
+                if (rows.is_null(i))
+                    chunk.add_null(i);
+                else
+                    chunk.add_variable(
+                        i, text.data(), text.size() * sizeof(nanodbc::string::value_type));
+                break;
+            case cell_kind::binary:
+                rows.get_ref(i, std::vector<std::uint8_t>(), bytes);
+                if (rows.is_null(i))
+                    chunk.add_null(i);
+                else
+                    chunk.add_variable(i, bytes.data(), bytes.size());
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+// The layout of a file written by spool(), in the byte order of the machine that wrote it:
+//
+//   header     magic, byte order mark, version, column count, text unit size, rows per chunk
+//   columns    per column: SQL type, C type, size, decimal digits, cell kind, name
+//   chunks     per chunk and column: null bitmap, offsets if text or binary, values
+//   directory  chunk count, and per chunk its rows and per column where its parts start
+//   trailer    where the directory starts, magic
+//
+// Every part starts on an 8 byte boundary, so the offsets can be read in place from a mapping.
+// The trailer is written last, so a file whose writing was cut short is not taken for a whole
+// one.
+char const spool_magic[8] = {'N', 'A', 'N', 'O', 'D', 'B', 'C', 'S'};
+std::uint32_t const spool_byte_order = 0x01020304;
+std::uint32_t const spool_version = 1;
+
+struct spool_header
+{
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t columns;
+    std::uint32_t text_unit;
+    std::uint64_t rows_per_chunk;
+};
+
+struct spool_column
+{
+    std::int32_t sql_type;
+    std::int32_t c_type;
+    std::int64_t size;
+    std::int32_t decimal_digits;
+    std::uint32_t kind;
+    std::uint64_t name_units;
+};
+
+struct spool_part
+{
+    std::uint64_t nulls;
+    std::uint64_t offsets; // zero for fixed size values
+    std::uint64_t data;
+    std::uint64_t data_size;
+};
+
+struct spool_trailer
+{
+    std::uint64_t directory;
+    char magic[8];
+};
+
+class spool_writer
+{
+public:
+    explicit spool_writer(std::string const& path)
+        : path_(path)
+        , file_(std::fopen(path.c_str(), "wb"))
+    {
+        if (!file_)
+            throw nanodbc::programming_error("cannot create spool file: " + path);
+    }
+
+    ~spool_writer() noexcept
+    {
+        if (file_)
+            std::fclose(file_);
+    }
+
+    spool_writer(spool_writer const&) = delete;
+    spool_writer& operator=(spool_writer const&) = delete;
+
+    std::uint64_t position() const noexcept { return position_; }
+
+    void write(void const* data, std::size_t size)
+    {
+        if (size != 0 && std::fwrite(data, 1, size, file_) != size)
+            throw nanodbc::programming_error("cannot write spool file: " + path_);
+        position_ += size;
+    }
+
+    template <class T>
+    void write_value(T const& value)
+    {
+        write(&value, sizeof(value));
+    }
+
+    void align()
+    {
+        static char const zeros[8] = {};
+        write(zeros, static_cast<std::size_t>((8 - position_ % 8) % 8));
+    }
+
+    void close()
+    {
+        auto const file = file_;
+        file_ = nullptr;
+        if (std::fclose(file) != 0)
+            throw nanodbc::programming_error("cannot write spool file: " + path_);
+    }
+
+private:
+    std::string path_;
+    std::FILE* file_;
+    std::uint64_t position_{0};
+};
+
+// A file mapped into memory for reading, unmapped on destruction.
+class mapped_file
+{
+public:
+    explicit mapped_file(std::string const& path)
+    {
+#if defined(_WIN32)
+        HANDLE const file = ::CreateFileA(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw nanodbc::programming_error("cannot open spool file: " + path);
+        LARGE_INTEGER size{};
+        if (!::GetFileSizeEx(file, &size) ||
+            static_cast<unsigned long long>(size.QuadPart) >
+                (std::numeric_limits<std::size_t>::max)())
+        {
+            ::CloseHandle(file);
+            throw nanodbc::programming_error("cannot map spool file: " + path);
+        }
+        size_ = static_cast<std::size_t>(size.QuadPart);
+        HANDLE mapping = nullptr;
+        if (size_ != 0)
+            mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        ::CloseHandle(file);
+        if (mapping)
+        {
+            data_ = static_cast<char const*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            ::CloseHandle(mapping);
+        }
+#else
+        int const file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            throw nanodbc::programming_error("cannot open spool file: " + path);
+        struct stat status;
+        if (::fstat(file, &status) != 0 || status.st_size < 0 ||
+            static_cast<unsigned long long>(status.st_size) >
+                std::numeric_limits<std::size_t>::max())
+        {
+            ::close(file);
+            throw nanodbc::programming_error("cannot map spool file: " + path);
+        }
+        size_ = static_cast<std::size_t>(status.st_size);
+        if (size_ != 0)
+        {
+            void* const data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED)
+                data_ = static_cast<char const*>(data);
+        }
+        ::close(file);
+#endif
+        if (!data_)
+            throw nanodbc::programming_error("cannot map spool file: " + path);
+    }
+
+    ~mapped_file() noexcept
+    {
+#if defined(_WIN32)
+        ::UnmapViewOfFile(data_);
+#else
+        ::munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    mapped_file(mapped_file const&) = delete;
+    mapped_file& operator=(mapped_file const&) = delete;
+
+    char const* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    char const* data_{nullptr};
+    std::size_t size_{0};
+};
+
+} // namespace
+
+namespace nanodbc
+{
+
+class materialized_result::materialized_result_impl
+{
+public:
+    // The chunks, of rows_per_chunk rows each but for the last, are added after construction.
+    // Their cells are held by storage, which is either a chunk_builder or a mapped_file.
+    materialized_result_impl(
+        std::vector<column_meta> columns,
+        std::size_t rows_per_chunk,
+        std::shared_ptr<void const> storage,
+        std::size_t memory_size)
+        : columns_(std::move(columns))
+        , rows_per_chunk_(rows_per_chunk)
+        , storage_(std::move(storage))
+        , memory_size_(memory_size)
+    {
+        NANODBC_ASSERT(rows_per_chunk_ != 0);
+        for (std::size_t i = 0; i < columns_.size(); ++i)
+            columns_by_name_.emplace(columns_[i].name, static_cast<short>(i));
+    }
+
+    materialized_result_impl(materialized_result_impl const&) = delete;
+    materialized_result_impl& operator=(materialized_result_impl const&) = delete;
+
+    void add_chunk(std::size_t rows, std::vector<column_cells> cells)
+    {
+        NANODBC_ASSERT(cells.size() == columns_.size());
+        chunks_.push_back(std::move(cells));
+        rows_ += rows;
+    }
+
+    std::size_t rows() const noexcept { return rows_; }
+
+    short columns() const noexcept { return static_cast<short>(columns_.size()); }
+
+    std::size_t memory_size() const noexcept { return memory_size_; }
+
+    // The cells of the chunk holding a row, and the index of the row within that chunk.
+    std::pair<column_cells, std::size_t> cells(short column, std::size_t row) const
+    {
+        column_at(column);
+        return {
+            chunks_[row / rows_per_chunk_][static_cast<std::size_t>(column)],
+            row % rows_per_chunk_};
+    }
+
+    short column(string const& column_name) const
+    {
+        auto const it = columns_by_name_.find(column_name);
+        if (it == columns_by_name_.end())
+            throw index_range_error();
+        return it->second;
+    }
+
+    string const& column_name(short column) const { return column_at(column).name; }
+    long column_size(short column) const { return column_at(column).size; }
+    int column_decimal_digits(short column) const { return column_at(column).decimal_digits; }
+    int column_datatype(short column) const { return column_at(column).sql_type; }
+    int column_c_datatype(short column) const { return column_at(column).c_type; }
+
+private:
+    column_meta const& column_at(short column) const
+    {
+        if (column < 0 || column >= columns())
+            throw index_range_error();
+        return columns_[static_cast<std::size_t>(column)];
+    }
+
+    std::vector<column_meta> columns_;
+    std::map<string, short> columns_by_name_;
+    std::size_t rows_per_chunk_;
+    std::vector<std::vector<column_cells>> chunks_;
+    std::shared_ptr<void const> storage_;
+    std::size_t memory_size_;
+    std::size_t rows_{0};
+};
+
+materialized_result result::materialize()
+{
+    if (!impl_)
+        throw programming_error("result is empty");
+
+    auto columns = describe_columns(*this);
+    auto chunk = std::make_shared<chunk_builder>(columns);
+    std::size_t const rows = read_rows(*this, *chunk, 0);
+    chunk->shrink_to_fit();
+
+    std::vector<column_cells> cells;
+    for (short i = 0; i < static_cast<short>(columns.size()); ++i)
+        cells.push_back(chunk->cells(i));
+    auto const memory_size = chunk->memory_size();
+    auto table = std::make_shared<materialized_result::materialized_result_impl>(
+        std::move(columns), std::max<std::size_t>(rows, 1), std::move(chunk), memory_size);
+    table->add_chunk(rows, std::move(cells));
+    return materialized_result(std::move(table));
+}
+
+std::size_t spool(result& rows, std::string const& path, spool_options const& options)
+{
+    if (!rows)
+        throw programming_error("result is empty");
+    if (options.rows_per_chunk == 0)
+        throw programming_error("spool chunks must hold at least one row");
+
+    auto const columns = describe_columns(rows);
+    std::string const partial = path + ".partial";
+    std::size_t total = 0;
+    try
+    {
+        spool_writer out(partial);
+
+        spool_header header{};
+        std::memcpy(header.magic, spool_magic, sizeof(spool_magic));
+        header.byte_order = spool_byte_order;
+        header.version = spool_version;
+        header.columns = static_cast<std::uint32_t>(columns.size());
+        header.text_unit = sizeof(string::value_type);
+        header.rows_per_chunk = options.rows_per_chunk;
+        out.write_value(header);
+        for (auto const& column : columns)
+        {
+            spool_column described{};
+            described.sql_type = column.sql_type;
+            described.c_type = column.c_type;
+            described.size = column.size;
+            described.decimal_digits = column.decimal_digits;
+            described.kind = static_cast<std::uint32_t>(column.kind);
+            described.name_units = column.name.size();
+            out.write_value(described);
+            out.write(column.name.data(), column.name.size() * sizeof(string::value_type));
+            out.align();
+        }
+
+        // Each chunk is written once it is full, so no more than one is ever held in memory.
+        std::vector<std::uint64_t> chunk_rows;
+        std::vector<spool_part> parts;
+        chunk_builder chunk(columns);
+        for (;;)
+        {
+            std::size_t const count = read_rows(rows, chunk, options.rows_per_chunk);
+            if (count == 0)
+                break;
+            chunk_rows.push_back(count);
+            for (short i = 0; i < static_cast<short>(columns.size()); ++i)
+            {
+                auto const& buffers = chunk.buffers(i);
+                spool_part part{};
+                part.nulls = out.position();
+                out.write(buffers.nulls.data(), buffers.nulls.size());
+                out.align();
+                if (!buffers.offsets.empty())
+                {
+                    part.offsets = out.position();
+                    out.write(
+                        buffers.offsets.data(), buffers.offsets.size() * sizeof(std::uint64_t));
+                }
+                part.data = out.position();
+                part.data_size = buffers.data.size();
+                out.write(buffers.data.data(), buffers.data.size());
+                out.align();
+                parts.push_back(part);
+            }
+            total += count;
+            chunk.clear();
+            if (count < options.rows_per_chunk)
+                break;
+        }
+
+        spool_trailer trailer{};
+        trailer.directory = out.position();
+        std::memcpy(trailer.magic, spool_magic, sizeof(spool_magic));
+        out.write_value(static_cast<std::uint64_t>(chunk_rows.size()));
+        for (std::size_t i = 0; i < chunk_rows.size(); ++i)
+        {
+            out.write_value(chunk_rows[i]);
+            out.write(&parts[i * columns.size()], columns.size() * sizeof(spool_part));
+        }
+        out.write_value(trailer);
+        out.close();
+    }
+    catch (...)
+    {
+        std::remove(partial.c_str());
+        throw;
+    }
+
+    // Only a whole file takes the place of an earlier one, which is replaced in one step, so
+    // that there is no moment at which neither is there.
+#if defined(_WIN32)
+    bool const moved =
+        ::MoveFileExA(partial.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool const moved = std::rename(partial.c_str(), path.c_str()) == 0;
+#endif
+    if (!moved)
+    {
+        std::remove(partial.c_str());
+        throw programming_error("cannot create spool file: " + path);
+    }
+    return total;
+}
+
+materialized_result open_spool(std::string const& path)
+{
+    auto file = std::make_shared<mapped_file>(path);
+    char const* const base = file->data();
+    std::uint64_t const size = file->size();
+
+    // Every part is checked to lie within the file before it is read, and offsets to be in
+    // order, so that a damaged file fails here rather than when its values are read.
+    auto const at = [&](std::uint64_t position, std::uint64_t length) {
+        if (position > size || length > size - position)
+            throw programming_error("invalid spool file: " + path);
+        return base + position;
+    };
+    auto const check = [&](bool valid) {
+        if (!valid)
+            throw programming_error("invalid spool file: " + path);
+    };
+
+    spool_header header;
+    std::memcpy(&header, at(0, sizeof(header)), sizeof(header));
+    spool_trailer trailer;
+    check(size >= sizeof(header) + sizeof(trailer));
+    std::memcpy(&trailer, at(size - sizeof(trailer), sizeof(trailer)), sizeof(trailer));
+    check(
+        std::memcmp(header.magic, spool_magic, sizeof(spool_magic)) == 0 &&
+        std::memcmp(trailer.magic, spool_magic, sizeof(spool_magic)) == 0);
+    check(header.byte_order == spool_byte_order && header.version == spool_version);
+    check(header.text_unit == sizeof(string::value_type));
+    check(header.rows_per_chunk != 0);
+    check(header.columns <= static_cast<std::uint32_t>(std::numeric_limits<short>::max()));
+
+    std::vector<column_meta> columns;
+    std::uint64_t position = sizeof(header);
+    for (std::uint32_t i = 0; i < header.columns; ++i)
+    {
+        spool_column described;
+        std::memcpy(&described, at(position, sizeof(described)), sizeof(described));
+        position += sizeof(described);
+        check(described.kind <= static_cast<std::uint32_t>(cell_kind::binary));
+        check(described.name_units <= size);
+        auto const name_size = described.name_units * sizeof(string::value_type);
+        string name(static_cast<std::size_t>(described.name_units), 0);
+        if (!name.empty())
+            std::memcpy(&name[0], at(position, name_size), static_cast<std::size_t>(name_size));
+        position += (name_size + 7) / 8 * 8;
+        columns.push_back(
+            {std::move(name),
+             described.sql_type,
+             described.c_type,
+             static_cast<long>(described.size),
+             described.decimal_digits,
+             static_cast<cell_kind>(described.kind)});
+    }
+
+    std::uint64_t chunks;
+    std::memcpy(&chunks, at(trailer.directory, sizeof(chunks)), sizeof(chunks));
+    check(chunks <= size);
+    position = trailer.directory + sizeof(chunks);
+
+    auto table = std::make_shared<materialized_result::materialized_result_impl>(
+        columns, static_cast<std::size_t>(header.rows_per_chunk), file, file->size());
+    for (std::uint64_t chunk = 0; chunk < chunks; ++chunk)
+    {
+        std::uint64_t rows;
+        std::memcpy(&rows, at(position, sizeof(rows)), sizeof(rows));
+        position += sizeof(rows);
+        // Only the last chunk may be short, and none empty.
+        check(
+            rows != 0 && rows <= header.rows_per_chunk &&
+            (rows == header.rows_per_chunk || chunk + 1 == chunks));
+
+        std::vector<column_cells> cells;
+        for (auto const& column : columns)
+        {
+            spool_part part;
+            std::memcpy(&part, at(position, sizeof(part)), sizeof(part));
+            position += sizeof(part);
+
+            column_cells found{column.kind, nullptr, nullptr, nullptr};
+            found.nulls = reinterpret_cast<std::uint8_t const*>(at(part.nulls, (rows + 7) / 8));
+            found.data = at(part.data, part.data_size);
+            auto const width = cell_width(column.kind);
+            if (width != 0)
+            {
+                check(part.data_size == rows * width);
+            }
+            else
+            {
+                check(part.offsets % 8 == 0);
+                auto const offsets = reinterpret_cast<std::uint64_t const*>(
+                    at(part.offsets, (rows + 1) * sizeof(std::uint64_t)));
+                check(offsets[0] == 0 && offsets[rows] == part.data_size);
+                for (std::uint64_t row = 0; row < rows; ++row)
+                    check(offsets[row] <= offsets[row + 1]);
+                found.offsets = offsets;
+            }
+            cells.push_back(found);
+        }
+        table->add_chunk(static_cast<std::size_t>(rows), std::move(cells));
+    }
+    return materialized_result(std::move(table));
+}
+
+materialized_result::materialized_result() noexcept = default;
+
+materialized_result::materialized_result(
+    std::shared_ptr<materialized_result_impl const> impl) noexcept
+    : impl_(std::move(impl))
+{
+}
+
+long materialized_result::rows() const noexcept
+{
+    return impl_ ? static_cast<long>(impl_->rows()) : 0;
+}
+
+short materialized_result::columns() const noexcept
+{
+    return impl_ ? impl_->columns() : 0;
+}
+
+std::size_t materialized_result::memory_size() const noexcept
+{
+    return impl_ ? impl_->memory_size() : 0;
+}
+
+bool materialized_result::first() noexcept
+{
+    return move(1);
+}
+
+bool materialized_result::last() noexcept
+{
+    return move(-1);
+}
+
+bool materialized_result::next() noexcept
+{
+    return skip(1);
+}
+
+bool materialized_result::prior() noexcept
+{
+    return skip(-1);
+}
+
+bool materialized_result::move(long row) noexcept
+{
+    long const count = rows();
+    if (row < 0)
+        row = std::max(count + 1 + row, 0L);
+    row_ = std::min(row, count + 1);
+    return !at_end();
+}
+
+bool materialized_result::skip(long rows) noexcept
+{
+    long const count = this->rows();
+    row_ = std::max(0L, std::min(row_ + rows, count + 1));
+    return !at_end();
+}
+
+unsigned long materialized_result::position() const noexcept
+{
+    return at_end() ? 0 : static_cast<unsigned long>(row_);
+}
+
+bool materialized_result::at_end() const noexcept
+{
+    return row_ < 1 || row_ > rows();
+}
+
+std::size_t materialized_result::current_row() const
+{
+    if (at_end())
+        throw index_range_error();
+    return static_cast<std::size_t>(row_ - 1);
+}
+
+template <class T>
+void materialized_result::get_ref(short column, T& result) const
+{
+    if (!impl_)
+        throw index_range_error();
+    auto const cells = impl_->cells(column, current_row());
+    if (cell_is_null(cells.first, cells.second))
+        throw null_access_error();
+    read_cell(cells.first, cells.second, result);
+}
+
+template <class T>
+void materialized_result::get_ref(short column, T const& fallback, T& result) const
+{
+    if (is_null(column))
+        result = fallback;
+    else
+        get_ref(column, result);
+}
+
+template <class T>
+void materialized_result::get_ref(string const& column_name, T& result) const
+{
+    get_ref(this->column(column_name), result);
+}
+
+template <class T>
+void materialized_result::get_ref(string const& column_name, T const& fallback, T& result) const
+{
+    get_ref(this->column(column_name), fallback, result);
+}
+
+template <class T>
+T materialized_result::get(short column) const
+{
+    T result;
+    get_ref(column, result);
+    return result;
+}
+
+template <class T>
+T materialized_result::get(short column, T const& fallback) const
+{
+    T result;
+    get_ref(column, fallback, result);
+    return result;
+}
+
+template <class T>
+T materialized_result::get(string const& column_name) const
+{
+    return get<T>(this->column(column_name));
+}
+
+template <class T>
+T materialized_result::get(string const& column_name, T const& fallback) const
+{
+    return get<T>(this->column(column_name), fallback);
+}
+
+bool materialized_result::is_null(short column) const
+{
+    if (!impl_)
+        throw index_range_error();
+    auto const cells = impl_->cells(column, current_row());
+    return cell_is_null(cells.first, cells.second);
+}
+
+bool materialized_result::is_null(string const& column_name) const
+{
+    return is_null(this->column(column_name));
+}
+
+short materialized_result::column(string const& column_name) const
+{
+    if (!impl_)
+        throw index_range_error();
+    return impl_->column(column_name);
+}
+
+string materialized_result::column_name(short column) const
+{
+    if (!impl_)
+        throw index_range_error();
+    return impl_->column_name(column);
+}
+
+long materialized_result::column_size(short column) const
+{
+    if (!impl_)
+        throw index_range_error();
+    return impl_->column_size(column);
+}
+
+int materialized_result::column_decimal_digits(short column) const
+{
+    if (!impl_)
+        throw index_range_error();
+    return impl_->column_decimal_digits(column);
+}
+
+int materialized_result::column_datatype(short column) const
+{
+    if (!impl_)
+        throw index_range_error();
+    return impl_->column_datatype(column);
+}
+
+int materialized_result::column_c_datatype(short column) const
+{
+    if (!impl_)
+        throw index_range_error();
+    return impl_->column_c_datatype(column);
+}
+
+materialized_result::operator bool() const noexcept
+{
+    return static_cast<bool>(impl_);
+}
+
+// The following are the only supported instantiations of materialized_result::get() and
+// get_ref(), those of result other than std::optional and _variant_t.
+#define NANODBC_INSTANTIATE_MATERIALIZED_GET(type)                                                 \
+    template void materialized_result::get_ref(short, type&) const;                                \
+    template void materialized_result::get_ref(short, type const&, type&) const;                   \
+    template void materialized_result::get_ref(string const&, type&) const;                        \
+    template void materialized_result::get_ref(string const&, type const&, type&) const;           \
+    template type materialized_result::get(short) const;                                           \
+    template type materialized_result::get(short, type const&) const;                              \
+    template type materialized_result::get(string const&) const;                                   \
+    template type materialized_result::get(string const&, type const&) const
+
+NANODBC_INSTANTIATE_MATERIALIZED_GET(std::string::value_type);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(wide_string::value_type);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(bool);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(signed char);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(unsigned char);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(short);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(unsigned short);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(int);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(unsigned int);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(long int);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(unsigned long int);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(long long int);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(unsigned long long int);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(float);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(double);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(std::string);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(wide_string);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(date);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(time);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(timestamp);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(timestampoffset);
+NANODBC_INSTANTIATE_MATERIALIZED_GET(std::vector<std::uint8_t>);
+
+#undef NANODBC_INSTANTIATE_MATERIALIZED_GET
+
+} // namespace nanodbc
+
+// clang-format off
+// 8888888888                                    888
+// 888                                           888
+// 888                                           888
+// 8888888    888  888 88888b.   .d88b.  888d888 888888
+// 888        `Y8bd8P' 888 "88b d88""88b 888P"   888
+// 888          X88K   888  888 888  888 888     888
+// 888        .d8""8b. 888 d88P Y88..88P 888     Y88b.
+// 8888888888 888  888 88888P"   "Y88P"  888      "Y888
+//                     888
+//                     888
+//                     888
+// MARK: Export -
+// clang-format on
+
+namespace
+{
+
+// Room for any value formatted in place: a temporal one, or a real number with the terminator
+// snprintf writes.
+constexpr std::size_t max_formatted_size = 128;
+
+// The shortest text that reads back as the same value of T, a float being written at float
+// precision rather than widened, and with '.' as the decimal mark whatever the locale.
+template <class T>
+char* format_real(char* out, T value) noexcept
+{
+#if defined(NANODBC_HAS_STD_FROM_CHARS)
+    return std::to_chars(out, out + max_formatted_size - 1, value).ptr;
+#else
+    // The fewest digits of digits10 and max_digits10 that read back as the same value, which
+    // for the decimals most columns hold is the shorter. snprintf and strtod share the decimal
+    // mark of the C locale, which is swapped for '.' once the digits are settled.
+    int size = std::snprintf(
+        out, max_formatted_size, "%.*g", std::numeric_limits<T>::digits10, double(value));
+    T const read = std::is_same<T, float>::value ? std::strtof(out, nullptr)
+                                                 : static_cast<T>(std::strtod(out, nullptr));
+    if (read != value)
+        size = std::snprintf(
+            out, max_formatted_size, "%.*g", std::numeric_limits<T>::max_digits10, double(value));
+    if (size <= 0)
+        return out;
+    char const mark = *std::localeconv()->decimal_point;
+    if (mark != '.')
+        std::replace(out, out + size, mark, '.');
+    return out + size;
+#endif
+}
+
+// Appends SQLWCHAR text as UTF-8, replacing an unpaired surrogate with U+FFFD.
+template <class Unit>
+void append_utf8(Unit const* units, std::size_t count, std::string& out)
+{
+    typedef typename std::make_unsigned<Unit>::type unsigned_unit;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto code = static_cast<std::uint32_t>(static_cast<unsigned_unit>(units[i]));
+        if (sizeof(Unit) == 2 && code >= 0xD800 && code <= 0xDFFF)
+        {
+            auto const low =
+                i + 1 < count ? static_cast<std::uint32_t>(static_cast<unsigned_unit>(units[i + 1]))
+                              : 0;
+            if (code <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF)
+            {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                ++i;
+            }
+            else
+            {
+                code = 0xFFFD;
+            }
+        }
+        if (code < 0x80)
+        {
+            out += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+}
+
+// Formats fields into one buffer, quoting and escaping them, and hands the buffer to the sink
+// whenever it fills.
+class delimited_writer
+{
+public:
+    delimited_writer(
+        nanodbc::delimited_options const& options,
+        std::function<void(char const*, std::size_t)> const& sink)
+        : options_(options)
+        , sink_(sink)
+        , buffer_(std::max<std::size_t>(options.buffer_size, max_formatted_size))
+        , escapes_(
+              options.escape != '\0' &&
+              (options.quoting != nanodbc::delimited_quoting::none ||
+               options.escape != options.quote))
+    {
+        // The characters that make a field be quoted, or be escaped when none is quoted.
+        auto const mark = [this](char c) { special_[static_cast<unsigned char>(c)] = true; };
+        mark(options.delimiter);
+        mark('\r');
+        mark('\n');
+        if (options.quoting != nanodbc::delimited_quoting::none)
+            mark(options.quote);
+        if (escapes_)
+            mark(options.escape);
+    }
+
+    delimited_writer(delimited_writer const&) = delete;
+    delimited_writer& operator=(delimited_writer const&) = delete;
+
+    // Room for size bytes, size being at most max_formatted_size, taken by commit().
+    char* reserve(std::size_t size)
+    {
+        NANODBC_ASSERT(size <= buffer_.size());
+        if (buffer_.size() - used_ < size)
+            flush();
+        return buffer_.data() + used_;
+    }
+
+    void commit(char const* end) noexcept
+    {
+        used_ = static_cast<std::size_t>(end - buffer_.data());
+    }
+
+    void put(char c)
+    {
+        if (used_ == buffer_.size())
+            flush();
+        buffer_[used_++] = c;
+    }
+
+    void put(char const* data, std::size_t size)
+    {
+        while (size != 0)
+        {
+            if (used_ == buffer_.size())
+                flush();
+            auto const count = std::min(size, buffer_.size() - used_);
+            std::memcpy(buffer_.data() + used_, data, count);
+            used_ += count;
+            data += count;
+            size -= count;
+        }
+    }
+
+    void flush()
+    {
+        if (used_ != 0)
+            sink_(buffer_.data(), used_);
+        used_ = 0;
+    }
+
+    void delimiter() { put(options_.delimiter); }
+
+    void end_row() { put(options_.line_end.data(), options_.line_end.size()); }
+
+    void null() { put(options_.null_value.data(), options_.null_value.size()); }
+
+    // A field formatted by value into scratch space at most max_formatted_size long, which is
+    // the buffer itself unless the field has to be quoted or escaped.
+    template <class Format>
+    void formatted(Format format)
+    {
+        if (options_.quoting == nanodbc::delimited_quoting::all)
+        {
+            char field[max_formatted_size];
+            text(field, static_cast<std::size_t>(format(field) - field));
+            return;
+        }
+        char* const begin = reserve(max_formatted_size);
+        char* const end = format(begin);
+        for (char const* c = begin; c != end; ++c)
+        {
+            if (special_[static_cast<unsigned char>(*c)])
+            {
+                // A delimiter or escape among digits; rare enough to take the long way round.
+                char field[max_formatted_size];
+                std::memcpy(field, begin, static_cast<std::size_t>(end - begin));
+                text(field, static_cast<std::size_t>(end - begin));
+                return;
+            }
+        }
+        commit(end);
+    }
+
+    void text(char const* data, std::size_t size)
+    {
+        switch (options_.quoting)
+        {
+        case nanodbc::delimited_quoting::minimal:
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                if (special_[static_cast<unsigned char>(data[i])])
+                    return quoted(data, size);
+            }
+            return put(data, size);
+        case nanodbc::delimited_quoting::all:
+            return quoted(data, size);
+        case nanodbc::delimited_quoting::none:
+            return escaped(data, size);
+        }
+    }
+
+    void text(std::string const& value) { text(value.data(), value.size()); }
+
+    void hex(std::uint8_t const* data, std::size_t size)
+    {
+        static char const digits[] = "0123456789abcdef";
+        bool const quote = options_.quoting == nanodbc::delimited_quoting::all;
+        if (quote)
+            put(options_.quote);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            char* const out = reserve(2);
+            out[0] = digits[data[i] >> 4];
+            out[1] = digits[data[i] & 0xF];
+            commit(out + 2);
+        }
+        if (quote)
+            put(options_.quote);
+    }
+
+private:
+    // Within quotes only the quote and the escape are escaped, the delimiter and line breaks
+    // being part of the field.
+    void quoted(char const* data, std::size_t size)
+    {
+        put(options_.quote);
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            char const c = data[i];
+            if (c == options_.quote || (escapes_ && c == options_.escape))
+            {
+                put(data + begin, i - begin);
+                put(options_.escape != '\0' ? options_.escape : options_.quote);
+                begin = i;
+            }
+        }
+        put(data + begin, size - begin);
+        put(options_.quote);
+    }
+
+    void escaped(char const* data, std::size_t size)
+    {
+        if (!escapes_)
+            return put(data, size);
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            char const c = data[i];
+            if (!special_[static_cast<unsigned char>(c)])
+                continue;
+            put(data + begin, i - begin);
+            put(options_.escape);
+            put(c == '\n' ? 'n' : c == '\r' ? 'r' : c);
+            begin = i + 1;
+        }
+        put(data + begin, size - begin);
+    }
+
+    nanodbc::delimited_options const& options_;
+    std::function<void(char const*, std::size_t)> const& sink_;
+    std::vector<char> buffer_;
+    std::size_t used_{0};
+    bool const escapes_;
+    bool special_[256] = {};
+};
+
+} // namespace
+
+namespace nanodbc
+{
+
+std::size_t export_delimited(
+    result& rows,
+    std::function<void(char const*, std::size_t)> const& sink,
+    delimited_options const& options)
+{
+    if (!rows)
+        throw programming_error("result is empty");
+    if (!sink)
+        throw programming_error("export needs a sink");
+
+    auto& impl = *rows.impl_;
+    delimited_writer out(options, sink);
+    short const columns = impl.columns();
+
+    struct column_type
+    {
+        int c_type;
+        int sql_type;
+        SQLSMALLINT scale;
+    };
+    std::vector<column_type> types;
+    for (short i = 0; i < columns; ++i)
+    {
+        types.push_back(
+            {impl.column_c_datatype(i),
+             impl.column_datatype(i),
+             static_cast<SQLSMALLINT>(impl.column_decimal_digits(i))});
+    }
+
+    // Reused from one value to the next, for those that are not formatted in place.
+    std::string text;
+    std::vector<std::uint8_t> bytes;
+
+    if (options.header)
+    {
+        for (short i = 0; i < columns; ++i)
+        {
+            if (i != 0)
+                out.delimiter();
+            convert(impl.column_name(i), text);
+            out.text(text);
+        }
+        out.end_row();
+    }
+
+    std::size_t count = 0;
+    while (impl.next())
+    {
+        for (short i = 0; i < columns; ++i)
+        {
+            if (i != 0)
+                out.delimiter();
+            // Read in column order, as unbound columns have to be.
+            if (impl.is_null(i))
+            {
+                out.null();
+                continue;
+            }
+
+            auto const& type = types[static_cast<std::size_t>(i)];
+            std::size_t length = 0;
+            char const* const data = impl.bound_cell(i, length);
+            if (data)
+            {
+                // The buffers of a rowset are not aligned for their types, so values are copied
+                // out of them rather than cast.
+                auto const integer = [&](auto value) {
+                    std::memcpy(&value, data, sizeof(value));
+                    out.formatted([value](char* at) { return format_integer(at, value); });
+                };
+                switch (type.c_type)
+                {
+                case SQL_C_BIT:
+                case SQL_C_UTINYINT:
+                    integer(static_cast<unsigned char>(0));
+                    continue;
+                case SQL_C_TINYINT:
+                case SQL_C_STINYINT:
+                    integer(static_cast<signed char>(0));
+                    continue;
+                case SQL_C_SHORT:
+                case SQL_C_SSHORT:
+                    integer(static_cast<std::int16_t>(0));
+                    continue;
+                case SQL_C_USHORT:
+                    integer(static_cast<std::uint16_t>(0));
+                    continue;
+                case SQL_C_LONG:
+                case SQL_C_SLONG:
+                    integer(static_cast<std::int32_t>(0));
+                    continue;
+                case SQL_C_ULONG:
+                    integer(static_cast<std::uint32_t>(0));
+                    continue;
+                case SQL_C_SBIGINT:
+                    integer(static_cast<std::int64_t>(0));
+                    continue;
+                case SQL_C_UBIGINT:
+                    integer(static_cast<std::uint64_t>(0));
+                    continue;
+                case SQL_C_DOUBLE:
+                {
+                    double value;
+                    std::memcpy(&value, data, sizeof(value));
+                    // A REAL column is bound as a double, but holds no more than a float.
+                    if (type.sql_type == SQL_REAL)
+                        out.formatted([value](char* at) {
+                            return format_real(at, static_cast<float>(value));
+                        });
+                    else
+                        out.formatted([value](char* at) { return format_real(at, value); });
+                    continue;
+                }
+                case SQL_C_FLOAT:
+                {
+                    float value;
+                    std::memcpy(&value, data, sizeof(value));
+                    out.formatted([value](char* at) { return format_real(at, value); });
+                    continue;
+                }
+                case SQL_C_DATE:
+                {
+                    date value;
+                    std::memcpy(&value, data, sizeof(value));
+                    out.formatted([&value](char* at) {
+                        return format_date(at, value.year, value.month, value.day);
+                    });
+                    continue;
+                }
+                case SQL_C_TIME:
+                {
+                    time value;
+                    std::memcpy(&value, data, sizeof(value));
+                    out.formatted([&value](char* at) {
+                        return format_time(at, value.hour, value.min, value.sec);
+                    });
+                    continue;
+                }
+                case SQL_C_TIMESTAMP:
+                {
+                    timestamp value;
+                    std::memcpy(&value, data, sizeof(value));
+                    out.formatted(
+                        [&](char* at) { return format_timestamp(at, value, type.scale); });
+                    continue;
+                }
+                case SQL_C_CHAR:
+                    out.text(data, length);
+                    continue;
+                case SQL_C_WCHAR:
+                    text.clear();
+                    append_utf8(
+                        reinterpret_cast<SQLWCHAR const*>(data), length / sizeof(SQLWCHAR), text);
+                    out.text(text);
+                    continue;
+                case SQL_C_BINARY:
+                    if (type.sql_type == SQL_SS_TIMESTAMPOFFSET &&
+                        length >= sizeof(timestampoffset))
+                    {
+                        timestampoffset value;
+                        std::memcpy(&value, data, sizeof(value));
+                        out.formatted([&](char* at) {
+                            return format_timestampoffset(at, value, type.scale);
+                        });
+                        continue;
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            // Unbound, truncated or of a type without a formatter of its own: read as get() does.
+            if (type.c_type == SQL_C_BINARY && type.sql_type != SQL_SS_TIMESTAMPOFFSET)
+            {
+                if (impl.get_unless_null(i, bytes))
+                    out.hex(bytes.data(), bytes.size());
+                else
+                    out.null();
+            }
+            else
+            {
+                if (impl.get_unless_null(i, text))
+                    out.text(text);
+                else
+                    out.null();
+            }
+        }
+        out.end_row();
+        ++count;
+    }
+    out.flush();
+    return count;
+}
+
+std::size_t
+export_delimited(result& rows, std::string const& path, delimited_options const& options)
+{
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file(
+        std::fopen(path.c_str(), "wb"), &std::fclose);
+    if (!file)
+        throw programming_error("cannot create export file: " + path);
+    // The export hands over large buffers of its own, which need no copying into another.
+    std::setvbuf(file.get(), nullptr, _IONBF, 0);
+
+    auto const count = export_delimited(
+        rows,
+        [&](char const* data, std::size_t size) {
+            if (std::fwrite(data, 1, size, file.get()) != size)
+                throw programming_error("cannot write export file: " + path);
+        },
+        options);
+    if (std::fclose(file.release()) != 0)
+        throw programming_error("cannot write export file: " + path);
+    return count;
+}
+
+} // namespace nanodbc
+
+// clang-format off
+// 888b     d888                            d8b
+// 8888b   d8888                            Y8P
+// 88888b.d88888
+// 888Y88888P888  8888b.  88888b.  88888b.  888 88888b.   .d88b.
+// 888 Y888P 888     "88b 888 "88b 888 "88b 888 888 "88b d88P"88b
+// 888  Y8P  888 .d888888 888  888 888  888 888 888  888 888  888
+// 888   "   888 888  888 888 d88P 888 d88P 888 888  888 Y88b 888
+// 888       888 "Y888888 88888P"  88888P"  888 888  888  "Y88888
+//                        888      888                        888
+//                        888      888                   Y8b d88P
+//                        888      888                    "Y88P"
+// MARK: Mapping -
+// clang-format on
+
+namespace nanodbc
+{
+
+mapped_reader_base::mapped_reader_base(result& rows)
+    : rows_(rows)
+{
+}
+
+void mapped_reader_base::add_column(string const& name, mapped_kind kind, std::size_t size)
+{
+    short const column = rows_.column(name);
+    auto const ctype = static_cast<SQLSMALLINT>(rows_.column_c_datatype(column));
+
+    bool const text = ctype == SQL_C_CHAR || ctype == SQL_C_WCHAR;
+    bool const offset =
+        ctype == SQL_C_BINARY && rows_.column_datatype(column) == SQL_SS_TIMESTAMPOFFSET;
+    bool number = false;
+    switch (ctype)
+    {
+    case SQL_C_BIT:
+    case SQL_C_TINYINT:
+    case SQL_C_STINYINT:
+    case SQL_C_UTINYINT:
+    case SQL_C_SHORT:
+    case SQL_C_SSHORT:
+    case SQL_C_USHORT:
+    case SQL_C_LONG:
+    case SQL_C_SLONG:
+    case SQL_C_ULONG:
+    case SQL_C_SBIGINT:
+    case SQL_C_UBIGINT:
+    case SQL_C_FLOAT:
+    case SQL_C_DOUBLE:
+        number = true;
+        break;
+    default:
+        break;
+    }
+
+    // The conversions are those of result::get_ref(), which reads the values all the same: a
+    // column that passes here may still hold text that does not parse.
+    bool readable = false;
+    SQLSMALLINT fixed = 0;
+    switch (kind)
+    {
+    case mapped_kind::boolean:
+    case mapped_kind::character:
+        readable = number || text;
+        break;
+    case mapped_kind::signed_integer:
+        readable = number || text;
+        if ((size == 1 && (ctype == SQL_C_TINYINT || ctype == SQL_C_STINYINT)) ||
+            (size == 2 && (ctype == SQL_C_SHORT || ctype == SQL_C_SSHORT)) ||
+            (size == 4 && (ctype == SQL_C_LONG || ctype == SQL_C_SLONG)) ||
+            (size == 8 && ctype == SQL_C_SBIGINT))
+            fixed = ctype;
+        break;
+    case mapped_kind::unsigned_integer:
+        readable = number || text;
+        if ((size == 1 && ctype == SQL_C_UTINYINT) || (size == 2 && ctype == SQL_C_USHORT) ||
+            (size == 4 && ctype == SQL_C_ULONG) || (size == 8 && ctype == SQL_C_UBIGINT))
+            fixed = ctype;
+        break;
+    case mapped_kind::floating:
+        readable = number || text;
+        if ((size == sizeof(float) && ctype == SQL_C_FLOAT) ||
+            (size == sizeof(double) && ctype == SQL_C_DOUBLE))
+            fixed = ctype;
+        break;
+    case mapped_kind::text:
+        readable = number || text || ctype == SQL_C_BINARY || ctype == SQL_C_DATE ||
+                   ctype == SQL_C_TIME || ctype == SQL_C_TIMESTAMP;
+        break;
+    case mapped_kind::binary:
+        readable = ctype == SQL_C_BINARY;
+        break;
+    case mapped_kind::date:
+        readable = ctype == SQL_C_DATE || ctype == SQL_C_TIMESTAMP || text || offset;
+        fixed = ctype == SQL_C_DATE ? ctype : 0;
+        break;
+    case mapped_kind::time:
+        readable = ctype == SQL_C_TIME || ctype == SQL_C_TIMESTAMP || text || offset;
+        fixed = ctype == SQL_C_TIME ? ctype : 0;
+        break;
+    case mapped_kind::timestamp:
+        readable = ctype == SQL_C_DATE || ctype == SQL_C_TIMESTAMP || text || offset;
+        fixed = ctype == SQL_C_TIMESTAMP ? ctype : 0;
+        break;
+    case mapped_kind::unsupported:
+        break;
+    }
+    if (!readable)
+        throw type_incompatible_error();
+    columns_.push_back(mapped_column{column, fixed});
+}
+
+char const* mapped_reader_base::bound_value(short column, short c_type) const
+{
+    return rows_.impl_->fixed_cell(column, c_type);
+}
+
+} // namespace nanodbc
+
+// clang-format off
+// 8888888                   888                                                     888             888    d8b
+//   888                     888                                                     888             888    Y8P
+//   888                     888                                                     888             888
+//   888   88888b.  .d8888b  888888 888d888 888  888 88888b.d88b.   .d88b.  88888b.  888888  8888b.  888888 888  .d88b.  88888b.
+//   888   888 "88b 88K      888    888P"   888  888 888 "888 "88b d8P  Y8b 888 "88b 888        "88b 888    888 d88""88b 888 "88b
+//   888   888  888 "Y8888b. 888    888     888  888 888  888  888 88888888 888  888 888    .d888888 888    888 888  888 888  888
+//   888   888  888      X88 Y88b.  888     Y88b 888 888  888  888 Y8b.     888  888 Y88b.  888  888 Y88b.  888 Y88..88P 888  888
+// 8888888 888  888  88888P'  "Y888 888      "Y88888 888  888  888  "Y8888  888  888  "Y888 "Y888888  "Y888 888  "Y88P"  888  888
+// MARK: Instrumentation -
+// clang-format on
+
+namespace nanodbc
+{
+
+#if __cplusplus < 201703L
+// Until C++17 a static constexpr member that is bound to a reference needs a definition.
+constexpr std::size_t call_stats::buckets;
+#endif
+
+void enable_call_tracing(bool enabled) noexcept
+{
+    call_tracing_on.store(enabled, std::memory_order_relaxed);
+}
+
+bool call_tracing_enabled() noexcept
+{
+    return call_tracing_on.load(std::memory_order_relaxed);
+}
+
+std::vector<call_stats> call_statistics()
+{
+    auto& registry = tracing_registry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+
+    std::vector<call_stats> stats;
+    for (std::size_t i = 0; i < registry.functions.size(); ++i)
+    {
+        traced_counters total{};
+        add_traced_counters(total, registry.exited.functions[i]);
+        for (auto const* counters : registry.threads)
+            add_traced_counters(total, counters->functions[i]);
+
+        auto const calls = total.calls.load(std::memory_order_relaxed);
+        if (calls == 0)
+            continue;
+        call_stats function_stats;
+        function_stats.function = registry.functions[i];
+        function_stats.calls = calls;
+        function_stats.errors = total.errors.load(std::memory_order_relaxed);
+        function_stats.total_nanoseconds = total.nanoseconds.load(std::memory_order_relaxed);
+        for (auto const& bucket : total.histogram)
+            function_stats.histogram.push_back(bucket.load(std::memory_order_relaxed));
+        stats.push_back(std::move(function_stats));
+    }
+    return stats;
+}
+
+void reset_call_statistics()
+{
+    auto const reset = [](traced_thread_counters& counters) {
+        for (auto& function : counters.functions)
+        {
+            function.calls.store(0, std::memory_order_relaxed);
+            function.errors.store(0, std::memory_order_relaxed);
+            function.nanoseconds.store(0, std::memory_order_relaxed);
+            for (auto& bucket : function.histogram)
+                bucket.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    auto& registry = tracing_registry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    reset(registry.exited);
+    for (auto* counters : registry.threads)
+        reset(*counters);
+}
+
+void set_call_span_handler(std::function<void(call_span const&)> handler)
+{
+    std::shared_ptr<std::function<void(call_span const&)>> shared;
+    if (handler)
+        shared = std::make_shared<std::function<void(call_span const&)>>(std::move(handler));
+
+    auto& registry = tracing_registry();
+    std::lock_guard<std::mutex> guard(registry.span_mutex);
+    registry.span_handler = std::move(shared);
+    registry.has_span_handler.store(
+        static_cast<bool>(registry.span_handler), std::memory_order_release);
+}
+
+} // namespace nanodbc
+
 #endif // NANODBC_DISABLE_NANODBC_NAMESPACE_FOR_INTERNAL_TESTS
 
 #undef NANODBC_THROW_DATABASE_ERROR
 #undef NANODBC_STRINGIZE
 #undef NANODBC_STRINGIZE_I
+#undef NANODBC_TRACED_CALL_RC
+#undef NANODBC_DRIVER_FUNCTION
 #undef NANODBC_CALL_RC
 #undef NANODBC_CALL
 
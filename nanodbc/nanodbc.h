@@ -77,15 +77,22 @@
 #ifndef NANODBC_NANODBC_H
 #define NANODBC_NANODBC_H
 
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <deque>
 #include <exception>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -251,6 +258,8 @@ class connection;
 class transaction;
 class catalog;
 class result;
+template <class Row, class... Members>
+struct row_mapping;
 
 // clang-format off
 // 8888888888                                      888    888                        888 888 d8b
@@ -520,6 +529,23 @@ using enable_if_string = typename std::enable_if<is_string<T>::value>::type;
 template <typename T>
 using enable_if_character = typename std::enable_if<is_character<T>::value>::type;
 
+/// \brief What a member of a mapped struct is, as far as reading or binding it goes.
+/// \see mapped_member
+enum class mapped_kind : unsigned char
+{
+    unsupported,      ///< A member nanodbc cannot read or bind.
+    boolean,          ///< bool.
+    character,        ///< A single character.
+    signed_integer,   ///< A signed integer.
+    unsigned_integer, ///< An unsigned integer.
+    floating,         ///< float or double.
+    text,             ///< nanodbc::string.
+    binary,           ///< std::vector<std::uint8_t>.
+    date,             ///< nanodbc::date.
+    time,             ///< nanodbc::time.
+    timestamp         ///< nanodbc::timestamp.
+};
+
 /// \}
 
 /// \addtogroup mainc Main classes
@@ -911,6 +937,33 @@ public:
                      ///< `{ ? = CALL proc(?) }` escape sequence.
     };
 
+    /// \brief Outcome of one row of a parameter array execution.
+    enum param_status
+    {
+        PARAM_SUCCESS,           ///< The row was executed successfully.
+        PARAM_SUCCESS_WITH_INFO, ///< The row was executed, with a warning.
+        PARAM_ERROR,             ///< The row failed.
+        PARAM_UNUSED,            ///< The row was not executed.
+        PARAM_DIAG_UNAVAILABLE   ///< The driver cannot tell how the row fared.
+    };
+
+    /// \brief A diagnostic record the driver attached to one row of a parameter array.
+    struct param_diagnostic
+    {
+        long row;            ///< Zero-based row of the parameter array, -1 if not known.
+        std::string state;   ///< Five character SQLSTATE.
+        long native;         ///< Native error code reported by the driver.
+        std::string message; ///< Diagnostic message.
+    };
+
+    /// \brief SQL type, size and scale of a parameter marker, as `SQLDescribeParam` reports them.
+    struct param_description
+    {
+        short type = 0;         ///< SQL data type, such as `SQL_INTEGER`.
+        unsigned long size = 0; ///< Column size, or maximum length in characters or bytes.
+        short scale = 0;        ///< Decimal digits.
+    };
+
 public:
     /// \brief Creates a new un-prepared statement.
     /// \see execute(), just_execute(), execute_direct(), just_execute_direct(), open(), prepare()
@@ -959,6 +1012,10 @@ public:
     /// \brief Returns true if connection is open.
     bool open() const noexcept;
 
+    /// \brief Returns true if a query is prepared, and neither closed nor replaced by a query
+    /// executed directly since.
+    bool prepared() const noexcept;
+
     /// \brief Returns true if connected to the database.
     bool connected() const noexcept;
 
@@ -1203,6 +1260,24 @@ public:
     /// \brief Returns parameter type for indicated parameter placeholder in a prepared statement.
     short parameter_type(short param_index) const;
 
+    /// \brief Returns the status of every row of the parameter array of the last execution.
+    ///
+    /// The status comes from `SQL_ATTR_PARAM_STATUS_PTR`, which is bound for every execution,
+    /// and is available after a failed execution as well, so that only the rows which failed
+    /// need to be executed again.
+    /// \see parameters_processed(), parameter_diagnostics()
+    std::vector<param_status> parameter_status() const;
+
+    /// \brief Returns the number of parameter rows the last execution processed, including
+    /// rows that failed, as reported through `SQL_ATTR_PARAMS_PROCESSED_PTR`.
+    unsigned long parameters_processed() const noexcept;
+
+    /// \brief Returns the diagnostic records of the last execution of a parameter array.
+    ///
+    /// Records are collected when an execution of more than one row fails or reports a
+    /// warning, together with the row each record concerns.
+    std::vector<param_diagnostic> parameter_diagnostics() const;
+
     /// \addtogroup binding Binding parameters
     /// \brief These functions are used to bind values to ODBC parameters.
     ///
@@ -1462,6 +1537,71 @@ public:
     /// \throws database_error
     void bind_null(short param_index, std::size_t batch_size = 1);
 
+    /// \brief Binds a parameter to a variable once, for repeated execution.
+    ///
+    /// The variable stays bound until the parameter is bound again or the parameters are reset,
+    /// and each execute() of a single parameter set sends the value the variable holds at that
+    /// time. A loop that only assigns the variable between executions makes no bind calls.
+    ///
+    /// A std::string or wide_string is bound by its own characters: each execution, whether by
+    /// execute(), just_execute() or their _direct forms, updates the length it sends, and binds
+    /// the string again only after it has reallocated. Strings can be bound this way as input
+    /// parameters only.
+    ///
+    /// The types supported are those of bind(), but for the character types, and std::string and
+    /// wide_string. The variable must outlive its binding.
+    ///
+    /// \param param_index Zero-based index of parameter marker (placeholder position).
+    /// \param value Variable holding the parameter's value at each execution.
+    /// \param direction ODBC parameter direction.
+    /// \throws database_error
+    /// \throws programming_error
+    template <class T>
+    void bind_ref(short param_index, T& value, param_direction direction = PARAM_IN);
+
+    /// \brief Binds the members of an array of structs to the parameters, one struct per
+    /// parameter set, for a batch execute().
+    ///
+    /// The mapped members are bound to parameters 0, 1, 2 and so on, in the mapping's order; the
+    /// names of their columns are not used. Parameters are bound row-wise, with
+    /// SQL_ATTR_PARAM_BIND_TYPE set to the size of a row. If every member is an integer, floating
+    /// point, bool, date, time or timestamp, the rows themselves are bound and nothing is copied.
+    /// Otherwise, such as for text or a std::optional member, the values are copied into a buffer
+    /// the statement keeps, a row at a time, beside their length and null indicators.
+    ///
+    /// \code{.cpp}
+    /// nanodbc::statement insert(connection, NANODBC_TEXT("insert into orders values (?, ?, ?)"));
+    /// insert.bind_rows(orders);
+    /// insert.execute(static_cast<long>(orders.size()));
+    /// \endcode
+    ///
+    /// Rows that are bound where they are are read at each execution, so they must outlive the
+    /// binding, and a member assigned between executions sends its new value; copied rows are
+    /// read once, here. Binding a parameter any other way afterwards unbinds them.
+    ///
+    /// \param rows The first of the structs.
+    /// \param count The number of structs, and the batch size to execute with.
+    /// \param mapping The members to bind.
+    /// \throws database_error
+    /// \throws programming_error If count is zero, or there is no C type of a member's size.
+    template <class Row, class... Members>
+    void bind_rows(Row const* rows, std::size_t count, row_mapping<Row, Members...> const& mapping);
+
+    /// \brief Binds the members of a vector of structs to the parameters, one struct per
+    /// parameter set.
+    /// \see bind_rows(Row const*, std::size_t, row_mapping<Row, Members...> const&)
+    template <class Row, class... Members>
+    void bind_rows(std::vector<Row> const& rows, row_mapping<Row, Members...> const& mapping)
+    {
+        bind_rows(rows.data(), rows.size(), mapping);
+    }
+
+    /// \brief Binds the members of a vector of structs to the parameters, as the row_mapping
+    /// NANODBC_MAP declared for Row maps them.
+    /// \see bind_rows(Row const*, std::size_t, row_mapping<Row, Members...> const&)
+    template <class Row>
+    void bind_rows(std::vector<Row> const& rows);
+
     /// @}
 
     /// \brief Sets descriptions for parameters in the prepared statement.
@@ -1487,8 +1627,52 @@ public:
         const std::vector<unsigned long>& size,
         const std::vector<short>& scale);
 
+    /// \brief Sets descriptions for the leading parameters of the prepared statement, in order.
+    ///
+    /// Describes parameter i as descriptions[i], so that binding it makes no `SQLDescribeParam`
+    /// call. Parameters past the end of descriptions are left as they were.
+    ///
+    /// \param descriptions Descriptions of parameters 0 to descriptions.size() - 1.
+    /// \see parameter_descriptions()
+    void describe_parameters(std::vector<param_description> const& descriptions);
+
+    /// \brief Returns the descriptions of all parameters of the prepared statement.
+    ///
+    /// Parameters not described yet are described by the driver, so the result can be kept and
+    /// passed to describe_parameters() for the same query later.
+    ///
+    /// \throws database_error
+    std::vector<param_description> parameter_descriptions();
+
 private:
+    // A member bound by bind_rows(), as far as binding it does not depend on its type.
+    struct row_parameter
+    {
+        mapped_kind kind;
+        std::size_t unit_size; // Of the value, of a character of text, or 1 for binary.
+        std::size_t offset;    // Of the member, from the start of its row.
+        bool in_place;         // Whether the member can be bound where it is.
+        std::size_t (*size)(void const* member);
+        bool (*copy)(void const* member, void* out, std::size_t& length);
+    };
+
+    template <class Member>
+    static row_parameter row_parameter_of(std::size_t offset);
+
+    template <class Row, class... Members, std::size_t... I>
+    static std::vector<row_parameter> row_parameters(
+        Row const& row,
+        row_mapping<Row, Members...> const& mapping,
+        std::index_sequence<I...>);
+
+    void bind_rows(
+        void const* rows,
+        std::size_t count,
+        std::size_t row_size,
+        std::vector<row_parameter> const& parameters);
+
     typedef std::function<bool(std::size_t)> null_predicate_type;
+    friend class nanodbc::connection;
     friend class nanodbc::result;
 #ifndef NANODBC_DISABLE_MSSQL_TVP
     friend class nanodbc::table_valued_parameter::table_valued_parameter_impl;
@@ -1510,6 +1694,61 @@ private:
 // MARK: Connection -
 // clang-format on
 
+/// \brief What a driver supports, as far as nanodbc's choice of how to use it goes.
+///
+/// A connection probes its driver once, the first time connection::profile() is asked for it,
+/// and the operations that can go more than one way consult the profile rather than the
+/// driver:
+///
+/// - bulk_copy loads rows with multi-row INSERT statements, as copy_in does, when the driver
+///   executes parameter arrays one row at a time, and with parameter arrays otherwise.
+/// - copy_out() fetches rowsets of rows_per_fetch rows unless told otherwise.
+/// - A result re-reads a truncated bound column with SQLGetData only when the driver allows
+///   `SQL_GD_BOUND`.
+///
+/// The raw values are those of `SQLGetInfo`, or zero where the driver does not report them.
+struct driver_profile
+{
+    string driver_name;    ///< SQL_DRIVER_NAME.
+    string driver_version; ///< SQL_DRIVER_VER.
+    string dbms_name;      ///< SQL_DBMS_NAME.
+    string dbms_version;   ///< SQL_DBMS_VER.
+
+    std::uint32_t param_array_row_counts = 0; ///< SQL_PARAM_ARRAY_ROW_COUNTS.
+    std::uint32_t batch_support = 0;          ///< SQL_BATCH_SUPPORT.
+    std::uint32_t scroll_options = 0;         ///< SQL_SCROLL_OPTIONS.
+    std::uint32_t getdata_extensions = 0;     ///< SQL_GETDATA_EXTENSIONS.
+
+    /// \brief Whether the driver reported getdata_extensions, rather than its being unknown.
+    bool getdata_extensions_reported = false;
+
+    /// \brief Whether an array of parameters goes to the server in one execution.
+    ///
+    /// False for drivers that do not report SQL_PARAM_ARRAY_ROW_COUNTS, and for those known to
+    /// execute the statement once per row of the array: the SQLite, MySQL and MariaDB drivers.
+    bool native_parameter_arrays = false;
+
+    /// \brief Rows per fetch for reads that choose their own rowset size.
+    ///
+    /// 1000, whatever the driver's getdata_extensions; see result for the one case in which a
+    /// result is fetched a row at a time.
+    long rows_per_fetch = 1000;
+
+    /// \brief Parameter markers one statement may have, as copy_in and multirow_insert size
+    /// their statements.
+    ///
+    /// ODBC does not report it, so the probe sets it by dbms_name; see copy_options.
+    std::size_t max_parameters = 999;
+
+    /// \brief Rows the VALUES list of one INSERT may hold.
+    ///
+    /// ODBC does not report it, so the probe sets it by dbms_name; see copy_options.
+    std::size_t max_insert_rows = 1000;
+};
+
+/// \brief Describes a driver profile, one `name: value` line per field, for logs.
+std::string to_string(driver_profile const& profile);
+
 /// \brief Manages and encapsulates ODBC resources such as the connection and environment handles.
 class connection
 {
@@ -1745,6 +1984,10 @@ public:
     /// \brief Returns information from the ODBC connection as a string or fixed-size value.
     /// The general information about the driver and data source associated
     /// with a connection is obtained using `SQLGetInfo` function.
+    ///
+    /// Each value is asked for once and remembered until the connection is closed or
+    /// invalidate_metadata() is called, except `SQL_DATABASE_NAME`, which follows the current
+    /// database.
     template <class T>
     T get_info(short info_type) const;
 
@@ -1774,7 +2017,95 @@ public:
     /// Returns the current setting of the connection attribute SQL_ATTR_CURRENT_CATALOG.
     string catalog_name() const;
 
+    /// \brief Remembers the parameter descriptions of queries prepared on this connection.
+    ///
+    /// While enabled, the descriptions the driver reports for the parameters of a prepared query
+    /// are kept by the query's text. A statement that prepares the same text later, on this
+    /// connection or a copy of it, binds with them instead of asking the driver again, which
+    /// for some drivers is a round trip to the server. Descriptions set with
+    /// statement::describe_parameters() are not cached.
+    ///
+    /// Disabled by default. Disabling it empties the cache; so should changing a table that a
+    /// cached query refers to, with clear_parameter_descriptions().
+    ///
+    /// \param enable Whether to cache parameter descriptions.
+    void cache_parameter_descriptions(bool enable = true);
+
+    /// \brief Returns true if parameter descriptions are cached.
+    /// \see cache_parameter_descriptions()
+    bool caches_parameter_descriptions() const noexcept;
+
+    /// \brief Forgets all cached parameter descriptions.
+    /// \see cache_parameter_descriptions()
+    void clear_parameter_descriptions();
+
+    /// \brief Returns what the driver supports, probing it on the first call.
+    ///
+    /// The probe asks `SQLGetInfo` for the values in driver_profile once per connection; the
+    /// profile is kept until the connection is closed, or for good once set_profile() replaced
+    /// it.
+    ///
+    /// \throws database_error
+    /// \see driver_profile
+    driver_profile profile() const;
+
+    /// \brief Replaces the probed driver profile, for drivers that report it wrongly.
+    /// \see profile()
+    void set_profile(driver_profile const& profile);
+
+    /// \brief Forgets the driver profile, probed or set, so the next profile() probes again.
+    /// \see profile()
+    void reset_profile();
+
+    /// \brief Keeps the results of catalog lookups on this connection for the given time.
+    ///
+    /// While enabled, the rows read by catalog::find_tables(), catalog::find_columns() and
+    /// catalog::find_primary_keys() are kept by the arguments of the lookup, and the same lookup
+    /// made within ttl, through this connection or a copy of it, is answered from them without
+    /// calling the driver.
+    ///
+    /// Disabled by default. A ttl of zero disables it and empties the cache; so should changing
+    /// a table that a lookup may have read, with invalidate_metadata().
+    ///
+    /// \param ttl How long a lookup's rows are kept.
+    void cache_metadata(std::chrono::seconds ttl);
+
+    /// \brief Returns how long catalog lookups are kept, zero if they are not.
+    /// \see cache_metadata()
+    std::chrono::seconds metadata_ttl() const;
+
+    /// \brief Forgets every cached catalog lookup and `get_info()` value.
+    /// \see cache_metadata()
+    void invalidate_metadata();
+
+    /// \brief Forgets the cached catalog lookups that may have read the given table.
+    ///
+    /// Lookups of that table are forgotten, as are those by a pattern that may match it.
+    /// An empty schema or catalog matches any.
+    ///
+    /// \see cache_metadata()
+    void invalidate_metadata(
+        string const& table,
+        string const& schema = string(),
+        string const& catalog = string());
+
 private:
+    friend class nanodbc::statement::statement_impl;
+    friend class nanodbc::catalog;
+    // The rows of a catalog lookup kept by the metadata cache, which only the catalog reads.
+    std::shared_ptr<void const> cached_metadata(
+        short lookup,
+        string const& catalog,
+        string const& schema,
+        string const& table,
+        string const& column) const;
+    void cache_metadata(
+        short lookup,
+        string const& catalog,
+        string const& schema,
+        string const& table,
+        string const& column,
+        std::shared_ptr<void const> rows);
     std::size_t ref_transaction() noexcept;
     std::size_t unref_transaction() noexcept;
     bool rollback() const noexcept;
@@ -1797,10 +2128,23 @@ private:
 // clang-format on
 
 class catalog;
+struct delimited_options;
+class mapped_reader_base;
+class materialized_result;
+class prefetching_result;
+#ifdef NANODBC_HAS_STD_VARIANT
+class cached_row_result;
+#endif
 class variant_row_cached_result;
 
 /// \brief A resource for managing result sets from statement execution.
 ///
+/// A result is fetched in rowsets of the size its statement was executed with, with one
+/// exception: a result with long columns, which nanodbc reads with SQLGetData by positioning on
+/// each row, is fetched a row at a time where connection::profile() says the driver lacks
+/// `SQL_GD_BLOCK`. rowset_size() reports the size in effect. Where the profile does not know,
+/// the requested size is kept.
+///
 /// \see statement::execute(), statement::execute_direct()
 /// \note result objects may be copied, however all copies will refer to the same result set.
 class result
@@ -1827,7 +2171,8 @@ public:
     /// \brief Returns the native ODBC statement handle.
     void* native_statement_handle() const noexcept;
 
-    /// \brief The rowset size for this result set.
+    /// \brief The rowset size for this result set, which is one where a result with long
+    /// columns was executed with more on a driver without `SQL_GD_BLOCK`.
     long rowset_size() const noexcept;
 
     /// \brief Number of affected rows by the request or -1 if the affected rows is not available.
@@ -2180,6 +2525,16 @@ public:
     /// signed.
     bool column_unsigned(string const& column_name) const;
 
+    /// \brief Reads the rows not yet read into memory, and returns them for random access.
+    ///
+    /// Every remaining row of the current result set is fetched, in blocks of rowset_size()
+    /// rows, so execute the query with a rowset size of more than one, such as
+    /// connection::profile().rows_per_fetch. The rows are then held column by column and no
+    /// longer refer to the statement, which can be closed or executed again.
+    /// \see materialized_result
+    /// \throws database_error
+    materialized_result materialize();
+
     /// \brief Returns the next result, e.g. when stored procedure returns multiple result sets.
     bool next_result();
 
@@ -2193,9 +2548,18 @@ private:
     class result_impl;
     friend class nanodbc::statement::statement_impl;
     friend class nanodbc::catalog;
+    friend class nanodbc::prefetching_result;
+#ifdef NANODBC_HAS_STD_VARIANT
+    friend class nanodbc::cached_row_result;
+#endif
 #ifdef _MSC_VER
     friend class nanodbc::variant_row_cached_result;
 #endif
+    friend std::size_t export_delimited(
+        result& rows,
+        std::function<void(char const*, std::size_t)> const& sink,
+        delimited_options const& options);
+    friend class nanodbc::mapped_reader_base;
 
 private:
     std::shared_ptr<result_impl> impl_;
@@ -2287,6 +2651,203 @@ inline result_iterator end(result& /*r*/) noexcept
     return {};
 }
 
+/// \brief A result set reader that fetches the next rowset while the current one is read.
+///
+/// Once the rows of the current rowset have been handed out by next(), the following rowset is
+/// already being fetched by a background thread into a second set of bound buffers, so the
+/// time spent in the driver overlaps with the time spent processing rows. The fetch thread
+/// waits for next() to reach the end of the current rowset before it starts the fetch after
+/// that, so at most two rowsets are held in memory.
+///
+/// Only forward iteration and reading values are offered: scrolling, unbinding and moving to
+/// the next result set would race with the background fetch.
+///
+/// \note Prefetching requires every column to be bound. A result with unbound columns, such as
+///       long text or binary columns, is read one rowset at a time as by result itself, and
+///       prefetching() returns false.
+/// \note While a rowset is prefetched the cursor is already past the current one, so a bound
+///       value the driver truncated is not read again in full.
+class prefetching_result
+{
+public:
+    /// \brief Empty result set.
+    prefetching_result() = default;
+
+    /// \brief Takes over the given result and starts fetching its first rowset.
+    ///
+    /// The result must not be used directly afterwards, neither through the argument nor
+    /// through copies of it.
+    /// \throws database_error
+    explicit prefetching_result(result&& rows);
+
+    /// \brief Returns true if rowsets are fetched in the background.
+    bool prefetching() const noexcept;
+
+    /// \brief Returns the native ODBC statement handle.
+    void* native_statement_handle() const noexcept;
+
+    /// \brief The rowset size for this result set.
+    long rowset_size() const noexcept;
+
+    /// \brief Returns the number of rows in the current rowset.
+    long rows() const noexcept;
+
+    /// \brief Returns the number of columns in a result set.
+    /// \throws database_error
+    short columns() const;
+
+    /// \brief Moves to the next row, waiting for the next rowset if the current one is done.
+    /// \return true if a row is available, false once the result set is exhausted.
+    /// \throws database_error
+    bool next();
+
+    /// \brief Returns true if and only if the given column of the current row is null.
+    /// \throws database_error, index_range_error
+    bool is_null(short column) const;
+
+    /// \brief Returns true if and only if the named column of the current row is null.
+    /// \throws database_error, index_range_error
+    bool is_null(string const& column_name) const;
+
+    /// \brief Returns the column number of the specified column name.
+    /// \throws index_range_error
+    short column(string const& column_name) const;
+
+    /// \brief Returns the name of the specified column.
+    /// \throws index_range_error
+    string column_name(short column) const;
+
+    /// \brief Gets data from the given column of the current row.
+    /// \see result::get(short) const
+    template <class T>
+    T get(short column) const
+    {
+        return result_.get<T>(column);
+    }
+
+    /// \brief Gets data from the given column of the current row, or the fallback if it is null.
+    /// \see result::get(short, T const&) const
+    template <class T>
+    T get(short column, T const& fallback) const
+    {
+        return result_.get<T>(column, fallback);
+    }
+
+    /// \brief Gets data from the named column of the current row.
+    /// \see result::get(string const&) const
+    template <class T>
+    T get(string const& column_name) const
+    {
+        return result_.get<T>(column_name);
+    }
+
+    /// \brief Gets data from the named column of the current row, or the fallback if it is null.
+    /// \see result::get(string const&, T const&) const
+    template <class T>
+    T get(string const& column_name, T const& fallback) const
+    {
+        return result_.get<T>(column_name, fallback);
+    }
+
+    /// \brief If and only if the result object is valid, returns true.
+    explicit operator bool() const noexcept;
+
+private:
+    result result_;
+    bool prefetching_{false};
+};
+
+#ifdef NANODBC_HAS_STD_VARIANT
+/// \brief A column value of a row read by cached_row_result.
+///
+/// std::monostate stands for null. Integer and bit columns are held as long long, floating
+/// point columns as double, binary columns as bytes and date, time and timestamp columns as
+/// the nanodbc structures; every other column, including decimal and numeric, is held as text.
+typedef std::variant<
+    std::monostate,
+    long long,
+    double,
+    string,
+    date,
+    time,
+    timestamp,
+    std::vector<std::uint8_t>>
+    value;
+
+/// \brief A result set reader that reads each row whole, so its columns can be read in any order.
+///
+/// next() reads every column of the row in a single pass from left to right, which is the only
+/// order in which a driver without SQL_GD_ANY_ORDER hands out unbound columns, and get() then
+/// serves the values from the cache. The cache is kept from one row to the next, and a bound
+/// text column is copied into the string its cell already holds, without allocating one per row.
+///
+/// This is the portable counterpart of variant_row_cached_result, available where the standard
+/// library provides std::variant.
+class cached_row_result
+{
+public:
+    /// \brief Empty result set.
+    cached_row_result() = default;
+
+    /// \brief Takes over the given result.
+    ///
+    /// The result must not be used directly afterwards, neither through the argument nor
+    /// through copies of it.
+    explicit cached_row_result(result&& rows);
+
+    /// \brief Returns the native ODBC statement handle.
+    void* native_statement_handle() const noexcept;
+
+    /// \brief Returns the number of columns in a result set.
+    /// \throws database_error
+    short columns() const;
+
+    /// \brief Fetches the next row and reads all of its columns.
+    /// \return true if a row is available, false once the result set is exhausted.
+    /// \throws database_error, type_incompatible_error
+    bool next();
+
+    /// \brief Returns the cached value of the given column of the current row.
+    ///
+    /// Columns are numbered from left to right and 0-indexed.
+    /// \throws index_range_error if there is no current row or no such column.
+    value const& get(short column) const;
+
+    /// \brief Returns the cached value of the named column of the current row.
+    /// \throws index_range_error if there is no current row or no such column.
+    value const& get(string const& column_name) const;
+
+    /// \brief Returns true if and only if the given column of the current row is null.
+    /// \throws index_range_error if there is no current row or no such column.
+    bool is_null(short column) const;
+
+    /// \brief Returns true if and only if the named column of the current row is null.
+    /// \throws index_range_error if there is no current row or no such column.
+    bool is_null(string const& column_name) const;
+
+    /// \brief Returns the cached values of the current row, one per column.
+    ///
+    /// Empty if there is no current row.
+    std::vector<value> const& row() const noexcept;
+
+    /// \brief Returns the column number of the specified column name.
+    /// \throws index_range_error
+    short column(string const& column_name) const;
+
+    /// \brief Returns the name of the specified column.
+    /// \throws index_range_error
+    string column_name(short column) const;
+
+    /// \brief If and only if the result object is valid, returns true.
+    explicit operator bool() const noexcept;
+
+private:
+    result result_;
+    std::vector<value> row_;
+    bool has_row_{false};
+};
+#endif
+
 // clang-format off
 // 8888888b.                                     d8b          888
 // 888  "Y88b                                    Y8P          888
@@ -2463,13 +3024,95 @@ private:
 // MARK: Catalog -
 // clang-format on
 
+/// \brief Options of catalog::snapshot().
+struct catalog_snapshot_options
+{
+    string table;   ///< Search pattern for table names, empty for all.
+    string type;    ///< Table types, as for catalog::find_tables(), empty for all.
+    string schema;  ///< Search pattern for schema names, empty for all.
+    string catalog; ///< Search pattern for catalog names, empty for all.
+
+    /// \brief Whether to read primary keys, which takes a `SQLPrimaryKeys` call per table.
+    bool primary_keys = true;
+
+    /// \brief Whether to read indexes, which takes a `SQLStatistics` call per table.
+    bool indexes = true;
+};
+
+/// \brief Tables, columns, primary keys and indexes of a data source, read by catalog::snapshot().
+///
+/// Every name is kept once, in strings, and referred to by its position there, so the many
+/// columns that share a name or a type cost an index each. Columns, key columns and index
+/// columns are grouped by table, in the order of tables, and each table records where its
+/// groups start and how long they are.
+struct catalog_snapshot
+{
+    /// \brief A table or view.
+    struct table
+    {
+        std::uint32_t catalog;            ///< TABLE_CAT, empty if not applicable.
+        std::uint32_t schema;             ///< TABLE_SCHEM, empty if not applicable.
+        std::uint32_t name;               ///< TABLE_NAME.
+        std::uint32_t type;               ///< TABLE_TYPE.
+        std::uint32_t first_column;       ///< Position of the table's first column in columns.
+        std::uint32_t column_count;       ///< Number of columns.
+        std::uint32_t first_key_column;   ///< Position of its first key column in key_columns.
+        std::uint32_t key_column_count;   ///< Number of primary key columns.
+        std::uint32_t first_index_column; ///< Position of its first column in index_columns.
+        std::uint32_t index_column_count; ///< Number of index columns.
+    };
+
+    /// \brief A column of a table.
+    struct column
+    {
+        std::uint32_t table;         ///< Position of the table in tables.
+        std::uint32_t name;          ///< COLUMN_NAME.
+        std::uint32_t type_name;     ///< TYPE_NAME.
+        std::uint32_t default_value; ///< COLUMN_DEF, empty if none.
+        long column_size;            ///< COLUMN_SIZE.
+        long ordinal_position;       ///< ORDINAL_POSITION.
+        short data_type;             ///< DATA_TYPE.
+        short decimal_digits;        ///< DECIMAL_DIGITS.
+        short nullable;              ///< NULLABLE.
+    };
+
+    /// \brief A column of a table's primary key.
+    struct key_column
+    {
+        std::uint32_t table;    ///< Position of the table in tables.
+        std::uint32_t column;   ///< COLUMN_NAME.
+        std::uint32_t key_name; ///< PK_NAME, empty if not applicable.
+        short sequence;         ///< KEY_SEQ.
+    };
+
+    /// \brief A column of an index of a table.
+    struct index_column
+    {
+        std::uint32_t table;  ///< Position of the table in tables.
+        std::uint32_t name;   ///< INDEX_NAME.
+        std::uint32_t column; ///< COLUMN_NAME, empty for an index on an expression.
+        short position;       ///< ORDINAL_POSITION of the column in the index.
+        bool unique;          ///< Whether NON_UNIQUE is false.
+    };
+
+    std::vector<string> strings; ///< Every name, once; strings[0] is the empty string.
+    std::vector<table> tables;
+    std::vector<column> columns;
+    std::vector<key_column> key_columns;
+    std::vector<index_column> index_columns;
+};
+
 /// \brief A resource for get catalog information from connected data source.
 ///
 /// Queries are performed using the Catalog Functions in ODBC.
 /// All provided operations are convenient wrappers around the ODBC API
 /// The original ODBC behaviour should not be affected by any added processing.
+/// Results are fetched in rowsets of up to 256 rows, or of one row where they have long columns
+/// and the driver lacks `SQL_GD_BLOCK`.
 class catalog
 {
+    class cached_rows; // the rows of a lookup, as kept by connection::cache_metadata()
+
 public:
     /// \brief Result set for a list of tables in the data source.
     class tables
@@ -2485,7 +3128,14 @@ public:
     private:
         friend class nanodbc::catalog;
         explicit tables(result& find_result) noexcept;
+        explicit tables(std::shared_ptr<cached_rows const> rows) noexcept;
+        template <class T>
+        T get(short column) const;
+        template <class T>
+        T get(short column, T const& fallback) const;
         result result_;
+        std::shared_ptr<cached_rows const> cached_;
+        std::size_t cached_row_{0}; // one past the current row of cached_
     };
 
     /// \brief Result set for a list of columns in one or more tables.
@@ -2525,7 +3175,14 @@ public:
     private:
         friend class nanodbc::catalog;
         explicit columns(result& find_result) noexcept;
+        explicit columns(std::shared_ptr<cached_rows const> rows) noexcept;
+        template <class T>
+        T get(short column) const;
+        template <class T>
+        T get(short column, T const& fallback) const;
         result result_;
+        std::shared_ptr<cached_rows const> cached_;
+        std::size_t cached_row_{0}; // one past the current row of cached_
     };
 
     /// \brief Result set for a list of columns that compose the primary key of a single table.
@@ -2550,7 +3207,14 @@ public:
     private:
         friend class nanodbc::catalog;
         explicit primary_keys(result& find_result) noexcept;
+        explicit primary_keys(std::shared_ptr<cached_rows const> rows) noexcept;
+        template <class T>
+        T get(short column) const;
+        template <class T>
+        T get(short column, T const& fallback) const;
         result result_;
+        std::shared_ptr<cached_rows const> cached_;
+        std::size_t cached_row_{0}; // one past the current row of cached_
     };
 
     /// \brief Result set for a list of tables and the privileges associated with each table.
@@ -2676,6 +3340,8 @@ public:
     ///
     /// All arguments are treated as the Pattern Value Arguments.
     /// Empty string argument is equivalent to passing the search pattern '%'.
+    ///
+    /// \see connection::cache_metadata()
     catalog::columns find_columns(
         string const& column = string(),
         string const& table = string(),
@@ -2690,6 +3356,8 @@ public:
     ///
     /// All arguments are treated as the Pattern Value Arguments.
     /// Empty string argument is equivalent to passing the search pattern '%'.
+    ///
+    /// \see connection::cache_metadata()
     catalog::primary_keys find_primary_keys(
         string const& table,
         string const& schema = string(),
@@ -2742,6 +3410,17 @@ public:
     /// table type search pattern.
     std::list<string> list_table_types();
 
+    /// \brief Reads the tables of the data source, with their columns, primary keys and
+    /// indexes, into one catalog_snapshot.
+    ///
+    /// Tables and columns take one `SQLTables` and one `SQLColumns` call between them, however
+    /// many tables there are. Primary keys and indexes take a call per table, since ODBC does
+    /// not accept patterns for them. Every result is fetched in blocks of rows, as the
+    /// find_*() results are.
+    ///
+    /// \throws database_error
+    catalog_snapshot snapshot(catalog_snapshot_options const& options = {});
+
 private:
     connection conn_;
 };
@@ -2749,19 +3428,1749 @@ private:
 /// @}
 
 // clang-format off
-// 8888888888                            8888888888                         888    d8b
-// 888                                   888                                888    Y8P
-// 888                                   888                                888
-// 8888888 888d888 .d88b.   .d88b.       8888888 888  888 88888b.   .d8888b 888888 888  .d88b.  88888b.  .d8888b
-// 888     888P"  d8P  Y8b d8P  Y8b      888     888  888 888 "88b d88P"    888    888 d88""88b 888 "88b 88K
-// 888     888    88888888 88888888      888     888  888 888  888 888      888    888 888  888 888  888 "Y8888b.
-// 888     888    Y8b.     Y8b.          888     Y88b 888 888  888 Y88b.    Y88b.  888 Y88..88P 888  888      X88
-// 888     888     "Y8888   "Y8888       888      "Y88888 888  888  "Y8888P  "Y888 888  "Y88P"  888  888  88888P'
-// MARK: Free Functions -
+// 8888888b.                          888 888          888       .d8888b.
+// 888   Y88b                         888 888          888      d88P  Y88b
+// 888    888                         888 888          888      Y88b.
+// 888   d88P 8888b.  888d888 8888b.  888 888  .d88b.  888       "Y888b.    .d8888b  8888b.  88888b.
+// 8888888P"     "88b 888P"      "88b 888 888 d8P  Y8b 888          "Y88b. d88P"        "88b 888 "88b
+// 888       .d888888 888    .d888888 888 888 88888888 888            "888 888      .d888888 888  888
+// 888       888  888 888    888  888 888 888 Y8b.     888      Y88b  d88P Y88b.    888  888 888  888
+// 888       "Y888888 888    "Y888888 888 888  "Y8888  888       "Y8888P"   "Y8888P "Y888888 888  888
+// MARK: Parallel Scan -
 // clang-format on
 
-/// \addtogroup mainf Free Functions
-/// \brief Convenience functions.
+/// \addtogroup parallel Parallel scan
+/// \brief Running a partitioned query concurrently over several connections.
+///
+/// The query is split by the caller into partitions, each described by a predicate
+/// which is substituted into the query text in place of the `{partition}` placeholder.
+/// Every worker thread opens its own connection and pulls partitions from a work-stealing
+/// pool until all of them are processed. Rows are fetched with the regular result machinery.
+///
+/// @{
+
+/// \brief Identifies the partition being delivered to a parallel_scan consumer.
+struct scan_partition
+{
+    std::size_t index; ///< Position of the partition in the partition list.
+    string predicate;  ///< Predicate substituted for the `{partition}` placeholder.
+};
+
+/// \brief Options controlling parallel_scan.
+struct parallel_scan_options
+{
+    std::size_t connections = 4; ///< Maximum number of worker threads and connections.
+    long rowset_size = 1000;     ///< Number of rows fetched into a rowset at a time.
+    long timeout = 0;            ///< Query timeout in seconds, 0 meaning no timeout.
+};
+
+/// \brief A blocking queue of bounded capacity used to hand rows over between threads.
+///
+/// Producers block in push() while the queue is full, consumers block in pop() while it is
+/// empty. Once close() is called, push() fails and pop() drains the remaining items.
+template <class T>
+class bounded_queue
+{
+public:
+    /// \brief Creates a queue holding at most the given number of items.
+    explicit bounded_queue(std::size_t capacity)
+        : capacity_(capacity == 0 ? 1 : capacity)
+    {
+    }
+
+    bounded_queue(bounded_queue const&) = delete;
+    bounded_queue& operator=(bounded_queue const&) = delete;
+
+    /// \brief Appends an item, waiting for room if the queue is full.
+    /// \return false if the queue has been closed and the item was discarded.
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+        if (closed_)
+            return false;
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /// \brief Removes the oldest item, waiting for one if the queue is empty.
+    /// \return false if the queue has been closed and no items remain.
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+        if (items_.empty())
+            return false;
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /// \brief Closes the queue, waking up all waiting producers and consumers.
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    /// \brief Returns true if close() has been called.
+    bool closed() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+private:
+    std::size_t const capacity_;
+    std::deque<T> items_;
+    bool closed_{false};
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+/// \brief Splits the range of an integer key column into contiguous partitions.
+///
+/// Executes `SELECT MIN(key), MAX(key)` on the given table and divides the range into
+/// at most `count` predicates of roughly equal width. A `key IS NULL` predicate is always
+/// appended, so rows without a key are scanned too. If the table is empty only the
+/// `IS NULL` predicate is returned.
+/// \param conn The connection used to determine the key range.
+/// \param table Name of the table, used verbatim in the query.
+/// \param key_column Name of the integer key column, used verbatim in the query.
+/// \param count Number of key ranges to produce.
+/// \throws database_error, programming_error
+std::vector<string> key_range_partitions(
+    connection& conn,
+    string const& table,
+    string const& key_column,
+    std::size_t count);
+
+/// \brief Executes a partitioned query concurrently, delivering each partition to a callback.
+///
+/// For every predicate in `partitions` the `{partition}` placeholder in `query` is replaced
+/// with the parenthesized predicate and the query is executed on one of the worker
+/// connections. The consumer receives the result positioned before the first row and may
+/// iterate it with result::next(). The consumer is called concurrently from several threads.
+///
+/// The first exception thrown by a worker or by the consumer stops the scan, and is rethrown
+/// once all workers finished.
+/// \param connect Callable returning a new open connection, called once per worker thread.
+/// \param query The SQL query containing the `{partition}` placeholder.
+/// \param partitions Predicates selecting disjoint parts of the data.
+/// \param consumer Callback receiving each executed partition.
+/// \param options Number of connections, rowset size and timeout.
+/// \throws database_error, programming_error
+void parallel_scan(
+    std::function<connection()> const& connect,
+    string const& query,
+    std::vector<string> const& partitions,
+    std::function<void(scan_partition const&, result&)> const& consumer,
+    parallel_scan_options const& options = parallel_scan_options());
+
+/// \brief Executes a partitioned query concurrently, opening connections from the given
+/// connection string.
+/// \see parallel_scan(std::function<connection()> const&, string const&, std::vector<string>
+/// const&, std::function<void(scan_partition const&, result&)> const&, parallel_scan_options
+/// const&)
+void parallel_scan(
+    string const& connection_string,
+    string const& query,
+    std::vector<string> const& partitions,
+    std::function<void(scan_partition const&, result&)> const& consumer,
+    parallel_scan_options const& options = parallel_scan_options());
+
+/// \brief Executes a partitioned query concurrently, pushing batches of rows into a queue.
+///
+/// Each row is converted with `extract(result&)` and rows are pushed into `queue` in batches
+/// of at most `options.rowset_size`. The queue is closed when the scan completes or fails,
+/// so a consumer may simply pop() until it returns false. Closing the queue from the
+/// consumer side cancels the scan: the worker whose push() fails stops, and the others stop at
+/// their next push() or before their next partition. The call then returns without throwing.
+/// \param connect Callable returning a new open connection, called once per worker thread.
+/// \param query The SQL query containing the `{partition}` placeholder.
+/// \param partitions Predicates selecting disjoint parts of the data.
+/// \param queue Queue receiving row batches.
+/// \param extract Callable converting the current row of a result into a Row.
+/// \param options Number of connections, rowset size and timeout.
+/// \throws database_error, programming_error
+template <class Row, class Extract>
+void parallel_scan(
+    std::function<connection()> const& connect,
+    string const& query,
+    std::vector<string> const& partitions,
+    bounded_queue<std::vector<Row>>& queue,
+    Extract extract,
+    parallel_scan_options const& options = parallel_scan_options())
+{
+    // Thrown from a worker whose push() failed, stopping the other workers as any error would.
+    struct cancelled
+    {
+    };
+
+    std::size_t const batch_size =
+        options.rowset_size > 0 ? static_cast<std::size_t>(options.rowset_size) : 1;
+    try
+    {
+        parallel_scan(
+            connect,
+            query,
+            partitions,
+            [&](scan_partition const&, result& rows) {
+                std::vector<Row> batch;
+                batch.reserve(batch_size);
+                while (rows.next())
+                {
+                    batch.push_back(extract(rows));
+                    if (batch.size() == batch_size)
+                    {
+                        if (!queue.push(std::move(batch)))
+                            throw cancelled();
+                        batch = std::vector<Row>();
+                        batch.reserve(batch_size);
+                    }
+                }
+                if (!batch.empty() && !queue.push(std::move(batch)))
+                    throw cancelled();
+            },
+            options);
+    }
+    catch (cancelled const&)
+    {
+        // The consumer closed the queue.
+    }
+    catch (...)
+    {
+        queue.close();
+        throw;
+    }
+    queue.close();
+}
+
+/// \brief Executes a partitioned query concurrently, pushing batches of rows into a queue and
+/// opening connections from the given connection string.
+/// \see parallel_scan(std::function<connection()> const&, string const&, std::vector<string>
+/// const&, bounded_queue<std::vector<Row>>&, Extract, parallel_scan_options const&)
+template <class Row, class Extract>
+void parallel_scan(
+    string const& connection_string,
+    string const& query,
+    std::vector<string> const& partitions,
+    bounded_queue<std::vector<Row>>& queue,
+    Extract extract,
+    parallel_scan_options const& options = parallel_scan_options())
+{
+    parallel_scan<Row>(
+        std::function<connection()>([connection_string] { return connection(connection_string); }),
+        query,
+        partitions,
+        queue,
+        std::move(extract),
+        options);
+}
+
+/// @}
+
+// clang-format off
+// 888888b.            888            888           888       888         d8b 888
+// 888  "88b           888            888           888   o   888         Y8P 888
+// 888  .88P           888            888           888  d8b  888             888
+// 8888888K.   8888b.  888888 .d8888b 88888b.       888 d888b 888 888d888 888 888888 .d88b.  888d888
+// 888  "Y88b     "88b 888   d88P"    888 "88b      888d88888b888 888P"   888 888   d8P  Y8b 888P"
+// 888    888 .d888888 888   888      888  888      88888P Y88888 888     888 888   88888888 888
+// 888   d88P 888  888 Y88b. Y88b.    888  888      8888P   Y8888 888     888 Y88b. Y8b.     888
+// 8888888P"  "Y888888  "Y888 "Y8888P 888  888      888P     Y888 888     888  "Y888 "Y8888  888
+// MARK: Batch Writer -
+// clang-format on
+
+/// \addtogroup batch_writer Batch writer
+/// \brief Loading rows in parameter array batches, packing one while the other executes.
+///
+/// @{
+
+/// \brief Outcome of one batch executed by a batch_writer.
+struct batch_result
+{
+    std::size_t sequence;  ///< Zero-based number of the batch, in submission order.
+    std::size_t rows;      ///< Number of rows submitted in the batch.
+    std::size_t processed; ///< Number of rows the driver reports as processed.
+    std::vector<statement::param_status> row_status; ///< Status of every submitted row.
+    std::exception_ptr error; ///< The error raised by the execution, if any.
+};
+
+/// \brief Writes rows through a prepared statement in parameter array batches, executing each
+/// batch on a background thread while the next one is being filled.
+///
+/// The writer owns two sets of parameter buffers laid out in one block of memory. Both are
+/// bound once, and `SQL_ATTR_PARAM_BIND_OFFSET_PTR` selects the set a batch executes from.
+/// While one set executes, rows are packed into the other. When that set is full and the
+/// previous batch still runs, add_row() blocks until it has completed.
+///
+/// Parameters are declared with add_column() or add_string_column() before the first value is
+/// set. A parameter not set in a row is sent as null.
+///
+/// Every batch is reported to the handler given to on_batch(), on the background thread, with
+/// the status of each of its rows. Without a handler, the error of a failed batch is rethrown
+/// from the next call to add_row(), flush() or finish().
+///
+/// \note The statement must not be used by anything else while the writer exists.
+/// \note Rows added but not submitted by flush() or finish() are discarded on destruction.
+class batch_writer
+{
+public:
+    /// \brief Creates a writer for the given prepared statement.
+    ///
+    /// Batches execute synchronously on the background thread, so asynchronous execution is
+    /// turned off for the statement.
+    ///
+    /// \param stmt A prepared statement with parameter markers.
+    /// \param batch_size Number of rows per batch.
+    /// \throws database_error, programming_error
+    batch_writer(statement& stmt, std::size_t batch_size);
+
+    /// \brief Waits for the batch in flight, discarding rows not yet submitted.
+    ~batch_writer() noexcept;
+
+    batch_writer(batch_writer const&) = delete;
+    batch_writer& operator=(batch_writer const&) = delete;
+
+    /// \brief Declares a parameter of fixed size type T.
+    /// \param param_index Zero-based index of the parameter marker.
+    /// \throws database_error, programming_error
+    template <class T>
+    void add_column(short param_index);
+
+    /// \brief Declares a character parameter holding strings of up to max_length characters.
+    /// \param param_index Zero-based index of the parameter marker.
+    /// \param max_length Maximum number of characters, not counting the terminator.
+    /// \throws database_error, programming_error
+    void add_string_column(short param_index, std::size_t max_length);
+
+    /// \brief Sets the function called with the outcome of every batch.
+    void on_batch(std::function<void(batch_result const&)> handler);
+
+    /// \brief Sets the value of a parameter in the current row.
+    /// \throws programming_error, type_incompatible_error
+    template <class T>
+    void set(short param_index, T const& value);
+
+    /// \brief Sets the value of a string parameter in the current row.
+    /// \throws programming_error, type_incompatible_error
+    void set(short param_index, string const& value);
+
+    /// \brief Sets the value of a string parameter in the current row.
+    /// \throws programming_error, type_incompatible_error
+    void set(short param_index, string::value_type const* value);
+
+    /// \brief Completes the current row, submitting the batch once it is full.
+    /// \throws database_error
+    void add_row();
+
+    /// \brief Submits the rows added so far, without waiting for them to be executed.
+    /// \throws database_error
+    void flush();
+
+    /// \brief Submits the rows added so far and waits until every batch has been executed.
+    /// \throws database_error
+    void finish();
+
+    /// \brief Returns the number of rows added to the batch being filled.
+    std::size_t rows() const noexcept;
+
+private:
+    class batch_writer_impl;
+    std::shared_ptr<batch_writer_impl> impl_;
+};
+
+/// @}
+
+// clang-format off
+// 888888b.            888 888            .d8888b.
+// 888  "88b           888 888           d88P  Y88b
+// 888  .88P           888 888           888    888
+// 8888888K.  888  888 888 888  888      888         .d88b.  88888b.  888  888
+// 888  "Y88b 888  888 888 888 .88P      888        d88""88b 888 "88b 888  888
+// 888    888 888  888 888 888888K       888    888 888  888 888  888 888  888
+// 888   d88P Y88b 888 888 888 "88b      Y88b  d88P Y88..88P 888 d88P Y88b 888
+// 8888888P"   "Y88888 888 888  888       "Y8888P"   "Y88P"  88888P"   "Y88888
+//                                                           888           888
+//                                                           888      Y8b d88P
+//                                                           888       "Y88P"
+// MARK: Bulk Copy -
+// clang-format on
+
+/// \addtogroup bulk_copy Bulk copy
+/// \brief Loading rows into a table with SQL Server's bulk copy API, or with array inserts.
+///
+/// @{
+
+/// \brief Copies rows into a table, through SQL Server's bulk copy program (BCP) API where the
+/// connection allows it and through parameter array inserts otherwise.
+///
+/// Columns are declared with add_column() or add_string_column(), by name and in the order their
+/// values are then set by index. A column not set in a row is sent as null. Rows are sent in
+/// batches of the given size, and each batch is committed as it completes.
+///
+/// Rows can also come from arrays, bound to the columns with bind() and bind_strings() as for
+/// an array insert, and added by add_rows() many at a time. Their values are sent as though
+/// set one row at a time.
+///
+/// The BCP path is taken when the connection was opened with the Microsoft ODBC Driver for SQL
+/// Server and BCP enabled, that is with connection attribute 1219 (`SQL_COPT_SS_BCP`) set to 1
+/// (`SQL_BCP_ON`) before connecting. It calls the driver's `bcp_*` functions on the connection
+/// handle, binding one row of buffers once and sending each row as it is added. Any other
+/// connection gets a batch_writer executing `INSERT INTO table (columns) VALUES (?, ...)`, or,
+/// where driver_profile::native_parameter_arrays says the driver would execute it row by row,
+/// a copy_in of up to batch size rows per statement.
+///
+/// The column types supported are unsigned char, short, int, long int, long long, float,
+/// double, date and timestamp, which have a bulk copy type of their own, and strings.
+///
+/// \note The table and column names are used as given, quoted if they need to be.
+/// \note While the copy is in progress, the connection must not be used for anything else.
+/// \note Only finish() commits the rows of the last batch. On the BCP path, destruction before
+///       finish() aborts the copy, discarding the rows sent since the last batch committed. On
+///       the insert path, rows not yet submitted are discarded as by batch_writer.
+class bulk_copy
+{
+public:
+    /// \brief Prepares to copy rows into the given table.
+    /// \param conn An open connection.
+    /// \param table Name of the table to copy into.
+    /// \param batch_size Number of rows per batch.
+    /// \throws database_error, programming_error
+    bulk_copy(connection& conn, string const& table, std::size_t batch_size = 1000);
+
+    /// \brief Ends the copy, as described above, if finish() was not called.
+    ~bulk_copy() noexcept;
+
+    bulk_copy(bulk_copy const&) = delete;
+    bulk_copy& operator=(bulk_copy const&) = delete;
+
+    /// \brief Returns true if the rows go through the bulk copy API.
+    ///
+    /// False also where BCP was enabled on the connection but the `bcp_*` functions were not
+    /// found in the library the driver was loaded from, in which case the rows go through
+    /// inserts.
+    bool uses_bcp() const noexcept;
+
+    /// \brief Declares the next column, holding values of fixed size type T.
+    /// \param name Name of the column in the table.
+    /// \throws programming_error
+    template <class T>
+    void add_column(string const& name);
+
+    /// \brief Declares the next column, holding strings of up to max_length characters.
+    /// \param name Name of the column in the table.
+    /// \param max_length Maximum number of characters, not counting the terminator.
+    /// \throws programming_error
+    void add_string_column(string const& name, std::size_t max_length);
+
+    /// \brief Sets the value of a column in the current row.
+    /// \param column Zero-based index of the column, in the order the columns were added.
+    /// \throws database_error, programming_error, type_incompatible_error
+    template <class T>
+    void set(short column, T const& value);
+
+    /// \brief Sets the value of a string column in the current row.
+    /// \throws database_error, programming_error, type_incompatible_error
+    void set(short column, string const& value);
+
+    /// \brief Sets the value of a string column in the current row.
+    /// \throws database_error, programming_error, type_incompatible_error
+    void set(short column, string::value_type const* value);
+
+    /// \brief Binds an array of values to a column, for add_rows() to read.
+    /// \param column Zero-based index of the column, in the order the columns were added.
+    /// \param values Values of the column, one per row.
+    /// \param batch_size Number of values.
+    /// \param nulls Flags for values that should be null, or nullptr for none.
+    /// \throws index_range_error, type_incompatible_error
+    template <class T>
+    void bind(short column, T const* values, std::size_t batch_size, bool const* nulls = nullptr);
+
+    /// \brief Binds an array of strings to a string column, for add_rows() to read.
+    /// \throws index_range_error, type_incompatible_error
+    void bind_strings(short column, std::vector<string> const& values, bool const* nulls = nullptr);
+
+    /// \brief Completes the current row, sending the batch once it is full.
+    /// \throws database_error
+    void add_row();
+
+    /// \brief Adds the first rows of the bound arrays, each as by add_row().
+    ///
+    /// A column with no array bound is null in these rows. The arrays are read during the call
+    /// only.
+    /// \throws database_error, programming_error, type_incompatible_error
+    void add_rows(std::size_t rows);
+
+    /// \brief Sends the rows added so far as a batch.
+    /// \throws database_error
+    void flush();
+
+    /// \brief Sends the rows added so far, waits for every batch to be committed and ends the copy.
+    /// \return The number of rows copied in total.
+    /// \throws database_error
+    std::size_t finish();
+
+private:
+    class bulk_copy_impl;
+    std::shared_ptr<bulk_copy_impl> impl_;
+};
+
+/// @}
+
+// clang-format off
+//  .d8888b.
+// d88P  Y88b
+// 888    888
+// 888         .d88b.  88888b.  888  888
+// 888        d88""88b 888 "88b 888  888
+// 888    888 888  888 888  888 888  888
+// Y88b  d88P Y88..88P 888 d88P Y88b 888
+//  "Y8888P"   "Y88P"  88888P"   "Y88888
+//                     888           888
+//                     888      Y8b d88P
+//                     888       "Y88P"
+// MARK: Copy -
+// clang-format on
+
+/// \addtogroup copy Copy in and out
+/// \brief Loading rows with multi-row INSERT statements and reading them with block fetches.
+///
+/// @{
+
+/// \brief Options of copy_in and copy_out().
+///
+/// ODBC reports neither how many parameter markers a statement may have nor how many rows an
+/// INSERT may list, so the connection's driver_profile holds them, probed by `SQL_DBMS_NAME`:
+///
+/// DBMS                 | max_parameters | max_insert_rows
+/// -------------------- | -------------- | ---------------
+/// Microsoft SQL Server | 2000           | 1000
+/// PostgreSQL           | 65535          | 1000
+/// MySQL, MariaDB       | 65535          | 1000
+/// Oracle               | 65535          | 1
+/// SQLite               | 999            | 1000
+/// any other            | 999            | 1000
+///
+/// Oracle before 23ai has no multi-row VALUES lists. Where a DBMS allows more, or less, set
+/// rows_per_statement and max_parameters here for one copy, or change the profile with
+/// connection::set_profile() for every copy on the connection.
+struct copy_options
+{
+    /// \brief Rows per INSERT statement, or zero for as many as the driver's limits allow, up to
+    /// driver_profile::max_insert_rows.
+    std::size_t rows_per_statement = 0;
+
+    /// \brief Parameter markers a statement may have, or zero for
+    /// driver_profile::max_parameters.
+    std::size_t max_parameters = 0;
+
+    /// \brief Whether copy_in may use bulk_copy where it takes the SQL Server bulk copy path.
+    bool allow_bulk_copy = true;
+
+    /// \brief Rows per fetch of copy_out(), or zero for driver_profile::rows_per_fetch.
+    long rows_per_fetch = 0;
+};
+
+/// \brief Copies rows into a table with INSERT statements of many rows each.
+///
+/// Drivers that execute a parameter array by looping over its rows gain nothing from array
+/// binding, but an `INSERT INTO table (columns) VALUES (?, ...), (?, ...), ...` statement sends
+/// all its rows in one execution on any driver. Rows are buffered column by column, as for
+/// batch_writer, and bound once to a prepared statement of as many rows as fit within the
+/// driver's limits: the parameter markers the DBMS accepts, unless copy_options::max_parameters
+/// says otherwise, and the statement length reported as `SQL_MAX_STATEMENT_LEN`. The last,
+/// partial batch is inserted by a statement of its own size.
+///
+/// Where bulk_copy would use the SQL Server bulk copy API, copy_in hands the rows to it instead.
+///
+/// Columns are declared with add_column() or add_string_column(), by name and in the order their
+/// values are then set by index. A column not set in a row is sent as null.
+///
+/// \note The table and column names are used as given, quoted if they need to be.
+/// \note Rows not yet inserted by flush() or finish() are discarded on destruction.
+class copy_in
+{
+public:
+    /// \brief Prepares to copy rows into the given table.
+    /// \param conn An open connection.
+    /// \param table Name of the table to copy into.
+    /// \param options Shape of the statements.
+    /// \throws database_error, programming_error
+    copy_in(connection& conn, string const& table, copy_options const& options = {});
+
+    /// \brief Discards the rows not yet inserted.
+    ~copy_in() noexcept;
+
+    copy_in(copy_in const&) = delete;
+    copy_in& operator=(copy_in const&) = delete;
+
+    /// \brief Returns true if the rows go through bulk_copy's SQL Server bulk copy path.
+    bool uses_bcp() const noexcept;
+
+    /// \brief Returns the number of rows per INSERT statement, once the first value is set.
+    std::size_t rows_per_statement() const noexcept;
+
+    /// \brief Declares the next column, holding values of fixed size type T.
+    /// \param name Name of the column in the table.
+    /// \throws programming_error
+    template <class T>
+    void add_column(string const& name);
+
+    /// \brief Declares the next column, holding strings of up to max_length characters.
+    /// \param name Name of the column in the table.
+    /// \param max_length Maximum number of characters, not counting the terminator.
+    /// \throws programming_error
+    void add_string_column(string const& name, std::size_t max_length);
+
+    /// \brief Sets the value of a column in the current row.
+    /// \param column Zero-based index of the column, in the order the columns were added.
+    /// \throws database_error, programming_error, type_incompatible_error
+    template <class T>
+    void set(short column, T const& value);
+
+    /// \brief Sets the value of a string column in the current row.
+    /// \throws database_error, programming_error, type_incompatible_error
+    void set(short column, string const& value);
+
+    /// \brief Sets the value of a string column in the current row.
+    /// \throws database_error, programming_error, type_incompatible_error
+    void set(short column, string::value_type const* value);
+
+    /// \brief Completes the current row, inserting the buffered rows once a statement is full.
+    /// \throws database_error
+    void add_row();
+
+    /// \brief Inserts the rows added so far.
+    /// \throws database_error
+    void flush();
+
+    /// \brief Inserts the rows added so far and ends the copy.
+    /// \return The number of rows copied in total.
+    /// \throws database_error
+    std::size_t finish();
+
+private:
+    class copy_in_impl;
+    std::shared_ptr<copy_in_impl> impl_;
+};
+
+/// \brief Reads the rows of a query in blocks, fetching the next block while one is handled.
+///
+/// The query is executed with a rowset of copy_options::rows_per_fetch rows, and the result is
+/// read through a prefetching_result, so the driver fetches a block while the handler works
+/// through the one before.
+///
+/// \param conn An open connection.
+/// \param query The query to read.
+/// \param row_handler Called for every row, with the reader positioned on it.
+/// \param options Rows per fetch.
+/// \return The number of rows read.
+/// \throws database_error
+std::size_t copy_out(
+    connection& conn,
+    string const& query,
+    std::function<void(prefetching_result&)> const& row_handler,
+    copy_options const& options = {});
+
+/// \brief Executes a single-row INSERT for many rows at a time as a multi-row INSERT.
+///
+/// Drivers such as those of MySQL and SQLite execute a parameter array by executing the
+/// statement once per row, so binding arrays to a statement gains nothing over inserting row by
+/// row. multirow_insert rewrites `INSERT INTO table (a, b) VALUES (?, ?)` into a statement whose
+/// VALUES list repeats the row as many times as the driver's limits allow, as copy_in does, and
+/// fills parameter i of every row of it from the array bound to parameter i of the original
+/// query.
+///
+/// Arrays are bound as for statement::bind() and executed with execute(), so code written for
+/// `execute(statement, batch_operations)` moves over unchanged. The values are copied, a
+/// statement's worth of rows at a time, into buffers of the statement's own that are bound to
+/// it once: bound in place, each parameter would have to be bound again for every statement
+/// executed, and strings and null flags would still need copying into ODBC's layout.
+///
+/// The full-size statement and the statement for the last, partial group of rows are both
+/// prepared once and kept, so repeated executions of batches of the same size prepare nothing.
+/// Binding a longer string, or a parameter of another type, than the statements were prepared
+/// for prepares them again.
+///
+/// \note The bound arrays are read during execute(), and must stay valid until then.
+class multirow_insert
+{
+public:
+    /// \brief Prepares to execute the given INSERT for many rows at a time.
+    /// \param conn An open connection.
+    /// \param query An INSERT of a single row, whose VALUES list ends the statement.
+    /// \param options Rows per statement and parameter limit, as for copy_in.
+    /// \throws database_error, programming_error
+    multirow_insert(connection& conn, string const& query, copy_options const& options = {});
+
+    ~multirow_insert() noexcept;
+
+    multirow_insert(multirow_insert const&) = delete;
+    multirow_insert& operator=(multirow_insert const&) = delete;
+
+    /// \brief Returns the number of parameters of a row of the original query.
+    short parameters() const noexcept;
+
+    /// \brief Returns the number of rows per INSERT statement.
+    std::size_t rows_per_statement() const noexcept;
+
+    /// \brief Binds an array of values to a parameter of the original query.
+    /// \param param_index Zero-based index of the parameter in the original query.
+    /// \param values Values of the parameter, one per row.
+    /// \param batch_size Number of values.
+    /// \param nulls Flags for values that should be null, or nullptr for none.
+    /// \throws index_range_error
+    template <class T>
+    void bind(
+        short param_index,
+        T const* values,
+        std::size_t batch_size,
+        bool const* nulls = nullptr);
+
+    /// \brief Binds an array of strings to a parameter of the original query.
+    /// \throws index_range_error
+    void bind_strings(
+        short param_index,
+        std::vector<string> const& values,
+        bool const* nulls = nullptr);
+
+    /// \brief Inserts the first batch_operations rows of the bound arrays.
+    /// \return The number of rows inserted.
+    /// \throws database_error, programming_error
+    /// \see rows_inserted()
+    std::size_t execute(std::size_t batch_operations);
+
+    /// \brief Returns the number of rows the last execute() inserted, also when it threw.
+    ///
+    /// A failed statement inserts none of its rows, but those of the statements executed
+    /// before it in the same call stay inserted unless a transaction is rolled back.
+    std::size_t rows_inserted() const noexcept;
+
+private:
+    class multirow_insert_impl;
+    std::shared_ptr<multirow_insert_impl> impl_;
+};
+
+/// @}
+
+// clang-format off
+// 888b     d888          888                    d8b          888 d8b
+// 8888b   d8888          888                    Y8P          888 Y8P
+// 88888b.d88888          888                                 888
+// 888Y88888P888  8888b.  888888 .d88b.  888d888 888  8888b.  888 888 88888888 .d88b.
+// 888 Y888P 888     "88b 888   d8P  Y8b 888P"   888     "88b 888 888    d88P d8P  Y8b
+// 888  Y8P  888 .d888888 888   88888888 888     888 .d888888 888 888   d88P  88888888
+// 888   "   888 888  888 Y88b. Y8b.     888     888 888  888 888 888  d88P   Y8b.
+// 888       888 "Y888888  "Y888 "Y8888  888     888 "Y888888 888 888 88888888 "Y8888
+// MARK: Materialize -
+// clang-format on
+
+/// \addtogroup materialize Materialized results
+/// \brief Result sets read whole into memory, for random access once the cursor is gone.
+///
+/// @{
+
+/// \brief The rows of a result set, held in memory column by column.
+///
+/// Made by result::materialize(). Each column holds its values in a single array: integer
+/// columns as 64-bit integers, floating point columns as doubles, and date, time and timestamp
+/// columns as the nanodbc structures. Text and binary columns hold their values end to end in
+/// one buffer, with an offset per row, and every column has a bit per row for nulls.
+///
+/// Values are read as of result, with get(), get_ref() and is_null(), from the current row.
+/// Any row can be made current in constant time by move(), and first(), last(), next(),
+/// prior() and skip() move as their result counterparts do, without asking a driver to scroll.
+/// Rows are numbered from 1, as by result::position().
+///
+/// get() and get_ref() are available for the types of result::get() other than the
+/// std::optional and _variant_t ones. A value converts to the same types as under result: a
+/// number to any arithmetic type or to text, text to a number by parsing it, and a timestamp
+/// to a date, a time or a timestampoffset.
+///
+/// \note Copies share the rows, which are never changed, and each has a current row of its own.
+class materialized_result
+{
+public:
+    /// \brief Empty result set.
+    materialized_result() noexcept;
+
+    /// \brief Returns the number of rows.
+    long rows() const noexcept;
+
+    /// \brief Returns the number of columns.
+    short columns() const noexcept;
+
+    /// \brief Returns the number of bytes the values take in memory.
+    ///
+    /// For rows read by open_spool(), this is the size of the file, which is mapped rather than
+    /// read, so that only the parts of it in use take memory.
+    std::size_t memory_size() const noexcept;
+
+    /// \brief Moves to the first row.
+    /// \return true if there is one.
+    bool first() noexcept;
+
+    /// \brief Moves to the last row.
+    /// \return true if there is one.
+    bool last() noexcept;
+
+    /// \brief Moves to the next row.
+    /// \return true if there is one, false once past the last row.
+    bool next() noexcept;
+
+    /// \brief Moves to the prior row.
+    /// \return true if there is one, false once before the first row.
+    bool prior() noexcept;
+
+    /// \brief Moves to the given row.
+    ///
+    /// Rows are numbered from 1, and a negative row counts back from the last one, which is -1,
+    /// as for SQL_FETCH_ABSOLUTE.
+    /// \return true if there is such a row.
+    bool move(long row) noexcept;
+
+    /// \brief Moves the given number of rows forward, or backward if it is negative.
+    /// \return true if there is such a row.
+    bool skip(long rows) noexcept;
+
+    /// \brief Returns the current row, numbered from 1, or 0 if there is none.
+    unsigned long position() const noexcept;
+
+    /// \brief Returns true if there is no current row.
+    bool at_end() const noexcept;
+
+    /// \brief Gets data from the given column of the current row.
+    /// \see result::get_ref(short, T&) const
+    /// \throws index_range_error, type_incompatible_error, null_access_error
+    template <class T>
+    void get_ref(short column, T& result) const;
+
+    /// \brief Gets data from the given column of the current row, or the fallback if it is null.
+    /// \throws index_range_error, type_incompatible_error
+    template <class T>
+    void get_ref(short column, T const& fallback, T& result) const;
+
+    /// \brief Gets data from the named column of the current row.
+    /// \throws index_range_error, type_incompatible_error, null_access_error
+    template <class T>
+    void get_ref(string const& column_name, T& result) const;
+
+    /// \brief Gets data from the named column of the current row, or the fallback if it is null.
+    /// \throws index_range_error, type_incompatible_error
+    template <class T>
+    void get_ref(string const& column_name, T const& fallback, T& result) const;
+
+    /// \brief Gets data from the given column of the current row.
+    /// \throws index_range_error, type_incompatible_error, null_access_error
+    template <class T>
+    T get(short column) const;
+
+    /// \brief Gets data from the given column of the current row, or the fallback if it is null.
+    /// \throws index_range_error, type_incompatible_error
+    template <class T>
+    T get(short column, T const& fallback) const;
+
+    /// \brief Gets data from the named column of the current row.
+    /// \throws index_range_error, type_incompatible_error, null_access_error
+    template <class T>
+    T get(string const& column_name) const;
+
+    /// \brief Gets data from the named column of the current row, or the fallback if it is null.
+    /// \throws index_range_error, type_incompatible_error
+    template <class T>
+    T get(string const& column_name, T const& fallback) const;
+
+    /// \brief Returns true if and only if the given column of the current row is null.
+    /// \throws index_range_error
+    bool is_null(short column) const;
+
+    /// \brief Returns true if and only if the named column of the current row is null.
+    /// \throws index_range_error
+    bool is_null(string const& column_name) const;
+
+    /// \brief Returns the column number of the specified column name.
+    /// \throws index_range_error
+    short column(string const& column_name) const;
+
+    /// \brief Returns the name of the specified column.
+    /// \throws index_range_error
+    string column_name(short column) const;
+
+    /// \brief Returns the size of the specified column, as result::column_size() reported it.
+    /// \throws index_range_error
+    long column_size(short column) const;
+
+    /// \brief Returns the decimal digits of the specified column.
+    /// \throws index_range_error
+    int column_decimal_digits(short column) const;
+
+    /// \brief Returns the SQL type of the specified column.
+    /// \throws index_range_error
+    int column_datatype(short column) const;
+
+    /// \brief Returns the C type the specified column was read as.
+    /// \throws index_range_error
+    int column_c_datatype(short column) const;
+
+    /// \brief If and only if the object holds a result set, returns true.
+    explicit operator bool() const noexcept;
+
+private:
+    class materialized_result_impl;
+    friend class nanodbc::result;
+    friend materialized_result open_spool(std::string const& path);
+
+    explicit materialized_result(std::shared_ptr<materialized_result_impl const> impl) noexcept;
+
+    // The current row, numbered from 1; 0 is before the first row and rows() + 1 after the last.
+    std::size_t current_row() const;
+
+private:
+    std::shared_ptr<materialized_result_impl const> impl_;
+    long row_{0};
+};
+
+/// \brief Options of spool().
+struct spool_options
+{
+    /// \brief The number of rows held in memory, and written to the file, at a time.
+    std::size_t rows_per_chunk = 65536;
+};
+
+/// \brief Writes the remaining rows of a result set to a file, in the layout materialized_result
+/// keeps in memory.
+///
+/// The rows are read and written a chunk at a time, so a result set of any size can be spooled
+/// in the memory of one chunk. Within a chunk, each column is written as materialize() holds it:
+/// a bit per row for nulls, then fixed size values end to end, or text and binary values end to
+/// end behind an offset per row. The file is read back, without parsing, by open_spool().
+///
+/// The file is written under the given path with ".partial" appended, and renamed to the path
+/// only once whole, replacing any file there in the same step, so that readers of the path see
+/// either the earlier file or the new one. Should writing fail, the partial file is removed
+/// and the path left as it was, so an extract can be started again from its query.
+///
+/// \param rows The result set, whose cursor is left past the last row.
+/// \param path The file to write.
+/// \param options The size of the chunks.
+/// \return The number of rows written.
+/// \throws database_error, programming_error
+std::size_t spool(result& rows, std::string const& path, spool_options const& options = {});
+
+/// \brief Maps a file written by spool() into memory, as a materialized_result.
+///
+/// The values are read in place from the mapping, which the returned result and its copies
+/// share, and the operating system pages in only those in use. The file is checked to be whole
+/// and consistent, but must have been written by a machine of the same byte order, and by a
+/// build of nanodbc with the same NANODBC_ENABLE_UNICODE setting.
+///
+/// \param path The file to read.
+/// \throws programming_error If the file cannot be mapped or is not a whole spool file.
+materialized_result open_spool(std::string const& path);
+
+/// @}
+
+// clang-format off
+// 8888888888                                    888
+// 888                                           888
+// 888                                           888
+// 8888888    888  888 88888b.   .d88b.  888d888 888888
+// 888        `Y8bd8P' 888 "88b d88""88b 888P"   888
+// 888          X88K   888  888 888  888 888     888
+// 888        .d8""8b. 888 d88P Y88..88P 888     Y88b.
+// 8888888888 888  888 88888P"   "Y88P"  888      "Y888
+//                     888
+//                     888
+//                     888
+// MARK: Export -
+// clang-format on
+
+/// \addtogroup export Export
+/// \brief Writing result sets out as delimited text.
+///
+/// @{
+
+/// \brief How export_delimited() quotes fields.
+enum class delimited_quoting
+{
+    minimal, ///< Quote the fields holding a delimiter, quote, escape or line break.
+    all,     ///< Quote every field but nulls.
+    none     ///< Quote no field, escaping delimiters and line breaks instead.
+};
+
+/// \brief Options of export_delimited().
+///
+/// The defaults write CSV as RFC 4180 describes it, but for its CRLF line breaks. For tab
+/// separated values as PostgreSQL's COPY writes them, set delimiter to '\t', quoting to
+/// delimited_quoting::none, escape to '\\' and null_value to "\\N".
+struct delimited_options
+{
+    /// \brief Separates the fields of a row.
+    char delimiter = ',';
+
+    /// \brief Encloses a quoted field.
+    char quote = '"';
+
+    /// \brief Precedes a quote, or itself, within a quoted field; the default, the quote itself,
+    /// doubles quotes. With delimited_quoting::none it precedes a delimiter or itself, and writes
+    /// line breaks as "n" and "r"; '\0', or the quote, writes fields as they are.
+    char escape = '"';
+
+    /// \brief Which fields are quoted.
+    delimited_quoting quoting = delimited_quoting::minimal;
+
+    /// \brief Ends each row.
+    std::string line_end = "\n";
+
+    /// \brief Stands for a null, and is never quoted.
+    std::string null_value;
+
+    /// \brief Whether the first row holds the column names.
+    bool header = true;
+
+    /// \brief The size of the buffer the rows are formatted into, and handed to the sink in.
+    std::size_t buffer_size = 1 << 20;
+};
+
+/// \brief Writes the remaining rows of a result set as delimited text, such as CSV.
+///
+/// Each value is formatted straight from the buffer its column is bound to, into one buffer of
+/// options.buffer_size bytes, which is handed to the sink whenever it fills and once at the end.
+/// Numbers, dates and times are formatted without allocating and with '.' as the decimal mark:
+/// integers in decimal, floating point numbers as the shortest text that reads back as the same
+/// value, a float or a REAL column's value at float precision, dates, times and timestamps as
+/// ISO 8601 with a space between date and time and the fractional digits the column has. Text
+/// is written as UTF-8 and binary values as lowercase hexadecimal digits. Unbound columns are
+/// read as result::get() reads them.
+///
+/// \param rows The result set, whose cursor is left past the last row.
+/// \param sink Called with each buffer full of text; may throw to stop the export.
+/// \param options How fields are delimited and quoted.
+/// \return The number of rows written, not counting the header.
+/// \throws database_error, programming_error
+std::size_t export_delimited(
+    result& rows,
+    std::function<void(char const*, std::size_t)> const& sink,
+    delimited_options const& options = {});
+
+/// \brief Writes the remaining rows of a result set as delimited text to a file.
+///
+/// \see export_delimited(result&, std::function<void(char const*, std::size_t)> const&,
+/// delimited_options const&)
+/// \param rows The result set, whose cursor is left past the last row.
+/// \param path The file to write, replaced if it exists.
+/// \param options How fields are delimited and quoted.
+/// \return The number of rows written, not counting the header.
+/// \throws database_error, programming_error
+std::size_t export_delimited(
+    result& rows,
+    std::string const& path,
+    delimited_options const& options = {});
+
+/// @}
+
+// clang-format off
+// 888b     d888                            d8b
+// 8888b   d8888                            Y8P
+// 88888b.d88888
+// 888Y88888P888  8888b.  88888b.  88888b.  888 88888b.   .d88b.
+// 888 Y888P 888     "88b 888 "88b 888 "88b 888 888 "88b d88P"88b
+// 888  Y8P  888 .d888888 888  888 888  888 888 888  888 888  888
+// 888   "   888 888  888 888 d88P 888 d88P 888 888  888 Y88b 888
+// 888       888 "Y888888 88888P"  88888P"  888 888  888  "Y88888
+//                        888      888                        888
+//                        888      888                   Y8b d88P
+//                        888      888                    "Y88P"
+// MARK: Mapping -
+// clang-format on
+
+/// \addtogroup mapping Row mapping
+/// \brief Reading the rows of a result set into structs.
+///
+/// A row_mapping names the column each member of a struct is read from. It is written out with
+/// map_row() and map_column(), or declared once for a struct with NANODBC_MAP:
+///
+/// \code{.cpp}
+/// struct order
+/// {
+///     int id;
+///     nanodbc::string customer;
+///     double total;
+/// };
+/// NANODBC_MAP(order, id, customer, total)
+///
+/// std::vector<order> orders = nanodbc::fetch_rows<order>(results);
+/// \endcode
+///
+/// A mapped_reader looks the columns up by name once, when it is made, rather than once per
+/// value, and then reads every member with result::get_ref() by column number. Integer, floating
+/// point, date, time and timestamp members whose size and type are those of the buffer their
+/// column is bound to are copied out of it as they are.
+///
+/// The same mapping binds a vector of structs to the parameters of a batch with
+/// statement::bind_rows(), member by member in order.
+///
+/// @{
+
+/// \brief Names the column a member of Row is read from.
+template <class Row, class Member>
+struct column_mapping
+{
+    string name;         ///< The column, as result::column() looks it up.
+    Member Row::*member; ///< The member the column is read into.
+};
+
+/// \brief Returns a column_mapping of the given column and member.
+template <class Row, class Member>
+column_mapping<Row, Member> map_column(string name, Member Row::*member)
+{
+    return {std::move(name), member};
+}
+
+/// \brief Names the columns the members of Row are read from, in the order they are read.
+template <class Row, class... Members>
+struct row_mapping
+{
+    std::tuple<column_mapping<Row, Members>...> columns; ///< One per mapped member.
+};
+
+/// \brief Returns a row_mapping of the given columns.
+///
+/// \code{.cpp}
+/// auto const mapping = nanodbc::map_row(
+///     nanodbc::map_column(NANODBC_TEXT("order_id"), &order::id),
+///     nanodbc::map_column(NANODBC_TEXT("total"), &order::total));
+/// \endcode
+template <class Row, class... Members>
+row_mapping<Row, Members...> map_row(column_mapping<Row, Members>... columns)
+{
+    return {std::make_tuple(std::move(columns)...)};
+}
+
+/// \brief Returns the row_mapping NANODBC_MAP declared for Row.
+template <class Row>
+auto row_mapping_of() -> decltype(nanodbc_row_mapping(static_cast<Row const*>(nullptr)))
+{
+    return nanodbc_row_mapping(static_cast<Row const*>(nullptr));
+}
+
+/// \brief Returns what a member of the given type is.
+template <class Member>
+constexpr mapped_kind mapped_kind_of() noexcept
+{
+    if (std::is_same<Member, string>::value)
+        return mapped_kind::text;
+    if (is_character<Member>::value)
+        return mapped_kind::character;
+    if (std::is_same<Member, bool>::value)
+        return mapped_kind::boolean;
+    if (std::is_integral<Member>::value)
+        return std::is_signed<Member>::value ? mapped_kind::signed_integer
+                                             : mapped_kind::unsigned_integer;
+    if (std::is_floating_point<Member>::value)
+        return mapped_kind::floating;
+    if (std::is_same<Member, nanodbc::date>::value)
+        return mapped_kind::date;
+    if (std::is_same<Member, nanodbc::time>::value)
+        return mapped_kind::time;
+    if (std::is_same<Member, nanodbc::timestamp>::value)
+        return mapped_kind::timestamp;
+    if (std::is_same<Member, std::vector<std::uint8_t>>::value)
+        return mapped_kind::binary;
+    return mapped_kind::unsupported;
+}
+
+/// \brief What a member of the given type is, and how its value is sent as a parameter, looking
+/// through std::optional.
+template <class Member>
+struct mapped_member
+{
+    using value_type = Member; ///< The type of the member's value.
+    static constexpr mapped_kind kind = mapped_kind_of<Member>(); ///< What the value is.
+    static constexpr bool optional = false; ///< Whether the member can hold no value.
+
+    /// \brief Whether the member can be a copy of a bound value of the same type.
+    static constexpr bool fixed_size =
+        kind == mapped_kind::signed_integer || kind == mapped_kind::unsigned_integer ||
+        kind == mapped_kind::floating || kind == mapped_kind::date || kind == mapped_kind::time ||
+        kind == mapped_kind::timestamp;
+
+    /// \brief Returns the size of a value, or of a character of text, or 1 for binary.
+    static constexpr std::size_t unit_size() noexcept { return unit_size(tag()); }
+
+    /// \brief Returns the number of bytes copy() writes for the given member.
+    static std::size_t size(Member const& member) noexcept { return size(member, tag()); }
+
+    /// \brief Writes the given member's value to out as it is sent as a parameter, with text
+    /// null-terminated, and sets length to its length in bytes less any terminator.
+    /// \return false if the member holds no value, leaving out and length as they were.
+    static bool copy(Member const& member, void* out, std::size_t& length) noexcept
+    {
+        return copy(member, out, length, tag());
+    }
+
+private:
+    using tag = std::integral_constant<mapped_kind, kind>;
+    using text_tag = std::integral_constant<mapped_kind, mapped_kind::text>;
+    using character_tag = std::integral_constant<mapped_kind, mapped_kind::character>;
+    using binary_tag = std::integral_constant<mapped_kind, mapped_kind::binary>;
+
+    template <class Tag>
+    static constexpr std::size_t unit_size(Tag) noexcept
+    {
+        return sizeof(Member);
+    }
+    static constexpr std::size_t unit_size(text_tag) noexcept
+    {
+        return sizeof(typename Member::value_type);
+    }
+    static constexpr std::size_t unit_size(binary_tag) noexcept { return 1; }
+
+    template <class Tag>
+    static std::size_t size(Member const&, Tag) noexcept
+    {
+        return sizeof(Member);
+    }
+    static std::size_t size(Member const& member, text_tag) noexcept
+    {
+        return (member.size() + 1) * unit_size();
+    }
+    static std::size_t size(Member const&, character_tag) noexcept { return 2 * sizeof(Member); }
+    static std::size_t size(Member const& member, binary_tag) noexcept { return member.size(); }
+
+    template <class Tag>
+    static bool copy(Member const& member, void* out, std::size_t& length, Tag) noexcept
+    {
+        *static_cast<Member*>(out) = member;
+        length = sizeof(Member);
+        return true;
+    }
+    static bool copy(Member const& member, void* out, std::size_t& length, text_tag) noexcept
+    {
+        using char_type = typename Member::value_type;
+        auto* const text = static_cast<char_type*>(out);
+        std::char_traits<char_type>::copy(text, member.data(), member.size());
+        text[member.size()] = char_type();
+        length = member.size() * sizeof(char_type);
+        return true;
+    }
+    static bool copy(Member const& member, void* out, std::size_t& length, character_tag) noexcept
+    {
+        auto* const text = static_cast<Member*>(out);
+        text[0] = member;
+        text[1] = Member();
+        length = sizeof(Member);
+        return true;
+    }
+    static bool copy(Member const& member, void* out, std::size_t& length, binary_tag) noexcept
+    {
+        std::char_traits<char>::copy(
+            static_cast<char*>(out), reinterpret_cast<char const*>(member.data()), member.size());
+        length = member.size();
+        return true;
+    }
+};
+
+#ifdef NANODBC_HAS_STD_OPTIONAL
+template <class Member>
+struct mapped_member<std::optional<Member>>
+{
+    using value_type = Member;
+    static constexpr mapped_kind kind = mapped_member<Member>::kind;
+    static constexpr bool optional = true;
+    static constexpr bool fixed_size = mapped_member<Member>::fixed_size;
+
+    static constexpr std::size_t unit_size() noexcept { return mapped_member<Member>::unit_size(); }
+
+    static std::size_t size(std::optional<Member> const& member) noexcept
+    {
+        return member ? mapped_member<Member>::size(*member) : 0;
+    }
+
+    static bool copy(std::optional<Member> const& member, void* out, std::size_t& length) noexcept
+    {
+        return member && mapped_member<Member>::copy(*member, out, length);
+    }
+};
+#endif
+
+/// \brief The part of mapped_reader that does not depend on the row type.
+class mapped_reader_base
+{
+protected:
+    /// \brief Reads from the given result set, which is shared rather than copied.
+    explicit mapped_reader_base(result& rows);
+
+    /// \brief Looks up the column a member is read from, and checks it can be read into it.
+    /// \param name The name of the column.
+    /// \param kind What the member is.
+    /// \param size The size of the member, or of the value a std::optional member holds.
+    /// \throws index_range_error If the result set has no such column.
+    /// \throws type_incompatible_error If the column's values can never be read into the member.
+    void add_column(string const& name, mapped_kind kind, std::size_t size);
+
+    /// \brief Returns the number of the column the given member is read from.
+    short column(std::size_t member) const noexcept { return columns_[member].column; }
+
+    /// \brief Returns the current row's value of the given member's column, if it can be copied
+    /// into the member as it is and is not null, or else nullptr.
+    char const* cell(std::size_t member) const
+    {
+        mapped_column const& mapped = columns_[member];
+        return mapped.c_type != 0 ? bound_value(mapped.column, mapped.c_type) : nullptr;
+    }
+
+    result rows_; ///< The result set read from.
+
+private:
+    char const* bound_value(short column, short c_type) const;
+
+    struct mapped_column
+    {
+        short column;
+        short c_type; // The C type of a value the member can be a copy of, or 0 if none.
+    };
+    std::vector<mapped_column> columns_;
+};
+
+/// \brief Reads the rows of a result set into Row structs, as a row_mapping says.
+///
+/// The columns are looked up and checked when the reader is made. Null values can be read into
+/// std::optional members; read into any other member they throw null_access_error.
+///
+/// \code{.cpp}
+/// auto reader = nanodbc::make_mapped_reader<order>(results);
+/// std::vector<order> orders;
+/// while (reader.read_rows(orders, results.rowset_size()) > 0)
+/// {
+///     process(orders);
+///     orders.clear();
+/// }
+/// \endcode
+///
+/// \note Copies of a reader, like copies of a result, move the same cursor.
+template <class Row, class... Members>
+class mapped_reader : private mapped_reader_base
+{
+    static_assert(sizeof...(Members) > 0, "a row mapping needs at least one column");
+
+public:
+    /// \brief Looks up the mapped columns in the given result set.
+    /// \throws index_range_error If the result set lacks a mapped column.
+    /// \throws type_incompatible_error If a column's values can never be read into its member.
+    mapped_reader(result& rows, row_mapping<Row, Members...> const& mapping)
+        : mapped_reader_base(rows)
+        , mapping_(mapping)
+    {
+        add_columns(std::index_sequence_for<Members...>());
+    }
+
+    /// \brief Reads the current row into the given struct.
+    /// \throws database_error, index_range_error, null_access_error, type_incompatible_error
+    void read(Row& row) const { read_members(row, std::index_sequence_for<Members...>()); }
+
+    /// \brief Returns the current row as a struct.
+    /// \throws database_error, index_range_error, null_access_error, type_incompatible_error
+    Row read() const
+    {
+        Row row{};
+        read(row);
+        return row;
+    }
+
+    /// \brief Moves to the next row up to count times, appending each row to the given vector.
+    ///
+    /// Given the rowset size as count, this reads a rowset at a time. A row that fails to be
+    /// read is not appended.
+    /// \return The number of rows appended, less than count only at the end of the result set.
+    /// \throws database_error, index_range_error, null_access_error, type_incompatible_error
+    std::size_t read_rows(std::vector<Row>& rows, std::size_t count)
+    {
+        if (rows.empty())
+        {
+            auto const rowset_size = static_cast<std::size_t>(rows_.rowset_size());
+            rows.reserve(count < rowset_size ? count : rowset_size);
+        }
+        std::size_t appended = 0;
+        while (appended < count && rows_.next())
+        {
+            rows.emplace_back();
+            try
+            {
+                read(rows.back());
+            }
+            catch (...)
+            {
+                rows.pop_back();
+                throw;
+            }
+            ++appended;
+        }
+        return appended;
+    }
+
+    /// \brief Appends the remaining rows to the given vector.
+    /// \return The number of rows appended.
+    /// \throws database_error, index_range_error, null_access_error, type_incompatible_error
+    std::size_t read_all(std::vector<Row>& rows)
+    {
+        return read_rows(rows, (std::numeric_limits<std::size_t>::max)());
+    }
+
+private:
+    template <std::size_t... I>
+    void add_columns(std::index_sequence<I...>)
+    {
+        int const expand[] = {(add_column<I>(), 0)...};
+        (void)expand;
+    }
+
+    template <std::size_t I>
+    void add_column()
+    {
+        auto const& mapped = std::get<I>(mapping_.columns);
+        using traits = mapped_member<typename std::tuple_element<I, std::tuple<Members...>>::type>;
+        static_assert(
+            traits::kind != mapped_kind::unsupported,
+            "a mapped member must be of a type result::get_ref() reads");
+        mapped_reader_base::add_column(
+            mapped.name, traits::kind, sizeof(typename traits::value_type));
+    }
+
+    template <std::size_t... I>
+    void read_members(Row& row, std::index_sequence<I...>) const
+    {
+        int const expand[] = {(read_member(I, row.*std::get<I>(mapping_.columns).member), 0)...};
+        (void)expand;
+    }
+
+    template <class Member>
+    void read_member(std::size_t index, Member& member) const
+    {
+        read_member(
+            index, member, std::integral_constant<bool, mapped_member<Member>::fixed_size>());
+    }
+
+    template <class Member>
+    void read_member(std::size_t index, Member& member, std::true_type) const
+    {
+        if (char const* value = cell(index))
+        {
+            // A bound buffer need not be aligned for the type, so the value is copied out.
+            typename mapped_member<Member>::value_type copy;
+            std::memcpy(&copy, value, sizeof copy);
+            member = copy;
+            return;
+        }
+        rows_.get_ref(column(index), member);
+    }
+
+    template <class Member>
+    void read_member(std::size_t index, Member& member, std::false_type) const
+    {
+        rows_.get_ref(column(index), member);
+    }
+
+    row_mapping<Row, Members...> mapping_;
+};
+
+/// \brief Returns a mapped_reader of the given result set and row_mapping.
+/// \throws index_range_error, type_incompatible_error
+template <class Row, class... Members>
+mapped_reader<Row, Members...>
+make_mapped_reader(result& rows, row_mapping<Row, Members...> const& mapping)
+{
+    return mapped_reader<Row, Members...>(rows, mapping);
+}
+
+/// \brief Returns a mapped_reader of the given result set and the row_mapping NANODBC_MAP
+/// declared for Row.
+/// \throws index_range_error, type_incompatible_error
+template <class Row>
+auto make_mapped_reader(result& rows) -> decltype(make_mapped_reader(rows, row_mapping_of<Row>()))
+{
+    return make_mapped_reader(rows, row_mapping_of<Row>());
+}
+
+/// \brief Reads the remaining rows of a result set into a vector of Row structs.
+/// \throws database_error, index_range_error, null_access_error, type_incompatible_error
+template <class Row, class... Members>
+std::vector<Row> fetch_rows(result& rows, row_mapping<Row, Members...> const& mapping)
+{
+    std::vector<Row> fetched;
+    make_mapped_reader(rows, mapping).read_all(fetched);
+    return fetched;
+}
+
+/// \brief Reads the remaining rows of a result set into a vector of Row structs, as the
+/// row_mapping NANODBC_MAP declared for Row says.
+/// \throws database_error, index_range_error, null_access_error, type_incompatible_error
+template <class Row>
+std::vector<Row> fetch_rows(result& rows)
+{
+    return fetch_rows(rows, row_mapping_of<Row>());
+}
+
+template <class Member>
+statement::row_parameter statement::row_parameter_of(std::size_t offset)
+{
+    using traits = mapped_member<Member>;
+    static_assert(
+        traits::kind != mapped_kind::unsupported,
+        "a mapped member must be of a type statement::bind() binds");
+    bool const in_place =
+        !traits::optional && (traits::fixed_size ||
+                              (traits::kind == mapped_kind::boolean && sizeof(bool) == 1));
+    return {
+        traits::kind,
+        traits::unit_size(),
+        offset,
+        in_place,
+        [](void const* member) { return traits::size(*static_cast<Member const*>(member)); },
+        [](void const* member, void* out, std::size_t& length) {
+            return traits::copy(*static_cast<Member const*>(member), out, length);
+        }};
+}
+
+template <class Row, class... Members, std::size_t... I>
+std::vector<statement::row_parameter> statement::row_parameters(
+    Row const& row,
+    row_mapping<Row, Members...> const& mapping,
+    std::index_sequence<I...>)
+{
+    auto const* const start = reinterpret_cast<char const*>(&row);
+    return {row_parameter_of<Members>(static_cast<std::size_t>(
+        reinterpret_cast<char const*>(&(row.*std::get<I>(mapping.columns).member)) - start))...};
+}
+
+template <class Row, class... Members>
+void statement::bind_rows(
+    Row const* rows,
+    std::size_t count,
+    row_mapping<Row, Members...> const& mapping)
+{
+    static_assert(sizeof...(Members) > 0, "a row mapping needs at least one column");
+    if (count == 0)
+        throw programming_error("bind_rows needs at least one row");
+    bind_rows(
+        rows,
+        count,
+        sizeof(Row),
+        row_parameters(*rows, mapping, std::index_sequence_for<Members...>()));
+}
+
+template <class Row>
+void statement::bind_rows(std::vector<Row> const& rows)
+{
+    bind_rows(rows, row_mapping_of<Row>());
+}
+
+/// \brief Declares the row_mapping of a struct, reading each of the given members from the column
+/// of the same name.
+///
+/// Use it at namespace scope, in the namespace of the struct, for up to 32 members. The mapping
+/// is then found by row_mapping_of(), make_mapped_reader(), fetch_rows() and
+/// statement::bind_rows() without naming it.
+/// \code{.cpp}
+/// namespace shop
+/// {
+/// struct order
+/// {
+///     int id;
+///     nanodbc::string customer;
+/// };
+/// NANODBC_MAP(order, id, customer)
+/// } // namespace shop
+/// \endcode
+#define NANODBC_MAP(Row, ...)                                                                      \
+    inline auto nanodbc_row_mapping(Row const*)                                                    \
+    {                                                                                              \
+        return ::nanodbc::map_row(NANODBC_MAP_COLUMNS(Row, __VA_ARGS__));                          \
+    }
+
+// The rest spell out one map_column() per member. The extra expansions make MSVC's traditional
+// preprocessor split __VA_ARGS__ into arguments as the others do.
+#define NANODBC_MAP_COLUMNS(Row, ...)                                                              \
+    NANODBC_MAP_EXPAND(                                                                            \
+        NANODBC_MAP_CONCAT(NANODBC_MAP_, NANODBC_MAP_COUNT(__VA_ARGS__))(Row, __VA_ARGS__))
+#define NANODBC_MAP_EXPAND(x) x
+#define NANODBC_MAP_CONCAT(a, b) NANODBC_MAP_CONCAT_(a, b)
+#define NANODBC_MAP_CONCAT_(a, b) a##b
+#define NANODBC_MAP_COUNT(...)                                                                     \
+    NANODBC_MAP_EXPAND(NANODBC_MAP_COUNT_(                                                         \
+        __VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14,   \
+        13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define NANODBC_MAP_COUNT_(                                                                        \
+    _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20,     \
+    _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...)                            \
+    N
+#define NANODBC_MAP_COLUMN(Row, member) ::nanodbc::map_column(NANODBC_TEXT(#member), &Row::member)
+#define NANODBC_MAP_1(Row, m) NANODBC_MAP_COLUMN(Row, m)
+#define NANODBC_MAP_2(Row, m, ...)                                                                 \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_1(Row, __VA_ARGS__))
+#define NANODBC_MAP_3(Row, m, ...)                                                                 \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_2(Row, __VA_ARGS__))
+#define NANODBC_MAP_4(Row, m, ...)                                                                 \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_3(Row, __VA_ARGS__))
+#define NANODBC_MAP_5(Row, m, ...)                                                                 \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_4(Row, __VA_ARGS__))
+#define NANODBC_MAP_6(Row, m, ...)                                                                 \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_5(Row, __VA_ARGS__))
+#define NANODBC_MAP_7(Row, m, ...)                                                                 \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_6(Row, __VA_ARGS__))
+#define NANODBC_MAP_8(Row, m, ...)                                                                 \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_7(Row, __VA_ARGS__))
+#define NANODBC_MAP_9(Row, m, ...)                                                                 \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_8(Row, __VA_ARGS__))
+#define NANODBC_MAP_10(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_9(Row, __VA_ARGS__))
+#define NANODBC_MAP_11(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_10(Row, __VA_ARGS__))
+#define NANODBC_MAP_12(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_11(Row, __VA_ARGS__))
+#define NANODBC_MAP_13(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_12(Row, __VA_ARGS__))
+#define NANODBC_MAP_14(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_13(Row, __VA_ARGS__))
+#define NANODBC_MAP_15(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_14(Row, __VA_ARGS__))
+#define NANODBC_MAP_16(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_15(Row, __VA_ARGS__))
+#define NANODBC_MAP_17(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_16(Row, __VA_ARGS__))
+#define NANODBC_MAP_18(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_17(Row, __VA_ARGS__))
+#define NANODBC_MAP_19(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_18(Row, __VA_ARGS__))
+#define NANODBC_MAP_20(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_19(Row, __VA_ARGS__))
+#define NANODBC_MAP_21(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_20(Row, __VA_ARGS__))
+#define NANODBC_MAP_22(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_21(Row, __VA_ARGS__))
+#define NANODBC_MAP_23(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_22(Row, __VA_ARGS__))
+#define NANODBC_MAP_24(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_23(Row, __VA_ARGS__))
+#define NANODBC_MAP_25(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_24(Row, __VA_ARGS__))
+#define NANODBC_MAP_26(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_25(Row, __VA_ARGS__))
+#define NANODBC_MAP_27(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_26(Row, __VA_ARGS__))
+#define NANODBC_MAP_28(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_27(Row, __VA_ARGS__))
+#define NANODBC_MAP_29(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_28(Row, __VA_ARGS__))
+#define NANODBC_MAP_30(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_29(Row, __VA_ARGS__))
+#define NANODBC_MAP_31(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_30(Row, __VA_ARGS__))
+#define NANODBC_MAP_32(Row, m, ...)                                                                \
+    NANODBC_MAP_COLUMN(Row, m), NANODBC_MAP_EXPAND(NANODBC_MAP_31(Row, __VA_ARGS__))
+
+/// @}
+
+// clang-format off
+// 8888888                   888                                                     888             888    d8b
+//   888                     888                                                     888             888    Y8P
+//   888                     888                                                     888             888
+//   888   88888b.  .d8888b  888888 888d888 888  888 88888b.d88b.   .d88b.  88888b.  888888  8888b.  888888 888  .d88b.  88888b.
+//   888   888 "88b 88K      888    888P"   888  888 888 "888 "88b d8P  Y8b 888 "88b 888        "88b 888    888 d88""88b 888 "88b
+//   888   888  888 "Y8888b. 888    888     888  888 888  888  888 88888888 888  888 888    .d888888 888    888 888  888 888  888
+//   888   888  888      X88 Y88b.  888     Y88b 888 888  888  888 Y8b.     888  888 Y88b.  888  888 Y88b.  888 Y88..88P 888  888
+// 8888888 888  888  88888P'  "Y888 888      "Y88888 888  888  888  "Y8888  888  888  "Y888 "Y888888  "Y888 888  "Y88P"  888  888
+// MARK: Instrumentation -
+// clang-format on
+
+/// \addtogroup instrumentation Instrumentation
+/// \brief Counting and timing the ODBC calls nanodbc makes.
+///
+/// Every ODBC function nanodbc calls goes through one hook. While call tracing is enabled, the
+/// hook counts each call, times it and adds the time to a latency histogram kept per function.
+/// The counters of each thread are its own and are updated without locks; call_statistics()
+/// adds them up when it is asked. While tracing is disabled, the hook costs one relaxed atomic
+/// load per call.
+///
+/// A handler given to set_call_span_handler() is called after every traced call with the
+/// function, its start time, its duration and its return code, which is enough to open and
+/// close a span in a tracer.
+///
+/// @{
+
+/// \brief Counters of one ODBC function, summed over every thread.
+struct call_stats
+{
+    /// \brief Number of histogram buckets.
+    static constexpr std::size_t buckets = 32;
+
+    std::string function;                 ///< Name of the ODBC function.
+    unsigned long long calls;             ///< Number of calls.
+    unsigned long long errors;            ///< Calls returning SQL_ERROR or SQL_INVALID_HANDLE.
+    unsigned long long total_nanoseconds; ///< Time spent in the calls.
+
+    /// \brief Number of calls by latency.
+    ///
+    /// Bucket i counts calls that took from 2^i up to but not including 2^(i+1) nanoseconds,
+    /// except that the first also counts calls under one nanosecond and the last every call of
+    /// 2^31 nanoseconds or more.
+    std::vector<unsigned long long> histogram;
+};
+
+/// \brief One traced ODBC call, as handed to a span handler.
+struct call_span
+{
+    char const* function;                        ///< Name of the ODBC function.
+    std::chrono::steady_clock::time_point start; ///< When the call was made.
+    std::chrono::nanoseconds duration;           ///< How long the call took.
+    short return_code;                           ///< What the call returned.
+};
+
+/// \brief Starts or stops counting and timing ODBC calls.
+void enable_call_tracing(bool enabled = true) noexcept;
+
+/// \brief Returns true while ODBC calls are counted and timed.
+bool call_tracing_enabled() noexcept;
+
+/// \brief Returns the counters of every ODBC function called since the last reset.
+///
+/// The counters of threads that have exited are included. A call that completes while the
+/// counters are read may be counted in some and not yet in others.
+std::vector<call_stats> call_statistics();
+
+/// \brief Sets every counter back to zero.
+void reset_call_statistics();
+
+/// \brief Sets the function called after every traced ODBC call.
+///
+/// The handler is called on the thread that made the call, which may be any thread using
+/// nanodbc, so it must be safe to call concurrently. An exception thrown by it is discarded.
+/// An empty function removes the handler.
+void set_call_span_handler(std::function<void(call_span const&)> handler);
+
+/// @}
+
+// clang-format off
+// 8888888888                            8888888888                         888    d8b
+// 888                                   888                                888    Y8P
+// 888                                   888                                888
+// 8888888 888d888 .d88b.   .d88b.       8888888 888  888 88888b.   .d8888b 888888 888  .d88b.  88888b.  .d8888b
+// 888     888P"  d8P  Y8b d8P  Y8b      888     888  888 888 "88b d88P"    888    888 d88""88b 888 "88b 88K
+// 888     888    88888888 88888888      888     888  888 888  888 888      888    888 888  888 888  888 "Y8888b.
+// 888     888    Y8b.     Y8b.          888     Y88b 888 888  888 Y88b.    Y88b.  888 Y88..88P 888  888      X88
+// 888     888     "Y8888   "Y8888       888      "Y88888 888  888  "Y8888P  "Y888 888  "Y88P"  888  888  88888P'
+// MARK: Free Functions -
+// clang-format on
+
+/// \addtogroup mainf Free Functions
+/// \brief Convenience functions.
 ///
 /// @{
 
@@ -2792,6 +5201,28 @@ std::list<driver> list_drivers();
 /// \brief Returns a list of ODBC data sources on your system.
 std::list<datasource> list_datasources();
 
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+/// \brief Calls the ODBC driver in the given shared library directly, bypassing the driver manager.
+///
+/// Loads the library and resolves its entry points, after which every ODBC call nanodbc makes in
+/// this process goes straight to the driver, without the driver manager's locking, handle
+/// validation and, in Unicode builds, the translation of W functions to A ones. The driver must
+/// implement ODBC 3 and, in Unicode builds, export the W functions. Functions it does not export
+/// fail with SQL_ERROR. list_drivers() and list_datasources() need the driver manager and throw.
+///
+/// Only available if nanodbc is built with `NANODBC_ENABLE_DIRECT_DRIVER`, on systems with
+/// `dlopen`.
+///
+/// \param path The driver library, as given to `dlopen`.
+/// \throws programming_error if the library cannot be loaded or is not an ODBC driver, if another
+///         driver is linked already, or if connections through the driver manager are open.
+///         Linking the same library again does nothing.
+void link_driver(std::string const& path);
+
+/// \brief Returns the library given to link_driver(), or an empty string if none is linked.
+std::string linked_driver();
+#endif
+
 /// \brief Immediately opens, prepares, and executes the given query directly on the given
 /// connection.
 /// \param conn The connection where the statement will be executed.
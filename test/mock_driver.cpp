@@ -0,0 +1,2440 @@
+// A fake ODBC driver, serving synthetic result sets from memory, for measuring nanodbc's own
+// overhead without a database behind it and for asserting which ODBC calls it makes.
+//
+// The driver manager loads it like any other driver, from odbcinst.ini or from the path given
+// as the connection string's Driver keyword. The statement text describes the result set:
+//
+//     rows=100000 columns=int,bigint,double,varchar(32) nulls=10 latency_us=50
+//
+// rows       Number of rows in the result set.
+// columns    Column types: smallint, int, bigint, real, double, decimal(n), char(n),
+//            varchar(n), wvarchar(n), text(n), binary(n), blob(n), date and timestamp. Text and
+//            blob are long columns of n characters or bytes, which are read with SQLGetData.
+//            Decimal holds the values of double, with n digits.
+// nulls      Every nulls-th row is null in every column.
+// latency_us Microseconds each execution and each fetch sleeps for.
+//
+// Anything from " where " on is ignored, so that a partitioned query returns the same rows for
+// every partition.
+//
+// Values are a function of the row and the column, so a reader can check them: numbers count
+// up from the row number, a real having a tenth added that it holds to float precision, text
+// starts with "r<row>c<column>" and is padded with dots to its full length, and dates count
+// days from 2000-01-01.
+//
+// The statement "calls" returns the number of times each entry point has been called since
+// the driver was loaded or since the statement "reset", as rows of (function, calls). With a
+// Unicode application, the driver manager maps the W functions onto the ANSI ones counted
+// here. Any other statement succeeds without a result set, reporting as many affected rows as
+// there are parameter sets.
+//
+// Bound parameters are read only by a statement starting with "record", such as
+// "record ?, ?", which keeps the value of each of its parameters in each set as text, null as
+// NULL. The statement "parameters" returns the values the last "record" kept, a set at a time,
+// as rows of (value).
+//
+// A leading "select * from " is skipped, so that a description can stand in for a table name.
+//
+// With SQL_COPT_SS_BCP (1219) set on the connection, the bulk copy functions of the SQL Server
+// driver work too, bcp_init taking such a description for the table. The values of the rows
+// each bcp_batch or bcp_done commits are kept as those of "record" are, from bcp_init on, while
+// aborting the copy with bcp_control drops the rows sent since the last batch. The driver
+// reports the file name of its library as SQL_DRIVER_NAME, as drivers do, since that is how
+// nanodbc finds the bulk copy functions.
+//
+// A "record" statement ending in " tvp=" and a list of column types, such as
+// "record ?, ? tvp=int,varchar(16)", has a table-valued parameter of those columns as its first
+// marker, as SQL Server's driver describes one: its type name is the list, SQLColumns of that
+// name lists its columns, and its columns are bound with SQL_SOPT_SS_PARAM_FOCUS set. The
+// parameter is kept as "tvp rows=<n>" followed by the values of its n rows.
+//
+// Catalog functions other than that use of SQLColumns, descriptors beyond reading the
+// implementation row and parameter descriptors, bookmarks, SQLSetPos beyond positioning and
+// asynchronous execution are not implemented.
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <sql.h>
+#include <sqlext.h>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+// clang-format off
+#define NANODBC_MOCK_FUNCTIONS(X)                                                                  \
+    X(SQLAllocHandle) X(SQLBindCol) X(SQLBindParameter) X(SQLCancel) X(SQLCloseCursor)             \
+    X(SQLColAttribute) X(SQLColumns) X(SQLConnect) X(SQLDescribeCol) X(SQLDescribeParam)           \
+    X(SQLDisconnect) X(SQLDriverConnect) X(SQLEndTran) X(SQLExecDirect) X(SQLExecute)              \
+    X(SQLFetch) X(SQLFetchScroll) X(SQLFreeHandle) X(SQLFreeStmt) X(SQLGetConnectAttr)             \
+    X(SQLGetData) X(SQLGetDescField) X(SQLGetDiagField) X(SQLGetDiagRec) X(SQLGetEnvAttr)          \
+    X(SQLGetInfo) X(SQLGetStmtAttr) X(SQLMoreResults) X(SQLNumParams) X(SQLNumResultCols)          \
+    X(SQLPrepare) X(SQLRowCount) X(SQLSetConnectAttr) X(SQLSetEnvAttr) X(SQLSetPos)                \
+    X(SQLSetStmtAttr) X(bcp_batch) X(bcp_bind) X(bcp_collen) X(bcp_control) X(bcp_done)            \
+    X(bcp_init) X(bcp_sendrow)
+// clang-format on
+
+enum class mock_function
+{
+#define NANODBC_MOCK_ENUMERATOR(f) f,
+    NANODBC_MOCK_FUNCTIONS(NANODBC_MOCK_ENUMERATOR)
+#undef NANODBC_MOCK_ENUMERATOR
+        count
+};
+
+char const* const function_names[] = {
+#define NANODBC_MOCK_NAME(f) #f,
+    NANODBC_MOCK_FUNCTIONS(NANODBC_MOCK_NAME)
+#undef NANODBC_MOCK_NAME
+};
+
+std::atomic<unsigned long long> call_counts[static_cast<std::size_t>(mock_function::count)];
+
+#define NANODBC_MOCK_COUNT(f)                                                                      \
+    call_counts[static_cast<std::size_t>(mock_function::f)].fetch_add(1, std::memory_order_relaxed)
+
+// SQL Server's table-valued parameter extensions, by value, as not every set of headers has them.
+constexpr SQLSMALLINT ss_table = -153;      // SQL_SS_TABLE
+constexpr SQLSMALLINT ss_type_name = 1227;  // SQL_CA_SS_TYPE_NAME
+constexpr SQLINTEGER ss_param_focus = 1236; // SQL_SOPT_SS_PARAM_FOCUS
+
+struct diagnostic
+{
+    std::string state;
+    std::string message;
+};
+
+struct handle
+{
+    explicit handle(SQLSMALLINT type)
+        : type(type)
+    {
+    }
+
+    SQLSMALLINT const type;
+    std::vector<diagnostic> diagnostics;
+};
+
+struct environment : handle
+{
+    environment()
+        : handle(SQL_HANDLE_ENV)
+    {
+    }
+
+    SQLINTEGER odbc_version = SQL_OV_ODBC3;
+};
+
+// A program variable bound by bcp_bind, with the length bcp_collen last gave it.
+struct bcp_column
+{
+    char const* data = nullptr;
+    SQLSMALLINT c_type = 0;
+    SQLLEN length = SQL_NULL_DATA;
+};
+
+struct connection : handle
+{
+    connection()
+        : handle(SQL_HANDLE_DBC)
+    {
+    }
+
+    bool connected = false;
+    std::map<SQLINTEGER, SQLULEN> attributes{{SQL_ATTR_AUTOCOMMIT, SQL_AUTOCOMMIT_ON}};
+
+    // The bulk copy in progress, from bcp_init to bcp_done or an abort.
+    bool copying = false;
+    std::map<int, bcp_column> bcp_columns; // by ordinal
+    std::vector<std::string> bcp_values;   // of the rows sent since the last batch
+    SQLINTEGER bcp_rows = 0;
+};
+
+enum class value_kind
+{
+    integer,
+    floating,
+    text,
+    wide_text,
+    binary,
+    date,
+    timestamp
+};
+
+struct column_spec
+{
+    std::string name;
+    std::string type_name;
+    SQLSMALLINT sql_type;
+    value_kind kind;
+    SQLULEN size;
+    SQLSMALLINT digits;
+};
+
+struct binding
+{
+    SQLSMALLINT c_type;
+    SQLPOINTER target;
+    SQLLEN buffer_length;
+    SQLLEN* indicator;
+};
+
+struct statement;
+
+struct descriptor : handle
+{
+    enum role_type
+    {
+        application_row,
+        application_parameter,
+        implementation_row,
+        implementation_parameter
+    };
+
+    descriptor(statement& owner, role_type role)
+        : handle(SQL_HANDLE_DESC)
+        , owner(owner)
+        , role(role)
+    {
+    }
+
+    statement& owner;
+    role_type const role;
+};
+
+struct statement : handle
+{
+    statement()
+        : handle(SQL_HANDLE_STMT)
+        , ard(*this, descriptor::application_row)
+        , apd(*this, descriptor::application_parameter)
+        , ird(*this, descriptor::implementation_row)
+        , ipd(*this, descriptor::implementation_parameter)
+    {
+    }
+
+    enum class kind_type
+    {
+        none,
+        rows,
+        calls,
+        reset,
+        record,
+        parameters,
+        command,
+        table_type_columns
+    };
+
+    kind_type kind = kind_type::none;
+    std::vector<column_spec> columns;
+    long long rows = 0;
+    long long nulls = 0;
+    long latency_us = 0;
+    SQLSMALLINT parameters = 0;
+    std::vector<std::pair<std::string, unsigned long long>> calls;
+    std::vector<std::string> recorded;
+
+    // The columns of a table-valued parameter, its type name, and their bindings.
+    std::vector<column_spec> tvp_columns;
+    std::string tvp_type;
+    std::vector<binding> tvp_bindings;
+
+    bool open = false;
+    long long cursor = -1;      // first row of the current rowset
+    SQLULEN rowset_rows = 0;    // rows in the current rowset
+    SQLULEN position = 1;       // row of the rowset SQLGetData reads, from one
+    SQLLEN row_count = -1;
+
+    std::vector<binding> bindings;
+    std::vector<binding> parameter_bindings;
+
+    // Where the last SQLGetData left off.
+    long long get_data_row = -1;
+    SQLUSMALLINT get_data_column = 0;
+    std::size_t get_data_offset = 0;
+    bool get_data_done = false;
+
+    // The text of the cell last rendered, which a long value read in pieces needs again.
+    long long text_row = -1;
+    SQLUSMALLINT text_column = 0;
+    std::string text;
+
+    SQLULEN row_array_size = 1;
+    SQLULEN row_bind_type = SQL_BIND_BY_COLUMN;
+    SQLULEN* row_bind_offset = nullptr;
+    SQLUSMALLINT* row_status = nullptr;
+    SQLULEN* rows_fetched = nullptr;
+    SQLULEN paramset_size = 1;
+    SQLULEN param_bind_type = SQL_PARAM_BIND_BY_COLUMN;
+    SQLULEN* param_bind_offset = nullptr;
+    SQLUSMALLINT* param_status = nullptr;
+    SQLULEN* params_processed = nullptr;
+    std::map<SQLINTEGER, SQLULEN> attributes;
+
+    descriptor ard;
+    descriptor apd;
+    descriptor ird;
+    descriptor ipd;
+};
+
+SQLRETURN fail(handle& h, char const* state, std::string message)
+{
+    h.diagnostics.push_back({state, "[nanodbc mock] " + std::move(message)});
+    return SQL_ERROR;
+}
+
+SQLRETURN warn(handle& h, char const* state, std::string message)
+{
+    h.diagnostics.push_back({state, "[nanodbc mock] " + std::move(message)});
+    return SQL_SUCCESS_WITH_INFO;
+}
+
+template <class T>
+T* checked(SQLHANDLE h, SQLSMALLINT type)
+{
+    auto* p = static_cast<handle*>(h);
+    if (!p || p->type != type)
+        return nullptr;
+    p->diagnostics.clear();
+    return static_cast<T*>(p);
+}
+
+std::string text_argument(SQLCHAR const* text, SQLINTEGER length)
+{
+    if (!text)
+        return {};
+    auto const* chars = reinterpret_cast<char const*>(text);
+    if (length == SQL_NTS)
+        return chars;
+    return std::string(chars, static_cast<std::size_t>(length));
+}
+
+// Copies a string out to a buffer of the given size in bytes, terminating it and reporting its
+// full length, and warns when it had to be cut short.
+template <class Length>
+SQLRETURN copy_out(handle& h, std::string const& s, SQLPOINTER buffer, SQLLEN size, Length* length)
+{
+    if (length)
+        *length = static_cast<Length>(s.size());
+    if (!buffer || size <= 0)
+        return SQL_SUCCESS;
+    auto const n = std::min(s.size(), static_cast<std::size_t>(size - 1));
+    std::memcpy(buffer, s.data(), n);
+    static_cast<char*>(buffer)[n] = '\0';
+    if (n < s.size())
+        return warn(h, "01004", "String data, right truncated");
+    return SQL_SUCCESS;
+}
+
+void sleep_for_latency(statement const& stmt)
+{
+    if (stmt.latency_us > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(stmt.latency_us));
+}
+
+
+std::string lowercase(std::string s)
+{
+    for (auto& c : s)
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+std::string trimmed(std::string const& s)
+{
+    auto const first = s.find_first_not_of(" \t\r\n;");
+    if (first == std::string::npos)
+        return {};
+    auto const last = s.find_last_not_of(" \t\r\n;");
+    return s.substr(first, last - first + 1);
+}
+
+bool parse_column(std::string const& type, std::size_t index, column_spec& column)
+{
+    auto name = type;
+    SQLULEN size = 0;
+    auto const paren = type.find('(');
+    if (paren != std::string::npos)
+    {
+        if (type.back() != ')')
+            return false;
+        name = type.substr(0, paren);
+        size = std::strtoul(type.c_str() + paren + 1, nullptr, 10);
+        if (size == 0)
+            return false;
+    }
+
+    column.name = "c" + std::to_string(index + 1);
+    column.type_name = name;
+    column.digits = 0;
+    if (name == "smallint")
+        column = {column.name, name, SQL_SMALLINT, value_kind::integer, 5, 0};
+    else if (name == "int" || name == "integer")
+        column = {column.name, "int", SQL_INTEGER, value_kind::integer, 10, 0};
+    else if (name == "bigint")
+        column = {column.name, name, SQL_BIGINT, value_kind::integer, 19, 0};
+    else if (name == "real")
+        column = {column.name, name, SQL_REAL, value_kind::floating, 7, 0};
+    else if (name == "double" || name == "float")
+        column = {column.name, "double", SQL_DOUBLE, value_kind::floating, 15, 0};
+    else if (name == "decimal" && size)
+        column = {column.name, name, SQL_DECIMAL, value_kind::floating, size, 3};
+    else if (name == "char" && size)
+        column = {column.name, name, SQL_CHAR, value_kind::text, size, 0};
+    else if (name == "varchar" && size)
+        column = {column.name, name, SQL_VARCHAR, value_kind::text, size, 0};
+    else if (name == "wvarchar" && size)
+        column = {column.name, name, SQL_WVARCHAR, value_kind::wide_text, size, 0};
+    else if (name == "text" && size)
+        column = {column.name, name, SQL_LONGVARCHAR, value_kind::text, size, 0};
+    else if (name == "binary" && size)
+        column = {column.name, name, SQL_VARBINARY, value_kind::binary, size, 0};
+    else if (name == "blob" && size)
+        column = {column.name, name, SQL_LONGVARBINARY, value_kind::binary, size, 0};
+    else if (name == "date")
+        column = {column.name, name, SQL_TYPE_DATE, value_kind::date, 10, 0};
+    else if (name == "timestamp")
+        column = {column.name, name, SQL_TYPE_TIMESTAMP, value_kind::timestamp, 23, 3};
+    else
+        return false;
+    return true;
+}
+
+// Parses a comma separated list of column types.
+bool parse_columns(std::string const& list, std::vector<column_spec>& columns)
+{
+    std::size_t first = 0;
+    while (first <= list.size())
+    {
+        auto last = list.find(',', first);
+        if (last == std::string::npos)
+            last = list.size();
+        column_spec column;
+        if (!parse_column(list.substr(first, last - first), columns.size(), column))
+            return false;
+        columns.push_back(column);
+        first = last + 1;
+    }
+    return true;
+}
+
+SQLRETURN parse(statement& stmt, std::string const& text)
+{
+    stmt.kind = statement::kind_type::command;
+    stmt.columns.clear();
+    stmt.tvp_columns.clear();
+    stmt.tvp_type.clear();
+    stmt.tvp_bindings.clear();
+    stmt.rows = 0;
+    stmt.nulls = 0;
+    stmt.latency_us = 0;
+
+    stmt.parameters = 0;
+    bool quoted = false;
+    for (char c : text)
+    {
+        if (c == '\'')
+            quoted = !quoted;
+        else if (c == '?' && !quoted)
+            ++stmt.parameters;
+    }
+
+    auto s = lowercase(trimmed(text));
+    auto const where = s.find(" where ");
+    if (where != std::string::npos)
+        s.erase(where);
+    if (s.compare(0, 14, "select * from ") == 0)
+        s.erase(0, 14);
+    if (s == "calls")
+    {
+        stmt.kind = statement::kind_type::calls;
+        column_spec function;
+        column_spec calls;
+        parse_column("varchar(32)", 0, function);
+        parse_column("bigint", 1, calls);
+        function.name = "function";
+        calls.name = "calls";
+        stmt.columns = {function, calls};
+        return SQL_SUCCESS;
+    }
+    if (s == "reset")
+    {
+        stmt.kind = statement::kind_type::reset;
+        return SQL_SUCCESS;
+    }
+    if (s == "parameters")
+    {
+        stmt.kind = statement::kind_type::parameters;
+        column_spec value;
+        parse_column("varchar(64)", 0, value);
+        value.name = "value";
+        stmt.columns = {value};
+        return SQL_SUCCESS;
+    }
+    if (s.compare(0, 6, "record") == 0)
+    {
+        stmt.kind = statement::kind_type::record;
+        auto const tvp = s.find(" tvp=");
+        if (tvp != std::string::npos)
+        {
+            stmt.tvp_type = s.substr(tvp + 5);
+            if (stmt.parameters < 1 || !parse_columns(stmt.tvp_type, stmt.tvp_columns))
+                return fail(stmt, "42000", "unknown column type in: " + stmt.tvp_type);
+        }
+        return SQL_SUCCESS;
+    }
+    if (s.compare(0, 5, "rows=") != 0 && s.compare(0, 8, "columns=") != 0)
+        return SQL_SUCCESS;
+
+    stmt.kind = statement::kind_type::rows;
+    std::size_t begin = 0;
+    while (begin < s.size())
+    {
+        auto end = s.find_first_of(" \t\r\n;", begin);
+        if (end == std::string::npos)
+            end = s.size();
+        auto const token = s.substr(begin, end - begin);
+        begin = end + 1;
+        if (token.empty())
+            continue;
+
+        auto const equals = token.find('=');
+        if (equals == std::string::npos)
+            return fail(stmt, "42000", "expected key=value: " + token);
+        auto const key = token.substr(0, equals);
+        auto const value = token.substr(equals + 1);
+        if (key == "rows")
+            stmt.rows = std::strtoll(value.c_str(), nullptr, 10);
+        else if (key == "nulls")
+            stmt.nulls = std::strtoll(value.c_str(), nullptr, 10);
+        else if (key == "latency_us")
+            stmt.latency_us = std::strtol(value.c_str(), nullptr, 10);
+        else if (key == "columns")
+        {
+            if (!parse_columns(value, stmt.columns))
+                return fail(stmt, "42000", "unknown column type in: " + value);
+        }
+        else
+            return fail(stmt, "42000", "unknown key: " + key);
+    }
+    if (stmt.columns.empty())
+        return fail(stmt, "42000", "a result set needs columns=");
+    return SQL_SUCCESS;
+}
+
+
+bool is_null(statement const& stmt, long long row)
+{
+    return stmt.nulls > 0 && (row + 1) % stmt.nulls == 0;
+}
+
+long long integer_value(column_spec const& column, long long row, std::size_t index)
+{
+    auto const v = row + static_cast<long long>(index);
+    if (column.sql_type == SQL_SMALLINT)
+        return v % 32768;
+    if (column.sql_type == SQL_INTEGER)
+        return v % 2147483648LL;
+    return v;
+}
+
+double floating_value(column_spec const& column, long long row, std::size_t index)
+{
+    double const value = static_cast<double>(row) + static_cast<double>(index) / 8.0;
+    if (column.sql_type == SQL_REAL)
+        return static_cast<float>(value + 0.1);
+    return value;
+}
+
+SQL_DATE_STRUCT date_value(long long row)
+{
+    SQL_DATE_STRUCT d;
+    d.year = static_cast<SQLSMALLINT>(2000 + row / 336 % 100);
+    d.month = static_cast<SQLUSMALLINT>(1 + row / 28 % 12);
+    d.day = static_cast<SQLUSMALLINT>(1 + row % 28);
+    return d;
+}
+
+SQL_TIMESTAMP_STRUCT timestamp_value(long long row, std::size_t index)
+{
+    auto const d = date_value(row);
+    SQL_TIMESTAMP_STRUCT ts;
+    ts.year = d.year;
+    ts.month = d.month;
+    ts.day = d.day;
+    ts.hour = static_cast<SQLUSMALLINT>(row % 24);
+    ts.minute = static_cast<SQLUSMALLINT>(index % 60);
+    ts.second = static_cast<SQLUSMALLINT>(row % 60);
+    ts.fraction = 0;
+    return ts;
+}
+
+// The cell rendered as text, which is what character and binary columns hold and what any
+// column converted to a character type reads as.
+std::string const& cell_text(statement& stmt, long long row, SQLUSMALLINT number)
+{
+    if (stmt.text_row == row && stmt.text_column == number)
+        return stmt.text;
+
+    std::size_t const index = number - 1u;
+    auto const& column = stmt.columns[index];
+    char buffer[64];
+    auto& text = stmt.text;
+    switch (column.kind)
+    {
+    case value_kind::integer:
+        text = std::to_string(integer_value(column, row, index));
+        break;
+    case value_kind::floating:
+        std::snprintf(buffer, sizeof(buffer), "%.17g", floating_value(column, row, index));
+        text = buffer;
+        break;
+    case value_kind::date:
+    {
+        auto const d = date_value(row);
+        std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", d.year, d.month, d.day);
+        text = buffer;
+        break;
+    }
+    case value_kind::timestamp:
+    {
+        auto const ts = timestamp_value(row, index);
+        std::snprintf(
+            buffer,
+            sizeof(buffer),
+            "%04d-%02d-%02d %02d:%02d:%02d",
+            ts.year,
+            ts.month,
+            ts.day,
+            ts.hour,
+            ts.minute,
+            ts.second);
+        text = buffer;
+        break;
+    }
+    case value_kind::binary:
+        text.resize(column.size);
+        for (std::size_t i = 0; i < text.size(); ++i)
+            text[i] = static_cast<char>((row + static_cast<long long>(index + i)) & 0xff);
+        break;
+    case value_kind::text:
+    case value_kind::wide_text:
+        std::snprintf(buffer, sizeof(buffer), "r%lldc%u", row, static_cast<unsigned>(number));
+        text.assign(buffer, std::min(std::strlen(buffer), static_cast<std::size_t>(column.size)));
+        text.resize(column.size, '.');
+        break;
+    }
+    if (stmt.kind == statement::kind_type::calls && index == 0)
+        text = stmt.calls[static_cast<std::size_t>(row)].first;
+    if (stmt.kind == statement::kind_type::parameters)
+        text = stmt.recorded[static_cast<std::size_t>(row)];
+    stmt.text_row = row;
+    stmt.text_column = number;
+    return text;
+}
+
+SQLSMALLINT default_c_type(column_spec const& column)
+{
+    switch (column.kind)
+    {
+    case value_kind::integer:
+        return column.sql_type == SQL_SMALLINT ? SQL_C_SSHORT
+               : column.sql_type == SQL_INTEGER ? SQL_C_SLONG
+                                                : SQL_C_SBIGINT;
+    case value_kind::floating:
+        return column.sql_type == SQL_REAL ? SQL_C_FLOAT : SQL_C_DOUBLE;
+    case value_kind::text:
+        return SQL_C_CHAR;
+    case value_kind::wide_text:
+        return SQL_C_WCHAR;
+    case value_kind::binary:
+        return SQL_C_BINARY;
+    case value_kind::date:
+        return SQL_C_TYPE_DATE;
+    case value_kind::timestamp:
+        return SQL_C_TYPE_TIMESTAMP;
+    }
+    return SQL_C_CHAR;
+}
+
+// Size of a value of a fixed size C type, or zero for the character and binary types, whose
+// size is the buffer length.
+SQLLEN fixed_size(SQLSMALLINT c_type)
+{
+    switch (c_type)
+    {
+    case SQL_C_STINYINT:
+    case SQL_C_UTINYINT:
+    case SQL_C_TINYINT:
+    case SQL_C_BIT:
+        return 1;
+    case SQL_C_SSHORT:
+    case SQL_C_USHORT:
+    case SQL_C_SHORT:
+        return sizeof(SQLSMALLINT);
+    case SQL_C_SLONG:
+    case SQL_C_ULONG:
+    case SQL_C_LONG:
+        return sizeof(SQLINTEGER);
+    case SQL_C_SBIGINT:
+    case SQL_C_UBIGINT:
+        return sizeof(SQLBIGINT);
+    case SQL_C_FLOAT:
+        return sizeof(SQLREAL);
+    case SQL_C_DOUBLE:
+        return sizeof(SQLDOUBLE);
+    case SQL_C_DATE:
+    case SQL_C_TYPE_DATE:
+        return sizeof(SQL_DATE_STRUCT);
+    case SQL_C_TIMESTAMP:
+    case SQL_C_TYPE_TIMESTAMP:
+        return sizeof(SQL_TIMESTAMP_STRUCT);
+    default:
+        return 0;
+    }
+}
+
+template <class T>
+void store(SQLPOINTER target, T value)
+{
+    std::memcpy(target, &value, sizeof(value));
+}
+
+template <class T>
+SQLRETURN store_number(SQLSMALLINT c_type, SQLPOINTER target, T v)
+{
+    switch (c_type)
+    {
+    case SQL_C_STINYINT:
+    case SQL_C_TINYINT:
+        store(target, static_cast<SQLSCHAR>(v));
+        return SQL_SUCCESS;
+    case SQL_C_UTINYINT:
+    case SQL_C_BIT:
+        store(target, static_cast<SQLCHAR>(v));
+        return SQL_SUCCESS;
+    case SQL_C_SSHORT:
+    case SQL_C_SHORT:
+        store(target, static_cast<SQLSMALLINT>(v));
+        return SQL_SUCCESS;
+    case SQL_C_USHORT:
+        store(target, static_cast<SQLUSMALLINT>(v));
+        return SQL_SUCCESS;
+    case SQL_C_SLONG:
+    case SQL_C_LONG:
+        store(target, static_cast<SQLINTEGER>(v));
+        return SQL_SUCCESS;
+    case SQL_C_ULONG:
+        store(target, static_cast<SQLUINTEGER>(v));
+        return SQL_SUCCESS;
+    case SQL_C_SBIGINT:
+        store(target, static_cast<SQLBIGINT>(v));
+        return SQL_SUCCESS;
+    case SQL_C_UBIGINT:
+        store(target, static_cast<SQLUBIGINT>(v));
+        return SQL_SUCCESS;
+    case SQL_C_FLOAT:
+        store(target, static_cast<SQLREAL>(v));
+        return SQL_SUCCESS;
+    case SQL_C_DOUBLE:
+        store(target, static_cast<SQLDOUBLE>(v));
+        return SQL_SUCCESS;
+    default:
+        return SQL_ERROR;
+    }
+}
+
+// Writes one cell to a buffer as the given C type. Character and binary values continue from
+// offset, which is advanced past what was written, so that SQLGetData can read a long value in
+// pieces; a bound column always starts at zero.
+SQLRETURN put_cell(
+    statement& stmt,
+    long long row,
+    SQLUSMALLINT number,
+    SQLSMALLINT c_type,
+    SQLPOINTER target,
+    SQLLEN buffer_length,
+    SQLLEN* indicator,
+    std::size_t& offset)
+{
+    auto const& column = stmt.columns[number - 1u];
+    if (is_null(stmt, row))
+    {
+        if (!indicator)
+            return fail(stmt, "22002", "Indicator variable required but not supplied");
+        *indicator = SQL_NULL_DATA;
+        return SQL_SUCCESS;
+    }
+    if (c_type == SQL_C_DEFAULT)
+        c_type = default_c_type(column);
+
+    std::size_t const index = number - 1u;
+    switch (c_type)
+    {
+    case SQL_C_CHAR:
+    case SQL_C_WCHAR:
+    case SQL_C_BINARY:
+    {
+        auto const& text = cell_text(stmt, row, number);
+        auto const available = text.size() - std::min(offset, text.size());
+        std::size_t const unit = c_type == SQL_C_WCHAR ? sizeof(SQLWCHAR) : 1;
+        std::size_t const terminator = c_type == SQL_C_BINARY ? 0 : 1;
+        std::size_t room = buffer_length > 0 ? static_cast<std::size_t>(buffer_length) / unit : 0;
+        room = room > terminator ? room - terminator : 0;
+        auto const n = std::min(available, room);
+        if (target)
+        {
+            if (unit == 1)
+                std::memcpy(target, text.data() + offset, n);
+            else
+            {
+                auto* wide = static_cast<SQLWCHAR*>(target);
+                for (std::size_t i = 0; i < n; ++i)
+                    wide[i] = static_cast<unsigned char>(text[offset + i]);
+            }
+            if (terminator && buffer_length >= static_cast<SQLLEN>(unit))
+            {
+                if (unit == 1)
+                    static_cast<char*>(target)[n] = '\0';
+                else
+                    static_cast<SQLWCHAR*>(target)[n] = 0;
+            }
+        }
+        if (indicator)
+            *indicator = static_cast<SQLLEN>(available * unit);
+        offset += n;
+        if (n < available)
+            return warn(stmt, "01004", "String data, right truncated");
+        return SQL_SUCCESS;
+    }
+    case SQL_C_DATE:
+    case SQL_C_TYPE_DATE:
+        if (column.kind == value_kind::date)
+            store(target, date_value(row));
+        else if (column.kind == value_kind::timestamp)
+            store(target, date_value(row));
+        else
+            break;
+        if (indicator)
+            *indicator = sizeof(SQL_DATE_STRUCT);
+        return SQL_SUCCESS;
+    case SQL_C_TIMESTAMP:
+    case SQL_C_TYPE_TIMESTAMP:
+        if (column.kind == value_kind::timestamp)
+            store(target, timestamp_value(row, index));
+        else if (column.kind == value_kind::date)
+        {
+            auto const d = date_value(row);
+            SQL_TIMESTAMP_STRUCT ts{};
+            ts.year = d.year;
+            ts.month = d.month;
+            ts.day = d.day;
+            store(target, ts);
+        }
+        else
+            break;
+        if (indicator)
+            *indicator = sizeof(SQL_TIMESTAMP_STRUCT);
+        return SQL_SUCCESS;
+    default:
+    {
+        SQLRETURN rc = SQL_ERROR;
+        if (stmt.kind == statement::kind_type::calls && index == 1)
+            rc = store_number(c_type, target, stmt.calls[static_cast<std::size_t>(row)].second);
+        else if (stmt.kind == statement::kind_type::table_type_columns)
+        {
+            // DATA_TYPE, COLUMN_SIZE, BUFFER_LENGTH and DECIMAL_DIGITS of a column of the type.
+            auto const& described = stmt.tvp_columns[static_cast<std::size_t>(row)];
+            rc = store_number(
+                c_type,
+                target,
+                index == 4   ? static_cast<long long>(described.sql_type)
+                : index == 8 ? static_cast<long long>(described.digits)
+                             : static_cast<long long>(described.size));
+        }
+        else if (column.kind == value_kind::integer)
+            rc = store_number(c_type, target, integer_value(column, row, index));
+        else if (column.kind == value_kind::floating)
+            rc = store_number(c_type, target, floating_value(column, row, index));
+        if (rc != SQL_SUCCESS)
+            break;
+        if (indicator)
+            *indicator = fixed_size(c_type);
+        return SQL_SUCCESS;
+    }
+    }
+    return fail(stmt, "07006", "Restricted data type attribute violation");
+}
+
+
+template <class T>
+T load(char const* source)
+{
+    T value;
+    std::memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+// The values of parameters the last "record" statement kept, for "parameters" to return.
+std::mutex recorded_mutex;
+std::vector<std::string> recorded_parameters;
+
+std::string value_text(SQLSMALLINT c_type, char const* value, SQLLEN indicator, SQLLEN size);
+
+// Renders a bound parameter's value in the given parameter set as text, stepping through the
+// array as SQL_ATTR_PARAM_BIND_TYPE and SQL_ATTR_PARAM_BIND_OFFSET_PTR say.
+std::string parameter_text(statement const& stmt, binding const& b, SQLULEN set)
+{
+    SQLULEN const bind_offset = stmt.param_bind_offset ? *stmt.param_bind_offset : 0;
+    std::size_t step = 0;
+    std::size_t indicator_step = sizeof(SQLLEN);
+    if (stmt.param_bind_type == SQL_PARAM_BIND_BY_COLUMN)
+    {
+        auto const fixed = fixed_size(b.c_type);
+        step = fixed ? static_cast<std::size_t>(fixed) : static_cast<std::size_t>(b.buffer_length);
+    }
+    else
+        step = indicator_step = stmt.param_bind_type;
+
+    SQLLEN indicator = SQL_NTS;
+    if (b.indicator)
+        indicator = load<SQLLEN>(
+            reinterpret_cast<char const*>(b.indicator) + bind_offset + set * indicator_step);
+    if (indicator == SQL_NULL_DATA || !b.target)
+        return "NULL";
+    auto const* value = static_cast<char const*>(b.target) + bind_offset + set * step;
+    return value_text(b.c_type, value, indicator, b.buffer_length);
+}
+
+// Renders a value of the given C type as text. The indicator is its length in bytes, or
+// SQL_NTS, and size that of its buffer.
+std::string value_text(SQLSMALLINT c_type, char const* value, SQLLEN indicator, SQLLEN size)
+{
+    char buffer[64];
+    switch (c_type)
+    {
+    case SQL_C_CHAR:
+        if (indicator == SQL_NTS)
+            return value;
+        return std::string(value, static_cast<std::size_t>(indicator));
+    case SQL_C_WCHAR:
+    {
+        std::string text;
+        for (std::size_t i = 0;; ++i)
+        {
+            if (indicator != SQL_NTS && i * sizeof(SQLWCHAR) >= static_cast<std::size_t>(indicator))
+                break;
+            auto const c = load<SQLWCHAR>(value + i * sizeof(SQLWCHAR));
+            if (indicator == SQL_NTS && c == 0)
+                break;
+            text += static_cast<char>(c);
+        }
+        return text;
+    }
+    case SQL_C_BINARY:
+    {
+        auto const length = indicator == SQL_NTS ? size : indicator;
+        std::string text;
+        for (SQLLEN i = 0; i < length; ++i)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%02x", static_cast<unsigned char>(value[i]));
+            text += buffer;
+        }
+        return text;
+    }
+    case SQL_C_BIT:
+    case SQL_C_UTINYINT:
+        return std::to_string(load<SQLCHAR>(value));
+    case SQL_C_STINYINT:
+    case SQL_C_TINYINT:
+        return std::to_string(load<SQLSCHAR>(value));
+    case SQL_C_SSHORT:
+    case SQL_C_SHORT:
+        return std::to_string(load<SQLSMALLINT>(value));
+    case SQL_C_USHORT:
+        return std::to_string(load<SQLUSMALLINT>(value));
+    case SQL_C_SLONG:
+    case SQL_C_LONG:
+        return std::to_string(load<SQLINTEGER>(value));
+    case SQL_C_ULONG:
+        return std::to_string(load<SQLUINTEGER>(value));
+    case SQL_C_SBIGINT:
+        return std::to_string(load<SQLBIGINT>(value));
+    case SQL_C_UBIGINT:
+        return std::to_string(load<SQLUBIGINT>(value));
+    case SQL_C_FLOAT:
+        std::snprintf(buffer, sizeof(buffer), "%.9g", load<SQLREAL>(value));
+        return buffer;
+    case SQL_C_DOUBLE:
+        std::snprintf(buffer, sizeof(buffer), "%.17g", load<SQLDOUBLE>(value));
+        return buffer;
+    case SQL_C_DATE:
+    case SQL_C_TYPE_DATE:
+    {
+        auto const d = load<SQL_DATE_STRUCT>(value);
+        std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", d.year, d.month, d.day);
+        return buffer;
+    }
+    case SQL_C_TIME:
+    case SQL_C_TYPE_TIME:
+    {
+        auto const t = load<SQL_TIME_STRUCT>(value);
+        std::snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", t.hour, t.minute, t.second);
+        return buffer;
+    }
+    case SQL_C_TIMESTAMP:
+    case SQL_C_TYPE_TIMESTAMP:
+    {
+        auto const ts = load<SQL_TIMESTAMP_STRUCT>(value);
+        std::snprintf(
+            buffer,
+            sizeof(buffer),
+            "%04d-%02d-%02d %02d:%02d:%02d",
+            ts.year,
+            ts.month,
+            ts.day,
+            ts.hour,
+            ts.minute,
+            ts.second);
+        return buffer;
+    }
+    default:
+        return "?";
+    }
+}
+
+void close_cursor(statement& stmt)
+{
+    stmt.open = false;
+    stmt.cursor = -1;
+    stmt.rowset_rows = 0;
+    stmt.position = 1;
+    stmt.get_data_row = -1;
+    stmt.text_row = -1;
+}
+
+SQLRETURN execute(statement& stmt)
+{
+    close_cursor(stmt);
+    stmt.row_count = -1;
+    switch (stmt.kind)
+    {
+    case statement::kind_type::none:
+        return fail(stmt, "HY010", "Function sequence error");
+    case statement::kind_type::rows:
+    case statement::kind_type::table_type_columns:
+        sleep_for_latency(stmt);
+        stmt.open = true;
+        return SQL_SUCCESS;
+    case statement::kind_type::calls:
+        stmt.calls.clear();
+        for (std::size_t i = 0; i < static_cast<std::size_t>(mock_function::count); ++i)
+        {
+            auto const n = call_counts[i].load(std::memory_order_relaxed);
+            if (n)
+                stmt.calls.emplace_back(function_names[i], n);
+        }
+        stmt.rows = static_cast<long long>(stmt.calls.size());
+        stmt.open = true;
+        return SQL_SUCCESS;
+    case statement::kind_type::reset:
+        for (auto& count : call_counts)
+            count.store(0, std::memory_order_relaxed);
+        stmt.row_count = 0;
+        return SQL_SUCCESS;
+    case statement::kind_type::parameters:
+    {
+        std::lock_guard<std::mutex> lock(recorded_mutex);
+        stmt.recorded = recorded_parameters;
+        stmt.rows = static_cast<long long>(stmt.recorded.size());
+        stmt.open = true;
+        return SQL_SUCCESS;
+    }
+    case statement::kind_type::record:
+    {
+        std::vector<std::string> recorded;
+        for (SQLULEN set = 0; set < stmt.paramset_size; ++set)
+        {
+            for (SQLSMALLINT i = 0; i < stmt.parameters; ++i)
+            {
+                auto const index = static_cast<std::size_t>(i);
+                if (index >= stmt.parameter_bindings.size())
+                    return fail(stmt, "07002", "COUNT field incorrect");
+                auto const& b = stmt.parameter_bindings[index];
+                if (index != 0 || stmt.tvp_columns.empty())
+                {
+                    recorded.push_back(parameter_text(stmt, b, set));
+                    continue;
+                }
+                // The indicator of a table-valued parameter holds its number of rows.
+                SQLLEN const rows = b.indicator ? *b.indicator : SQL_NULL_DATA;
+                if (rows < 0 || stmt.tvp_bindings.size() < stmt.tvp_columns.size())
+                    return fail(stmt, "07002", "COUNT field incorrect");
+                recorded.push_back("tvp rows=" + std::to_string(rows));
+                for (SQLLEN row = 0; row < rows; ++row)
+                    for (auto const& column : stmt.tvp_bindings)
+                        recorded.push_back(
+                            parameter_text(stmt, column, static_cast<SQLULEN>(row)));
+            }
+        }
+        std::lock_guard<std::mutex> lock(recorded_mutex);
+        recorded_parameters.swap(recorded);
+    }
+        // fall through
+    case statement::kind_type::command:
+        for (SQLULEN i = 0; stmt.param_status && i < stmt.paramset_size; ++i)
+            stmt.param_status[i] = SQL_PARAM_SUCCESS;
+        if (stmt.params_processed)
+            *stmt.params_processed = stmt.paramset_size;
+        stmt.row_count = static_cast<SQLLEN>(stmt.paramset_size);
+        return SQL_SUCCESS;
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN fetch(statement& stmt, SQLSMALLINT orientation, SQLLEN offset)
+{
+    if (!stmt.open)
+        return fail(stmt, "24000", "Invalid cursor state");
+
+    auto const size = static_cast<long long>(std::max<SQLULEN>(stmt.row_array_size, 1));
+    long long first = 0;
+    switch (orientation)
+    {
+    case SQL_FETCH_NEXT:
+        first = stmt.cursor < 0 ? 0 : stmt.cursor + static_cast<long long>(stmt.rowset_rows);
+        if (stmt.cursor >= 0 && stmt.rowset_rows == 0)
+            first = stmt.rows;
+        break;
+    case SQL_FETCH_FIRST:
+        first = 0;
+        break;
+    case SQL_FETCH_LAST:
+        first = std::max(stmt.rows - size, 0LL);
+        break;
+    case SQL_FETCH_PRIOR:
+        first = stmt.cursor - size;
+        break;
+    case SQL_FETCH_ABSOLUTE:
+        first = offset > 0 ? offset - 1 : stmt.rows + offset;
+        break;
+    case SQL_FETCH_RELATIVE:
+        first = stmt.cursor + offset;
+        break;
+    default:
+        return fail(stmt, "HY106", "Fetch type out of range");
+    }
+
+    sleep_for_latency(stmt);
+    stmt.position = 1;
+    stmt.get_data_row = -1;
+    if (first < 0 || first >= stmt.rows)
+    {
+        stmt.cursor = first < 0 ? -1 : stmt.rows;
+        stmt.rowset_rows = 0;
+        if (stmt.rows_fetched)
+            *stmt.rows_fetched = 0;
+        for (long long i = 0; stmt.row_status && i < size; ++i)
+            stmt.row_status[i] = SQL_ROW_NOROW;
+        return SQL_NO_DATA;
+    }
+
+    stmt.cursor = first;
+    stmt.rowset_rows = static_cast<SQLULEN>(std::min(size, stmt.rows - first));
+    if (stmt.rows_fetched)
+        *stmt.rows_fetched = stmt.rowset_rows;
+
+    SQLRETURN rc = SQL_SUCCESS;
+    SQLULEN const bind_offset = stmt.row_bind_offset ? *stmt.row_bind_offset : 0;
+    for (SQLULEN r = 0; r < stmt.rowset_rows; ++r)
+    {
+        SQLRETURN row_rc = SQL_SUCCESS;
+        for (std::size_t c = 0; c < stmt.bindings.size(); ++c)
+        {
+            auto const& b = stmt.bindings[c];
+            if (!b.target && !b.indicator)
+                continue;
+
+            auto* target = static_cast<char*>(b.target);
+            auto* indicator = reinterpret_cast<char*>(b.indicator);
+            std::size_t step = 0;
+            std::size_t indicator_step = sizeof(SQLLEN);
+            if (stmt.row_bind_type == SQL_BIND_BY_COLUMN)
+            {
+                auto const fixed = fixed_size(
+                    b.c_type == SQL_C_DEFAULT ? default_c_type(stmt.columns[c]) : b.c_type);
+                step = fixed ? static_cast<std::size_t>(fixed)
+                             : static_cast<std::size_t>(b.buffer_length);
+            }
+            else
+                step = indicator_step = stmt.row_bind_type;
+            if (target)
+                target += bind_offset + r * step;
+            if (indicator)
+                indicator += bind_offset + r * indicator_step;
+
+            std::size_t from = 0;
+            auto const cell_rc = put_cell(
+                stmt,
+                stmt.cursor + static_cast<long long>(r),
+                static_cast<SQLUSMALLINT>(c + 1),
+                b.c_type,
+                target,
+                b.buffer_length,
+                reinterpret_cast<SQLLEN*>(indicator),
+                from);
+            if (cell_rc == SQL_ERROR)
+                return SQL_ERROR;
+            if (cell_rc == SQL_SUCCESS_WITH_INFO)
+                row_rc = rc = SQL_SUCCESS_WITH_INFO;
+        }
+        if (stmt.row_status)
+            stmt.row_status[r] =
+                row_rc == SQL_SUCCESS ? SQL_ROW_SUCCESS : SQL_ROW_SUCCESS_WITH_INFO;
+    }
+    for (auto r = static_cast<long long>(stmt.rowset_rows); stmt.row_status && r < size; ++r)
+        stmt.row_status[r] = SQL_ROW_NOROW;
+    return rc;
+}
+
+
+// A numeric or string attribute of a result column, as SQLColAttribute and SQLGetDescField on
+// the implementation row descriptor report it.
+bool column_attribute(
+    column_spec const& column,
+    SQLUSMALLINT field,
+    std::string& text,
+    SQLLEN& number)
+{
+    SQLLEN const octets = column.kind == value_kind::wide_text
+                              ? static_cast<SQLLEN>(column.size * sizeof(SQLWCHAR))
+                              : static_cast<SQLLEN>(column.size);
+    switch (field)
+    {
+    case SQL_DESC_NAME:
+    case SQL_DESC_LABEL:
+    case SQL_DESC_BASE_COLUMN_NAME:
+    case SQL_COLUMN_NAME:
+        text = column.name;
+        return true;
+    case SQL_DESC_TYPE_NAME:
+        text = column.type_name;
+        return true;
+    case SQL_DESC_TABLE_NAME:
+    case SQL_DESC_BASE_TABLE_NAME:
+    case SQL_DESC_SCHEMA_NAME:
+    case SQL_DESC_CATALOG_NAME:
+        text.clear();
+        return true;
+    case SQL_DESC_CONCISE_TYPE:
+    case SQL_DESC_TYPE:
+        number = column.sql_type;
+        if (field == SQL_DESC_TYPE && column.kind == value_kind::date)
+            number = SQL_DATETIME;
+        if (field == SQL_DESC_TYPE && column.kind == value_kind::timestamp)
+            number = SQL_DATETIME;
+        return true;
+    case SQL_DESC_LENGTH:
+    case SQL_DESC_DISPLAY_SIZE:
+    case SQL_COLUMN_LENGTH:
+    case SQL_COLUMN_PRECISION:
+        number = static_cast<SQLLEN>(column.size);
+        return true;
+    case SQL_DESC_OCTET_LENGTH:
+        number = octets;
+        return true;
+    case SQL_DESC_PRECISION:
+        number = column.kind == value_kind::timestamp ? column.digits
+                                                      : static_cast<SQLLEN>(column.size);
+        return true;
+    case SQL_DESC_SCALE:
+    case SQL_COLUMN_SCALE:
+        number = column.digits;
+        return true;
+    case SQL_DESC_NULLABLE:
+    case SQL_COLUMN_NULLABLE:
+        number = SQL_NULLABLE;
+        return true;
+    case SQL_DESC_UNSIGNED:
+    case SQL_DESC_AUTO_UNIQUE_VALUE:
+    case SQL_DESC_FIXED_PREC_SCALE:
+    case SQL_DESC_CASE_SENSITIVE:
+        number = SQL_FALSE;
+        return true;
+    case SQL_DESC_UPDATABLE:
+        number = SQL_ATTR_READONLY;
+        return true;
+    case SQL_DESC_SEARCHABLE:
+        number = SQL_PRED_SEARCHABLE;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The file name of the library the driver was loaded from, without its directory.
+std::string driver_file_name()
+{
+#ifdef _WIN32
+    return "nanodbc_mock_driver.dll";
+#else
+    Dl_info info;
+    if (!dladdr(reinterpret_cast<void*>(&driver_file_name), &info) || !info.dli_fname)
+        return "nanodbc_mock_driver";
+    char const* const slash = std::strrchr(info.dli_fname, '/');
+    return slash ? slash + 1 : info.dli_fname;
+#endif
+}
+
+constexpr RETCODE bcp_succeed = 1;
+constexpr RETCODE bcp_fail = 0;
+constexpr int bcp_abort = 6;              // BCPABORT
+constexpr SQLINTEGER bcp_varlen_data = -10; // SQL_VARLEN_DATA
+
+// The C type of the program variables a bulk copy type token stands for.
+SQLSMALLINT bcp_c_type(int type)
+{
+    switch (type)
+    {
+    case 0x30:
+        return SQL_C_UTINYINT;
+    case 0x34:
+        return SQL_C_SSHORT;
+    case 0x38:
+        return SQL_C_SLONG;
+    case 0x7f:
+        return SQL_C_SBIGINT;
+    case 0x3b:
+        return SQL_C_FLOAT;
+    case 0x3e:
+        return SQL_C_DOUBLE;
+    case 0x28:
+        return SQL_C_TYPE_DATE;
+    case 0x2a:
+        return SQL_C_TYPE_TIMESTAMP;
+    case 0x2f:
+        return SQL_C_CHAR;
+    case 0xef:
+        return SQL_C_WCHAR;
+    default:
+        return 0;
+    }
+}
+
+// Returns the connection, if BCP is enabled on it and a copy is or is not in progress as the
+// function called expects.
+connection* bcp_connection(SQLHDBC hdbc, bool copying)
+{
+    auto* dbc = checked<connection>(hdbc, SQL_HANDLE_DBC);
+    if (!dbc)
+        return nullptr;
+    auto const bcp = dbc->attributes.find(1219);
+    if (bcp == dbc->attributes.end() || bcp->second != 1 || dbc->copying != copying)
+    {
+        fail(*dbc, "HY010", "Function sequence error");
+        return nullptr;
+    }
+    return dbc;
+}
+
+RETCODE bcp_start(SQLHDBC hdbc, std::string const& table)
+{
+    auto* dbc = bcp_connection(hdbc, false);
+    if (!dbc)
+        return bcp_fail;
+    statement described;
+    if (parse(described, table) != SQL_SUCCESS || described.kind != statement::kind_type::rows)
+    {
+        fail(*dbc, "42S02", "Invalid object name: " + table);
+        return bcp_fail;
+    }
+    dbc->copying = true;
+    dbc->bcp_columns.clear();
+    dbc->bcp_values.clear();
+    dbc->bcp_rows = 0;
+    std::lock_guard<std::mutex> lock(recorded_mutex);
+    recorded_parameters.clear();
+    return bcp_succeed;
+}
+
+SQLINTEGER bcp_commit(connection& dbc)
+{
+    std::lock_guard<std::mutex> lock(recorded_mutex);
+    recorded_parameters.insert(
+        recorded_parameters.end(), dbc.bcp_values.begin(), dbc.bcp_values.end());
+    dbc.bcp_values.clear();
+    return std::exchange(dbc.bcp_rows, 0);
+}
+
+} // namespace
+
+
+extern "C" {
+
+SQLRETURN SQL_API SQLAllocHandle(SQLSMALLINT type, SQLHANDLE input, SQLHANDLE* output)
+{
+    NANODBC_MOCK_COUNT(SQLAllocHandle);
+    if (!output)
+        return SQL_ERROR;
+    switch (type)
+    {
+    case SQL_HANDLE_ENV:
+        *output = new environment();
+        return SQL_SUCCESS;
+    case SQL_HANDLE_DBC:
+        if (!checked<environment>(input, SQL_HANDLE_ENV))
+            return SQL_INVALID_HANDLE;
+        *output = new connection();
+        return SQL_SUCCESS;
+    case SQL_HANDLE_STMT:
+    {
+        auto* dbc = checked<connection>(input, SQL_HANDLE_DBC);
+        if (!dbc)
+            return SQL_INVALID_HANDLE;
+        if (!dbc->connected)
+            return fail(*dbc, "08003", "Connection not open");
+        *output = new statement();
+        return SQL_SUCCESS;
+    }
+    default:
+        *output = SQL_NULL_HANDLE;
+        return SQL_ERROR;
+    }
+}
+
+SQLRETURN SQL_API SQLFreeHandle(SQLSMALLINT type, SQLHANDLE h)
+{
+    NANODBC_MOCK_COUNT(SQLFreeHandle);
+    switch (type)
+    {
+    case SQL_HANDLE_ENV:
+        if (auto* env = checked<environment>(h, type))
+        {
+            delete env;
+            return SQL_SUCCESS;
+        }
+        break;
+    case SQL_HANDLE_DBC:
+        if (auto* dbc = checked<connection>(h, type))
+        {
+            delete dbc;
+            return SQL_SUCCESS;
+        }
+        break;
+    case SQL_HANDLE_STMT:
+        if (auto* stmt = checked<statement>(h, type))
+        {
+            delete stmt;
+            return SQL_SUCCESS;
+        }
+        break;
+    }
+    return SQL_INVALID_HANDLE;
+}
+
+SQLRETURN SQL_API
+SQLSetEnvAttr(SQLHENV henv, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER /*length*/)
+{
+    NANODBC_MOCK_COUNT(SQLSetEnvAttr);
+    auto* env = checked<environment>(henv, SQL_HANDLE_ENV);
+    if (!env)
+        return SQL_INVALID_HANDLE;
+    if (attribute == SQL_ATTR_ODBC_VERSION)
+        env->odbc_version = static_cast<SQLINTEGER>(reinterpret_cast<SQLLEN>(value));
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLGetEnvAttr(
+    SQLHENV henv,
+    SQLINTEGER attribute,
+    SQLPOINTER value,
+    SQLINTEGER /*buffer_length*/,
+    SQLINTEGER* /*length*/)
+{
+    NANODBC_MOCK_COUNT(SQLGetEnvAttr);
+    auto* env = checked<environment>(henv, SQL_HANDLE_ENV);
+    if (!env)
+        return SQL_INVALID_HANDLE;
+    if (attribute == SQL_ATTR_ODBC_VERSION && value)
+        store(value, env->odbc_version);
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLDriverConnect(
+    SQLHDBC hdbc,
+    SQLHWND /*window*/,
+    SQLCHAR* in,
+    SQLSMALLINT in_length,
+    SQLCHAR* out,
+    SQLSMALLINT out_size,
+    SQLSMALLINT* out_length,
+    SQLUSMALLINT /*completion*/)
+{
+    NANODBC_MOCK_COUNT(SQLDriverConnect);
+    auto* dbc = checked<connection>(hdbc, SQL_HANDLE_DBC);
+    if (!dbc)
+        return SQL_INVALID_HANDLE;
+    if (dbc->connected)
+        return fail(*dbc, "08002", "Connection name in use");
+    dbc->connected = true;
+    return copy_out(*dbc, text_argument(in, in_length), out, out_size, out_length);
+}
+
+SQLRETURN SQL_API SQLConnect(
+    SQLHDBC hdbc,
+    SQLCHAR* /*dsn*/,
+    SQLSMALLINT /*dsn_length*/,
+    SQLCHAR* /*user*/,
+    SQLSMALLINT /*user_length*/,
+    SQLCHAR* /*password*/,
+    SQLSMALLINT /*password_length*/)
+{
+    NANODBC_MOCK_COUNT(SQLConnect);
+    auto* dbc = checked<connection>(hdbc, SQL_HANDLE_DBC);
+    if (!dbc)
+        return SQL_INVALID_HANDLE;
+    if (dbc->connected)
+        return fail(*dbc, "08002", "Connection name in use");
+    dbc->connected = true;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLDisconnect(SQLHDBC hdbc)
+{
+    NANODBC_MOCK_COUNT(SQLDisconnect);
+    auto* dbc = checked<connection>(hdbc, SQL_HANDLE_DBC);
+    if (!dbc)
+        return SQL_INVALID_HANDLE;
+    dbc->connected = false;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLGetInfo(
+    SQLHDBC hdbc,
+    SQLUSMALLINT type,
+    SQLPOINTER value,
+    SQLSMALLINT buffer_length,
+    SQLSMALLINT* length)
+{
+    NANODBC_MOCK_COUNT(SQLGetInfo);
+    auto* dbc = checked<connection>(hdbc, SQL_HANDLE_DBC);
+    if (!dbc)
+        return SQL_INVALID_HANDLE;
+
+    auto const text = [&](char const* s) {
+        return copy_out(*dbc, s, value, buffer_length, length);
+    };
+    auto const small = [&](SQLUSMALLINT n) {
+        if (value)
+            store(value, n);
+        if (length)
+            *length = sizeof(n);
+        return SQL_SUCCESS;
+    };
+    auto const mask = [&](SQLUINTEGER n) {
+        if (value)
+            store(value, n);
+        if (length)
+            *length = sizeof(n);
+        return SQL_SUCCESS;
+    };
+
+    switch (type)
+    {
+    case SQL_DBMS_NAME:
+        return text("nanodbc mock");
+    case SQL_DBMS_VER:
+    case SQL_DRIVER_VER:
+        return text("01.00.0000");
+    case SQL_DRIVER_NAME:
+        return text(driver_file_name().c_str());
+    case SQL_DRIVER_ODBC_VER:
+        return text("03.80");
+    case SQL_DATABASE_NAME:
+    case SQL_SERVER_NAME:
+        return text("mock");
+    case SQL_DATA_SOURCE_NAME:
+    case SQL_USER_NAME:
+        return text("");
+    case SQL_IDENTIFIER_QUOTE_CHAR:
+        return text("\"");
+    case SQL_CATALOG_NAME_SEPARATOR:
+        return text(".");
+    case SQL_SEARCH_PATTERN_ESCAPE:
+        return text("\\");
+    case SQL_DATA_SOURCE_READ_ONLY:
+        return text("N");
+    case SQL_TXN_CAPABLE:
+        return small(SQL_TC_ALL);
+    case SQL_CURSOR_COMMIT_BEHAVIOR:
+    case SQL_CURSOR_ROLLBACK_BEHAVIOR:
+        return small(SQL_CB_PRESERVE);
+    case SQL_MAX_CONCURRENT_ACTIVITIES:
+    case SQL_MAX_DRIVER_CONNECTIONS:
+        return small(0);
+    case SQL_GETDATA_EXTENSIONS:
+        return mask(SQL_GD_ANY_COLUMN | SQL_GD_ANY_ORDER | SQL_GD_BLOCK | SQL_GD_BOUND);
+    case SQL_SCROLL_OPTIONS:
+        return mask(SQL_SO_FORWARD_ONLY | SQL_SO_STATIC);
+    case SQL_PARAM_ARRAY_ROW_COUNTS:
+        return mask(SQL_PARC_BATCH);
+    case SQL_PARAM_ARRAY_SELECTS:
+        return mask(SQL_PAS_NO_SELECT);
+    case SQL_ASYNC_MODE:
+        return mask(SQL_AM_NONE);
+    case SQL_DEFAULT_TXN_ISOLATION:
+    case SQL_TXN_ISOLATION_OPTION:
+        return mask(SQL_TXN_READ_COMMITTED);
+    case SQL_ODBC_INTERFACE_CONFORMANCE:
+        return mask(SQL_OIC_CORE);
+    default:
+        return fail(*dbc, "HY096", "Information type out of range");
+    }
+}
+
+SQLRETURN SQL_API
+SQLSetConnectAttr(SQLHDBC hdbc, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER /*length*/)
+{
+    NANODBC_MOCK_COUNT(SQLSetConnectAttr);
+    auto* dbc = checked<connection>(hdbc, SQL_HANDLE_DBC);
+    if (!dbc)
+        return SQL_INVALID_HANDLE;
+    if (attribute == SQL_ATTR_CURRENT_CATALOG)
+        return SQL_SUCCESS;
+    dbc->attributes[attribute] = static_cast<SQLULEN>(reinterpret_cast<SQLLEN>(value));
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLGetConnectAttr(
+    SQLHDBC hdbc,
+    SQLINTEGER attribute,
+    SQLPOINTER value,
+    SQLINTEGER buffer_length,
+    SQLINTEGER* length)
+{
+    NANODBC_MOCK_COUNT(SQLGetConnectAttr);
+    auto* dbc = checked<connection>(hdbc, SQL_HANDLE_DBC);
+    if (!dbc)
+        return SQL_INVALID_HANDLE;
+    if (attribute == SQL_ATTR_CURRENT_CATALOG)
+        return copy_out(*dbc, "mock", value, buffer_length, length);
+    if (attribute == SQL_ATTR_CONNECTION_DEAD)
+    {
+        if (value)
+            store(value, static_cast<SQLUINTEGER>(dbc->connected ? SQL_CD_FALSE : SQL_CD_TRUE));
+        return SQL_SUCCESS;
+    }
+    auto const found = dbc->attributes.find(attribute);
+    if (value)
+        store(value, static_cast<SQLUINTEGER>(found == dbc->attributes.end() ? 0 : found->second));
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLEndTran(SQLSMALLINT type, SQLHANDLE h, SQLSMALLINT /*completion*/)
+{
+    NANODBC_MOCK_COUNT(SQLEndTran);
+    if (!checked<handle>(h, type))
+        return SQL_INVALID_HANDLE;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLPrepare(SQLHSTMT hstmt, SQLCHAR* text, SQLINTEGER length)
+{
+    NANODBC_MOCK_COUNT(SQLPrepare);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    close_cursor(*stmt);
+    return parse(*stmt, text_argument(text, length));
+}
+
+SQLRETURN SQL_API SQLExecute(SQLHSTMT hstmt)
+{
+    NANODBC_MOCK_COUNT(SQLExecute);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    return execute(*stmt);
+}
+
+SQLRETURN SQL_API SQLExecDirect(SQLHSTMT hstmt, SQLCHAR* text, SQLINTEGER length)
+{
+    NANODBC_MOCK_COUNT(SQLExecDirect);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    close_cursor(*stmt);
+    auto const rc = parse(*stmt, text_argument(text, length));
+    if (rc != SQL_SUCCESS)
+        return rc;
+    return execute(*stmt);
+}
+
+// Lists the columns of a table type, whose name is the list of their types; see above.
+SQLRETURN SQL_API SQLColumns(
+    SQLHSTMT hstmt,
+    SQLCHAR* /*catalog*/,
+    SQLSMALLINT /*catalog_length*/,
+    SQLCHAR* /*schema*/,
+    SQLSMALLINT /*schema_length*/,
+    SQLCHAR* table,
+    SQLSMALLINT table_length,
+    SQLCHAR* /*column*/,
+    SQLSMALLINT /*column_length*/)
+{
+    NANODBC_MOCK_COUNT(SQLColumns);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    close_cursor(*stmt);
+    auto const rc = parse(*stmt, std::string());
+    if (rc != SQL_SUCCESS)
+        return rc;
+    stmt->tvp_type = lowercase(text_argument(table, table_length));
+    if (!parse_columns(stmt->tvp_type, stmt->tvp_columns))
+        return fail(*stmt, "42S02", "Base table or view not found");
+
+    static char const* const names[] = {
+        "TABLE_CAT",
+        "TABLE_SCHEM",
+        "TABLE_NAME",
+        "COLUMN_NAME",
+        "DATA_TYPE",
+        "TYPE_NAME",
+        "COLUMN_SIZE",
+        "BUFFER_LENGTH",
+        "DECIMAL_DIGITS"};
+    for (std::size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i)
+    {
+        column_spec column;
+        parse_column(
+            i == 4 || i == 8 ? "smallint" : i == 6 || i == 7 ? "int" : "varchar(128)", i, column);
+        column.name = names[i];
+        stmt->columns.push_back(column);
+    }
+    stmt->kind = statement::kind_type::table_type_columns;
+    stmt->rows = static_cast<long long>(stmt->tvp_columns.size());
+    stmt->open = true;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLNumParams(SQLHSTMT hstmt, SQLSMALLINT* count)
+{
+    NANODBC_MOCK_COUNT(SQLNumParams);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (count)
+        *count = stmt->parameters;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLDescribeParam(
+    SQLHSTMT hstmt,
+    SQLUSMALLINT number,
+    SQLSMALLINT* type,
+    SQLULEN* size,
+    SQLSMALLINT* digits,
+    SQLSMALLINT* nullable)
+{
+    NANODBC_MOCK_COUNT(SQLDescribeParam);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (number < 1 || number > stmt->parameters)
+        return fail(*stmt, "07009", "Invalid descriptor index");
+    bool const tvp = number == 1 && !stmt->tvp_columns.empty();
+    if (type)
+        *type = tvp ? ss_table : SQLSMALLINT{SQL_VARCHAR};
+    if (size)
+        *size = tvp ? 0 : 255;
+    if (digits)
+        *digits = 0;
+    if (nullable)
+        *nullable = SQL_NULLABLE;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLBindParameter(
+    SQLHSTMT hstmt,
+    SQLUSMALLINT number,
+    SQLSMALLINT /*direction*/,
+    SQLSMALLINT c_type,
+    SQLSMALLINT /*sql_type*/,
+    SQLULEN /*size*/,
+    SQLSMALLINT /*digits*/,
+    SQLPOINTER value,
+    SQLLEN buffer_length,
+    SQLLEN* indicator)
+{
+    NANODBC_MOCK_COUNT(SQLBindParameter);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (number < 1)
+        return fail(*stmt, "07009", "Invalid descriptor index");
+    // With the focus on a table-valued parameter, the number is that of one of its columns.
+    auto const focus = stmt->attributes.find(ss_param_focus);
+    bool const tvp_column = focus != stmt->attributes.end() && focus->second != 0;
+    if (tvp_column && (focus->second != 1 || number > stmt->tvp_columns.size()))
+        return fail(*stmt, "07009", "Invalid descriptor index");
+    auto& bindings = tvp_column ? stmt->tvp_bindings : stmt->parameter_bindings;
+    if (bindings.size() < number)
+        bindings.resize(number, binding{SQL_C_DEFAULT, nullptr, 0, nullptr});
+    bindings[number - 1u] = binding{c_type, value, buffer_length, indicator};
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLNumResultCols(SQLHSTMT hstmt, SQLSMALLINT* count)
+{
+    NANODBC_MOCK_COUNT(SQLNumResultCols);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (count)
+        *count = static_cast<SQLSMALLINT>(stmt->columns.size());
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLDescribeCol(
+    SQLHSTMT hstmt,
+    SQLUSMALLINT number,
+    SQLCHAR* name,
+    SQLSMALLINT name_size,
+    SQLSMALLINT* name_length,
+    SQLSMALLINT* type,
+    SQLULEN* size,
+    SQLSMALLINT* digits,
+    SQLSMALLINT* nullable)
+{
+    NANODBC_MOCK_COUNT(SQLDescribeCol);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (number < 1 || number > stmt->columns.size())
+        return fail(*stmt, "07009", "Invalid descriptor index");
+    auto const& column = stmt->columns[number - 1u];
+    if (type)
+        *type = column.sql_type;
+    if (size)
+        *size = column.size;
+    if (digits)
+        *digits = column.digits;
+    if (nullable)
+        *nullable = SQL_NULLABLE;
+    return copy_out(*stmt, column.name, name, name_size, name_length);
+}
+
+SQLRETURN SQL_API SQLColAttribute(
+    SQLHSTMT hstmt,
+    SQLUSMALLINT number,
+    SQLUSMALLINT field,
+    SQLPOINTER text_value,
+    SQLSMALLINT buffer_length,
+    SQLSMALLINT* length,
+    SQLLEN* number_value)
+{
+    NANODBC_MOCK_COUNT(SQLColAttribute);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (field == SQL_DESC_COUNT || field == SQL_COLUMN_COUNT)
+    {
+        if (number_value)
+            *number_value = static_cast<SQLLEN>(stmt->columns.size());
+        return SQL_SUCCESS;
+    }
+    if (number < 1 || number > stmt->columns.size())
+        return fail(*stmt, "07009", "Invalid descriptor index");
+
+    std::string text;
+    SQLLEN n = 0;
+    if (!column_attribute(stmt->columns[number - 1u], field, text, n))
+        return fail(*stmt, "HY091", "Invalid descriptor field identifier");
+    if (number_value)
+        *number_value = n;
+    return copy_out(*stmt, text, text_value, buffer_length, length);
+}
+
+SQLRETURN SQL_API SQLBindCol(
+    SQLHSTMT hstmt,
+    SQLUSMALLINT number,
+    SQLSMALLINT c_type,
+    SQLPOINTER target,
+    SQLLEN buffer_length,
+    SQLLEN* indicator)
+{
+    NANODBC_MOCK_COUNT(SQLBindCol);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (number < 1)
+        return fail(*stmt, "07009", "Invalid descriptor index");
+    if (stmt->bindings.size() < number)
+        stmt->bindings.resize(number, binding{SQL_C_DEFAULT, nullptr, 0, nullptr});
+    stmt->bindings[number - 1u] = binding{c_type, target, buffer_length, indicator};
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLFetch(SQLHSTMT hstmt)
+{
+    NANODBC_MOCK_COUNT(SQLFetch);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    return fetch(*stmt, SQL_FETCH_NEXT, 0);
+}
+
+SQLRETURN SQL_API SQLFetchScroll(SQLHSTMT hstmt, SQLSMALLINT orientation, SQLLEN offset)
+{
+    NANODBC_MOCK_COUNT(SQLFetchScroll);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    return fetch(*stmt, orientation, offset);
+}
+
+SQLRETURN SQL_API SQLGetData(
+    SQLHSTMT hstmt,
+    SQLUSMALLINT number,
+    SQLSMALLINT c_type,
+    SQLPOINTER target,
+    SQLLEN buffer_length,
+    SQLLEN* indicator)
+{
+    NANODBC_MOCK_COUNT(SQLGetData);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (!stmt->open || stmt->cursor < 0 || stmt->rowset_rows == 0)
+        return fail(*stmt, "24000", "Invalid cursor state");
+    if (number < 1 || number > stmt->columns.size())
+        return fail(*stmt, "07009", "Invalid descriptor index");
+
+    auto const row = stmt->cursor + static_cast<long long>(stmt->position) - 1;
+    if (stmt->get_data_row != row || stmt->get_data_column != number)
+    {
+        stmt->get_data_row = row;
+        stmt->get_data_column = number;
+        stmt->get_data_offset = 0;
+        stmt->get_data_done = false;
+    }
+    if (stmt->get_data_done)
+        return SQL_NO_DATA;
+
+    auto const rc = put_cell(
+        *stmt, row, number, c_type, target, buffer_length, indicator, stmt->get_data_offset);
+    // A fixed size value, a null or the last piece of a long one has been read in full.
+    if (rc == SQL_SUCCESS)
+        stmt->get_data_done = true;
+    return rc;
+}
+
+SQLRETURN SQL_API
+SQLSetPos(SQLHSTMT hstmt, SQLSETPOSIROW row, SQLUSMALLINT operation, SQLUSMALLINT /*lock*/)
+{
+    NANODBC_MOCK_COUNT(SQLSetPos);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (operation != SQL_POSITION)
+        return fail(*stmt, "HYC00", "Optional feature not implemented");
+    if (row < 1 || row > stmt->rowset_rows)
+        return fail(*stmt, "HY107", "Row value out of range");
+    stmt->position = row;
+    stmt->get_data_row = -1;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLRowCount(SQLHSTMT hstmt, SQLLEN* count)
+{
+    NANODBC_MOCK_COUNT(SQLRowCount);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (count)
+        *count = stmt->row_count;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLMoreResults(SQLHSTMT hstmt)
+{
+    NANODBC_MOCK_COUNT(SQLMoreResults);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    close_cursor(*stmt);
+    return SQL_NO_DATA;
+}
+
+SQLRETURN SQL_API SQLFreeStmt(SQLHSTMT hstmt, SQLUSMALLINT option)
+{
+    NANODBC_MOCK_COUNT(SQLFreeStmt);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    switch (option)
+    {
+    case SQL_CLOSE:
+        close_cursor(*stmt);
+        break;
+    case SQL_UNBIND:
+        stmt->bindings.clear();
+        break;
+    case SQL_RESET_PARAMS:
+        stmt->parameter_bindings.clear();
+        break;
+    case SQL_DROP:
+        delete stmt;
+        break;
+    default:
+        return fail(*stmt, "HY092", "Invalid attribute/option identifier");
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLCloseCursor(SQLHSTMT hstmt)
+{
+    NANODBC_MOCK_COUNT(SQLCloseCursor);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (!stmt->open)
+        return fail(*stmt, "24000", "Invalid cursor state");
+    close_cursor(*stmt);
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLCancel(SQLHSTMT hstmt)
+{
+    NANODBC_MOCK_COUNT(SQLCancel);
+    if (!checked<statement>(hstmt, SQL_HANDLE_STMT))
+        return SQL_INVALID_HANDLE;
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API
+SQLSetStmtAttr(SQLHSTMT hstmt, SQLINTEGER attribute, SQLPOINTER value, SQLINTEGER /*length*/)
+{
+    NANODBC_MOCK_COUNT(SQLSetStmtAttr);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    auto const integer = static_cast<SQLULEN>(reinterpret_cast<SQLLEN>(value));
+    switch (attribute)
+    {
+    case SQL_ATTR_ROW_ARRAY_SIZE:
+        stmt->row_array_size = integer;
+        break;
+    case SQL_ATTR_ROW_BIND_TYPE:
+        stmt->row_bind_type = integer;
+        break;
+    case SQL_ATTR_ROW_BIND_OFFSET_PTR:
+        stmt->row_bind_offset = static_cast<SQLULEN*>(value);
+        break;
+    case SQL_ATTR_ROW_STATUS_PTR:
+        stmt->row_status = static_cast<SQLUSMALLINT*>(value);
+        break;
+    case SQL_ATTR_ROWS_FETCHED_PTR:
+        stmt->rows_fetched = static_cast<SQLULEN*>(value);
+        break;
+    case SQL_ATTR_PARAMSET_SIZE:
+        stmt->paramset_size = integer;
+        break;
+    case SQL_ATTR_PARAM_BIND_TYPE:
+        stmt->param_bind_type = integer;
+        break;
+    case SQL_ATTR_PARAM_BIND_OFFSET_PTR:
+        stmt->param_bind_offset = static_cast<SQLULEN*>(value);
+        break;
+    case SQL_ATTR_PARAM_STATUS_PTR:
+        stmt->param_status = static_cast<SQLUSMALLINT*>(value);
+        break;
+    case SQL_ATTR_PARAMS_PROCESSED_PTR:
+        stmt->params_processed = static_cast<SQLULEN*>(value);
+        break;
+    case SQL_ATTR_ASYNC_ENABLE:
+        if (integer != SQL_ASYNC_ENABLE_OFF)
+            return fail(*stmt, "HYC00", "Optional feature not implemented");
+        break;
+    default:
+        stmt->attributes[attribute] = integer;
+        break;
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLGetStmtAttr(
+    SQLHSTMT hstmt,
+    SQLINTEGER attribute,
+    SQLPOINTER value,
+    SQLINTEGER /*buffer_length*/,
+    SQLINTEGER* /*length*/)
+{
+    NANODBC_MOCK_COUNT(SQLGetStmtAttr);
+    auto* stmt = checked<statement>(hstmt, SQL_HANDLE_STMT);
+    if (!stmt)
+        return SQL_INVALID_HANDLE;
+    if (!value)
+        return SQL_SUCCESS;
+    switch (attribute)
+    {
+    case SQL_ATTR_APP_ROW_DESC:
+        store(value, static_cast<SQLHDESC>(&stmt->ard));
+        break;
+    case SQL_ATTR_APP_PARAM_DESC:
+        store(value, static_cast<SQLHDESC>(&stmt->apd));
+        break;
+    case SQL_ATTR_IMP_ROW_DESC:
+        store(value, static_cast<SQLHDESC>(&stmt->ird));
+        break;
+    case SQL_ATTR_IMP_PARAM_DESC:
+        store(value, static_cast<SQLHDESC>(&stmt->ipd));
+        break;
+    case SQL_ATTR_ROW_ARRAY_SIZE:
+        store(value, stmt->row_array_size);
+        break;
+    case SQL_ATTR_ROW_BIND_TYPE:
+        store(value, stmt->row_bind_type);
+        break;
+    case SQL_ATTR_ROW_BIND_OFFSET_PTR:
+        store(value, static_cast<SQLPOINTER>(stmt->row_bind_offset));
+        break;
+    case SQL_ATTR_ROW_STATUS_PTR:
+        store(value, static_cast<SQLPOINTER>(stmt->row_status));
+        break;
+    case SQL_ATTR_ROWS_FETCHED_PTR:
+        store(value, static_cast<SQLPOINTER>(stmt->rows_fetched));
+        break;
+    case SQL_ATTR_PARAMSET_SIZE:
+        store(value, stmt->paramset_size);
+        break;
+    case SQL_ATTR_PARAM_STATUS_PTR:
+        store(value, static_cast<SQLPOINTER>(stmt->param_status));
+        break;
+    case SQL_ATTR_PARAMS_PROCESSED_PTR:
+        store(value, static_cast<SQLPOINTER>(stmt->params_processed));
+        break;
+    case SQL_ATTR_PARAM_BIND_TYPE:
+        store(value, stmt->param_bind_type);
+        break;
+    case SQL_ATTR_PARAM_BIND_OFFSET_PTR:
+        store(value, static_cast<SQLPOINTER>(stmt->param_bind_offset));
+        break;
+    case SQL_ATTR_ROW_NUMBER:
+        if (!stmt->open || stmt->cursor < 0 || stmt->rowset_rows == 0)
+            return fail(*stmt, "24000", "Invalid cursor state");
+        store(value, static_cast<SQLULEN>(stmt->cursor + static_cast<long long>(stmt->position)));
+        break;
+    default:
+    {
+        auto const found = stmt->attributes.find(attribute);
+        store(value, found == stmt->attributes.end() ? SQLULEN{0} : found->second);
+        break;
+    }
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLGetDescField(
+    SQLHDESC hdesc,
+    SQLSMALLINT record,
+    SQLSMALLINT field,
+    SQLPOINTER value,
+    SQLINTEGER buffer_length,
+    SQLINTEGER* length)
+{
+    NANODBC_MOCK_COUNT(SQLGetDescField);
+    auto* desc = checked<descriptor>(hdesc, SQL_HANDLE_DESC);
+    if (!desc)
+        return SQL_INVALID_HANDLE;
+    auto const& stmt = desc->owner;
+
+    SQLSMALLINT count = 0;
+    if (desc->role == descriptor::implementation_row)
+        count = static_cast<SQLSMALLINT>(stmt.columns.size());
+    else if (desc->role == descriptor::implementation_parameter)
+        count = stmt.parameters;
+    if (record == 0)
+    {
+        if (field != SQL_DESC_COUNT)
+            return fail(*desc, "HY091", "Invalid descriptor field identifier");
+        if (value)
+            store(value, count);
+        return SQL_SUCCESS;
+    }
+    if (record < 0 || record > count)
+        return fail(*desc, "07009", "Invalid descriptor index");
+    if (field == ss_type_name)
+    {
+        if (desc->role != descriptor::implementation_parameter || record != 1 ||
+            stmt.tvp_columns.empty())
+            return fail(*desc, "HY091", "Invalid descriptor field identifier");
+        return copy_out(*desc, stmt.tvp_type, value, buffer_length, length);
+    }
+
+    column_spec parameter;
+    parse_column("varchar(255)", static_cast<std::size_t>(record - 1), parameter);
+    auto const& column = desc->role == descriptor::implementation_row
+                             ? stmt.columns[static_cast<std::size_t>(record - 1)]
+                             : parameter;
+    std::string text;
+    SQLLEN n = 0;
+    if (!column_attribute(column, static_cast<SQLUSMALLINT>(field), text, n))
+        return fail(*desc, "HY091", "Invalid descriptor field identifier");
+
+    switch (field)
+    {
+    case SQL_DESC_NAME:
+    case SQL_DESC_LABEL:
+    case SQL_DESC_BASE_COLUMN_NAME:
+    case SQL_DESC_TYPE_NAME:
+    case SQL_DESC_TABLE_NAME:
+    case SQL_DESC_BASE_TABLE_NAME:
+    case SQL_DESC_SCHEMA_NAME:
+    case SQL_DESC_CATALOG_NAME:
+        return copy_out(*desc, text, value, buffer_length, length);
+    case SQL_DESC_LENGTH:
+        if (value)
+            store(value, static_cast<SQLULEN>(n));
+        break;
+    case SQL_DESC_OCTET_LENGTH:
+    case SQL_DESC_DISPLAY_SIZE:
+        if (value)
+            store(value, n);
+        break;
+    case SQL_DESC_AUTO_UNIQUE_VALUE:
+    case SQL_DESC_CASE_SENSITIVE:
+        if (value)
+            store(value, static_cast<SQLINTEGER>(n));
+        break;
+    default:
+        if (value)
+            store(value, static_cast<SQLSMALLINT>(n));
+        break;
+    }
+    return SQL_SUCCESS;
+}
+
+SQLRETURN SQL_API SQLGetDiagRec(
+    SQLSMALLINT type,
+    SQLHANDLE h,
+    SQLSMALLINT record,
+    SQLCHAR* state,
+    SQLINTEGER* native,
+    SQLCHAR* message,
+    SQLSMALLINT message_size,
+    SQLSMALLINT* message_length)
+{
+    NANODBC_MOCK_COUNT(SQLGetDiagRec);
+    auto* p = static_cast<handle*>(h);
+    if (!p || p->type != type)
+        return SQL_INVALID_HANDLE;
+    if (record < 1)
+        return SQL_ERROR;
+    if (static_cast<std::size_t>(record) > p->diagnostics.size())
+        return SQL_NO_DATA;
+    auto const& diag = p->diagnostics[static_cast<std::size_t>(record - 1)];
+    if (state)
+        std::memcpy(state, diag.state.c_str(), 6);
+    if (native)
+        *native = 0;
+    // Reading a record must not leave one of its own.
+    std::vector<diagnostic> kept;
+    kept.swap(p->diagnostics);
+    auto const rc = copy_out(*p, diag.message, message, message_size, message_length);
+    p->diagnostics.swap(kept);
+    return rc;
+}
+
+SQLRETURN SQL_API SQLGetDiagField(
+    SQLSMALLINT type,
+    SQLHANDLE h,
+    SQLSMALLINT record,
+    SQLSMALLINT field,
+    SQLPOINTER value,
+    SQLSMALLINT buffer_length,
+    SQLSMALLINT* length)
+{
+    NANODBC_MOCK_COUNT(SQLGetDiagField);
+    auto* p = static_cast<handle*>(h);
+    if (!p || p->type != type)
+        return SQL_INVALID_HANDLE;
+
+    if (record == 0)
+    {
+        if (field == SQL_DIAG_NUMBER && value)
+            store(value, static_cast<SQLINTEGER>(p->diagnostics.size()));
+        else if (field == SQL_DIAG_RETURNCODE && value)
+            store(value, static_cast<SQLRETURN>(SQL_SUCCESS));
+        else if (field == SQL_DIAG_ROW_COUNT && value)
+            store(value, SQLLEN{0});
+        return SQL_SUCCESS;
+    }
+    if (record < 0 || static_cast<std::size_t>(record) > p->diagnostics.size())
+        return SQL_NO_DATA;
+
+    auto const diag = p->diagnostics[static_cast<std::size_t>(record - 1)];
+    std::vector<diagnostic> kept;
+    kept.swap(p->diagnostics);
+    SQLRETURN rc = SQL_SUCCESS;
+    switch (field)
+    {
+    case SQL_DIAG_SQLSTATE:
+        rc = copy_out(*p, diag.state, value, buffer_length, length);
+        break;
+    case SQL_DIAG_MESSAGE_TEXT:
+        rc = copy_out(*p, diag.message, value, buffer_length, length);
+        break;
+    case SQL_DIAG_CLASS_ORIGIN:
+    case SQL_DIAG_SUBCLASS_ORIGIN:
+        rc = copy_out(*p, "ISO 9075", value, buffer_length, length);
+        break;
+    case SQL_DIAG_CONNECTION_NAME:
+        rc = copy_out(*p, "", value, buffer_length, length);
+        break;
+    case SQL_DIAG_SERVER_NAME:
+        rc = copy_out(*p, "mock", value, buffer_length, length);
+        break;
+    case SQL_DIAG_NATIVE:
+        if (value)
+            store(value, SQLINTEGER{0});
+        break;
+    case SQL_DIAG_ROW_NUMBER:
+        if (value)
+            store(value, static_cast<SQLLEN>(SQL_ROW_NUMBER_UNKNOWN));
+        break;
+    case SQL_DIAG_COLUMN_NUMBER:
+        if (value)
+            store(value, static_cast<SQLINTEGER>(SQL_COLUMN_NUMBER_UNKNOWN));
+        break;
+    default:
+        rc = SQL_ERROR;
+        break;
+    }
+    p->diagnostics.swap(kept);
+    return rc;
+}
+
+RETCODE SQL_API bcp_initA(SQLHDBC hdbc, char const* table, char const*, char const*, int)
+{
+    NANODBC_MOCK_COUNT(bcp_init);
+    return bcp_start(hdbc, table ? table : "");
+}
+
+RETCODE SQL_API
+bcp_initW(SQLHDBC hdbc, SQLWCHAR const* table, SQLWCHAR const*, SQLWCHAR const*, int)
+{
+    NANODBC_MOCK_COUNT(bcp_init);
+    std::string narrow;
+    for (; table && *table; ++table)
+        narrow += static_cast<char>(*table);
+    return bcp_start(hdbc, narrow);
+}
+
+RETCODE SQL_API bcp_bind(
+    SQLHDBC hdbc,
+    unsigned char const* data,
+    int /*prefix_length*/,
+    SQLINTEGER length,
+    unsigned char const* /*terminator*/,
+    int /*terminator_length*/,
+    int type,
+    int ordinal)
+{
+    NANODBC_MOCK_COUNT(bcp_bind);
+    auto* dbc = bcp_connection(hdbc, true);
+    if (!dbc)
+        return bcp_fail;
+    bcp_column& column = dbc->bcp_columns[ordinal];
+    column.data = reinterpret_cast<char const*>(data);
+    column.c_type = bcp_c_type(type);
+    column.length = length == bcp_varlen_data ? SQL_NULL_DATA : length;
+    return bcp_succeed;
+}
+
+RETCODE SQL_API bcp_collen(SQLHDBC hdbc, SQLINTEGER length, int ordinal)
+{
+    NANODBC_MOCK_COUNT(bcp_collen);
+    auto* dbc = bcp_connection(hdbc, true);
+    if (!dbc)
+        return bcp_fail;
+    auto const column = dbc->bcp_columns.find(ordinal);
+    if (column == dbc->bcp_columns.end())
+        return bcp_fail;
+    column->second.length = length;
+    return bcp_succeed;
+}
+
+RETCODE SQL_API bcp_sendrow(SQLHDBC hdbc)
+{
+    NANODBC_MOCK_COUNT(bcp_sendrow);
+    auto* dbc = bcp_connection(hdbc, true);
+    if (!dbc)
+        return bcp_fail;
+    for (auto const& bound : dbc->bcp_columns)
+    {
+        bcp_column const& column = bound.second;
+        if (column.length == SQL_NULL_DATA)
+            dbc->bcp_values.push_back("NULL");
+        else
+            dbc->bcp_values.push_back(
+                value_text(column.c_type, column.data, column.length, column.length));
+    }
+    ++dbc->bcp_rows;
+    return bcp_succeed;
+}
+
+SQLINTEGER SQL_API bcp_batch(SQLHDBC hdbc)
+{
+    NANODBC_MOCK_COUNT(bcp_batch);
+    auto* dbc = bcp_connection(hdbc, true);
+    return dbc ? bcp_commit(*dbc) : -1;
+}
+
+SQLINTEGER SQL_API bcp_done(SQLHDBC hdbc)
+{
+    NANODBC_MOCK_COUNT(bcp_done);
+    auto* dbc = bcp_connection(hdbc, true);
+    if (!dbc)
+        return -1;
+    dbc->copying = false;
+    return bcp_commit(*dbc);
+}
+
+RETCODE SQL_API bcp_control(SQLHDBC hdbc, int option, void* /*value*/)
+{
+    NANODBC_MOCK_COUNT(bcp_control);
+    auto* dbc = bcp_connection(hdbc, true);
+    if (!dbc)
+        return bcp_fail;
+    if (option == bcp_abort)
+    {
+        dbc->copying = false;
+        dbc->bcp_values.clear();
+        dbc->bcp_rows = 0;
+    }
+    return bcp_succeed;
+}
+
+} // extern "C"
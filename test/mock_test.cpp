@@ -0,0 +1,1078 @@
+#include "base_test_fixture.h"
+
+#include <clocale>
+#include <cstdio>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// These run against the mock driver built from mock_driver.cpp, whose statements describe the
+// result set they return; see there for the syntax. Its values are a function of the row and
+// the column, so they are checked exactly, and it counts the calls it receives, so the tests
+// can say which ODBC functions a read does and does not need.
+
+namespace
+{
+struct mock_fixture : public base_test_fixture
+{
+    mock_fixture()
+        : base_test_fixture()
+    {
+        if (connection_string_.empty())
+            connection_string_ = get_env("NANODBC_TEST_CONNSTR_MOCK");
+#ifdef NANODBC_MOCK_DRIVER
+        if (connection_string_.empty())
+            connection_string_ = nanodbc::test::convert("Driver=" NANODBC_MOCK_DRIVER ";");
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER)
+        // The same tests run a second time with the driver linked directly.
+        if (!get_env("NANODBC_TEST_LINK_DRIVER").empty())
+            nanodbc::link_driver(NANODBC_MOCK_DRIVER);
+#endif
+#endif
+    }
+
+    // The number of calls the driver received per ODBC function since the last reset.
+    std::map<std::string, long long> calls(nanodbc::connection& connection)
+    {
+        std::map<std::string, long long> counts;
+        auto result = nanodbc::execute(connection, NANODBC_TEXT("calls"));
+        while (result.next())
+            counts[nanodbc::test::convert(result.get<nanodbc::string>(0))] =
+                result.get<long long>(1);
+        return counts;
+    }
+
+    void reset_calls(nanodbc::connection& connection)
+    {
+        nanodbc::just_execute(connection, NANODBC_TEXT("reset"));
+    }
+
+    // The parameter values the last "record" statement received, a parameter set at a time.
+    std::vector<std::string> recorded(nanodbc::connection& connection)
+    {
+        std::vector<std::string> values;
+        auto result = nanodbc::execute(connection, NANODBC_TEXT("parameters"));
+        while (result.next())
+            values.push_back(nanodbc::test::convert(result.get<nanodbc::string>(0)));
+        return values;
+    }
+};
+
+struct mock_row
+{
+    int c1;
+    long long c2;
+    double c3;
+    nanodbc::string c4;
+    nanodbc::date c5;
+};
+NANODBC_MAP(mock_row, c1, c2, c3, c4, c5)
+} // namespace
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_result_shape", "[mock]")
+{
+    auto connection = connect();
+    REQUIRE(connection.dbms_name() == NANODBC_TEXT("nanodbc mock"));
+
+    auto result = nanodbc::execute(
+        connection,
+        NANODBC_TEXT("rows=100 columns=int,bigint,double,varchar(12),date,timestamp"));
+    REQUIRE(result.columns() == 6);
+    REQUIRE(result.column_name(0) == NANODBC_TEXT("c1"));
+    REQUIRE(result.column_datatype(3) == SQL_VARCHAR);
+    REQUIRE(result.column_size(3) == 12);
+
+    long long rows = 0;
+    while (result.next())
+    {
+        REQUIRE(result.get<int>(0) == rows);
+        REQUIRE(result.get<long long>(1) == rows + 1);
+        REQUIRE(result.get<double>(2) == Catch::Approx(rows + 2 / 8.0));
+        auto const text = nanodbc::test::convert(result.get<nanodbc::string>(3));
+        REQUIRE(text.size() == 12);
+        auto const prefix = "r" + std::to_string(rows) + "c4";
+        REQUIRE(text.compare(0, prefix.size(), prefix) == 0);
+        auto const d = result.get<nanodbc::date>(4);
+        REQUIRE(d.year == 2000);
+        REQUIRE(d.day == 1 + rows % 28);
+        REQUIRE(result.get<nanodbc::timestamp>(5).hour == rows % 24);
+        ++rows;
+    }
+    REQUIRE(rows == 100);
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_rowsets", "[mock]")
+{
+    auto connection = connect();
+    for (long rowset_size : {1L, 7L, 100L, 1000L})
+    {
+        auto result = nanodbc::execute(
+            connection, NANODBC_TEXT("rows=250 columns=int nulls=10"), rowset_size);
+        long long rows = 0;
+        long long nulls = 0;
+        while (result.next())
+        {
+            if (result.is_null(0))
+                ++nulls;
+            else
+                REQUIRE(result.get<int>(0) == rows);
+            ++rows;
+        }
+        REQUIRE(rows == 250);
+        REQUIRE(nulls == 25);
+    }
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_prefetch", "[mock]")
+{
+    auto connection = connect();
+    nanodbc::statement statement(connection, NANODBC_TEXT("rows=1000 columns=int,double"));
+    {
+        nanodbc::prefetching_result result(statement.execute(100));
+        REQUIRE(result.prefetching());
+        reset_calls(connection);
+        long rows = 0;
+        // Stops halfway, so the thread is still fetching when the result goes.
+        while (rows < 500 && result.next())
+        {
+            REQUIRE(result.columns() == 2);
+            REQUIRE(result.get<int>(0) == rows);
+            ++rows;
+        }
+        REQUIRE(rows == 500);
+        // The column count was read before the thread started, not from the handle it uses.
+        REQUIRE(calls(connection).count("SQLNumResultCols") == 0);
+    }
+
+    // The statement is left bound to nothing the prefetching result owned.
+    auto result = statement.execute(100);
+    long rows = 0;
+    while (result.next())
+    {
+        REQUIRE(result.get<int>(0) == rows);
+        ++rows;
+    }
+    REQUIRE(rows == 1000);
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_bound_columns_skip_get_data", "[mock]")
+{
+    auto connection = connect();
+    reset_calls(connection);
+    {
+        auto result = nanodbc::execute(
+            connection, NANODBC_TEXT("rows=1000 columns=int,double,varchar(16)"), 100);
+        while (result.next())
+        {
+            result.get<int>(0);
+            result.get<double>(1);
+            result.get<nanodbc::string>(2);
+        }
+    }
+    auto const counts = calls(connection);
+    REQUIRE(counts.count("SQLGetData") == 0);
+    // Ten full rowsets, and the fetch that finds no more.
+    REQUIRE(counts.at("SQLFetchScroll") == 11);
+    REQUIRE(counts.at("SQLBindCol") == 3);
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_long_column", "[mock]")
+{
+    auto connection = connect();
+    reset_calls(connection);
+    {
+        auto result = nanodbc::execute(connection, NANODBC_TEXT("rows=3 columns=int,text(100000)"));
+        long long rows = 0;
+        while (result.next())
+        {
+            auto const text = nanodbc::test::convert(result.get<nanodbc::string>(1));
+            REQUIRE(text.size() == 100000);
+            REQUIRE(text.back() == '.');
+            ++rows;
+        }
+        REQUIRE(rows == 3);
+    }
+    // The long column is read in pieces rather than bound.
+    REQUIRE(calls(connection).at("SQLGetData") > 3);
+}
+
+#ifdef NANODBC_HAS_STD_VARIANT
+TEST_CASE_METHOD(mock_fixture, "test_mock_cached_row_result", "[mock]")
+{
+    auto connection = connect();
+    reset_calls(connection);
+    nanodbc::cached_row_result result(nanodbc::execute(
+        connection, NANODBC_TEXT("rows=30 columns=int,text(2000),double nulls=5")));
+    long long rows = 0;
+    while (result.next())
+    {
+        // Read right to left and twice over; the long column is still read once per row.
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            if ((rows + 1) % 5 == 0)
+            {
+                REQUIRE(result.is_null(2));
+                REQUIRE(result.is_null(1));
+                REQUIRE(result.is_null(0));
+                continue;
+            }
+            REQUIRE(std::get<double>(result.get(2)) == static_cast<double>(rows) + 0.25);
+            REQUIRE(std::get<nanodbc::string>(result.get(1)).size() == 2000);
+            REQUIRE(std::get<long long>(result.get(0)) == rows);
+        }
+        ++rows;
+    }
+    REQUIRE(rows == 30);
+    // At most the two reads that 2000 characters take, per row, however often a value is read.
+    REQUIRE(calls(connection).at("SQLGetData") <= 30 * 2);
+}
+#endif
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_materialize", "[mock]")
+{
+    auto connection = connect();
+    nanodbc::string const query = NANODBC_TEXT(
+        "rows=250 columns=int,bigint,double,varchar(32),text(100),binary(8),date,timestamp "
+        "nulls=10");
+
+    struct row
+    {
+        int i;
+        long long b;
+        double d;
+        nanodbc::string v;
+        nanodbc::string t;
+        std::vector<std::uint8_t> bin;
+        nanodbc::date date;
+        nanodbc::timestamp stamp;
+    };
+    std::vector<row> expected;
+    {
+        auto result = nanodbc::execute(connection, query, 100);
+        while (result.next())
+        {
+            row r{};
+            if (!result.is_null(0))
+            {
+                r.i = result.get<int>(0);
+                r.b = result.get<long long>(1);
+                r.d = result.get<double>(2);
+                r.v = result.get<nanodbc::string>(3);
+                r.t = result.get<nanodbc::string>(4);
+                r.bin = result.get<std::vector<std::uint8_t>>(5);
+                r.date = result.get<nanodbc::date>(6);
+                r.stamp = result.get<nanodbc::timestamp>(7);
+            }
+            expected.push_back(r);
+        }
+    }
+
+    auto result = nanodbc::execute(connection, query, 100);
+    reset_calls(connection);
+    auto rows = result.materialize();
+    auto const fetches = calls(connection).at("SQLFetchScroll");
+    REQUIRE(fetches <= 4); // three full rowsets and the end
+    REQUIRE(rows.rows() == 250);
+    REQUIRE(rows.columns() == 8);
+    REQUIRE(rows.column_name(3) == NANODBC_TEXT("c4"));
+    REQUIRE(rows.column(NANODBC_TEXT("c5")) == 4);
+    REQUIRE(rows.at_end());
+    REQUIRE_THROWS_AS(rows.get<int>(0), nanodbc::index_range_error);
+
+    // Read back to front, with the rows' own numbers.
+    for (long n = 250; n >= 1; --n)
+    {
+        REQUIRE(rows.move(n));
+        REQUIRE(rows.position() == static_cast<unsigned long>(n));
+        auto const& r = expected[static_cast<std::size_t>(n - 1)];
+        if (n % 10 == 0)
+        {
+            for (short c = 0; c < 8; ++c)
+                REQUIRE(rows.is_null(c));
+            REQUIRE_THROWS_AS(rows.get<int>(0), nanodbc::null_access_error);
+            REQUIRE(rows.get<int>(0, -1) == -1);
+            continue;
+        }
+        REQUIRE(rows.get<nanodbc::timestamp>(7).day == r.stamp.day);
+        REQUIRE(rows.get<nanodbc::date>(6).day == r.date.day);
+        REQUIRE(rows.get<std::vector<std::uint8_t>>(5) == r.bin);
+        REQUIRE(rows.get<nanodbc::string>(4) == r.t);
+        REQUIRE(rows.get<nanodbc::string>(NANODBC_TEXT("c4")) == r.v);
+        REQUIRE(rows.get<double>(2) == r.d);
+        REQUIRE(rows.get<long long>(1) == r.b);
+        REQUIRE(rows.get<int>(0) == r.i);
+        REQUIRE(rows.get<nanodbc::string>(0) == nanodbc::test::convert(std::to_string(r.i)));
+    }
+
+    // The statement is no longer needed, and the rows move without it.
+    result = nanodbc::result();
+    REQUIRE(rows.last());
+    REQUIRE(rows.is_null(0));
+    REQUIRE(rows.prior());
+    REQUIRE(rows.get<int>(0) == 248);
+    REQUIRE(rows.skip(-247));
+    REQUIRE(rows.get<int>(0) == 1);
+    REQUIRE_FALSE(rows.skip(-2));
+    REQUIRE(rows.next());
+    REQUIRE(rows.get<int>(0) == 0);
+    REQUIRE(rows.move(-1));
+    REQUIRE(rows.position() == 250);
+    REQUIRE_FALSE(rows.next());
+    REQUIRE(rows.at_end());
+
+    // A copy shares the rows but not the position.
+    auto copy = rows;
+    REQUIRE(copy.first());
+    REQUIRE(rows.at_end());
+    REQUIRE(copy.memory_size() == rows.memory_size());
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_spool", "[mock]")
+{
+    auto connection = connect();
+    nanodbc::string const query = NANODBC_TEXT(
+        "rows=250 columns=int,bigint,double,varchar(32),text(100),binary(8),date,timestamp "
+        "nulls=10");
+    std::string const path = "nanodbc_test_mock_spool.bin";
+
+    auto result = nanodbc::execute(connection, query, 100);
+    nanodbc::spool_options options;
+    options.rows_per_chunk = 64;
+    REQUIRE(nanodbc::spool(result, path, options) == 250);
+    REQUIRE(std::fopen((path + ".partial").c_str(), "rb") == nullptr);
+
+    auto rows = nanodbc::open_spool(path);
+    auto expected = nanodbc::execute(connection, query, 100).materialize();
+    REQUIRE(rows.rows() == 250);
+    REQUIRE(rows.columns() == 8);
+    REQUIRE(rows.memory_size() > 0);
+    for (short c = 0; c < 8; ++c)
+    {
+        REQUIRE(rows.column_name(c) == expected.column_name(c));
+        REQUIRE(rows.column_datatype(c) == expected.column_datatype(c));
+        REQUIRE(rows.column_c_datatype(c) == expected.column_c_datatype(c));
+        REQUIRE(rows.column_size(c) == expected.column_size(c));
+    }
+
+    // Read back to front, across the chunks, as the same rows materialized.
+    for (long n = 250; n >= 1; --n)
+    {
+        REQUIRE(rows.move(n));
+        REQUIRE(expected.move(n));
+        for (short c = 0; c < 8; ++c)
+            REQUIRE(rows.is_null(c) == expected.is_null(c));
+        if (expected.is_null(0))
+            continue;
+        REQUIRE(rows.get<int>(0) == expected.get<int>(0));
+        REQUIRE(rows.get<long long>(1) == expected.get<long long>(1));
+        REQUIRE(rows.get<double>(2) == expected.get<double>(2));
+        REQUIRE(rows.get<nanodbc::string>(3) == expected.get<nanodbc::string>(3));
+        REQUIRE(rows.get<nanodbc::string>(4) == expected.get<nanodbc::string>(4));
+        REQUIRE(
+            rows.get<std::vector<std::uint8_t>>(5) == expected.get<std::vector<std::uint8_t>>(5));
+        REQUIRE(rows.get<nanodbc::date>(6).day == expected.get<nanodbc::date>(6).day);
+        REQUIRE(rows.get<std::string>(7) == expected.get<std::string>(7));
+    }
+
+    // An empty result set spools to a file of no rows.
+    result = nanodbc::execute(connection, NANODBC_TEXT("rows=0 columns=int"));
+    REQUIRE(nanodbc::spool(result, path) == 0);
+    REQUIRE(nanodbc::open_spool(path).rows() == 0);
+
+    // Anything else is refused, whether missing, foreign or cut short.
+    REQUIRE(std::remove(path.c_str()) == 0);
+    REQUIRE_THROWS_AS(nanodbc::open_spool(path), nanodbc::programming_error);
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        REQUIRE(file != nullptr);
+        std::fputs("rows=250 columns=int,bigint,double,varchar(32),date,timestamp\n", file);
+        std::fclose(file);
+    }
+    REQUIRE_THROWS_AS(nanodbc::open_spool(path), nanodbc::programming_error);
+    result = nanodbc::execute(connection, query, 100);
+    REQUIRE(nanodbc::spool(result, path) == 250);
+    std::string whole;
+    {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        REQUIRE(file != nullptr);
+        char buffer[4096];
+        std::size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) != 0)
+            whole.append(buffer, read);
+        std::fclose(file);
+        file = std::fopen(path.c_str(), "wb");
+        REQUIRE(file != nullptr);
+        std::fwrite(whole.data(), 1, whole.size() - 8, file);
+        std::fclose(file);
+    }
+    REQUIRE_THROWS_AS(nanodbc::open_spool(path), nanodbc::programming_error);
+    REQUIRE(std::remove(path.c_str()) == 0);
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_export_delimited", "[mock]")
+{
+    auto connection = connect();
+    nanodbc::string const query =
+        NANODBC_TEXT("rows=250 columns=int,bigint,double,varchar(16),date,timestamp nulls=7");
+
+    std::string expected = "c1,c2,c3,c4,c5,c6\n";
+    {
+        auto result = nanodbc::execute(connection, query, 100);
+        char buffer[64];
+        while (result.next())
+        {
+            if (result.is_null(0))
+            {
+                expected += ",,,,,\n";
+                continue;
+            }
+            auto const d = result.get<nanodbc::date>(4);
+            auto const ts = result.get<nanodbc::timestamp>(5);
+            expected += std::to_string(result.get<int>(0)) + ',';
+            expected += std::to_string(result.get<long long>(1)) + ',';
+            std::snprintf(buffer, sizeof(buffer), "%.15g,", result.get<double>(2));
+            expected += buffer;
+            expected += nanodbc::test::convert(result.get<nanodbc::string>(3)) + ',';
+            std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d,", d.year, d.month, d.day);
+            expected += buffer;
+            std::snprintf(
+                buffer,
+                sizeof(buffer),
+                "%04d-%02d-%02d %02d:%02d:%02d.000\n",
+                ts.year,
+                ts.month,
+                ts.day,
+                ts.hour,
+                ts.min,
+                ts.sec);
+            expected += buffer;
+        }
+    }
+
+    // Bound columns are formatted from the rowset buffers, in buffers handed over whole.
+    auto result = nanodbc::execute(connection, query, 100);
+    reset_calls(connection);
+    std::string written;
+    std::size_t flushes = 0;
+    nanodbc::delimited_options options;
+    options.buffer_size = 1024;
+    auto const rows = nanodbc::export_delimited(
+        result,
+        [&](char const* data, std::size_t size) {
+            REQUIRE(size <= options.buffer_size);
+            written.append(data, size);
+            ++flushes;
+        },
+        options);
+    auto const counts = calls(connection);
+    REQUIRE(rows == 250);
+    REQUIRE(written == expected);
+    // A buffer is handed over once it has no room left for the next value.
+    REQUIRE(flushes <= expected.size() / (options.buffer_size / 2) + 1);
+    REQUIRE(counts.count("SQLGetData") == 0);
+    REQUIRE(counts.at("SQLFetchScroll") <= 4);
+
+    // Unbound binary columns are read as get() reads them, and written as hexadecimal digits.
+    result = nanodbc::execute(connection, NANODBC_TEXT("rows=3 columns=int,binary(3) nulls=2"));
+    written.clear();
+    options.header = false;
+    options.quoting = nanodbc::delimited_quoting::all;
+    options.null_value = "NULL";
+    REQUIRE(
+        nanodbc::export_delimited(
+            result, [&](char const* data, std::size_t size) { written.append(data, size); },
+            options) == 3);
+    REQUIRE(written == "\"0\",\"010203\"\nNULL,NULL\n\"2\",\"030405\"\n");
+
+    // A real is written at float precision, and the decimal mark is '.' whatever the locale.
+    options = nanodbc::delimited_options();
+    options.header = false;
+    auto const export_reals = [&]() {
+        written.clear();
+        result = nanodbc::execute(connection, NANODBC_TEXT("rows=2 columns=real,double"));
+        nanodbc::export_delimited(
+            result, [&](char const* data, std::size_t size) { written.append(data, size); },
+            options);
+        return written;
+    };
+    REQUIRE(export_reals() == "0.1,0.125\n1.1,1.125\n");
+    std::string const old_locale = std::setlocale(LC_NUMERIC, nullptr);
+    if (std::setlocale(LC_NUMERIC, "de_DE.UTF-8") || std::setlocale(LC_NUMERIC, "German"))
+    {
+        auto const in_locale = export_reals();
+        std::setlocale(LC_NUMERIC, old_locale.c_str());
+        REQUIRE(in_locale == "0.1,0.125\n1.1,1.125\n");
+    }
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_temporal_text", "[mock]")
+{
+    auto connection = connect();
+    auto result = nanodbc::execute(connection, NANODBC_TEXT("rows=400 columns=date,timestamp"));
+    char expected[64];
+    while (result.next())
+    {
+        auto const d = result.get<nanodbc::date>(0);
+        std::snprintf(expected, sizeof(expected), "%04d-%02d-%02d", d.year, d.month, d.day);
+        REQUIRE(result.get<std::string>(0) == expected);
+
+        // A timestamp carries no offset, and is rendered as UTC whatever the local time zone.
+        auto const ts = result.get<nanodbc::timestamp>(1);
+        std::snprintf(
+            expected,
+            sizeof(expected),
+            "%04d-%02d-%02d %02d:%02d:%02d +0000",
+            ts.year,
+            ts.month,
+            ts.day,
+            ts.hour,
+            ts.min,
+            ts.sec);
+        REQUIRE(result.get<std::string>(1) == expected);
+        REQUIRE(result.get<nanodbc::string>(1) == nanodbc::test::convert(expected));
+    }
+
+    // Text is a date only if the day is in the month.
+    std::vector<nanodbc::string> const dates{
+        NANODBC_TEXT("2023-02-28"),
+        NANODBC_TEXT("2023-02-29"),
+        NANODBC_TEXT("2023-02-31"),
+        NANODBC_TEXT("2023-04-30"),
+        NANODBC_TEXT("2023-04-31"),
+        NANODBC_TEXT("2024-02-29"),
+        NANODBC_TEXT("1900-02-29"),
+        NANODBC_TEXT("2000-02-29 12:00:00")};
+    nanodbc::statement statement(connection, NANODBC_TEXT("record ?"));
+    statement.bind_strings(0, dates);
+    statement.execute(static_cast<long>(dates.size()));
+    result = nanodbc::execute(connection, NANODBC_TEXT("parameters"));
+    std::vector<bool> valid;
+    while (result.next())
+    {
+        try
+        {
+            result.get<nanodbc::date>(0);
+            valid.push_back(true);
+        }
+        catch (nanodbc::type_incompatible_error const&)
+        {
+            valid.push_back(false);
+        }
+    }
+    REQUIRE(valid == std::vector<bool>{true, false, false, true, false, true, false, true});
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_decimal_text", "[mock]")
+{
+    auto connection = connect();
+    nanodbc::string const query = NANODBC_TEXT("rows=300 columns=int,decimal(18) nulls=50");
+
+    // DECIMAL is bound as text, and read as a number from the bound buffer.
+    auto result = nanodbc::execute(connection, query, 100);
+    reset_calls(connection);
+    long rows = 0;
+    while (result.next())
+    {
+        ++rows;
+        if (result.is_null(1))
+            continue;
+        int const row = result.get<int>(0);
+        REQUIRE(result.get<double>(1) == row + 0.125);
+        REQUIRE(result.get<float>(1) == static_cast<float>(row) + 0.125f);
+        REQUIRE(result.get<int>(1) == row);
+        REQUIRE(result.get<long long>(1) == row);
+        REQUIRE(result.get<unsigned short>(1) == row);
+    }
+    REQUIRE(rows == 300);
+    REQUIRE(calls(connection).count("SQLGetData") == 0);
+
+    // The decimal mark is '.' whatever the locale.
+    std::string const old_locale = std::setlocale(LC_NUMERIC, nullptr);
+    if (std::setlocale(LC_NUMERIC, "de_DE.UTF-8") || std::setlocale(LC_NUMERIC, "German"))
+    {
+        result = nanodbc::execute(connection, query);
+        REQUIRE(result.next());
+        REQUIRE(result.get<double>(1) == 0.125);
+        std::setlocale(LC_NUMERIC, old_locale.c_str());
+    }
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_row_mapping", "[mock]")
+{
+    auto connection = connect();
+    nanodbc::string const query =
+        NANODBC_TEXT("rows=250 columns=int,bigint,double,varchar(12),date");
+
+    auto result = nanodbc::execute(connection, query, 100);
+    reset_calls(connection);
+    auto const rows = nanodbc::fetch_rows<mock_row>(result);
+    REQUIRE(rows.size() == 250);
+    for (std::size_t i = 0; i < rows.size(); ++i)
+    {
+        long long const row = static_cast<long long>(i);
+        REQUIRE(rows[i].c1 == row);
+        REQUIRE(rows[i].c2 == row + 1);
+        REQUIRE(rows[i].c3 == row + 2 / 8.0);
+        auto const prefix = "r" + std::to_string(row) + "c4";
+        REQUIRE(nanodbc::test::convert(rows[i].c4).compare(0, prefix.size(), prefix) == 0);
+        REQUIRE(rows[i].c5.year == 2000);
+        REQUIRE(rows[i].c5.day == 1 + row % 28);
+    }
+    REQUIRE(calls(connection).count("SQLGetData") == 0);
+
+    // A rowset at a time, with the columns in another order and a member read from text.
+    struct pair_row
+    {
+        nanodbc::string text;
+        unsigned short number;
+    };
+    auto const mapping = nanodbc::map_row(
+        nanodbc::map_column(NANODBC_TEXT("c2"), &pair_row::text),
+        nanodbc::map_column(NANODBC_TEXT("c1"), &pair_row::number));
+    result = nanodbc::execute(connection, query, 100);
+    auto reader = nanodbc::make_mapped_reader(result, mapping);
+    std::vector<pair_row> rowset;
+    std::vector<std::size_t> sizes;
+    while (reader.read_rows(rowset, 100) > 0)
+    {
+        sizes.push_back(rowset.size());
+        for (auto const& row : rowset)
+            REQUIRE(nanodbc::test::convert(row.text) == std::to_string(row.number + 1));
+        rowset.clear();
+    }
+    REQUIRE(sizes == std::vector<std::size_t>{100, 100, 50});
+
+    // Columns are checked when the reader is made.
+    result = nanodbc::execute(connection, query);
+    struct date_row
+    {
+        nanodbc::date day;
+    };
+    REQUIRE_THROWS_AS(
+        nanodbc::make_mapped_reader(
+            result, nanodbc::map_row(nanodbc::map_column(NANODBC_TEXT("c1"), &date_row::day))),
+        nanodbc::type_incompatible_error);
+    REQUIRE_THROWS_AS(
+        nanodbc::make_mapped_reader(
+            result, nanodbc::map_row(nanodbc::map_column(NANODBC_TEXT("c9"), &date_row::day))),
+        nanodbc::index_range_error);
+
+    // A null can only be read into an optional member.
+    result = nanodbc::execute(connection, NANODBC_TEXT("rows=10 columns=int,double nulls=2"));
+    auto nullable = nanodbc::make_mapped_reader(
+        result, nanodbc::map_row(nanodbc::map_column(NANODBC_TEXT("c1"), &mock_row::c1)));
+    REQUIRE(result.next());
+    REQUIRE(nullable.read().c1 == 0);
+    REQUIRE(result.next());
+    REQUIRE_THROWS_AS(nullable.read(), nanodbc::null_access_error);
+#ifdef NANODBC_HAS_STD_OPTIONAL
+    struct optional_row
+    {
+        std::optional<int> number;
+        std::optional<double> real;
+    };
+    result = nanodbc::execute(connection, NANODBC_TEXT("rows=10 columns=int,double nulls=2"));
+    auto const optional_rows = nanodbc::fetch_rows(
+        result,
+        nanodbc::map_row(
+            nanodbc::map_column(NANODBC_TEXT("c1"), &optional_row::number),
+            nanodbc::map_column(NANODBC_TEXT("c2"), &optional_row::real)));
+    REQUIRE(optional_rows.size() == 10);
+    for (std::size_t i = 0; i < optional_rows.size(); ++i)
+    {
+        REQUIRE(optional_rows[i].number.has_value() == (i % 2 == 0));
+        REQUIRE(optional_rows[i].real.has_value() == (i % 2 == 0));
+        if (optional_rows[i].number)
+            REQUIRE(*optional_rows[i].number == static_cast<int>(i));
+    }
+#endif
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_batch_insert", "[mock]")
+{
+    auto connection = connect();
+    nanodbc::statement statement(connection, NANODBC_TEXT("insert into t (a, b) values (?, ?);"));
+    REQUIRE(statement.parameters() == 2);
+
+    std::vector<int> a(50, 1);
+    std::vector<double> b(50, 2.0);
+    statement.bind(0, a.data(), a.size());
+    statement.bind(1, b.data(), b.size());
+    auto result = nanodbc::execute(statement, static_cast<long>(a.size()));
+    REQUIRE(result.affected_rows() == 50);
+    REQUIRE(statement.parameters_processed() == 50);
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_rebind_parameters", "[mock]")
+{
+    auto connection = connect();
+    nanodbc::statement statement(connection, NANODBC_TEXT("insert into t (a, b) values (?, ?);"));
+    reset_calls(connection);
+    for (int i = 0; i < 20; ++i)
+    {
+        std::vector<int> a(1 + i % 5, i);
+        std::vector<nanodbc::string> b(a.size(), NANODBC_TEXT("b"));
+        statement.bind(0, a.data(), a.size());
+        statement.bind_strings(1, b);
+        auto result = nanodbc::execute(statement, static_cast<long>(b.size()));
+        REQUIRE(result.affected_rows() == static_cast<long>(b.size()));
+    }
+    // The parameters are counted and described once per prepare, not once per bind.
+    auto const counts = calls(connection);
+    REQUIRE(counts.at("SQLNumParams") == 1);
+    REQUIRE(counts.at("SQLDescribeParam") == 2);
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_bind_rows", "[mock]")
+{
+    auto connection = connect();
+
+    // Rows of fixed size members are bound where they are, and read when executed.
+    struct point
+    {
+        int x;
+        double y;
+        nanodbc::date day;
+    };
+    std::vector<point> points;
+    for (int i = 0; i < 30; ++i)
+        points.push_back({i, i / 4.0, {2024, 1, static_cast<std::int16_t>(1 + i % 28)}});
+    auto const mapping = nanodbc::map_row(
+        nanodbc::map_column(NANODBC_TEXT("x"), &point::x),
+        nanodbc::map_column(NANODBC_TEXT("y"), &point::y),
+        nanodbc::map_column(NANODBC_TEXT("day"), &point::day));
+
+    nanodbc::statement statement(connection, NANODBC_TEXT("record ?, ?, ?"));
+    reset_calls(connection);
+    statement.bind_rows(points, mapping);
+    REQUIRE(statement.execute(static_cast<long>(points.size())).affected_rows() == 30);
+    REQUIRE(calls(connection).at("SQLBindParameter") == 3);
+    auto values = recorded(connection);
+    REQUIRE(values.size() == 90);
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        REQUIRE(values[3 * i] == std::to_string(i));
+        REQUIRE(std::stod(values[3 * i + 1]) == points[i].y);
+        char day[16];
+        std::snprintf(day, sizeof(day), "2024-01-%02d", points[i].day.day);
+        REQUIRE(values[3 * i + 2] == day);
+    }
+
+    points[0].x = 100;
+    reset_calls(connection);
+    statement.execute(static_cast<long>(points.size()));
+    REQUIRE(calls(connection).count("SQLBindParameter") == 0);
+    REQUIRE(recorded(connection)[0] == "100");
+
+    // Text is copied, beside its length, into rows the statement keeps.
+    std::vector<mock_row> rows;
+    for (int i = 0; i < 12; ++i)
+    {
+        auto const text = nanodbc::test::convert("row " + std::to_string(i * 10));
+        rows.push_back({i, i * 3LL, i + 0.5, text, {2000, 2, static_cast<std::int16_t>(1 + i)}});
+    }
+    statement.prepare(NANODBC_TEXT("record ?, ?, ?, ?, ?"));
+    statement.bind_rows(rows);
+    statement.execute(static_cast<long>(rows.size()));
+    values = recorded(connection);
+    REQUIRE(values.size() == 60);
+    for (std::size_t i = 0; i < rows.size(); ++i)
+    {
+        REQUIRE(values[5 * i + 1] == std::to_string(rows[i].c2));
+        REQUIRE(values[5 * i + 3] == nanodbc::test::convert(rows[i].c4));
+    }
+
+    // Binding a parameter column-wise afterwards unbinds the rows.
+    statement.prepare(NANODBC_TEXT("record ?"));
+    std::vector<int> column{7, 8};
+    statement.bind(0, column.data(), column.size());
+    statement.execute(2);
+    REQUIRE(recorded(connection) == std::vector<std::string>{"7", "8"});
+
+#ifdef NANODBC_HAS_STD_OPTIONAL
+    struct optional_row
+    {
+        std::optional<long long> number;
+        std::optional<nanodbc::string> text;
+    };
+    std::vector<optional_row> optional_rows(6);
+    for (std::size_t i = 0; i < optional_rows.size(); i += 2)
+    {
+        optional_rows[i].number = static_cast<long long>(i);
+        optional_rows[i + 1].text = nanodbc::test::convert(std::to_string(i));
+    }
+    statement.prepare(NANODBC_TEXT("record ?, ?"));
+    statement.bind_rows(
+        optional_rows,
+        nanodbc::map_row(
+            nanodbc::map_column(NANODBC_TEXT("number"), &optional_row::number),
+            nanodbc::map_column(NANODBC_TEXT("text"), &optional_row::text)));
+    statement.execute(static_cast<long>(optional_rows.size()));
+    REQUIRE(
+        recorded(connection) ==
+        std::vector<std::string>{"0", "NULL", "NULL", "0", "2", "NULL", "NULL", "2", "4", "NULL",
+                                 "NULL", "4"});
+#endif
+
+    REQUIRE_THROWS_AS(
+        statement.bind_rows(std::vector<point>{}, mapping), nanodbc::programming_error);
+}
+
+#ifndef NANODBC_DISABLE_MSSQL_TVP
+TEST_CASE_METHOD(mock_fixture, "test_mock_table_valued_parameter", "[mock]")
+{
+    auto connection = connect();
+    // Two markers, the first a table-valued parameter of three columns.
+    nanodbc::statement statement(
+        connection, NANODBC_TEXT("record ?, ? tvp=int,varchar(16),bigint"));
+
+    std::vector<int> ids{1, 2, 3};
+    std::vector<nanodbc::string> names{NANODBC_TEXT("a"), NANODBC_TEXT("bb"), NANODBC_TEXT("c")};
+    std::vector<long long> totals{10, 20, 30};
+    nanodbc::table_valued_parameter tvp(statement, 0, ids.size());
+    tvp.bind(0, ids.data(), ids.size());
+    tvp.bind_strings(1, names);
+    tvp.bind(2, totals.data(), totals.size());
+    tvp.close();
+    int const outer = 7;
+    statement.bind(1, &outer);
+    statement.execute();
+
+    // The row count the table-valued parameter was bound with is still where it was bound.
+    REQUIRE(
+        recorded(connection) ==
+        std::vector<std::string>{
+            "tvp rows=3", "1", "a", "10", "2", "bb", "20", "3", "c", "30", "7"});
+}
+#endif
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_parallel_scan_cancel", "[mock]")
+{
+    auto connection = connect();
+    std::vector<nanodbc::string> const partitions(20, NANODBC_TEXT("1 = 1"));
+    nanodbc::parallel_scan_options options;
+    options.connections = 2;
+    options.rowset_size = 10;
+
+    reset_calls(connection);
+    nanodbc::bounded_queue<std::vector<int>> queue(1);
+    std::thread producer([&] {
+        nanodbc::parallel_scan<int>(
+            connection_string_,
+            NANODBC_TEXT("rows=1000 columns=int where {partition}"),
+            partitions,
+            queue,
+            [](nanodbc::result& rows) { return rows.get<int>(0); },
+            options);
+    });
+    std::vector<int> batch;
+    REQUIRE(queue.pop(batch));
+    REQUIRE(batch.size() == 10);
+    queue.close();
+    producer.join();
+
+    // Each worker stops at its next push, rather than going on through the other partitions.
+    // The "calls" statement is one of the executions counted.
+    auto const counts = calls(connection);
+    REQUIRE(counts.at("SQLExecDirect") - 1 <= 2);
+}
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_driver_profile", "[mock]")
+{
+    auto connection = connect();
+    reset_calls(connection);
+    auto profile = connection.profile();
+    REQUIRE(profile.driver_name == connection.driver_name());
+    REQUIRE(profile.dbms_name == NANODBC_TEXT("nanodbc mock"));
+    REQUIRE(profile.param_array_row_counts == SQL_PARC_BATCH);
+    REQUIRE(profile.batch_support == 0); // not reported
+    REQUIRE((profile.getdata_extensions & SQL_GD_BOUND) != 0);
+    REQUIRE(profile.getdata_extensions_reported);
+    REQUIRE(profile.native_parameter_arrays);
+    REQUIRE(profile.rows_per_fetch == 1000);
+    REQUIRE(
+        nanodbc::to_string(profile).find("native_parameter_arrays: true\n") != std::string::npos);
+
+    // The driver is probed once per connection.
+    auto const probes = calls(connection).at("SQLGetInfo");
+    connection.profile();
+    REQUIRE(calls(connection).at("SQLGetInfo") == probes);
+
+    // A driver said to execute arrays row by row gets multi-row INSERTs from bulk_copy.
+    profile.native_parameter_arrays = false;
+    connection.set_profile(profile);
+    REQUIRE_FALSE(connection.profile().native_parameter_arrays);
+    reset_calls(connection);
+    {
+        nanodbc::bulk_copy copy(connection, NANODBC_TEXT("t"), 100);
+        copy.add_column<int>(NANODBC_TEXT("a"));
+        copy.add_column<double>(NANODBC_TEXT("b"));
+        for (int i = 0; i < 250; ++i)
+        {
+            copy.set(0, i);
+            copy.set(1, 0.5);
+            copy.add_row();
+        }
+        REQUIRE(copy.finish() == 250);
+    }
+    auto const counts = calls(connection);
+    REQUIRE(counts.at("SQLPrepare") == 2); // 100 rows and the 50 row tail
+    REQUIRE(counts.at("SQLExecute") == 3);
+
+    // A DBMS not in the table of insert limits gets the defaults, which the profile overrides
+    // for every statement and copy_options for one.
+    REQUIRE(profile.max_parameters == 999);
+    REQUIRE(profile.max_insert_rows == 1000);
+    {
+        nanodbc::multirow_insert insert(
+            connection, NANODBC_TEXT("insert into t (a, b) values (?, ?)"));
+        REQUIRE(insert.rows_per_statement() == 499);
+    }
+    profile.max_insert_rows = 10;
+    connection.set_profile(profile);
+    {
+        nanodbc::multirow_insert insert(
+            connection, NANODBC_TEXT("insert into t (a, b) values (?, ?)"));
+        REQUIRE(insert.rows_per_statement() == 10);
+        nanodbc::copy_options options;
+        options.rows_per_statement = 20;
+        nanodbc::multirow_insert wider(
+            connection, NANODBC_TEXT("insert into t (a, b) values (?, ?)"), options);
+        REQUIRE(wider.rows_per_statement() == 20);
+    }
+    REQUIRE(nanodbc::to_string(profile).find("max_insert_rows: 10\n") != std::string::npos);
+
+    // Without SQL_GD_BLOCK only a result with a long column is fetched a row at a time.
+    profile.getdata_extensions &= ~static_cast<std::uint32_t>(SQL_GD_BLOCK);
+    connection.set_profile(profile);
+    REQUIRE(connection.profile().rows_per_fetch == 1000);
+    {
+        auto result = nanodbc::execute(
+            connection, NANODBC_TEXT("rows=3 columns=int,text(100000)"), 100);
+        REQUIRE(result.rowset_size() == 1);
+        long long rows = 0;
+        while (result.next())
+        {
+            REQUIRE(result.get<int>(0) == rows);
+            REQUIRE(nanodbc::test::convert(result.get<nanodbc::string>(1)).size() == 100000);
+            ++rows;
+        }
+        REQUIRE(rows == 3);
+    }
+    REQUIRE(
+        nanodbc::execute(connection, NANODBC_TEXT("rows=3 columns=int"), 100).rowset_size() ==
+        100);
+
+    // Where the driver's answer is unknown, the rowset size asked for is kept.
+    profile.getdata_extensions = 0;
+    profile.getdata_extensions_reported = false;
+    connection.set_profile(profile);
+    REQUIRE(
+        nanodbc::execute(connection, NANODBC_TEXT("rows=3 columns=int,text(100000)"), 100)
+            .rowset_size() == 100);
+    REQUIRE(
+        nanodbc::to_string(connection.profile()).find("getdata_extensions: unknown\n") !=
+        std::string::npos);
+
+    connection.reset_profile();
+    REQUIRE(connection.profile().native_parameter_arrays);
+}
+
+#if defined(NANODBC_HAS_STD_VARIANT) && !defined(NANODBC_DISABLE_MSSQL_BCP)
+TEST_CASE_METHOD(mock_fixture, "test_mock_bulk_copy_bcp", "[mock][bcp]")
+{
+    // SQL_COPT_SS_BCP, set before connecting as the SQL Server driver needs it.
+    std::list<nanodbc::connection::attribute> attributes;
+    attributes.push_back({1219, SQL_IS_UINTEGER, std::uintptr_t{1}});
+    nanodbc::connection connection(connection_string_, attributes);
+    nanodbc::string const table = NANODBC_TEXT("rows=0 columns=int,double,varchar(16)");
+
+    {
+        nanodbc::bulk_copy copy(connection, table, 2);
+        REQUIRE(copy.uses_bcp());
+        copy.add_column<int>(NANODBC_TEXT("c1"));
+        copy.add_column<double>(NANODBC_TEXT("c2"));
+        copy.add_string_column(NANODBC_TEXT("c3"), 16);
+
+        int const ints[] = {1, 2, 3};
+        double const doubles[] = {0.5, 1.5, 2.5};
+        bool const nulls[] = {false, true, false};
+        std::vector<nanodbc::string> const strings = {
+            NANODBC_TEXT("a"), NANODBC_TEXT("bc"), NANODBC_TEXT("def")};
+        copy.bind(0, ints, 3);
+        copy.bind(1, doubles, 3, nulls);
+        copy.bind_strings(2, strings);
+        copy.add_rows(3);
+        copy.set(0, 4);
+        copy.add_row();
+        REQUIRE(copy.finish() == 4);
+    }
+    REQUIRE(
+        recorded(connection) ==
+        std::vector<std::string>{
+            "1", "0.5", "a", "2", "NULL", "bc", "3", "2.5", "def", "4", "NULL", "NULL"});
+
+    // Without finish(), the rows sent since the last batch are dropped rather than committed.
+    reset_calls(connection);
+    {
+        nanodbc::bulk_copy copy(connection, table, 2);
+        copy.add_column<int>(NANODBC_TEXT("c1"));
+        for (int i = 0; i < 3; ++i)
+        {
+            copy.set(0, i);
+            copy.add_row();
+        }
+    }
+    auto const counts = calls(connection);
+    REQUIRE(counts.count("bcp_done") == 0);
+    REQUIRE(counts.at("bcp_control") == 1);
+    REQUIRE(recorded(connection) == std::vector<std::string>{"0", "1"});
+}
+#endif
+
+TEST_CASE_METHOD(mock_fixture, "test_mock_metadata_cache", "[mock]")
+{
+    auto connection = connect();
+    REQUIRE(connection.dbms_name() == NANODBC_TEXT("nanodbc mock"));
+    reset_calls(connection);
+
+    // get_info values are asked of the driver once per connection.
+    REQUIRE(connection.dbms_name() == NANODBC_TEXT("nanodbc mock"));
+    auto const driver = connection.driver_name();
+    REQUIRE(!driver.empty());
+    auto const asked = calls(connection)["SQLGetInfo"];
+    REQUIRE(connection.driver_name() == driver);
+    REQUIRE(calls(connection)["SQLGetInfo"] == asked);
+
+    connection.invalidate_metadata();
+    REQUIRE(connection.dbms_name() == NANODBC_TEXT("nanodbc mock"));
+    REQUIRE(calls(connection)["SQLGetInfo"] > asked);
+
+    REQUIRE(connection.metadata_ttl().count() == 0);
+    connection.cache_metadata(std::chrono::seconds(60));
+    REQUIRE(connection.metadata_ttl().count() == 60);
+}
+
+#if defined(NANODBC_ENABLE_DIRECT_DRIVER) && defined(NANODBC_MOCK_DRIVER)
+TEST_CASE_METHOD(mock_fixture, "test_mock_linked_driver", "[mock][direct]")
+{
+    if (nanodbc::linked_driver().empty())
+        SKIP("the driver manager loads the mock driver in this run");
+
+    REQUIRE(nanodbc::linked_driver() == NANODBC_MOCK_DRIVER);
+    REQUIRE_NOTHROW(nanodbc::link_driver(NANODBC_MOCK_DRIVER));
+    REQUIRE_THROWS_AS(nanodbc::link_driver("libother.so"), nanodbc::programming_error);
+    REQUIRE_THROWS_AS(nanodbc::list_drivers(), nanodbc::programming_error);
+
+    auto connection = connect();
+    std::string const path = NANODBC_MOCK_DRIVER;
+    REQUIRE(nanodbc::test::convert(connection.driver_name()) == path.substr(path.rfind('/') + 1));
+    auto result = nanodbc::execute(connection, NANODBC_TEXT("rows=10 columns=int"));
+    long long rows = 0;
+    while (result.next())
+        REQUIRE(result.get<int>(0) == rows++);
+    REQUIRE(rows == 10);
+}
+#endif
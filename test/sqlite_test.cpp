@@ -187,6 +187,16 @@ TEST_CASE_METHOD(sqlite_fixture, "test_catalog_primary_keys", "[sqlite][catalog]
     test_catalog_primary_keys();
 }
 
+TEST_CASE_METHOD(sqlite_fixture, "test_catalog_snapshot", "[sqlite][catalog][snapshot]")
+{
+    test_catalog_snapshot();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_catalog_metadata_cache", "[sqlite][catalog][cache]")
+{
+    test_catalog_metadata_cache();
+}
+
 TEST_CASE_METHOD(sqlite_fixture, "test_catalog_tables", "[sqlite][catalog][tables]")
 {
     before_catalog_test();
@@ -653,3 +663,85 @@ TEST_CASE_METHOD(sqlite_fixture, "test_bind_null_in_single_row_batch", "[sqlite]
 {
     test_bind_null_in_single_row_batch();
 }
+
+TEST_CASE_METHOD(sqlite_fixture, "test_parallel_scan", "[sqlite][parallel_scan]")
+{
+    test_parallel_scan();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_prefetching_result", "[sqlite][result][prefetch]")
+{
+    test_prefetching_result();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_materialize", "[sqlite][result][materialize]")
+{
+    test_materialize();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_export_delimited", "[sqlite][result][export]")
+{
+    test_export_delimited();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_temporal_from_text", "[sqlite][result][datetime]")
+{
+    test_temporal_from_text();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_row_mapping", "[sqlite][result][mapping]")
+{
+    test_row_mapping();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_bind_rows", "[sqlite][statement][mapping]")
+{
+    test_bind_rows();
+}
+
+#ifdef NANODBC_HAS_STD_VARIANT
+TEST_CASE_METHOD(sqlite_fixture, "test_cached_row_result", "[sqlite][result][cached]")
+{
+    test_cached_row_result();
+}
+#endif
+
+TEST_CASE_METHOD(sqlite_fixture, "test_batch_writer", "[sqlite][batch][writer]")
+{
+    test_batch_writer();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_parameter_status", "[sqlite][batch][status]")
+{
+    test_parameter_status();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_call_tracing", "[sqlite][instrumentation]")
+{
+    test_call_tracing();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_parameter_description_cache", "[sqlite][parameters]")
+{
+    test_parameter_description_cache();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_bind_ref", "[sqlite][parameters]")
+{
+    test_bind_ref();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_bulk_copy", "[sqlite][bulk_copy]")
+{
+    test_bulk_copy();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_copy_in", "[sqlite][copy]")
+{
+    test_copy_in();
+}
+
+TEST_CASE_METHOD(sqlite_fixture, "test_multirow_insert", "[sqlite][copy]")
+{
+    test_multirow_insert();
+}
@@ -9,6 +9,7 @@
 #include <limits>
 #include <random>
 #include <set>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -1011,6 +1012,925 @@ struct test_case_fixture : public base_test_fixture
         }
     }
 
+    // Every row has to be delivered exactly once, whichever worker ends up with which
+    // partition, and rows without a key come through the IS NULL partition.
+    void test_parallel_scan()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection, NANODBC_TEXT("test_parallel_scan"), NANODBC_TEXT("(k int, v int)"));
+
+        int const count = 100;
+        {
+            nanodbc::transaction transaction(connection);
+            nanodbc::statement statement(connection);
+            prepare(
+                statement, NANODBC_TEXT("insert into test_parallel_scan (k, v) values (?, ?);"));
+            std::vector<int> keys(count), values(count);
+            std::vector<std::uint8_t> nulls(count, 0);
+            for (int i = 0; i < count; ++i)
+            {
+                keys[i] = i + 1;
+                values[i] = i + 1;
+            }
+            nulls[count - 1] = 1; // one row without a key
+            statement.bind(0, keys.data(), count, reinterpret_cast<bool const*>(nulls.data()));
+            statement.bind(1, values.data(), count);
+            nanodbc::execute(statement, count);
+            transaction.commit();
+        }
+
+        auto const partitions = nanodbc::key_range_partitions(
+            connection, NANODBC_TEXT("test_parallel_scan"), NANODBC_TEXT("k"), 7);
+        REQUIRE(partitions.size() == 8);
+        REQUIRE(partitions.back() == NANODBC_TEXT("k IS NULL"));
+
+        nanodbc::string const query =
+            NANODBC_TEXT("select v from test_parallel_scan where {partition};");
+        nanodbc::parallel_scan_options options;
+        options.connections = 3;
+        options.rowset_size = 16;
+
+        {
+            std::mutex mutex;
+            long long sum = 0;
+            int rows = 0;
+            nanodbc::parallel_scan(
+                connection_string_,
+                query,
+                partitions,
+                [&](nanodbc::scan_partition const&, nanodbc::result& results) {
+                    while (results.next())
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        sum += results.get<int>(0);
+                        ++rows;
+                    }
+                },
+                options);
+            REQUIRE(rows == count);
+            REQUIRE(sum == count * (count + 1) / 2);
+        }
+
+        {
+            nanodbc::bounded_queue<std::vector<int>> queue(2);
+            std::thread producer([&] {
+                nanodbc::parallel_scan<int>(
+                    connection_string_,
+                    query,
+                    partitions,
+                    queue,
+                    [](nanodbc::result& results) { return results.get<int>(0); },
+                    options);
+            });
+            long long sum = 0;
+            int rows = 0;
+            std::vector<int> batch;
+            while (queue.pop(batch))
+            {
+                REQUIRE(batch.size() <= static_cast<std::size_t>(options.rowset_size));
+                for (int v : batch)
+                    sum += v;
+                rows += static_cast<int>(batch.size());
+            }
+            producer.join();
+            REQUIRE(rows == count);
+            REQUIRE(sum == count * (count + 1) / 2);
+        }
+
+        REQUIRE_THROWS_AS(
+            nanodbc::parallel_scan(
+                connection_string_,
+                NANODBC_TEXT("select v from test_parallel_scan;"),
+                partitions,
+                [](nanodbc::scan_partition const&, nanodbc::result&) {},
+                options),
+            nanodbc::programming_error);
+    }
+
+    // Rowsets come from the background thread, so each row has to arrive once and in order,
+    // across rowset boundaries and with a short last rowset.
+    void test_prefetching_result()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection, NANODBC_TEXT("test_prefetching_result"), NANODBC_TEXT("(i int, j int)"));
+
+        int const count = 50;
+        {
+            nanodbc::statement statement(connection);
+            prepare(
+                statement,
+                NANODBC_TEXT("insert into test_prefetching_result (i, j) values (?, ?);"));
+            std::vector<int> is(count), js(count);
+            std::vector<std::uint8_t> nulls(count, 0);
+            for (int i = 0; i < count; ++i)
+            {
+                is[i] = i;
+                js[i] = i * 2;
+                nulls[i] = i % 10 == 0 ? 1 : 0;
+            }
+            statement.bind(0, is.data(), count);
+            statement.bind(1, js.data(), count, reinterpret_cast<bool const*>(nulls.data()));
+            nanodbc::execute(statement, count);
+        }
+
+        nanodbc::prefetching_result results(execute(
+            connection,
+            NANODBC_TEXT("select i, j from test_prefetching_result order by i;"),
+            7));
+        REQUIRE(results.prefetching());
+        REQUIRE(results.columns() == 2);
+        REQUIRE(results.column_name(1) == NANODBC_TEXT("j"));
+
+        int expected = 0;
+        while (results.next())
+        {
+            REQUIRE(results.get<int>(0) == expected);
+            if (expected % 10 == 0)
+            {
+                REQUIRE(results.is_null(1));
+                REQUIRE(results.get<int>(NANODBC_TEXT("j"), -1) == -1);
+            }
+            else
+            {
+                REQUIRE(results.get<int>(NANODBC_TEXT("j")) == expected * 2);
+            }
+            ++expected;
+        }
+        REQUIRE(expected == count);
+        REQUIRE_FALSE(results.next());
+    }
+
+    // The rows are read whole, then moved through in any order after the statement is gone.
+    void test_materialize()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection, NANODBC_TEXT("test_materialize"), NANODBC_TEXT("(i int, s varchar(10))"));
+
+        int const count = 40;
+        {
+            nanodbc::statement statement(connection);
+            prepare(statement, NANODBC_TEXT("insert into test_materialize (i, s) values (?, ?);"));
+            std::vector<int> is(count);
+            std::vector<nanodbc::string> ss(count);
+            std::vector<std::uint8_t> nulls(count, 0);
+            for (int i = 0; i < count; ++i)
+            {
+                is[i] = i;
+                ss[i] = nanodbc::test::convert(std::to_string(i * 3));
+                nulls[i] = i % 7 == 0 ? 1 : 0;
+            }
+            statement.bind(0, is.data(), count);
+            statement.bind_strings(1, ss, reinterpret_cast<bool const*>(nulls.data()));
+            nanodbc::execute(statement, count);
+        }
+
+        // The result, and the statement with it, is gone once the rows are read.
+        auto rows =
+            execute(connection, NANODBC_TEXT("select i, s from test_materialize order by i;"), 16)
+                .materialize();
+        REQUIRE(rows.rows() == count);
+        REQUIRE(rows.columns() == 2);
+        REQUIRE(rows.column_name(1) == NANODBC_TEXT("s"));
+
+        for (int i = count - 1; i >= 0; --i)
+        {
+            REQUIRE(rows.move(i + 1));
+            REQUIRE(rows.get<int>(0) == i);
+            if (i % 7 == 0)
+            {
+                REQUIRE(rows.is_null(NANODBC_TEXT("s")));
+                REQUIRE(rows.get<int>(1, -1) == -1);
+            }
+            else
+            {
+                REQUIRE(rows.get<int>(1) == i * 3);
+                REQUIRE(rows.get<nanodbc::string>(NANODBC_TEXT("s")) ==
+                        nanodbc::test::convert(std::to_string(i * 3)));
+            }
+        }
+        REQUIRE(rows.first());
+        REQUIRE_FALSE(rows.prior());
+        REQUIRE(rows.at_end());
+    }
+
+    void test_export_delimited()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_export_delimited"),
+            NANODBC_TEXT("(i int, s varchar(20))"));
+        execute(
+            connection,
+            NANODBC_TEXT("insert into test_export_delimited (i, s) values "
+                         "(1, 'plain'), (2, 'a,b'), (3, 'say \"hi\"'), (4, NULL), "
+                         "(5, 'two\nlines'), (6, 'back\\slash');"));
+        nanodbc::string const query =
+            NANODBC_TEXT("select i, s from test_export_delimited order by i;");
+
+        std::string written;
+        auto const sink = [&written](char const* data, std::size_t size) {
+            written.append(data, size);
+        };
+
+        auto result = execute(connection, query);
+        REQUIRE(nanodbc::export_delimited(result, sink) == 6);
+        REQUIRE(
+            written == "i,s\n"
+                       "1,plain\n"
+                       "2,\"a,b\"\n"
+                       "3,\"say \"\"hi\"\"\"\n"
+                       "4,\n"
+                       "5,\"two\nlines\"\n"
+                       "6,back\\slash\n");
+
+        // Tab separated, as PostgreSQL's COPY writes it.
+        nanodbc::delimited_options options;
+        options.delimiter = '\t';
+        options.quoting = nanodbc::delimited_quoting::none;
+        options.escape = '\\';
+        options.null_value = "\\N";
+        options.header = false;
+        written.clear();
+        result = execute(connection, query);
+        REQUIRE(nanodbc::export_delimited(result, sink, options) == 6);
+        REQUIRE(
+            written == "1\tplain\n"
+                       "2\ta,b\n"
+                       "3\tsay \"hi\"\n"
+                       "4\t\\N\n"
+                       "5\ttwo\\nlines\n"
+                       "6\tback\\\\slash\n");
+    }
+
+    // Dates and times held as text are parsed when read as date, time or timestamp.
+    void test_temporal_from_text()
+    {
+        nanodbc::connection connection = connect();
+        auto result = execute(
+            connection,
+            NANODBC_TEXT("select '2006-12-30', '13:45:12', '2006-12-30 13:45:12.345', "
+                         "'2006-12-30T13:45:12.3450000 -08:30', 'not a date';"));
+        REQUIRE(result.next());
+
+        auto const d = result.get<nanodbc::date>(0);
+        REQUIRE(d.year == 2006);
+        REQUIRE(d.month == 12);
+        REQUIRE(d.day == 30);
+
+        auto const t = result.get<nanodbc::time>(1);
+        REQUIRE(t.hour == 13);
+        REQUIRE(t.min == 45);
+        REQUIRE(t.sec == 12);
+
+        auto const ts = result.get<nanodbc::timestamp>(2);
+        REQUIRE(ts.year == 2006);
+        REQUIRE(ts.sec == 12);
+        REQUIRE(ts.fract == 345000000);
+        REQUIRE(result.get<nanodbc::date>(2).day == 30);
+        REQUIRE(result.get<nanodbc::time>(2).min == 45);
+
+        auto const tso = result.get<nanodbc::timestampoffset>(3);
+        REQUIRE(tso.stamp.hour == 13);
+        REQUIRE(tso.stamp.fract == 345000000);
+        REQUIRE(tso.offset_hour == -8);
+        REQUIRE(tso.offset_minute == -30);
+
+        REQUIRE_THROWS_AS(result.get<nanodbc::date>(4), nanodbc::type_incompatible_error);
+        REQUIRE_THROWS_AS(result.get<nanodbc::time>(0), nanodbc::type_incompatible_error);
+    }
+
+    // Rows are read into structs, by the names of their columns.
+    void test_row_mapping()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_row_mapping"),
+            NANODBC_TEXT("(i int, s varchar(20), d float)"));
+        execute(
+            connection,
+            NANODBC_TEXT("insert into test_row_mapping (i, s, d) values "
+                         "(1, 'one', 1.5), (2, 'two', 2.5), (3, 'three', 3.5);"));
+
+        struct item
+        {
+            double value;
+            nanodbc::string name;
+            int id;
+        };
+        auto const mapping = nanodbc::map_row(
+            nanodbc::map_column(NANODBC_TEXT("i"), &item::id),
+            nanodbc::map_column(NANODBC_TEXT("s"), &item::name),
+            nanodbc::map_column(NANODBC_TEXT("d"), &item::value));
+
+        auto result =
+            execute(connection, NANODBC_TEXT("select i, s, d from test_row_mapping order by i;"));
+        auto const items = nanodbc::fetch_rows(result, mapping);
+        REQUIRE(items.size() == 3);
+        REQUIRE(items[0].id == 1);
+        REQUIRE(items[0].name == NANODBC_TEXT("one"));
+        REQUIRE(items[0].value == 1.5);
+        REQUIRE(items[2].id == 3);
+        REQUIRE(items[2].name == NANODBC_TEXT("three"));
+        REQUIRE(items[2].value == 3.5);
+
+        result = execute(connection, NANODBC_TEXT("select s from test_row_mapping;"));
+        REQUIRE_THROWS_AS(nanodbc::make_mapped_reader(result, mapping), nanodbc::index_range_error);
+    }
+
+    // A vector of structs is bound as the parameter sets of one batch, and read back.
+    void test_bind_rows()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_bind_rows"),
+            NANODBC_TEXT("(i int, s varchar(20), d float)"));
+
+        struct item
+        {
+            int id;
+            nanodbc::string name;
+            double value;
+        };
+        auto const mapping = nanodbc::map_row(
+            nanodbc::map_column(NANODBC_TEXT("i"), &item::id),
+            nanodbc::map_column(NANODBC_TEXT("s"), &item::name),
+            nanodbc::map_column(NANODBC_TEXT("d"), &item::value));
+        std::vector<item> const items{
+            {1, NANODBC_TEXT("one"), 1.5},
+            {2, NANODBC_TEXT("two"), 2.5},
+            {3, NANODBC_TEXT("three"), 3.5}};
+
+        nanodbc::statement insert(
+            connection, NANODBC_TEXT("insert into test_bind_rows (i, s, d) values (?, ?, ?);"));
+        insert.bind_rows(items, mapping);
+        execute(insert, static_cast<long>(items.size()));
+
+        auto result =
+            execute(connection, NANODBC_TEXT("select i, s, d from test_bind_rows order by i;"));
+        auto const read = nanodbc::fetch_rows(result, mapping);
+        REQUIRE(read.size() == 3);
+        for (std::size_t i = 0; i < read.size(); ++i)
+        {
+            REQUIRE(read[i].id == items[i].id);
+            REQUIRE(read[i].name == items[i].name);
+            REQUIRE(read[i].value == items[i].value);
+        }
+    }
+
+#ifdef NANODBC_HAS_STD_VARIANT
+    // Each row is read whole and in column order, then served in reverse order from the cache.
+    void test_cached_row_result()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_cached_row_result"),
+            NANODBC_TEXT("(i int, s text, d float)"));
+        execute(
+            connection,
+            NANODBC_TEXT("insert into test_cached_row_result values (1, 'one', 1.5);"));
+        execute(
+            connection,
+            NANODBC_TEXT("insert into test_cached_row_result values (2, NULL, 2.5);"));
+        execute(
+            connection,
+            NANODBC_TEXT("insert into test_cached_row_result values (3, 'three', NULL);"));
+
+        nanodbc::cached_row_result results(execute(
+            connection, NANODBC_TEXT("select i, s, d from test_cached_row_result order by i;")));
+        REQUIRE(results.columns() == 3);
+        REQUIRE(results.row().empty());
+        REQUIRE_THROWS_AS(results.get(0), nanodbc::index_range_error);
+
+        int rows = 0;
+        while (results.next())
+        {
+            ++rows;
+            REQUIRE(results.row().size() == 3);
+            auto const& d = results.get(NANODBC_TEXT("d"));
+            auto const& s = results.get(1);
+            auto const& i = results.get(0);
+            REQUIRE(std::get<long long>(i) == rows);
+            if (rows == 3)
+                REQUIRE(results.is_null(2));
+            else
+                REQUIRE(std::get<double>(d) == rows + 0.5);
+            if (rows == 2)
+                REQUIRE(std::holds_alternative<std::monostate>(s));
+            else
+                REQUIRE(
+                    std::get<nanodbc::string>(s) ==
+                    (rows == 1 ? NANODBC_TEXT("one") : NANODBC_TEXT("three")));
+        }
+        REQUIRE(rows == 3);
+        REQUIRE_THROWS_AS(results.get(0), nanodbc::index_range_error);
+    }
+#endif
+
+    // Batches alternate between the two buffer sets, so rows of every batch, including a
+    // short last one, have to come out as they were set, with unset values as null.
+    void test_batch_writer()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_batch_writer"),
+            NANODBC_TEXT("(i int, s varchar(20), d float)"));
+
+        // Only a prepared statement takes a writer, and not once another query ran directly.
+        nanodbc::statement statement(connection);
+        REQUIRE_FALSE(statement.prepared());
+        REQUIRE_THROWS_AS(nanodbc::batch_writer(statement, 10), nanodbc::programming_error);
+        prepare(
+            statement, NANODBC_TEXT("insert into test_batch_writer (i, s, d) values (?, ?, ?);"));
+        REQUIRE(statement.prepared());
+        statement.just_execute_direct(connection, NANODBC_TEXT("delete from test_batch_writer;"));
+        REQUIRE_FALSE(statement.prepared());
+        REQUIRE_THROWS_AS(nanodbc::batch_writer(statement, 10), nanodbc::programming_error);
+        prepare(
+            statement, NANODBC_TEXT("insert into test_batch_writer (i, s, d) values (?, ?, ?);"));
+
+        int const count = 25;
+        std::vector<nanodbc::batch_result> batches;
+        {
+            nanodbc::batch_writer writer(statement, 10);
+            writer.add_column<int>(0);
+            writer.add_string_column(1, 20);
+            writer.add_column<double>(2);
+            writer.on_batch([&](nanodbc::batch_result const& outcome) {
+                batches.push_back(outcome);
+            });
+
+            for (int i = 0; i < count; ++i)
+            {
+                writer.set(0, i);
+                if (i % 5 != 0)
+                    writer.set(1, NANODBC_TEXT("row ") + nanodbc::test::convert(std::to_string(i)));
+                writer.set(2, i * 0.5);
+                writer.add_row();
+            }
+            REQUIRE(writer.rows() == 5);
+            writer.finish();
+            REQUIRE(writer.rows() == 0);
+
+            REQUIRE_THROWS_AS(
+                writer.set(1, nanodbc::string(21, NANODBC_TEXT('x'))), nanodbc::programming_error);
+            REQUIRE_THROWS_AS(writer.set(0, 1.5), nanodbc::type_incompatible_error);
+        }
+
+        REQUIRE(batches.size() == 3);
+        for (std::size_t b = 0; b < batches.size(); ++b)
+        {
+            REQUIRE(batches[b].sequence == b);
+            REQUIRE(!batches[b].error);
+            REQUIRE(batches[b].row_status.size() == batches[b].rows);
+        }
+        REQUIRE(batches.back().rows == 5);
+
+        auto results = execute(
+            connection,
+            NANODBC_TEXT("select count(*), count(s), sum(i), sum(d) from test_batch_writer;"));
+        REQUIRE(results.next());
+        REQUIRE(results.get<int>(0) == count);
+        REQUIRE(results.get<int>(1) == count - 5);
+        REQUIRE(results.get<int>(2) == count * (count - 1) / 2);
+        REQUIRE(results.get<double>(3) == Catch::Approx(count * (count - 1) / 4.0));
+
+        results = execute(connection, NANODBC_TEXT("select s from test_batch_writer where i = 7;"));
+        REQUIRE(results.next());
+        REQUIRE(results.get<nanodbc::string>(0) == NANODBC_TEXT("row 7"));
+    }
+
+    // After an array execute every row has a status, whether the execution succeeded or not,
+    // so that a loader can retry only the rows that failed.
+    void test_parameter_status()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_parameter_status"),
+            NANODBC_TEXT("(i int not null primary key)"));
+
+        nanodbc::statement statement(connection);
+        prepare(statement, NANODBC_TEXT("insert into test_parameter_status (i) values (?);"));
+
+        std::vector<int> values{1, 2, 3, 4};
+        statement.bind(0, values.data(), values.size());
+        nanodbc::execute(statement, static_cast<long>(values.size()));
+
+        auto status = statement.parameter_status();
+        REQUIRE(status.size() == values.size());
+        for (auto s : status)
+            REQUIRE(s == nanodbc::statement::PARAM_SUCCESS);
+        REQUIRE(statement.parameters_processed() == values.size());
+        REQUIRE(statement.parameter_diagnostics().empty());
+
+        // 3 is already there, the other rows are new.
+        values = {5, 3, 6};
+        statement.bind(0, values.data(), values.size());
+        REQUIRE_THROWS_AS(
+            nanodbc::execute(statement, static_cast<long>(values.size())),
+            nanodbc::database_error);
+
+        status = statement.parameter_status();
+        REQUIRE(status.size() == values.size());
+        REQUIRE(status[0] != nanodbc::statement::PARAM_ERROR);
+        REQUIRE(status[1] != nanodbc::statement::PARAM_SUCCESS);
+
+        // Drivers either stop at the failing row or go on with the rest, but the rows they
+        // processed are the ones the status array reports as used.
+        auto const processed = statement.parameters_processed();
+        REQUIRE(processed >= 2);
+        REQUIRE(processed <= values.size());
+        REQUIRE(
+            static_cast<unsigned long>(std::count_if(
+                status.begin(),
+                status.end(),
+                [](nanodbc::statement::param_status s) {
+                    return s != nanodbc::statement::PARAM_UNUSED;
+                })) == processed);
+
+        auto const diagnostics = statement.parameter_diagnostics();
+        auto const duplicate = std::find_if(
+            diagnostics.begin(),
+            diagnostics.end(),
+            [](nanodbc::statement::param_diagnostic const& d) { return d.row == 1; });
+        REQUIRE(duplicate != diagnostics.end());
+        REQUIRE(duplicate->state.size() == 5);
+        REQUIRE(!duplicate->message.empty());
+    }
+
+    void test_call_tracing()
+    {
+        nanodbc::connection connection = connect();
+        nanodbc::reset_call_statistics();
+
+        std::vector<nanodbc::call_span> spans;
+        nanodbc::set_call_span_handler([&spans](nanodbc::call_span const& span) {
+            spans.push_back(span);
+        });
+        nanodbc::enable_call_tracing();
+        REQUIRE(nanodbc::call_tracing_enabled());
+        nanodbc::execute(connection, NANODBC_TEXT("select 1;"));
+        // Not a table, so the call fails and is counted as an error.
+        REQUIRE_THROWS_AS(
+            nanodbc::execute(connection, NANODBC_TEXT("select * from test_call_tracing_none;")),
+            nanodbc::database_error);
+        nanodbc::enable_call_tracing(false);
+        nanodbc::set_call_span_handler(nullptr);
+        nanodbc::execute(connection, NANODBC_TEXT("select 1;"));
+
+        // The wide build calls the W variants.
+        auto const is_exec_direct = [](std::string const& function) {
+            return function.compare(0, 13, "SQLExecDirect") == 0;
+        };
+        auto const stats = nanodbc::call_statistics();
+        auto const exec_direct = std::find_if(
+            stats.begin(), stats.end(), [&](nanodbc::call_stats const& s) {
+                return is_exec_direct(s.function);
+            });
+        REQUIRE(exec_direct != stats.end());
+        REQUIRE(exec_direct->calls == 2);
+        REQUIRE(exec_direct->errors == 1);
+        REQUIRE(exec_direct->histogram.size() == nanodbc::call_stats::buckets);
+        unsigned long long histogram_calls = 0;
+        for (auto n : exec_direct->histogram)
+            histogram_calls += n;
+        REQUIRE(histogram_calls == 2);
+
+        REQUIRE(
+            std::count_if(spans.begin(), spans.end(), [&](nanodbc::call_span const& s) {
+                return is_exec_direct(s.function);
+            }) == 2);
+        unsigned long long span_calls = 0;
+        for (auto const& s : stats)
+            span_calls += s.calls;
+        REQUIRE(spans.size() == span_calls);
+
+        nanodbc::reset_call_statistics();
+        REQUIRE(nanodbc::call_statistics().empty());
+    }
+
+    void test_parameter_description_cache()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_parameter_description_cache"),
+            NANODBC_TEXT("(i int, s varchar(10))"));
+        nanodbc::string const insert =
+            NANODBC_TEXT("insert into test_parameter_description_cache (i, s) values (?, ?);");
+
+        auto const describe_calls = [] {
+            for (auto const& stats : nanodbc::call_statistics())
+            {
+                if (stats.function == "SQLDescribeParam")
+                    return stats.calls;
+            }
+            return 0ull;
+        };
+        auto const insert_row =
+            [](nanodbc::statement& statement, int i, nanodbc::string const& s) {
+                statement.bind(0, &i);
+                statement.bind(1, s.c_str());
+                nanodbc::execute(statement);
+            };
+
+        REQUIRE(!connection.caches_parameter_descriptions());
+        connection.cache_parameter_descriptions();
+        REQUIRE(connection.caches_parameter_descriptions());
+
+        // The second statement binds with the descriptions the first one asked the driver for.
+        nanodbc::reset_call_statistics();
+        nanodbc::enable_call_tracing();
+        {
+            nanodbc::statement statement(connection, insert);
+            insert_row(statement, 1, NANODBC_TEXT("one"));
+        }
+        {
+            nanodbc::statement statement(connection, insert);
+            insert_row(statement, 2, NANODBC_TEXT("two"));
+        }
+        nanodbc::enable_call_tracing(false);
+        REQUIRE(describe_calls() == 2);
+
+        std::vector<nanodbc::statement::param_description> descriptions;
+        {
+            nanodbc::statement statement(connection, insert);
+            descriptions = statement.parameter_descriptions();
+        }
+        REQUIRE(descriptions.size() == 2);
+        connection.cache_parameter_descriptions(false);
+        REQUIRE(!connection.caches_parameter_descriptions());
+
+        // Descriptions given up front leave nothing for the driver to describe.
+        nanodbc::reset_call_statistics();
+        nanodbc::enable_call_tracing();
+        {
+            nanodbc::statement statement(connection, insert);
+            statement.describe_parameters(descriptions);
+            insert_row(statement, 3, NANODBC_TEXT("three"));
+        }
+        nanodbc::enable_call_tracing(false);
+        REQUIRE(describe_calls() == 0);
+        nanodbc::reset_call_statistics();
+
+        auto result = nanodbc::execute(
+            connection,
+            NANODBC_TEXT("select i, s from test_parameter_description_cache order by i;"));
+        std::vector<nanodbc::string> values;
+        for (int i = 1; result.next(); ++i)
+        {
+            REQUIRE(result.get<int>(0) == i);
+            values.push_back(result.get<nanodbc::string>(1));
+        }
+        REQUIRE(
+            values ==
+            std::vector<nanodbc::string>{
+                NANODBC_TEXT("one"), NANODBC_TEXT("two"), NANODBC_TEXT("three")});
+    }
+
+    void test_bind_ref()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection, NANODBC_TEXT("test_bind_ref"), NANODBC_TEXT("(i int, s varchar(64))"));
+        nanodbc::statement statement(
+            connection, NANODBC_TEXT("insert into test_bind_ref (i, s) values (?, ?);"));
+
+        auto const bind_calls = [] {
+            for (auto const& stats : nanodbc::call_statistics())
+            {
+                if (stats.function == "SQLBindParameter")
+                    return stats.calls;
+            }
+            return 0ull;
+        };
+
+        int i = 0;
+        nanodbc::string s;
+        s.reserve(16);
+        nanodbc::reset_call_statistics();
+        nanodbc::enable_call_tracing();
+        statement.bind_ref(0, i);
+        statement.bind_ref(1, s);
+        for (i = 1; i <= 5; ++i)
+        {
+            s.assign(static_cast<std::size_t>(i), 'a');
+            nanodbc::just_execute(statement);
+        }
+        REQUIRE(bind_calls() == 2);
+
+        // Outgrowing its buffer moves the string, which is bound again before it is sent.
+        i = 6;
+        s.assign(40, 'b');
+        nanodbc::just_execute(statement);
+        nanodbc::enable_call_tracing(false);
+        REQUIRE(bind_calls() == 3);
+        nanodbc::reset_call_statistics();
+
+        // Executed directly, the same statement sends the string as it is now too.
+        i = 7;
+        s.assign(60, 'c');
+        statement.just_execute_direct(
+            connection, NANODBC_TEXT("insert into test_bind_ref (i, s) values (?, ?);"));
+
+        REQUIRE_THROWS_AS(
+            statement.bind_ref(1, s, nanodbc::statement::PARAM_OUT), nanodbc::programming_error);
+
+        auto result = nanodbc::execute(
+            connection, NANODBC_TEXT("select i, s from test_bind_ref order by i;"));
+        int rows = 0;
+        while (result.next())
+        {
+            ++rows;
+            REQUIRE(result.get<int>(0) == rows);
+            auto const expected = rows < 6    ? nanodbc::string(static_cast<std::size_t>(rows), 'a')
+                                  : rows == 6 ? nanodbc::string(40, 'b')
+                                              : nanodbc::string(60, 'c');
+            REQUIRE(result.get<nanodbc::string>(1) == expected);
+        }
+        REQUIRE(rows == 7);
+    }
+
+    void test_bulk_copy()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_bulk_copy"),
+            NANODBC_TEXT("(i int, s varchar(20), d float)"));
+
+        int const count = 2500;
+        {
+            nanodbc::bulk_copy copy(connection, NANODBC_TEXT("test_bulk_copy"), 1000);
+            copy.add_column<int>(NANODBC_TEXT("i"));
+            copy.add_string_column(NANODBC_TEXT("s"), 20);
+            copy.add_column<double>(NANODBC_TEXT("d"));
+            for (int i = 0; i < count; ++i)
+            {
+                copy.set(0, i);
+                if (i % 5 != 0)
+                    copy.set(1, NANODBC_TEXT("row ") + nanodbc::test::convert(std::to_string(i)));
+                copy.set(2, i * 0.5);
+                copy.add_row();
+            }
+            REQUIRE(copy.finish() == static_cast<std::size_t>(count));
+
+            REQUIRE_THROWS_AS(copy.add_column<int>(NANODBC_TEXT("j")), nanodbc::programming_error);
+            REQUIRE_THROWS_AS(copy.set(0, 1.5), nanodbc::type_incompatible_error);
+            REQUIRE_THROWS_AS(copy.set(3, 1), nanodbc::index_range_error);
+        }
+
+        auto results = execute(
+            connection,
+            NANODBC_TEXT("select count(*), count(s), sum(i), sum(d) from test_bulk_copy;"));
+        REQUIRE(results.next());
+        REQUIRE(results.get<int>(0) == count);
+        REQUIRE(results.get<int>(1) == count - count / 5);
+        REQUIRE(results.get<int>(2) == count * (count - 1) / 2);
+        REQUIRE(results.get<double>(3) == Catch::Approx(count * (count - 1) / 4.0));
+
+        results = execute(connection, NANODBC_TEXT("select s from test_bulk_copy where i = 7;"));
+        REQUIRE(results.next());
+        REQUIRE(results.get<nanodbc::string>(0) == NANODBC_TEXT("row 7"));
+    }
+
+    void test_copy_in()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_copy_in"),
+            NANODBC_TEXT("(i int, s varchar(20), d float)"));
+
+        // 2550 rows in statements of 100 leave a tail of 50 for the second statement shape.
+        int const count = 2550;
+        {
+            nanodbc::copy_options options;
+            options.rows_per_statement = 100;
+            options.allow_bulk_copy = false;
+            nanodbc::copy_in copy(connection, NANODBC_TEXT("test_copy_in"), options);
+            copy.add_column<int>(NANODBC_TEXT("i"));
+            copy.add_string_column(NANODBC_TEXT("s"), 20);
+            copy.add_column<double>(NANODBC_TEXT("d"));
+            for (int i = 0; i < count; ++i)
+            {
+                copy.set(0, i);
+                if (i % 5 != 0)
+                    copy.set(1, NANODBC_TEXT("row ") + nanodbc::test::convert(std::to_string(i)));
+                copy.set(2, i * 0.5);
+                copy.add_row();
+            }
+            REQUIRE(!copy.uses_bcp());
+            REQUIRE(copy.rows_per_statement() == 100);
+            REQUIRE(copy.finish() == static_cast<std::size_t>(count));
+
+            REQUIRE_THROWS_AS(copy.add_column<int>(NANODBC_TEXT("j")), nanodbc::programming_error);
+            REQUIRE_THROWS_AS(copy.set(0, 1.5), nanodbc::type_incompatible_error);
+            REQUIRE_THROWS_AS(copy.set(3, 1), nanodbc::index_range_error);
+        }
+
+        auto results = execute(
+            connection,
+            NANODBC_TEXT("select count(*), count(s), sum(i), sum(d) from test_copy_in;"));
+        REQUIRE(results.next());
+        REQUIRE(results.get<int>(0) == count);
+        REQUIRE(results.get<int>(1) == count - count / 5);
+        REQUIRE(results.get<int>(2) == count * (count - 1) / 2);
+        REQUIRE(results.get<double>(3) == Catch::Approx(count * (count - 1) / 4.0));
+
+        long long sum = 0;
+        nanodbc::copy_options options;
+        options.rows_per_fetch = 64;
+        std::size_t const rows = nanodbc::copy_out(
+            connection,
+            NANODBC_TEXT("select i, s from test_copy_in;"),
+            [&sum](nanodbc::prefetching_result& row) { sum += row.get<int>(0); },
+            options);
+        REQUIRE(rows == static_cast<std::size_t>(count));
+        REQUIRE(sum == static_cast<long long>(count) * (count - 1) / 2);
+    }
+
+    void test_multirow_insert()
+    {
+        nanodbc::connection connection = connect();
+        create_table(
+            connection,
+            NANODBC_TEXT("test_multirow_insert"),
+            NANODBC_TEXT("(i int, s varchar(20))"));
+
+        REQUIRE_THROWS_AS(
+            nanodbc::multirow_insert(
+                connection, NANODBC_TEXT("insert into test_multirow_insert (i) select 1;")),
+            nanodbc::programming_error);
+
+        nanodbc::copy_options options;
+        options.rows_per_statement = 100;
+        nanodbc::multirow_insert insert(
+            connection,
+            NANODBC_TEXT("insert into test_multirow_insert (i, s) values (?, ?);"),
+            options);
+        REQUIRE(insert.parameters() == 2);
+        REQUIRE(insert.rows_per_statement() == 100);
+
+        // Batches of 250 rows take two full statements and a tail of 50.
+        int const batch = 250;
+        std::vector<int> numbers(batch);
+        std::vector<nanodbc::string> strings(batch);
+        bool nulls[batch] = {};
+        for (int i = 0; i < batch; ++i)
+        {
+            numbers[i] = i;
+            strings[i] = nanodbc::test::convert(std::to_string(i));
+            nulls[i] = i % 5 == 0;
+        }
+        insert.bind(0, numbers.data(), numbers.size());
+        insert.bind_strings(1, strings, nulls);
+        REQUIRE(insert.execute(batch) == static_cast<std::size_t>(batch));
+        REQUIRE(insert.execute(batch) == static_cast<std::size_t>(batch));
+        REQUIRE(insert.execute(10) == 10);
+        REQUIRE(insert.rows_inserted() == 10);
+        REQUIRE_THROWS_AS(insert.execute(batch + 1), nanodbc::programming_error);
+        REQUIRE(insert.rows_inserted() == 0);
+        REQUIRE_THROWS_AS(
+            insert.bind(2, numbers.data(), numbers.size()), nanodbc::index_range_error);
+
+        auto results = execute(
+            connection,
+            NANODBC_TEXT("select count(*), count(s), sum(i) from test_multirow_insert;"));
+        REQUIRE(results.next());
+        REQUIRE(results.get<int>(0) == 2 * batch + 10);
+        REQUIRE(results.get<int>(1) == 2 * (batch - batch / 5) + 8);
+        REQUIRE(results.get<int>(2) == batch * (batch - 1) + 45);
+
+        results = execute(
+            connection, NANODBC_TEXT("select s from test_multirow_insert where i = 7;"));
+        REQUIRE(results.next());
+        REQUIRE(results.get<nanodbc::string>(0) == NANODBC_TEXT("7"));
+
+        // The statements before a failing one keep their rows, and the count says so.
+        create_table(
+            connection,
+            NANODBC_TEXT("test_multirow_insert_partial"),
+            NANODBC_TEXT("(i int not null)"));
+        nanodbc::multirow_insert partial(
+            connection,
+            NANODBC_TEXT("insert into test_multirow_insert_partial (i) values (?);"),
+            options);
+        bool null_at_150[batch] = {};
+        null_at_150[150] = true;
+        partial.bind(0, numbers.data(), numbers.size(), null_at_150);
+        REQUIRE_THROWS_AS(partial.execute(batch), nanodbc::database_error);
+        REQUIRE(partial.rows_inserted() == 100);
+    }
+
     void test_binary_read_shapes()
     {
         nanodbc::connection connection = connect();
@@ -2275,6 +3195,129 @@ struct test_case_fixture : public base_test_fixture
         }
     }
 
+    void test_catalog_snapshot()
+    {
+        nanodbc::connection connection = connect();
+        nanodbc::string const table_name(NANODBC_TEXT("test_catalog_snapshot"));
+        drop_table(connection, table_name);
+        execute(
+            connection,
+            NANODBC_TEXT("create table ") + table_name +
+                NANODBC_TEXT("(i int NOT NULL, s varchar(10), d float, ") +
+                NANODBC_TEXT("CONSTRAINT test_pk_snapshot PRIMARY KEY (i));"));
+        execute(
+            connection,
+            NANODBC_TEXT("create unique index test_catalog_snapshot_s on ") + table_name +
+                NANODBC_TEXT(" (s);"));
+
+        nanodbc::catalog catalog(connection);
+        nanodbc::catalog_snapshot_options options;
+        options.table = table_name;
+        auto snapshot = catalog.snapshot(options);
+        REQUIRE(snapshot.strings.at(0).empty());
+        REQUIRE(snapshot.tables.size() == 1);
+        auto const& table = snapshot.tables[0];
+        REQUIRE(snapshot.strings[table.name] == table_name);
+
+        REQUIRE(table.column_count == 3);
+        nanodbc::string const column_names[] = {
+            NANODBC_TEXT("i"), NANODBC_TEXT("s"), NANODBC_TEXT("d")};
+        for (std::uint32_t i = 0; i < table.column_count; ++i)
+        {
+            auto const& column = snapshot.columns[table.first_column + i];
+            REQUIRE(column.table == 0);
+            REQUIRE(snapshot.strings[column.name] == column_names[i]);
+            REQUIRE(column.ordinal_position == static_cast<long>(i + 1));
+        }
+
+        REQUIRE(table.key_column_count == 1);
+        auto const& key = snapshot.key_columns[table.first_key_column];
+        REQUIRE(snapshot.strings[key.column] == NANODBC_TEXT("i"));
+        REQUIRE(key.sequence == 1);
+
+        bool unique_s = false;
+        for (std::uint32_t i = 0; i < table.index_column_count; ++i)
+        {
+            auto const& index = snapshot.index_columns[table.first_index_column + i];
+            if (snapshot.strings[index.column] == NANODBC_TEXT("s"))
+                unique_s = index.unique;
+        }
+        REQUIRE(unique_s);
+
+        options.primary_keys = false;
+        options.indexes = false;
+        snapshot = catalog.snapshot(options);
+        REQUIRE(snapshot.tables.size() == 1);
+        REQUIRE(snapshot.tables[0].column_count == 3);
+        REQUIRE(snapshot.key_columns.empty());
+        REQUIRE(snapshot.index_columns.empty());
+
+        // The columns of a table of another type leave no names behind.
+        options.type = NANODBC_TEXT("VIEW");
+        snapshot = catalog.snapshot(options);
+        REQUIRE(snapshot.tables.empty());
+        REQUIRE(snapshot.columns.empty());
+        REQUIRE(snapshot.strings.size() == 1);
+    }
+
+    void test_catalog_metadata_cache()
+    {
+        nanodbc::connection connection = connect();
+        nanodbc::string const table_name(NANODBC_TEXT("test_catalog_metadata_cache"));
+        drop_table(connection, table_name);
+        execute(connection, NANODBC_TEXT("create table ") + table_name + NANODBC_TEXT("(i int);"));
+
+        auto count_columns = [&]() {
+            nanodbc::catalog catalog(connection);
+            auto columns = catalog.find_columns(nanodbc::string(), table_name);
+            int count = 0;
+            while (columns.next())
+            {
+                REQUIRE(columns.table_name() == table_name);
+                ++count;
+            }
+            return count;
+        };
+
+        connection.cache_metadata(std::chrono::seconds(600));
+        REQUIRE(count_columns() == 1);
+        execute(
+            connection,
+            NANODBC_TEXT("alter table ") + table_name + NANODBC_TEXT(" add s varchar(10);"));
+
+        // Answered from the cache until the table is invalidated.
+        REQUIRE(count_columns() == 1);
+        connection.invalidate_metadata(table_name);
+        REQUIRE(count_columns() == 2);
+
+        // Tables are looked up through the same cache.
+        nanodbc::string const new_table_name(NANODBC_TEXT("test_catalog_metadata_cache_new"));
+        drop_table(connection, new_table_name);
+        auto count_tables = [&]() {
+            nanodbc::catalog catalog(connection);
+            auto tables = catalog.find_tables(new_table_name);
+            int count = 0;
+            while (tables.next())
+            {
+                REQUIRE(tables.table_name() == new_table_name);
+                ++count;
+            }
+            return count;
+        };
+        REQUIRE(count_tables() == 0);
+        execute(
+            connection, NANODBC_TEXT("create table ") + new_table_name + NANODBC_TEXT("(i int);"));
+        REQUIRE(count_tables() == 0);
+        connection.invalidate_metadata(new_table_name);
+        REQUIRE(count_tables() == 1);
+
+        connection.cache_metadata(std::chrono::seconds(0));
+        REQUIRE(connection.metadata_ttl().count() == 0);
+        REQUIRE(count_columns() == 2);
+        drop_table(connection, new_table_name);
+        REQUIRE(count_tables() == 0);
+    }
+
     void test_catalog_tables()
     {
         nanodbc::connection connection = connect();